@@ -1,4 +1,5 @@
 #include "baldr/accessrestriction.h"
+#include "baldr/rapidjson_utils.h"
 #include "baldr/timedomain.h"
 #include <string.h>
 
@@ -61,40 +62,41 @@ void AccessRestriction::set_value(const uint64_t v) {
   value_ = v;
 }
 
-const json::MapPtr AccessRestriction::json() const {
+void AccessRestriction::json(rapidjson::writer_wrapper_t& writer) const {
   auto maybe_found = type_to_string.find(type());
   std::string restriction_type = "unsupported";
   if (maybe_found != type_to_string.cend()) {
     restriction_type = maybe_found->second;
   }
-  auto map = json::map({{"type", restriction_type},
-                        {"edge_index", static_cast<uint64_t>(edgeindex())},
-                        {"bus", static_cast<bool>(modes_ & kBusAccess)},
-                        {"car", static_cast<bool>(modes_ & kAutoAccess)},
-                        {"emergency", static_cast<bool>(modes_ & kEmergencyAccess)},
-                        {"HOV", static_cast<bool>(modes_ & kHOVAccess)},
-                        {"pedestrian", static_cast<bool>(modes_ & kPedestrianAccess)},
-                        {"taxi", static_cast<bool>(modes_ & kTaxiAccess)},
-                        {"truck", static_cast<bool>(modes_ & kTruckAccess)},
-                        {"wheelchair", static_cast<bool>(modes_ & kWheelchairAccess)},
-                        {"moped", static_cast<bool>(modes_ & kMopedAccess)},
-                        {"motorcycle", static_cast<bool>(modes_ & kMotorcycleAccess)}});
+  writer("type", restriction_type);
+  writer("edge_index", static_cast<uint64_t>(edgeindex()));
+  writer("bus", static_cast<bool>(modes_ & kBusAccess));
+  writer("car", static_cast<bool>(modes_ & kAutoAccess));
+  writer("emergency", static_cast<bool>(modes_ & kEmergencyAccess));
+  writer("HOV", static_cast<bool>(modes_ & kHOVAccess));
+  writer("pedestrian", static_cast<bool>(modes_ & kPedestrianAccess));
+  writer("taxi", static_cast<bool>(modes_ & kTaxiAccess));
+  writer("truck", static_cast<bool>(modes_ & kTruckAccess));
+  writer("wheelchair", static_cast<bool>(modes_ & kWheelchairAccess));
+  writer("moped", static_cast<bool>(modes_ & kMopedAccess));
+  writer("motorcycle", static_cast<bool>(modes_ & kMotorcycleAccess));
 
   switch (type()) {
     case AccessType::kTimedAllowed:
     case AccessType::kTimedDenied:
     case AccessType::kDestinationAllowed:
       // TODO(nils): turn the time domain into a proper map
-      map->emplace("value", json::map({{std::string("time_domain"), value()}}));
+      writer.start_object("value");
+      writer("time_domain", value());
+      writer.end_object();
       break;
     case AccessType::kMaxAxles:
-      map->emplace("value", value());
+      writer("value", value());
       break;
     default:
-      map->emplace("value", json::fixed_t{static_cast<double>(value()) * 0.01, 2});
+      writer.set_rounded_precision(2);
+      writer("value", static_cast<double>(value()) * 0.01);
   }
-
-  return map;
 }
 
 // operator < - for sorting. Sort by route Id.
@@ -1,5 +1,6 @@
 #include "baldr/edgeinfo.h"
 #include "baldr/graphconstants.h"
+#include "baldr/rapidjson_utils.h"
 #include "midgard/elevation_encoding.h"
 
 using namespace valhalla::baldr;
@@ -11,21 +12,21 @@ bool IsNonLiguisticTagValue(char ch) {
   return static_cast<TaggedValue>(ch) != TaggedValue::kLinguistic;
 }
 
-json::MapPtr bike_network_json(uint8_t mask) {
-  return json::map({
-      {"national", static_cast<bool>(mask & kNcn)},
-      {"regional", static_cast<bool>(mask & kRcn)},
-      {"local", static_cast<bool>(mask & kLcn)},
-      {"mountain", static_cast<bool>(mask & kMcn)},
-  });
+void bike_network_json(uint8_t mask, rapidjson::writer_wrapper_t& writer) {
+  writer.start_object("bike_network");
+  writer("national", static_cast<bool>(mask & kNcn));
+  writer("regional", static_cast<bool>(mask & kRcn));
+  writer("local", static_cast<bool>(mask & kLcn));
+  writer("mountain", static_cast<bool>(mask & kMcn));
+  writer.end_object();
 }
 
-json::ArrayPtr names_json(const std::vector<std::string>& names) {
-  auto a = json::array({});
+void names_json(const std::vector<std::string>& names, rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("names");
   for (const auto& n : names) {
-    a->push_back(n);
+    writer(n);
   }
-  return a;
+  writer.end_array();
 }
 
 /**
@@ -515,28 +516,28 @@ std::vector<std::string> EdgeInfo::level_ref() const {
   return values;
 }
 
-json::MapPtr EdgeInfo::json() const {
-  json::MapPtr edge_info = json::map({
-      {"way_id", static_cast<uint64_t>(wayid())},
-      {"bike_network", bike_network_json(bike_network())},
-      {"names", names_json(GetNames())},
-      {"shape", midgard::encode(shape())},
-  });
+void EdgeInfo::json(rapidjson::writer_wrapper_t& writer) const {
+  writer("way_id", static_cast<uint64_t>(wayid()));
+  bike_network_json(bike_network(), writer);
+  names_json(GetNames(), writer);
+  writer("shape", midgard::encode(shape()));
   // add the mean_elevation depending on its validity
   const auto elev = mean_elevation();
   if (elev == kNoElevationData) {
-    edge_info->emplace("mean_elevation", nullptr);
+    writer("mean_elevation", nullptr);
   } else {
-    edge_info->emplace("mean_elevation", static_cast<int64_t>(elev));
+    writer("mean_elevation", static_cast<int64_t>(elev));
   }
 
   if (speed_limit() == kUnlimitedSpeedLimit) {
-    edge_info->emplace("speed_limit", std::string("unlimited"));
+    writer("speed_limit", "unlimited");
   } else {
-    edge_info->emplace("speed_limit", static_cast<uint64_t>(speed_limit()));
+    writer("speed_limit", static_cast<uint64_t>(speed_limit()));
   }
 
-  json::MapPtr conditional_speed_limits;
+  // conditional limits are grouped into one object after the other tags
+  std::vector<const ConditionalSpeedLimit*> conditional_speed_limits;
+  bool has_levels = false;
   for (const auto& [tag, value] : GetTags()) {
     switch (tag) {
       case TaggedValue::kLayer:
@@ -552,31 +553,34 @@ json::MapPtr EdgeInfo::json() const {
       case TaggedValue::kLandmark:
         break;
       case TaggedValue::kLevels: {
-        json::ArrayPtr levels = json::array({});
+        // only the first levels tag is used
+        if (has_levels) {
+          break;
+        }
+        has_levels = true;
         std::vector<std::pair<float, float>> decoded;
         uint32_t precision;
         std::tie(decoded, precision) = decode_levels(value);
+        writer.start_array("levels");
+        writer.set_rounded_precision(precision);
         for (auto& range : decoded) {
           if (range.first == range.second) {
             // single number
-            levels->emplace_back(json::fixed_t{range.first, precision});
+            writer(static_cast<double>(range.first));
           } else {
             // range
-            json::ArrayPtr level = json::array({});
-            level->emplace_back(json::fixed_t{range.first, precision});
-            level->emplace_back(json::fixed_t{range.second, precision});
-            levels->emplace_back(level);
+            writer.start_array();
+            writer(static_cast<double>(range.first));
+            writer(static_cast<double>(range.second));
+            writer.end_array();
           }
         }
-        edge_info->emplace("levels", levels);
+        writer.end_array();
         break;
       }
       case TaggedValue::kConditionalSpeedLimits: {
-        if (!conditional_speed_limits) {
-          conditional_speed_limits = json::map({});
-        }
-        const ConditionalSpeedLimit* l = reinterpret_cast<const ConditionalSpeedLimit*>(value.data());
-        conditional_speed_limits->emplace(l->td_.to_string(), static_cast<uint64_t>(l->speed_));
+        conditional_speed_limits.push_back(
+            reinterpret_cast<const ConditionalSpeedLimit*>(value.data()));
         break;
       }
       case TaggedValue::kTunnel:
@@ -585,11 +589,13 @@ json::MapPtr EdgeInfo::json() const {
         break;
     }
   }
-  if (conditional_speed_limits) {
-    edge_info->emplace("conditional_speed_limits", std::move(conditional_speed_limits));
+  if (!conditional_speed_limits.empty()) {
+    writer.start_object("conditional_speed_limits");
+    for (const auto* l : conditional_speed_limits) {
+      writer(l->td_.to_string(), static_cast<uint64_t>(l->speed_));
+    }
+    writer.end_object();
   }
-
-  return edge_info;
 }
 
 } // namespace baldr
@@ -1,19 +1,15 @@
 #include "baldr/graphid.h"
+#include "baldr/rapidjson_utils.h"
 
 namespace valhalla {
 namespace baldr {
 
 // The json representation of the Id
-json::Value GraphId::json() const {
-  if (Is_Valid()) {
-    return json::map({
-        {"level", static_cast<uint64_t>(level())},
-        {"tile_id", static_cast<uint64_t>(tileid())},
-        {"id", static_cast<uint64_t>(id())},
-        {"value", value},
-    });
-  }
-  return static_cast<std::nullptr_t>(nullptr);
+void GraphId::json(rapidjson::writer_wrapper_t& writer) const {
+  writer("level", static_cast<uint64_t>(level()));
+  writer("tile_id", static_cast<uint64_t>(tileid()));
+  writer("id", static_cast<uint64_t>(id()));
+  writer("value", static_cast<uint64_t>(value));
 }
 
 // Stream output
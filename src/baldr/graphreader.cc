@@ -11,6 +11,8 @@
 #include "midgard/logging.h"
 #include "shortcut_recovery.h"
 
+#include <boost/functional/hash.hpp>
+
 using namespace valhalla::midgard;
 
 namespace {
@@ -25,6 +27,37 @@ struct tile_index_entry {
   uint32_t size;    // size of the tile in bytes
 };
 
+#ifndef _WIN32
+// Identifies the tileset a shared tile cache is filled from by where it is and when it was last
+// written to, the extract or else the tile directory and its level directories
+uint64_t tileset_fingerprint(const boost::property_tree::ptree& pt) {
+  std::vector<std::string> paths;
+  auto tile_extract = pt.get<std::string>("tile_extract", "");
+  if (!tile_extract.empty() && filesystem::exists(tile_extract)) {
+    paths.push_back(tile_extract);
+  } else {
+    auto tile_dir = pt.get<std::string>("tile_dir", "");
+    paths.push_back(tile_dir);
+    for (const auto& level : valhalla::baldr::TileHierarchy::levels()) {
+      paths.push_back(tile_dir + filesystem::path::preferred_separator +
+                      std::to_string(level.level));
+    }
+    paths.push_back(tile_dir + filesystem::path::preferred_separator +
+                    std::to_string(valhalla::baldr::TileHierarchy::GetTransitLevel().level));
+  }
+
+  size_t fingerprint = 0;
+  for (const auto& path : paths) {
+    boost::hash_combine(fingerprint, path);
+    if (filesystem::exists(path)) {
+      boost::hash_combine(fingerprint,
+                          filesystem::last_write_time(path).time_since_epoch().count());
+    }
+  }
+  return fingerprint;
+}
+#endif
+
 } // namespace
 
 namespace valhalla {
@@ -436,6 +469,21 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
 
   bool use_simple_cache = pt.get<bool>("use_simple_mem_cache", false);
 
+  // tiles in shared memory don't come with their live traffic
+  auto shared_cache = pt.get<std::string>("shared_mem_cache", "");
+  if (!shared_cache.empty() && !pt.get<std::string>("traffic_extract", "").empty()) {
+    LOG_WARN("The shared tile cache can't be used along with a traffic extract");
+    shared_cache.clear();
+  }
+  size_t shared_cache_size = pt.get<size_t>("shared_mem_cache_size", max_cache_size);
+#ifdef _WIN32
+  // there is no posix shared memory here so the shared tile cache isn't even compiled, the
+  // branches making one below are left out
+  if (!shared_cache.empty()) {
+    throw std::runtime_error("The shared tile cache is not supported on this platform");
+  }
+#endif
+
   // wrap tile cache with thread-safe version
   if (pt.get<bool>("global_synchronized_cache", false)) {
     // Handle synchronization of cache
@@ -445,7 +493,13 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
     static std::mutex factoryMutex;
     std::lock_guard<std::mutex> lock(factoryMutex);
     if (!globalTileCache_) {
-      if (use_lru_cache) {
+      if (!shared_cache.empty()) {
+#ifndef _WIN32
+        globalTileCache_.reset(
+            new SharedTileCache(shared_cache, shared_cache_size, max_cache_size,
+                                tileset_fingerprint(pt)));
+#endif
+      } else if (use_lru_cache) {
         globalTileCache_.reset(new TileCacheLRU(max_cache_size, lru_mem_control));
       } else {
         // globalTileCache_.reset(new SimpleTileCache(max_cache_size));
@@ -455,6 +509,14 @@ TileCache* TileCacheFactory::createTileCache(const boost::property_tree::ptree&
     return new SynchronizedTileCache(*globalTileCache_, globalCacheMutex_);
   }
 
+  // maybe you want to share the tiles with other processes
+#ifndef _WIN32
+  if (!shared_cache.empty()) {
+    return new SharedTileCache(shared_cache, shared_cache_size, max_cache_size,
+                               tileset_fingerprint(pt));
+  }
+#endif
+
   // or do you want to use an LRU cache
   if (use_lru_cache) {
     return new TileCacheLRU(max_cache_size, lru_mem_control);
@@ -477,7 +539,8 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
       tile_dir_(tile_extract_->tiles.empty() ? pt.get<std::string>("tile_dir", "") : ""),
       tile_getter_(std::move(tile_getter)),
       max_concurrent_users_(pt.get<size_t>("max_concurrent_reader_users", 1)),
-      tile_url_(pt.get<std::string>("tile_url", "")), cache_(TileCacheFactory::createTileCache(pt)) {
+      tile_url_(pt.get<std::string>("tile_url", "")), cache_config_(pt),
+      cache_(TileCacheFactory::createTileCache(pt)) {
 
   // Make a tile fetcher if we havent passed one in from somewhere else
   if (!tile_getter_ && !tile_url_.empty()) {
@@ -511,6 +574,36 @@ GraphReader::GraphReader(const boost::property_tree::ptree& pt,
   }
 }
 
+GraphReader::GraphReader(const GraphReader& other)
+    : tile_extract_(other.tile_extract_), tile_dir_(other.tile_dir_),
+      tile_getter_(other.tile_getter_), max_concurrent_users_(other.max_concurrent_users_),
+      tile_url_(other.tile_url_), cache_config_(other.cache_config_),
+      shared_cache_(other.shared_cache_), shared_cache_lock_(other.shared_cache_lock_),
+      enable_incidents_(other.enable_incidents_) {
+  if (shared_cache_) {
+    cache_.reset(new SynchronizedTileCache(*shared_cache_, *shared_cache_lock_));
+    return;
+  }
+  // the global synchronized cache would hand the same tiles to several threads too
+  auto cache_config = cache_config_;
+  cache_config.put("global_synchronized_cache", false);
+  cache_.reset(TileCacheFactory::createTileCache(cache_config));
+  cache_->Reserve(tile_extract_->tiles.empty() ? AVERAGE_TILE_SIZE : AVERAGE_MM_TILE_SIZE);
+}
+
+std::unique_ptr<GraphReader> GraphReader::ShareTiles() {
+#ifdef ENABLE_THREAD_SAFE_TILE_REF_COUNT
+  // the first time we share, our own cache moves behind a lock that every sharing reader takes
+  if (!shared_cache_) {
+    shared_cache_ = std::move(cache_);
+    shared_cache_lock_ = std::make_shared<std::mutex>();
+    cache_.reset(new SynchronizedTileCache(*shared_cache_, *shared_cache_lock_));
+  }
+#endif
+  // otherwise the tile reference counts aren't atomic and the new reader caches its own tiles
+  return std::unique_ptr<GraphReader>(new GraphReader(*this));
+}
+
 // Method to test if tile exists
 bool GraphReader::DoesTileExist(const GraphId& graphid) const {
   if (!graphid.Is_Valid() || graphid.level() > TileHierarchy::get_max_level()) {
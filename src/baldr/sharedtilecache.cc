@@ -0,0 +1,705 @@
+#include "baldr/graphreader.h"
+#include "midgard/logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// there is no posix shared memory on windows, the factory doesn't make these caches there
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t kSegmentMagic = 0x56414c4854494c45; // VALHTILE
+constexpr uint32_t kSegmentVersion = 2;
+
+// tiles take up a run of blocks in the segment
+constexpr size_t kBlockSize = 64 * 1024;
+constexpr size_t kPageSize = 4096;
+
+// the graphid of an entry which holds no tile
+constexpr uint64_t kEmptyEntry = std::numeric_limits<uint64_t>::max();
+// the end of a list of entries or an empty slot in the hash table
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+// processes using a segment at once, each has a bit in the entries of the tiles it holds
+constexpr uint32_t kMaxProcesses = 64;
+
+// how long to wait for the process that makes the segment to set it up
+constexpr std::chrono::seconds kSetupTimeout{10};
+
+// how many segments of other tilesets a process may find in a row before it gives up
+constexpr int kMaxOpenAttempts = 5;
+
+// how often a process that can't make room looks for dead processes to reclaim tiles from
+constexpr std::chrono::seconds kReclaimInterval{1};
+
+size_t align(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// The start time of a process, which tells it apart from a later one that got the same pid. 0 when
+// it isn't known
+uint64_t process_start(pid_t pid) {
+#ifdef __linux__
+  std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+  std::string stat;
+  if (!std::getline(file, stat)) {
+    return 0;
+  }
+  // the program name is in parentheses and can hold spaces, the start time is the 20th field after
+  auto name_end = stat.rfind(')');
+  if (name_end == std::string::npos) {
+    return 0;
+  }
+  std::istringstream fields(stat.substr(name_end + 1));
+  std::string field;
+  for (int i = 0; i < 19 && fields >> field; ++i) {
+  }
+  uint64_t start = 0;
+  fields >> start;
+  return start;
+#else
+  return 0;
+#endif
+}
+
+// A process using the segment, the slot is free while pid is 0
+struct ProcessSlot {
+  pid_t pid;
+  uint64_t start;
+};
+
+// The start of the segment, followed by the entries, the hash table over them, a bitmap of the
+// blocks in use and the blocks themselves
+struct SegmentHeader {
+  std::atomic<uint64_t> magic;
+  uint32_t version;
+  // the tileset the tiles come from, a segment of another one is retired once it is unlinked
+  uint64_t fingerprint;
+  bool retired;
+  // every tile takes at least one block so there are as many entries as blocks
+  uint32_t block_count;
+  uint32_t table_size;
+  uint64_t entries_offset;
+  uint64_t table_offset;
+  uint64_t bitmap_offset;
+  uint64_t blocks_offset;
+  // the list of entries which hold no tile
+  uint32_t free_head;
+  // the ready tiles which no process holds, most recently released first
+  uint32_t lru_head;
+  uint32_t lru_tail;
+  // guards everything but the contents of the blocks
+  pthread_mutex_t mutex;
+  ProcessSlot processes[kMaxProcesses];
+};
+
+// A tile in the segment. The hash table refers to these so they never move while they hold a tile
+struct SegmentEntry {
+  uint64_t graphid;
+  uint64_t size;
+  // a bit for each process slot whose process holds the tile
+  uint64_t holders;
+  uint32_t first_block;
+  // links in the lru list, or next in the free list
+  uint32_t prev;
+  uint32_t next;
+  // whether the tile has been copied into its blocks yet
+  bool ready;
+};
+
+} // namespace
+
+namespace valhalla {
+namespace baldr {
+
+struct SharedTileCache::Segment {
+  Segment(const std::string& name, size_t segment_size, uint64_t fingerprint)
+      : fingerprint(fingerprint), process(getpid()) {
+    // a segment filled from another tileset is replaced by a new one
+    for (int attempt = 0; !Open(name, segment_size, fingerprint); ++attempt) {
+      if (attempt == kMaxOpenAttempts) {
+        throw std::runtime_error("Shared tile cache " + name + " keeps being replaced");
+      }
+    }
+
+    auto* bytes = static_cast<char*>(base);
+    entries = reinterpret_cast<SegmentEntry*>(bytes + header->entries_offset);
+    table = reinterpret_cast<uint32_t*>(bytes + header->table_offset);
+    bitmap = reinterpret_cast<uint64_t*>(bytes + header->bitmap_offset);
+    blocks = bytes + header->blocks_offset;
+    refs.resize(header->block_count, 0);
+
+    // take a slot, freeing those of processes that died without giving theirs back on the way
+    guard_t guard(*this);
+    ReclaimDead();
+    for (slot = 0; slot < kMaxProcesses && header->processes[slot].pid; ++slot) {
+    }
+    if (slot == kMaxProcesses) {
+      munmap(base, size);
+      throw std::runtime_error("Shared tile cache " + name + " is used by too many processes");
+    }
+    header->processes[slot].pid = getpid();
+    header->processes[slot].start = process_start(getpid());
+  }
+
+  ~Segment() {
+    // every tile memory holds on to the segment so by now this process holds no tiles
+    {
+      guard_t guard(*this);
+      header->processes[slot].pid = 0;
+    }
+    munmap(base, size);
+  }
+
+  // Maps the segment, making and setting it up if this is the first process to get here. Returns
+  // false if it was filled from another tileset, it is then unlinked to make way for a new one
+  bool Open(const std::string& name, size_t segment_size, uint64_t fingerprint) {
+    bool owner = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1 && errno == EEXIST) {
+      owner = false;
+      fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd == -1) {
+      throw std::runtime_error("Could not open shared tile cache " + name + ": " +
+                               std::strerror(errno));
+    }
+
+    // the others map it at the size it was made with. the memory is allocated up front as writing
+    // to a page that doesn't fit into the shared memory filesystem would be a SIGBUS
+    if (owner) {
+      size = segment_size;
+      int error = ftruncate(fd, size) == -1 ? errno : 0;
+#ifdef __linux__
+      if (!error) {
+        error = posix_fallocate(fd, 0, size);
+      }
+#endif
+      if (error) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Could not allocate " + std::to_string(size) +
+                                 " bytes for shared tile cache " + name + ": " +
+                                 std::strerror(error));
+      }
+    } else {
+      struct stat st {};
+      auto deadline = std::chrono::steady_clock::now() + kSetupTimeout;
+      while (fstat(fd, &st) == 0 && st.st_size == 0 &&
+             std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      size = st.st_size;
+    }
+    base = size ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (base == MAP_FAILED) {
+      throw std::runtime_error("Could not map shared tile cache " + name);
+    }
+    header = static_cast<SegmentHeader*>(base);
+
+    if (owner) {
+      Setup(fingerprint);
+    } else {
+      auto deadline = std::chrono::steady_clock::now() + kSetupTimeout;
+      while (header->magic.load(std::memory_order_acquire) != kSegmentMagic &&
+             std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      if (header->magic.load(std::memory_order_acquire) != kSegmentMagic ||
+          header->version != kSegmentVersion) {
+        munmap(base, size);
+        throw std::runtime_error("Shared tile cache " + name + " was not set up in time");
+      }
+    }
+
+    // only the first process of another tileset to get here unlinks it, the processes still using
+    // it keep it alive until they unmap it
+    bool retired = false;
+    {
+      guard_t guard(*this);
+      if (header->fingerprint != fingerprint || header->retired) {
+        if (!header->retired) {
+          LOG_WARN("Replacing shared tile cache " + name + " filled from another tileset");
+          header->retired = true;
+          shm_unlink(name.c_str());
+        }
+        retired = true;
+      }
+    }
+    if (retired) {
+      munmap(base, size);
+    }
+    return !retired;
+  }
+
+  // Lays out the segment and marks it as ready for the other processes
+  void Setup(uint64_t fingerprint) {
+    auto header_size = align(sizeof(SegmentHeader), 64);
+    auto per_block = kBlockSize + sizeof(SegmentEntry) + 2 * sizeof(uint32_t) + 1;
+    if (size < header_size + kPageSize + per_block) {
+      munmap(base, size);
+      throw std::runtime_error("Shared tile cache is too small to hold any tiles");
+    }
+    header->block_count = (size - header_size - kPageSize) / per_block;
+    // the table is at most half full so probing stays short
+    header->table_size = 2 * header->block_count;
+    header->entries_offset = header_size;
+    header->table_offset =
+        align(header->entries_offset + header->block_count * sizeof(SegmentEntry), 8);
+    header->bitmap_offset =
+        align(header->table_offset + header->table_size * sizeof(uint32_t), 8);
+    header->blocks_offset =
+        align(header->bitmap_offset + (header->block_count + 63) / 64 * 8, kPageSize);
+    header->version = kSegmentVersion;
+    header->fingerprint = fingerprint;
+
+    // every entry is free and the table is empty, the bitmap and process slots are already zeroed
+    // by ftruncate
+    auto* bytes = static_cast<char*>(base);
+    auto* all_entries = reinterpret_cast<SegmentEntry*>(bytes + header->entries_offset);
+    for (uint32_t i = 0; i < header->block_count; ++i) {
+      all_entries[i].graphid = kEmptyEntry;
+      all_entries[i].next = i + 1 < header->block_count ? i + 1 : kNone;
+    }
+    auto* all_slots = reinterpret_cast<uint32_t*>(bytes + header->table_offset);
+    std::fill(all_slots, all_slots + header->table_size, kNone);
+    header->free_head = 0;
+    header->lru_head = header->lru_tail = kNone;
+
+    // a process may die while holding the lock, where possible the next one to lock it recovers
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+#ifdef __linux__
+    pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+#endif
+    pthread_mutex_init(&header->mutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+
+    header->magic.store(kSegmentMagic, std::memory_order_release);
+  }
+
+  // Locks the segment for the lifetime of the guard. The threads of this process take turns on a
+  // mutex of their own first, only one of them at a time contends with the other processes
+  struct guard_t {
+    explicit guard_t(Segment& segment) : local(segment.local_mutex), mutex(segment.header->mutex) {
+      int result = pthread_mutex_lock(&mutex);
+#ifdef __linux__
+      // the tiles a dead owner held or was copying are reclaimed with the rest of its tiles
+      if (result == EOWNERDEAD) {
+        pthread_mutex_consistent(&mutex);
+        result = 0;
+      }
+#endif
+      if (result != 0) {
+        throw std::runtime_error("Could not lock shared tile cache");
+      }
+    }
+    ~guard_t() {
+      pthread_mutex_unlock(&mutex);
+    }
+    std::lock_guard<std::mutex> local;
+    pthread_mutex_t& mutex;
+  };
+
+  // The entry of a tile or kNone if it isn't in the segment, only call while locked
+  uint32_t Find(uint64_t graphid) const {
+    for (uint32_t i = Hash(graphid); table[i] != kNone; i = (i + 1) % header->table_size) {
+      if (entries[table[i]].graphid == graphid) {
+        return table[i];
+      }
+    }
+    return kNone;
+  }
+
+  // Makes room for a tile and adds it, held by this process and not ready. Returns kNone if there
+  // isn't enough room even after evicting all the tiles nobody holds. Only call while locked
+  uint32_t Insert(uint64_t graphid, size_t tile_size) {
+    uint32_t count = (tile_size + kBlockSize - 1) / kBlockSize;
+    uint32_t first_block;
+    while (!FindBlocks(count, first_block)) {
+      if (!EvictOne() && !ReclaimDeadThrottled()) {
+        return kNone;
+      }
+    }
+
+    // there is a free entry as long as there is a free block
+    uint32_t index = header->free_head;
+    auto& entry = entries[index];
+    header->free_head = entry.next;
+    entry.graphid = graphid;
+    entry.size = tile_size;
+    entry.first_block = first_block;
+    entry.holders = uint64_t(1) << slot;
+    entry.prev = entry.next = kNone;
+    entry.ready = false;
+    refs[index] = 1;
+    for (uint32_t block = first_block; block < first_block + count; ++block) {
+      bitmap[block / 64] |= uint64_t(1) << (block % 64);
+    }
+
+    uint32_t i = Hash(graphid);
+    while (table[i] != kNone) {
+      i = (i + 1) % header->table_size;
+    }
+    table[i] = index;
+    return index;
+  }
+
+  // Adds a reference of this process to a ready tile, only call while locked
+  void Hold(uint32_t index) {
+    auto& entry = entries[index];
+    if (refs[index]++ == 0) {
+      if (!entry.holders) {
+        Unlink(index);
+      }
+      entry.holders |= uint64_t(1) << slot;
+    }
+  }
+
+  // Drops a reference of this process to a tile, it can be evicted once no process holds it
+  void Release(uint32_t index) {
+    guard_t guard(*this);
+    auto& entry = entries[index];
+    if (--refs[index] == 0) {
+      entry.holders &= ~(uint64_t(1) << slot);
+      if (!entry.holders) {
+        // a tile that was never copied is of no use to anyone
+        if (entry.ready) {
+          LinkFront(index);
+        } else {
+          Remove(index);
+        }
+      }
+    }
+  }
+
+  const SegmentEntry& Entry(uint32_t index) const {
+    return entries[index];
+  }
+
+  // Marks a tile this process inserted as copied, only call while locked
+  void Ready(uint32_t index) {
+    entries[index].ready = true;
+  }
+
+  char* Data(uint32_t index) const {
+    return blocks + static_cast<size_t>(entries[index].first_block) * kBlockSize;
+  }
+
+  // the tileset this process fills the segment from and the process whose slot it has, a child
+  // forked off of it needs a slot of its own
+  const uint64_t fingerprint;
+  const pid_t process;
+
+protected:
+  uint32_t Hash(uint64_t graphid) const {
+    return (graphid * 0x9E3779B97F4A7C15ull >> 32) % header->table_size;
+  }
+
+  // First fit search for a run of free blocks, full words of the bitmap are skipped whole
+  bool FindBlocks(uint32_t count, uint32_t& first_block) const {
+    uint32_t run = 0;
+    for (uint32_t block = 0; block < header->block_count;) {
+      if (block % 64 == 0 && bitmap[block / 64] == ~uint64_t(0)) {
+        run = 0;
+        block += 64;
+        continue;
+      }
+      if (bitmap[block / 64] & (uint64_t(1) << (block % 64))) {
+        run = 0;
+      } else if (++run == count) {
+        first_block = block + 1 - count;
+        return true;
+      }
+      ++block;
+    }
+    return false;
+  }
+
+  // Evicts the least recently released tile that nobody holds, false if there is none
+  bool EvictOne() {
+    if (header->lru_tail == kNone) {
+      return false;
+    }
+    Remove(header->lru_tail);
+    return true;
+  }
+
+  // Takes a tile out of the lru list, the hash table and its blocks and frees its entry
+  void Remove(uint32_t index) {
+    auto& entry = entries[index];
+    if (entry.ready && !entry.holders) {
+      Unlink(index);
+    }
+    uint32_t count = (entry.size + kBlockSize - 1) / kBlockSize;
+    for (uint32_t block = entry.first_block; block < entry.first_block + count; ++block) {
+      bitmap[block / 64] &= ~(uint64_t(1) << (block % 64));
+    }
+
+    // rather than leave a tombstone, the tiles after the hole that can no longer be found past it
+    // are shifted back into it
+    uint32_t hole = Hash(entry.graphid);
+    while (table[hole] != index) {
+      hole = (hole + 1) % header->table_size;
+    }
+    table[hole] = kNone;
+    for (uint32_t i = (hole + 1) % header->table_size; table[i] != kNone;
+         i = (i + 1) % header->table_size) {
+      uint32_t home = Hash(entries[table[i]].graphid);
+      bool reachable = hole < i ? hole < home && home <= i : hole < home || home <= i;
+      if (!reachable) {
+        table[hole] = table[i];
+        table[i] = kNone;
+        hole = i;
+      }
+    }
+
+    entry.graphid = kEmptyEntry;
+    entry.next = header->free_head;
+    header->free_head = index;
+  }
+
+  void LinkFront(uint32_t index) {
+    auto& entry = entries[index];
+    entry.prev = kNone;
+    entry.next = header->lru_head;
+    if (header->lru_head != kNone) {
+      entries[header->lru_head].prev = index;
+    } else {
+      header->lru_tail = index;
+    }
+    header->lru_head = index;
+  }
+
+  void Unlink(uint32_t index) {
+    auto& entry = entries[index];
+    (entry.prev != kNone ? entries[entry.prev].next : header->lru_head) = entry.next;
+    (entry.next != kNone ? entries[entry.next].prev : header->lru_tail) = entry.prev;
+    entry.prev = entry.next = kNone;
+  }
+
+  // Only looks for dead processes every so often as it reads every process slot and entry
+  bool ReclaimDeadThrottled() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_reclaim < kReclaimInterval) {
+      return false;
+    }
+    last_reclaim = now;
+    return ReclaimDead();
+  }
+
+  // Frees the slots of processes that died without giving them back, the tiles they held can be
+  // evicted again and those they were copying are removed. Returns whether any tiles were affected
+  bool ReclaimDead() {
+    uint64_t dead = 0;
+    for (uint32_t other = 0; other < kMaxProcesses; ++other) {
+      const auto& process = header->processes[other];
+      if (!process.pid || process.pid == getpid()) {
+        continue;
+      }
+      // a process we may not signal is still alive, a reused pid has another start time
+      if ((kill(process.pid, 0) == -1 && errno == ESRCH) ||
+          (process.start && process_start(process.pid) != process.start)) {
+        LOG_WARN("Reclaiming shared tiles of dead process " + std::to_string(process.pid));
+        dead |= uint64_t(1) << other;
+        header->processes[other].pid = 0;
+      }
+    }
+    if (!dead) {
+      return false;
+    }
+
+    bool reclaimed = false;
+    for (uint32_t index = 0; index < header->block_count; ++index) {
+      auto& entry = entries[index];
+      if (entry.graphid == kEmptyEntry || !(entry.holders & dead)) {
+        continue;
+      }
+      reclaimed = true;
+      entry.holders &= ~dead;
+      if (!entry.ready) {
+        Remove(index);
+      } else if (!entry.holders) {
+        LinkFront(index);
+      }
+    }
+    return reclaimed;
+  }
+
+  void* base;
+  size_t size;
+  SegmentHeader* header;
+  SegmentEntry* entries;
+  uint32_t* table;
+  uint64_t* bitmap;
+  char* blocks;
+  // the process slot of this segment and how many tile memories of this process use each entry,
+  // only touched while locked
+  uint32_t slot;
+  std::vector<uint32_t> refs;
+  std::chrono::steady_clock::time_point last_reclaim;
+  std::mutex local_mutex;
+};
+
+namespace {
+
+// The segment of this process by the given name, all the caches of a process use the same mapping
+// and process slot of a segment for as long as any of them (or their tiles) is around
+std::shared_ptr<SharedTileCache::Segment>
+open_segment(const std::string& name, size_t segment_size, uint64_t fingerprint) {
+  static std::mutex lock;
+  static std::unordered_map<std::string, std::weak_ptr<SharedTileCache::Segment>> segments;
+  std::lock_guard<std::mutex> guard(lock);
+  auto& known = segments[name];
+  auto segment = known.lock();
+  // the one of another tileset is replaced, its caches keep using it until they go away
+  if (!segment || segment->fingerprint != fingerprint || segment->process != getpid()) {
+    segment = std::make_shared<SharedTileCache::Segment>(name, segment_size, fingerprint);
+    known = segment;
+  }
+  return segment;
+}
+
+// The memory of a tile in the segment, holds a reference to the tile for as long as it lives
+class SegmentGraphMemory final : public GraphMemory {
+public:
+  SegmentGraphMemory(std::shared_ptr<SharedTileCache::Segment> segment, uint32_t index)
+      : segment_(std::move(segment)), index_(index) {
+    data = segment_->Data(index_);
+    size = segment_->Entry(index_).size;
+  }
+  ~SegmentGraphMemory() override {
+    segment_->Release(index_);
+  }
+
+private:
+  std::shared_ptr<SharedTileCache::Segment> segment_;
+  uint32_t index_;
+};
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// SharedTileCache implementation
+// ----------------------------------------------------------------------------
+
+// Constructor.
+SharedTileCache::SharedTileCache(const std::string& name,
+                                 size_t segment_size,
+                                 size_t max_size,
+                                 uint64_t fingerprint)
+    : segment_(open_segment(name, segment_size, fingerprint)), local_(max_size) {
+}
+
+// Reserves enough cache to hold (max_cache_size / tile_size) items.
+void SharedTileCache::Reserve(size_t tile_size) {
+  local_.Reserve(tile_size);
+}
+
+// Checks if tile exists in the cache.
+bool SharedTileCache::Contains(const GraphId& graphid) const {
+  if (local_.Contains(graphid)) {
+    return true;
+  }
+  Segment::guard_t guard(*segment_);
+  auto index = segment_->Find(graphid.value);
+  return index != kNone && segment_->Entry(index).ready;
+}
+
+// Puts a copy of a tile into the segment and the tile over that copy into the cache.
+graph_tile_ptr SharedTileCache::Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) {
+  if (!tile || !tile->header()) {
+    return local_.Put(graphid, std::move(tile), size);
+  }
+  size_t tile_size = tile->header()->end_offset();
+
+  // get the tile if another process put it already or else make room for it
+  uint32_t index = kNone;
+  bool copy = false;
+  {
+    Segment::guard_t guard(*segment_);
+    index = segment_->Find(graphid.value);
+    if (index == kNone) {
+      index = segment_->Insert(graphid.value, tile_size);
+      copy = index != kNone;
+    } else if (!segment_->Entry(index).ready) {
+      index = kNone;
+    } else {
+      segment_->Hold(index);
+    }
+  }
+
+  // without room in the segment or while another process is copying it we keep our own
+  if (index == kNone) {
+    return local_.Put(graphid, std::move(tile), size);
+  }
+
+  // copy it outside of the lock, the other processes skip it until its ready. if this process
+  // dies before then the tile is removed when its slot is reclaimed
+  auto memory = std::make_unique<SegmentGraphMemory>(segment_, index);
+  if (copy) {
+    std::memcpy(memory->data, tile->header(), tile_size);
+    Segment::guard_t guard(*segment_);
+    segment_->Ready(index);
+  }
+  return local_.Put(graphid, GraphTile::Create(graphid, std::move(memory)), size);
+}
+
+// Get a pointer to a graph tile object given a GraphId.
+graph_tile_ptr SharedTileCache::Get(const GraphId& graphid) const {
+  if (auto tile = local_.Get(graphid)) {
+    return tile;
+  }
+
+  // another process may have put it into the segment
+  uint32_t index = kNone;
+  {
+    Segment::guard_t guard(*segment_);
+    index = segment_->Find(graphid.value);
+    if (index == kNone || !segment_->Entry(index).ready) {
+      return nullptr;
+    }
+    segment_->Hold(index);
+  }
+  auto memory = std::make_unique<SegmentGraphMemory>(segment_, index);
+  size_t size = memory->size;
+  return local_.Put(graphid, GraphTile::Create(graphid, std::move(memory)), size);
+}
+
+// Lets you know if the cache is too large.
+bool SharedTileCache::OverCommitted() const {
+  return local_.OverCommitted();
+}
+
+// Clears the cache.
+void SharedTileCache::Clear() {
+  local_.Clear();
+}
+
+void SharedTileCache::Trim() {
+  local_.Trim();
+}
+
+} // namespace baldr
+} // namespace valhalla
+#endif
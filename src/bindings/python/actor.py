@@ -49,6 +49,20 @@ class Actor(_Actor):
     def trace_attributes(self, req: Union[str, dict]):
         return super().trace_attributes(req)
 
+    @dict_or_str
+    def trace_attributes_batch(self, req: Union[str, dict]):
+        return super().trace_attributes_batch(req)
+
+    def batch(self, action: str, reqs: list):
+        # dict requests get dict responses, str requests get str responses
+        results = super().batch(
+            action, [json.dumps(req) if isinstance(req, dict) else req for req in reqs]
+        )
+        return [
+            json.loads(result) if isinstance(req, dict) else result
+            for req, result in zip(reqs, results)
+        ]
+
     @dict_or_str
     def height(self, req: Union[str, dict]):
         return super().height(req)
@@ -1,4 +1,5 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 #include "baldr/rapidjson_utils.h"
 #include <boost/make_shared.hpp>
@@ -63,6 +64,22 @@ PYBIND11_MODULE(python_valhalla, m) {
           "trace_attributes",
           [](vt::actor_t& self, std::string& req) { return self.trace_attributes(req); },
           "Returns detailed attribution along each portion of a route calculated from a set of input locations, e.g. from a GPS trace.")
+      .def(
+          "trace_attributes_batch",
+          [](vt::actor_t& self, std::string& req) { return self.trace_attributes_batch(req); },
+          py::call_guard<py::gil_scoped_release>(),
+          "Returns the trace_attributes response for each of a batch of traces, matched in parallel.")
+      .def(
+          "batch",
+          [](vt::actor_t& self, const std::string& action, const std::vector<std::string>& reqs) {
+            valhalla::Options::Action parsed;
+            if (!valhalla::Options_Action_Enum_Parse(action, &parsed)) {
+              throw std::invalid_argument("Unknown action: " + action);
+            }
+            return self.batch(parsed, reqs);
+          },
+          py::call_guard<py::gil_scoped_release>(),
+          "Returns the response for each of a batch of requests of one action, computed in parallel.")
       .def(
           "height", [](vt::actor_t& self, std::string& req) { return self.height(req); },
           "Provides elevation data for a set of input geometries.")
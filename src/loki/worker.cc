@@ -365,7 +365,7 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
   // grab the request info and make sure to record any metrics before we are done
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Loki Request " + std::to_string(info.id));
-  Api request;
+  Api& request = make_request();
   prime_server::worker_t::result_t result{true, {}, ""};
   try {
     // request parsing
@@ -380,6 +380,9 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
       throw valhalla_exception_t{106, action_str};
     }
 
+    // turn it away early if there is already too much work like it in flight
+    admit(request);
+
     // Set the interrupt function
     service_worker_t::set_interrupt(&interrupt_function);
     // do request specific processing
@@ -387,7 +390,7 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
       case Options::route:
       case Options::centroid:
         route(request);
-        result.messages.emplace_back(request.SerializeAsString());
+        result.messages.emplace_back(forward_request(request));
         break;
       case Options::locate:
         result = to_response(locate(request), info, request);
@@ -395,16 +398,16 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
       case Options::sources_to_targets:
       case Options::optimized_route:
         matrix(request);
-        result.messages.emplace_back(request.SerializeAsString());
+        result.messages.emplace_back(forward_request(request));
         break;
       case Options::isochrone:
         isochrones(request);
-        result.messages.emplace_back(request.SerializeAsString());
+        result.messages.emplace_back(forward_request(request));
         break;
       case Options::trace_attributes:
       case Options::trace_route:
         trace(request);
-        result.messages.emplace_back(request.SerializeAsString());
+        result.messages.emplace_back(forward_request(request));
         break;
       case Options::height:
         result = to_response(height(request), info, request);
@@ -414,7 +417,7 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
         break;
       case Options::status:
         status(request);
-        result.messages.emplace_back(request.SerializeAsString());
+        result.messages.emplace_back(forward_request(request));
         break;
       case Options::expansion:
         if (options.expansion_action() == Options::route) {
@@ -424,7 +427,7 @@ loki_worker_t::work(const std::list<zmq::message_t>& job,
         } else {
           matrix(request);
         }
-        result.messages.emplace_back(request.SerializeAsString());
+        result.messages.emplace_back(forward_request(request));
         break;
       default:
         // apparently you wanted something that we figured we'd support but havent written yet
@@ -2,6 +2,8 @@
 #include "baldr/tilehierarchy.h"
 #include "meili/geometry_helpers.h"
 
+#include <boost/functional/hash.hpp>
+
 using namespace valhalla::midgard;
 
 namespace valhalla {
@@ -168,10 +170,99 @@ void IndexBin(const graph_tile_ptr& tile,
   }
 }
 
+size_t CandidateGridCache::KeyHasher::operator()(const Key& key) const {
+  size_t seed = std::hash<uint64_t>{}(key.tile_id);
+  boost::hash_combine(seed, key.bin_index);
+  boost::hash_combine(seed, key.tile_fingerprint);
+  boost::hash_combine(seed, key.cell_width);
+  boost::hash_combine(seed, key.cell_height);
+  boost::hash_combine(seed, key.tileset);
+  return seed;
+}
+
+CandidateGridCache& CandidateGridCache::Global() {
+  static CandidateGridCache cache;
+  return cache;
+}
+
+CandidateGridCache::CandidateGridCache(size_t max_bytes) : max_bytes_(max_bytes), bytes_(0) {
+}
+
+void CandidateGridCache::Reserve(size_t max_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_bytes_ = std::max(max_bytes_, max_bytes);
+}
+
+std::shared_ptr<const CandidateGridCache::grid_t> CandidateGridCache::Find(const Key& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = entries_.find(key);
+  if (found == entries_.end()) {
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, found->second.lru);
+  return found->second.grid;
+}
+
+std::shared_ptr<const CandidateGridCache::grid_t>
+CandidateGridCache::Insert(const Key& key, std::shared_ptr<const grid_t> grid) {
+  // measure it before taking the lock, it walks the whole grid
+  const auto grid_bytes = grid->MemoryUsage();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = entries_.find(key);
+  if (found != entries_.end()) {
+    lru_.splice(lru_.begin(), lru_, found->second.lru);
+    return found->second.grid;
+  }
+
+  // a grid bigger than the whole cache is only used by the caller
+  if (grid_bytes > max_bytes_) {
+    return grid;
+  }
+
+  lru_.push_front(key);
+  entries_.emplace(key, Entry{grid, grid_bytes, lru_.begin()});
+  bytes_ += grid_bytes;
+  Evict();
+  return grid;
+}
+
+void CandidateGridCache::Evict() {
+  while (bytes_ > max_bytes_ && !lru_.empty()) {
+    auto found = entries_.find(lru_.back());
+    bytes_ -= found->second.bytes;
+    entries_.erase(found);
+    lru_.pop_back();
+  }
+}
+
+void CandidateGridCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  lru_.clear();
+  bytes_ = 0;
+}
+
+size_t CandidateGridCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t CandidateGridCache::bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+size_t CandidateGridCache::max_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_bytes_;
+}
+
 CandidateGridQuery::CandidateGridQuery(baldr::GraphReader& reader,
                                        float cell_width,
-                                       float cell_height)
-    : reader_(reader), cell_width_(cell_width), cell_height_(cell_height), grid_cache_() {
+                                       float cell_height,
+                                       CandidateGridCache* shared_cache)
+    : reader_(reader), cell_width_(cell_width), cell_height_(cell_height), grid_cache_(),
+      shared_cache_(shared_cache) {
   bin_level_ = baldr::TileHierarchy::levels().back().level;
 }
 
@@ -184,7 +275,7 @@ CandidateGridQuery::GetGrid(const int32_t bin_id,
   // Check if the bin is in the cache
   const auto it = grid_cache_.find(bin_id);
   if (it != grid_cache_.end()) {
-    return &(it->second);
+    return it->second.get();
   }
 
   // Not in the cache. Get the tile and Index the bin within the tile.
@@ -202,11 +293,30 @@ CandidateGridQuery::GetGrid(const int32_t bin_id,
   int32_t bin_col = rc.second % ndiv;
   int32_t bin_index = (bin_row * ndiv) + bin_col;
 
-  // Insert the bin into the cache and index the bin
-  const auto inserted =
-      grid_cache_.emplace(bin_id, grid_t(tile->BoundingBox(), cell_width_, cell_height_));
-  IndexBin(tile, bin_index, reader_, inserted.first->second);
-  return &(inserted.first->second);
+  // Maybe another query already indexed this bin
+  CandidateGridCache::Key key;
+  if (shared_cache_) {
+    const auto* header = tile->header();
+    size_t fingerprint = std::hash<uint64_t>{}(header->dataset_id());
+    boost::hash_combine(fingerprint, header->date_created());
+    boost::hash_combine(fingerprint, header->end_offset());
+    boost::hash_combine(fingerprint, header->directededgecount());
+    boost::hash_combine(fingerprint, header->nodecount());
+    key = {reader_.GetTileSetLocation(), fingerprint, tileid.value, bin_index, cell_width_,
+           cell_height_};
+    if (auto grid = shared_cache_->Find(key)) {
+      return grid_cache_.emplace(bin_id, std::move(grid)).first->second.get();
+    }
+  }
+
+  // Index the bin and insert it into the cache(s)
+  auto grid = std::make_shared<grid_t>(tile->BoundingBox(), cell_width_, cell_height_);
+  IndexBin(tile, bin_index, reader_, *grid);
+  std::shared_ptr<const grid_t> cached = std::move(grid);
+  if (shared_cache_) {
+    cached = shared_cache_->Insert(key, std::move(cached));
+  }
+  return grid_cache_.emplace(bin_id, std::move(cached)).first->second.get();
 }
 
 std::unordered_set<baldr::GraphId>
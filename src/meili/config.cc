@@ -37,6 +37,7 @@ void Config::Read(const boost::property_tree::ptree& params) {
   transition_cost.Read(params);
   emission_cost.Read(params);
   routing.Read(params);
+  viterbi.Read(params);
 }
 
 void Config::CandidateSearch::Read(const boost::property_tree::ptree& params) {
@@ -54,6 +55,7 @@ void Config::CandidateSearch::Read(const boost::property_tree::ptree& params) {
 
   ReadParamOptional(cache_size, params, "grid.cache_size");
   ReadParamOptional(grid_size, params, "grid.size");
+  ReadParamOptional(shared_cache_size, params, "grid.shared_cache_size");
 }
 
 void Config::TransitionCost::Read(const boost::property_tree::ptree& params) {
@@ -108,5 +110,14 @@ void Config::Routing::Read(const boost::property_tree::ptree& params) {
   }
 }
 
+void Config::Viterbi::Read(const boost::property_tree::ptree& params) {
+  ReadParamOptional(fixed_lag, params, "viterbi.fixed_lag");
+  ReadParamOptional(beam_width, params, "viterbi.beam_width");
+
+  ReadParamOptional(beam_cost_margin, params, "viterbi.beam_cost_margin");
+  CHECK_THROWS(beam_cost_margin >= 0.f,
+               NONNEGATIVE_VALUE_MSG(beam_cost_margin, "beam_cost_margin"));
+}
+
 } // namespace meili
 } // namespace valhalla
\ No newline at end of file
@@ -505,6 +505,7 @@ MapMatcher::MapMatcher(const Config& config,
                              config_.transition_cost) {
   vs_.set_emission_cost_model(emission_cost_model_);
   vs_.set_transition_cost_model(transition_cost_model_);
+  vs_.set_beam(config_.viterbi.beam_width, config_.viterbi.beam_cost_margin);
 }
 
 MapMatcher::~MapMatcher() {
@@ -514,6 +515,7 @@ void MapMatcher::Clear() {
   vs_.Clear();
   // reset cost models because they were possibly replaced by topk
   vs_.set_emission_cost_model(emission_cost_model_);
+  transition_cost_model_.Clear();
   vs_.set_transition_cost_model(transition_cost_model_);
   ts_.Clear();
   container_.Clear();
@@ -705,6 +707,9 @@ std::vector<MatchResults> MapMatcher::OfflineMatch(const std::vector<Measurement
 
   bool found_discontinuity = false;
 
+  // Committed columns can't be searched again so alternatives need the whole search
+  vs_.set_fixed_lag(config_.viterbi.fixed_lag && k == 1);
+
   // Separate the measurements we are using for matching from the ones we'll just interpolate
   auto interpolated = AppendMeasurements(measurements);
   // Without minimum number of edge candidates, throw a 443 - NoSegment error code.
@@ -28,9 +28,15 @@ MapMatcherFactory::MapMatcherFactory(const boost::property_tree::ptree& root,
     : config_(root.get_child("meili")), graphreader_(graph_reader) {
   if (!graphreader_)
     graphreader_.reset(new baldr::GraphReader(root.get_child("mjolnir")));
+  // grids are shared process wide unless turned off
+  CandidateGridCache* shared_cache = nullptr;
+  if (config_.candidate_search.shared_cache_size > 0) {
+    shared_cache = &CandidateGridCache::Global();
+    shared_cache->Reserve(config_.candidate_search.shared_cache_size);
+  }
   candidatequery_.reset(
       new CandidateGridQuery(*graphreader_, local_tile_size() / config_.candidate_search.grid_size,
-                             local_tile_size() / config_.candidate_search.grid_size));
+                             local_tile_size() / config_.candidate_search.grid_size, shared_cache));
 }
 
 MapMatcherFactory::~MapMatcherFactory() {
@@ -15,8 +15,9 @@
 namespace valhalla {
 namespace meili {
 
-LabelSet::LabelSet(const float max_cost, const float bucket_size)
-    : queue_(0.0f, max_cost, bucket_size, &labels_) {
+LabelSet::LabelSet(const float max_cost, const float bucket_size, status_table_ptr_t status)
+    : queue_(0.0f, max_cost, bucket_size, &labels_),
+      status_(status ? std::move(status) : std::make_shared<StatusTable>()) {
 }
 
 void LabelSet::put(const baldr::GraphId& nodeid,
@@ -36,17 +37,17 @@ void LabelSet::put(const baldr::GraphId& nodeid,
 
   // Find the node Id. If not found, create a new label and push
   // it to the queue
-  const auto it = node_status_.find(nodeid);
-  if (it == node_status_.end()) {
+  const auto* found = status_->find(nodeid);
+  if (!found) {
     const uint32_t idx = labels_.size();
     labels_.emplace_back(nodeid, kInvalidDestination, edgeid, source, target, cost, turn_cost,
                          sortcost, predecessor, edge, mode, restriction_idx);
     queue_.add(idx);
-    node_status_.emplace(nodeid, idx);
+    status_->emplace(nodeid, idx);
   } else {
     // Node has been found. Check if there is a lower sortcost than the
     // existing label - if so update priority queue and Label
-    const auto& status = it->second;
+    const auto& status = *found;
     if (!status.permanent && sortcost < labels_[status.label_idx].sortcost()) {
       // Update queue first since it uses the label cost within the decrease
       // method to determine the current bucket.
@@ -76,16 +77,16 @@ void LabelSet::put(const uint16_t dest,
   // Find the destination. If not count, create a new label and push it
   // to the queue
   baldr::GraphId inv;
-  const auto it = dest_status_.find(dest);
-  if (it == dest_status_.end()) {
+  const auto* found = status_->find(dest);
+  if (!found) {
     const uint32_t idx = labels_.size();
     labels_.emplace_back(inv, dest, edgeid, source, target, cost, turn_cost, sortcost, predecessor,
                          edge, travelmode, restriction_idx);
     queue_.add(idx);
-    dest_status_.emplace(dest, idx);
+    status_->emplace(dest, idx);
   } else {
     // Decrease cost of the existing label
-    const auto& status = it->second;
+    const auto& status = *found;
     if (!status.permanent && sortcost < labels_[status.label_idx].sortcost()) {
       // Update queue first since it uses the label cost within the decrease
       // method to determine the current bucket.
@@ -106,15 +107,15 @@ uint32_t LabelSet::pop() {
   if (idx != baldr::kInvalidLabel) {
     const auto& label = labels_[idx];
     if (label.nodeid().Is_Valid()) {
-      const auto it = node_status_.find(label.nodeid());
+      auto* found = status_->find(label.nodeid());
 
       // When these logic errors happen, go check LabelSet::put
-      if (it == node_status_.end()) {
+      if (!found) {
         // No exception, unless BucketQueue::put was wrong: it said it
         // added but actually failed
         throw std::logic_error("all nodes in the queue should have its status");
       }
-      auto& status = it->second;
+      auto& status = *found;
       if (status.label_idx != idx) {
         throw std::logic_error(
             "the index stored in the node status " + std::to_string(status.label_idx) +
@@ -131,12 +132,12 @@ uint32_t LabelSet::pop() {
 
       status.permanent = true;
     } else { // assert(label.dest != kInvalidDestination)
-      const auto it = dest_status_.find(label.dest());
+      auto* found = status_->find(label.dest());
 
-      if (it == dest_status_.end()) {
+      if (!found) {
         throw std::logic_error("all dests in the queue should have its status");
       }
-      auto& status = it->second;
+      auto& status = *found;
       if (status.label_idx != idx) {
         throw std::logic_error(
             "the index stored in the dest status " + std::to_string(status.label_idx) +
@@ -470,6 +471,16 @@ find_shortest_path(baldr::GraphReader& reader,
     }
   };
 
+  // The status table is reused by the next search so it is handed back clean however this one
+  // ends, a tile that fails to load throws out of the middle of it
+  struct status_guard_t {
+    ~status_guard_t() {
+      labelset->clear_queue();
+      labelset->clear_status();
+    }
+    const labelset_ptr_t& labelset;
+  } status_guard{labelset};
+
   // Load origin to the queue of the labelset
   set_origin(reader, destinations, origin_idx, labelset, travelmode, costing, edgelabel);
 
@@ -611,9 +622,6 @@ find_shortest_path(baldr::GraphReader& reader,
       }
     }
   }
-  // TODO - do we need to clear since it is constructed prior to each call??
-  labelset->clear_queue();
-  labelset->clear_status();
   return results;
 }
 
@@ -1,11 +1,50 @@
 #include "meili/transition_cost_model.h"
 #include "meili/routing.h"
 
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <cstring>
+
 namespace {
 inline float GreatCircleDistance(const valhalla::meili::Measurement& left,
                                  const valhalla::meili::Measurement& right) {
   return left.lnglat().Distance(right.lnglat());
 }
+
+inline uint64_t bits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// Flattens the candidate edges of a location so two locations can be compared exactly
+void LocationSignature(const valhalla::baldr::PathLocation& location,
+                       std::vector<uint64_t>& signature) {
+  signature.push_back(location.edges.size());
+  for (const auto& edge : location.edges) {
+    signature.push_back(edge.id.value);
+    signature.push_back(bits(edge.percent_along));
+    signature.push_back(edge.begin_node() | edge.end_node() << 1);
+  }
+}
+
+// Flattens everything about the origin a route search depends on so two searches can be compared
+// exactly. The graph and the costing are the same for the whole lifetime of a matcher
+void OriginSignature(const valhalla::baldr::PathLocation& origin,
+                     const valhalla::meili::Label* edgelabel,
+                     std::vector<uint64_t>& signature) {
+  signature.clear();
+  // the incoming edge decides about uturns, turn costs and restrictions at the origin
+  if (edgelabel) {
+    signature.push_back(edgelabel->edgeid().value);
+    signature.push_back(edgelabel->restriction_idx());
+  } else {
+    signature.push_back(valhalla::baldr::kInvalidGraphId);
+    signature.push_back(0);
+  }
+  signature.push_back(static_cast<uint64_t>(origin.stoptype_));
+  LocationSignature(origin, signature);
+}
 } // namespace
 
 namespace valhalla {
@@ -26,7 +65,8 @@ TransitionCostModel::TransitionCostModel(baldr::GraphReader& graphreader,
       travelmode_(travelmode), beta_(beta), inv_beta_(1.f / beta_),
       breakage_distance_(breakage_distance), max_route_distance_factor_(max_route_distance_factor),
       max_route_time_factor_(max_route_time_factor),
-      turn_penalty_factor_(turn_penalty_factor), turn_cost_table_{0.f} {
+      turn_penalty_factor_(turn_penalty_factor), turn_cost_table_{0.f},
+      workspace_(std::make_shared<Workspace>()) {
   if (beta_ <= 0.f) {
     throw std::invalid_argument("Expect beta to be positive");
   }
@@ -149,13 +189,95 @@ void TransitionCostModel::UpdateRoute(const StateId& lhs, const StateId& rhs) co
     max_route_time = std::ceil(max_route_time);
   }
 
-  labelset_ptr_t labelset = std::make_shared<LabelSet>(max_route_distance);
-  const auto& results = find_shortest_path(graphreader_, locations, 0, labelset, approximator,
-                                           right_measurement.search_radius(),
-                                           mode_costing_[static_cast<size_t>(travelmode_)], edgelabel,
-                                           turn_cost_table_, max_route_distance, max_route_time);
+  // If a search from the same origin was done from this or the previous column we just take its
+  // results for the destinations of this one
+  AdvanceRoutes(lhs.time());
+  std::vector<uint64_t> origin;
+  OriginSignature(locations.front(), edgelabel, origin);
+  const auto hash = boost::hash_range(origin.begin(), origin.end());
+  std::vector<std::vector<uint64_t>> destinations(locations.size());
+  for (size_t i = 1; i < locations.size(); ++i) {
+    LocationSignature(locations[i], destinations[i]);
+  }
+  std::unordered_map<uint16_t, uint32_t> reused;
+  if (const auto* route =
+          FindRoute(origin, hash, max_route_distance, max_route_time, destinations, reused)) {
+    LOG_TRACE("Reusing the route searched from an identical previous state");
+    left.SetRoute(unreached_stateids, reused, route->labelset);
+    return;
+  }
+
+  labelset_ptr_t labelset = std::make_shared<LabelSet>(max_route_distance, 1.0f,
+                                                       workspace_->status);
+  auto results = find_shortest_path(graphreader_, locations, 0, labelset, approximator,
+                                    right_measurement.search_radius(),
+                                    mode_costing_[static_cast<size_t>(travelmode_)], edgelabel,
+                                    turn_cost_table_, max_route_distance, max_route_time);
 
   left.SetRoute(unreached_stateids, results, labelset);
+  workspace_->current_routes.push_back({std::move(origin), hash, max_route_distance, max_route_time,
+                                        std::move(destinations), std::move(results), labelset});
+}
+
+void TransitionCostModel::AdvanceRoutes(const StateId::Time time) const {
+  auto& workspace = *workspace_;
+  if (time == workspace.time) {
+    return;
+  }
+
+  // only the routes of the column right before can still be identical
+  if (workspace.time != kInvalidTime && time == workspace.time + 1) {
+    workspace.previous_routes.swap(workspace.current_routes);
+  } else {
+    workspace.previous_routes.clear();
+  }
+  workspace.current_routes.clear();
+  workspace.time = time;
+}
+
+const TransitionCostModel::ReusableRoute*
+TransitionCostModel::FindRoute(const std::vector<uint64_t>& origin,
+                               size_t hash,
+                               float max_dist,
+                               float max_time,
+                               const std::vector<std::vector<uint64_t>>& destinations,
+                               std::unordered_map<uint16_t, uint32_t>& results) const {
+  for (const auto* routes : {&workspace_->current_routes, &workspace_->previous_routes}) {
+    for (const auto& route : *routes) {
+      // the search has to have had the same bounds, the labels a search with looser ones keeps
+      // for a node may be beyond those of this one while a fresh search would have found others
+      if (route.hash != hash || route.origin != origin || route.max_dist != max_dist ||
+          route.max_time != max_time) {
+        continue;
+      }
+
+      // and to have looked for all of its destinations. the heuristic only decides about the order
+      // in which labels are settled so what it found are the shortest paths and what it didn't
+      // find is out of reach
+      results.clear();
+      bool covered = true;
+      for (size_t i = 1; i < destinations.size() && covered; ++i) {
+        const auto found =
+            std::find(route.destinations.begin() + 1, route.destinations.end(), destinations[i]);
+        covered = found != route.destinations.end();
+        const auto result = covered ? route.results.find(found - route.destinations.begin())
+                                    : route.results.end();
+        if (result != route.results.end()) {
+          results[i] = result->second;
+        }
+      }
+      if (covered) {
+        return &route;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void TransitionCostModel::Clear() {
+  workspace_->time = kInvalidTime;
+  workspace_->current_routes.clear();
+  workspace_->previous_routes.clear();
 }
 
 } // namespace meili
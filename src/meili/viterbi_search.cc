@@ -1,6 +1,7 @@
 #include "meili/viterbi_search.h"
 
 #include <algorithm>
+#include <cmath>
 #include <string>
 
 namespace valhalla {
@@ -159,6 +160,30 @@ void IViterbiSearch::set_transition_cost_model(const ITransitionCostModel& cost_
   transition_cost_model_ = cost_model;
 }
 
+void IViterbiSearch::set_fixed_lag(bool fixed_lag) {
+  fixed_lag_ = fixed_lag;
+}
+
+bool IViterbiSearch::fixed_lag() const {
+  return fixed_lag_;
+}
+
+void IViterbiSearch::set_beam(size_t beam_width, double beam_cost_margin) {
+  if (beam_cost_margin < 0.0) {
+    throw std::invalid_argument("expect nonnegative beam cost margin");
+  }
+  beam_width_ = beam_width;
+  beam_cost_margin_ = beam_cost_margin;
+}
+
+size_t IViterbiSearch::beam_width() const {
+  return beam_width_;
+}
+
+double IViterbiSearch::beam_cost_margin() const {
+  return beam_cost_margin_;
+}
+
 float IViterbiSearch::TransitionCost(const StateId& lhs, const StateId& rhs) const {
   return transition_cost_model_(lhs, rhs);
 }
@@ -172,6 +197,56 @@ IViterbiSearch::CostSofar(double prev_costsofar, float transition_cost, float em
   return prev_costsofar + transition_cost + emission_cost;
 }
 
+bool IViterbiSearch::FindCommonAncestor(std::vector<StateId> frontier,
+                                        StateId::Time time,
+                                        StateId::Time& ancestor_time,
+                                        StateId& ancestor) const {
+  // A column without any surviving state breaks the path right there
+  if (frontier.empty()) {
+    frontier.emplace_back();
+  }
+
+  const auto by_value = [](const StateId& lhs, const StateId& rhs) {
+    return lhs.value() < rhs.value();
+  };
+  while (true) {
+    std::sort(frontier.begin(), frontier.end(), by_value);
+    frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+    if (frontier.size() == 1) {
+      ancestor_time = time;
+      ancestor = frontier.front();
+      return true;
+    }
+
+    // Columns before this time are already committed
+    if (time <= committed_time_) {
+      return false;
+    }
+
+    // Same as StateIdIterator, a broken path continues from the winner of the previous column
+    --time;
+    for (auto& stateid : frontier) {
+      const auto predecessor = Predecessor(stateid);
+      stateid = predecessor.IsValid() ? predecessor : winner_by_time[time];
+    }
+  }
+}
+
+void IViterbiSearch::CommitPath(StateId::Time time, StateId stateid) {
+  for (auto t = time + 1; committed_time_ < t--;) {
+    // Get the predecessor before its column is released
+    auto predecessor = Predecessor(stateid);
+    if (!predecessor.IsValid() && 0 < t) {
+      predecessor = winner_by_time[t - 1];
+    }
+
+    ReleaseColumn(t, stateid);
+    winner_by_time[t] = stateid;
+    stateid = predecessor;
+  }
+  committed_time_ = std::max(committed_time_, time + 1);
+}
+
 template <bool Maximize> NaiveViterbiSearch<Maximize>::~NaiveViterbiSearch() {
   Clear();
 }
@@ -185,6 +260,7 @@ template <bool Maximize> void NaiveViterbiSearch<Maximize>::Clear() {
 template <bool Maximize> void NaiveViterbiSearch<Maximize>::ClearSearch() {
   history_.clear();
   winner_by_time.clear();
+  committed_time_ = 0;
 }
 
 template <bool Maximize> bool NaiveViterbiSearch<Maximize>::AddStateId(const StateId& stateid) {
@@ -251,8 +327,26 @@ template <bool Maximize> StateId NaiveViterbiSearch<Maximize>::SearchWinner(Stat
       labels = InitLabels(column, true);
       winner = FindWinner(labels);
     }
+    if (0 < beam_width() || 0.0 < beam_cost_margin()) {
+      PruneLabels(labels);
+    }
     winner_by_time.push_back(winner);
     history_.push_back(move(labels));
+
+    // Commit the path as soon as all the reachable states of this column agree on its past
+    if (fixed_lag()) {
+      std::vector<StateId> frontier;
+      for (const auto& label : history_.back()) {
+        if (label.costsofar() != kInvalidCost) {
+          frontier.push_back(label.stateid());
+        }
+      }
+      StateId::Time ancestor_time;
+      StateId ancestor;
+      if (FindCommonAncestor(std::move(frontier), time, ancestor_time, ancestor)) {
+        CommitPath(ancestor_time, ancestor);
+      }
+    }
   }
 
   return winner_by_time[target];
@@ -334,6 +428,48 @@ StateId NaiveViterbiSearch<Maximize>::FindWinner(const std::vector<StateLabel>&
   return it->stateid();
 }
 
+template <bool Maximize>
+void NaiveViterbiSearch<Maximize>::PruneLabels(std::vector<StateLabel>& labels) const {
+  // Best labels first. Stable sorting keeps the winner (the first best label) in front and
+  // invalid labels sort last either way
+  std::stable_sort(labels.begin(), labels.end(), [](const StateLabel& lhs, const StateLabel& rhs) {
+    return Maximize ? rhs.costsofar() < lhs.costsofar() : lhs.costsofar() < rhs.costsofar();
+  });
+  if (labels.empty()) {
+    return;
+  }
+
+  const auto best_costsofar = labels.front().costsofar();
+  auto end = labels.end();
+  if (0 < beam_width() && beam_width() < labels.size()) {
+    end = labels.begin() + beam_width();
+  }
+  end = std::find_if(labels.begin(), end, [this, best_costsofar](const StateLabel& label) {
+    return label.costsofar() == kInvalidCost ||
+           (0.0 < beam_cost_margin() &&
+            beam_cost_margin() < std::abs(label.costsofar() - best_costsofar));
+  });
+  labels.erase(end, labels.end());
+}
+
+template <bool Maximize>
+void NaiveViterbiSearch<Maximize>::ReleaseColumn(StateId::Time time, const StateId& keep) {
+  for (const auto& stateid : states_by_time[time]) {
+    if (stateid != keep) {
+      IViterbiSearch::RemoveStateId(stateid);
+    }
+  }
+
+  std::vector<StateLabel> labels;
+  if (keep.IsValid()) {
+    labels.push_back(GetLabel(keep));
+    states_by_time[time] = std::vector<StateId>{keep};
+  } else {
+    states_by_time[time] = std::vector<StateId>();
+  }
+  history_[time].swap(labels);
+}
+
 // Linear search a state's label
 template <bool Maximize>
 const StateLabel& NaiveViterbiSearch<Maximize>::GetLabel(const StateId& stateid) const {
@@ -452,8 +588,10 @@ void ViterbiSearch::Clear() {
 
 void ViterbiSearch::ClearSearch() {
   earliest_time_ = 0;
+  committed_time_ = 0;
   queue_.clear();
   scanned_labels_.clear();
+  scanned_count_by_time_.clear();
   winner_by_time.clear();
   unreached_states_by_time = states_by_time;
 }
@@ -553,12 +691,24 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
       continue;
     }
 
+    // Labels are popped in increasing cost, so once a label falls out of the beam of its column
+    // all the following ones do too and we drop the rest of the column
+    if (IsOutOfBeam(label)) {
+      unreached_states_by_time[stateid.time()].clear();
+      OnColumnExhausted(stateid.time());
+      continue;
+    }
+
     // Mark it as scanned and remember its cost and predecessor
     const auto& inserted = scanned_labels_.emplace(stateid, label);
     if (!inserted.second) {
       throw std::logic_error("the principle of optimality is violated in the viterbi search,"
                              " probably negative costs occurred");
     }
+    if (scanned_count_by_time_.size() <= stateid.time()) {
+      scanned_count_by_time_.resize(stateid.time() + 1);
+    }
+    ++scanned_count_by_time_[stateid.time()];
 
     // Remove it from its column
     auto& column = unreached_states_by_time[stateid.time()];
@@ -568,13 +718,6 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
     }
     column.erase(it);
 
-    // Since current column is empty now, earlier labels can't reach
-    // future winners in a optimal way any more, so we mark time + 1
-    // as the earliest time to skip all earlier labels
-    if (column.empty()) {
-      earliest_time_ = stateid.time() + 1;
-    }
-
     // If it's the first state that arrives at this column, mark it as
     // the winner at this time
     if (winner_by_time.size() <= stateid.time()) {
@@ -587,6 +730,15 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
       winner_by_time.push_back(stateid);
     }
 
+    // Once the beam of this column is full the rest of its states are dropped
+    if (0 < beam_width() && beam_width() <= scanned_count_by_time_[stateid.time()]) {
+      column.clear();
+    }
+
+    if (column.empty()) {
+      OnColumnExhausted(stateid.time());
+    }
+
     // Update searched time
     searched_time = std::max(stateid.time(), searched_time);
 
@@ -613,6 +765,55 @@ StateId::Time ViterbiSearch::IterativeSearch(StateId::Time target, bool request_
   return searched_time;
 }
 
+bool ViterbiSearch::IsOutOfBeam(const StateLabel& label) const {
+  const auto time = label.stateid().time();
+  if (!(0.0 < beam_cost_margin()) || winner_by_time.size() <= time ||
+      !winner_by_time[time].IsValid()) {
+    return false;
+  }
+  const auto it = scanned_labels_.find(winner_by_time[time]);
+  return it != scanned_labels_.end() &&
+         beam_cost_margin() < label.costsofar() - it->second.costsofar();
+}
+
+void ViterbiSearch::OnColumnExhausted(StateId::Time time) {
+  // Since the column is empty now, earlier labels can't reach future winners in an optimal way
+  // any more, so we mark time + 1 as the earliest time to skip all earlier labels
+  earliest_time_ = time + 1;
+  if (!fixed_lag()) {
+    return;
+  }
+
+  // All future winners descend from the scanned states of this column
+  std::vector<StateId> frontier;
+  for (const auto& stateid : states_by_time[time]) {
+    if (scanned_labels_.find(stateid) != scanned_labels_.end()) {
+      frontier.push_back(stateid);
+    }
+  }
+  StateId::Time ancestor_time;
+  StateId ancestor;
+  if (FindCommonAncestor(std::move(frontier), time, ancestor_time, ancestor)) {
+    CommitPath(ancestor_time, ancestor);
+  }
+}
+
+void ViterbiSearch::ReleaseColumn(StateId::Time time, const StateId& keep) {
+  for (const auto& stateid : states_by_time[time]) {
+    if (stateid != keep) {
+      scanned_labels_.erase(stateid);
+      IViterbiSearch::RemoveStateId(stateid);
+    }
+  }
+
+  if (keep.IsValid()) {
+    states_by_time[time] = std::vector<StateId>{keep};
+  } else {
+    states_by_time[time] = std::vector<StateId>();
+  }
+  std::vector<StateId>().swap(unreached_states_by_time[time]);
+}
+
 constexpr bool ViterbiSearch::IsInvalidCost(double cost) {
   return cost < 0.f;
 }
@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "baldr/graphconstants.h"
 #include "filesystem.h"
+#include "midgard/sequence.h"
 #include "mjolnir/adminbuilder.h"
 #include "mjolnir/adminconstants.h"
+#include "mjolnir/adminindex.h"
 #include "mjolnir/osmpbfparser.h"
 #include "mjolnir/pbfadminparser.h"
 #include "mjolnir/util.h"
@@ -22,9 +26,6 @@ BOOST_GEOMETRY_REGISTER_POINT_2D(valhalla::midgard::PointLL,
                                  boost::geometry::cs::geographic<boost::geometry::degree>,
                                  first,
                                  second);
-using ring_t = boost::geometry::model::ring<valhalla::midgard::PointLL>;
-using polygon_t = boost::geometry::model::polygon<valhalla::midgard::PointLL>;
-using multipolygon_t = boost::geometry::model::multi_polygon<polygon_t>;
 
 // For OSM pbf reader
 using namespace valhalla::mjolnir;
@@ -33,35 +34,45 @@ using namespace valhalla::midgard;
 
 namespace {
 
+using ring_t = boost::geometry::model::ring<valhalla::midgard::PointLL>;
+using polygon_t = boost::geometry::model::polygon<valhalla::midgard::PointLL>;
+using multipolygon_t = boost::geometry::model::multi_polygon<polygon_t>;
+
+// How many admins each thread assembles before the batch is inserted into sqlite
+constexpr size_t kAdminsPerThreadBatch = 64;
+
 /**
- * a simple singleton to wrap geos setup and tear down as well as conversion to and from boost types
+ * wraps geos setup and tear down, one context per thread so that threads can buffer at the same
+ * time, as well as conversion to and from boost types
  */
 struct geos_helper_t {
-  static const geos_helper_t& get() {
-    static geos_helper_t singleton;
-    return singleton;
+  static GEOSContextHandle_t get() {
+    thread_local geos_helper_t helper;
+    return helper.handle;
   }
   template <typename striped_container_t>
   static GEOSGeometry* from_striped_container(const striped_container_t& coords) {
     // sadly we dont layout the memory in parallel arrays so we have to copy to geos
-    GEOSCoordSequence* geos_coords = GEOSCoordSeq_create(coords.size(), 2);
+    auto geos = get();
+    GEOSCoordSequence* geos_coords = GEOSCoordSeq_create_r(geos, coords.size(), 2);
     for (unsigned int i = 0; i < static_cast<unsigned int>(coords.size()); ++i) {
-      GEOSCoordSeq_setX(geos_coords, i, coords[i].first);
-      GEOSCoordSeq_setY(geos_coords, i, coords[i].second);
+      GEOSCoordSeq_setX_r(geos, geos_coords, i, coords[i].first);
+      GEOSCoordSeq_setY_r(geos, geos_coords, i, coords[i].second);
     }
-    return GEOSGeom_createLinearRing(geos_coords);
+    return GEOSGeom_createLinearRing_r(geos, geos_coords);
   }
   template <typename striped_container_t>
   static striped_container_t to_striped_container(const GEOSGeometry* geometry) {
     // sadly we dont layout the memory in parallel arrays so we have to copy from geos
-    auto* coords = GEOSGeom_getCoordSeq(geometry);
+    auto geos = get();
+    auto* coords = GEOSGeom_getCoordSeq_r(geos, geometry);
     unsigned int coords_size;
-    GEOSCoordSeq_getSize(coords, &coords_size);
+    GEOSCoordSeq_getSize_r(geos, coords, &coords_size);
     striped_container_t container;
     container.resize(coords_size);
     for (unsigned int i = 0; i < coords_size; ++i) {
-      GEOSCoordSeq_getX(coords, i, &container[i].first);
-      GEOSCoordSeq_getY(coords, i, &container[i].second);
+      GEOSCoordSeq_getX_r(geos, coords, i, &container[i].first);
+      GEOSCoordSeq_getY_r(geos, coords, i, &container[i].second);
     }
     return container;
   }
@@ -73,12 +84,14 @@ protected:
     vprintf(fmt, ap);
     va_end(ap);
   }
-  geos_helper_t() {
-    initGEOS(message_handler, message_handler);
+  geos_helper_t() : handle(GEOS_init_r()) {
+    GEOSContext_setNoticeHandler_r(handle, message_handler);
+    GEOSContext_setErrorHandler_r(handle, message_handler);
   }
   ~geos_helper_t() {
-    finishGEOS();
+    GEOS_finish_r(handle);
   }
+  GEOSContextHandle_t handle;
 };
 
 /**
@@ -89,29 +102,31 @@ protected:
  * @param inners if some kind of self intersection should cause inners to be created we push them here
  */
 void buffer_ring(const ring_t& ring, std::vector<ring_t>& rings, std::vector<ring_t>& inners) {
+  auto geos = geos_helper_t::get();
   // for collecting polygons
   auto add = [&](auto* geos_poly) {
-    rings.emplace_back(geos_helper_t::to_striped_container<ring_t>(GEOSGetExteriorRing(geos_poly)));
-    for (int i = 0; i < GEOSGetNumInteriorRings(geos_poly); ++i) {
-      auto* inner = GEOSGetInteriorRingN(geos_poly, i);
+    rings.emplace_back(
+        geos_helper_t::to_striped_container<ring_t>(GEOSGetExteriorRing_r(geos, geos_poly)));
+    for (int i = 0; i < GEOSGetNumInteriorRings_r(geos, geos_poly); ++i) {
+      auto* inner = GEOSGetInteriorRingN_r(geos, geos_poly, i);
       inners.push_back(geos_helper_t::to_striped_container<ring_t>(inner));
     }
   };
 
   auto* outer_ring = geos_helper_t::from_striped_container(ring);
-  auto* geos_poly = GEOSGeom_createPolygon(outer_ring, nullptr, 0);
-  auto* buffered = GEOSBuffer(geos_poly, 0, 8);
-  GEOSNormalize(buffered);
-  auto geom_type = GEOSGeomTypeId(buffered);
+  auto* geos_poly = GEOSGeom_createPolygon_r(geos, outer_ring, nullptr, 0);
+  auto* buffered = GEOSBuffer_r(geos, geos_poly, 0, 8);
+  GEOSNormalize_r(geos, buffered);
+  auto geom_type = GEOSGeomTypeId_r(geos, buffered);
   switch (geom_type) {
     case GEOS_POLYGON: {
       add(buffered);
       break;
     }
     case GEOS_MULTIPOLYGON: {
-      for (int i = 0; i < GEOSGetNumGeometries(buffered); ++i) {
-        auto* geom = GEOSGetGeometryN(buffered, i);
-        if (GEOSGeomTypeId(geom) != GEOS_POLYGON)
+      for (int i = 0; i < GEOSGetNumGeometries_r(geos, buffered); ++i) {
+        auto* geom = GEOSGetGeometryN_r(geos, buffered, i);
+        if (GEOSGeomTypeId_r(geos, geom) != GEOS_POLYGON)
           throw std::runtime_error("Unusable geometry type after buffering");
         add(geom);
       }
@@ -120,8 +135,8 @@ void buffer_ring(const ring_t& ring, std::vector<ring_t>& rings, std::vector<rin
     default:
       throw std::runtime_error("Unusable geometry type after buffering");
   }
-  GEOSGeom_destroy(geos_poly);
-  GEOSGeom_destroy(buffered);
+  GEOSGeom_destroy_r(geos, geos_poly);
+  GEOSGeom_destroy_r(geos, buffered);
 }
 
 /**
@@ -129,12 +144,14 @@ void buffer_ring(const ring_t& ring, std::vector<ring_t>& rings, std::vector<rin
  * @param multipolygon  any resulting polygons are output here
  */
 void buffer_polygon(const polygon_t& polygon, multipolygon_t& multipolygon) {
+  auto geos = geos_helper_t::get();
   // for collecting polygons
   auto add = [&](auto* geos_poly) {
     auto& poly = *multipolygon.emplace(multipolygon.end());
-    poly.outer() = geos_helper_t::to_striped_container<ring_t>(GEOSGetExteriorRing(geos_poly));
-    for (int i = 0; i < GEOSGetNumInteriorRings(geos_poly); ++i) {
-      auto* inner = GEOSGetInteriorRingN(geos_poly, i);
+    poly.outer() =
+        geos_helper_t::to_striped_container<ring_t>(GEOSGetExteriorRing_r(geos, geos_poly));
+    for (int i = 0; i < GEOSGetNumInteriorRings_r(geos, geos_poly); ++i) {
+      auto* inner = GEOSGetInteriorRingN_r(geos, geos_poly, i);
       poly.inners().push_back(geos_helper_t::to_striped_container<ring_t>(inner));
     }
   };
@@ -150,19 +167,20 @@ void buffer_polygon(const polygon_t& polygon, multipolygon_t& multipolygon) {
   for (const auto& inner : polygon.inners()) {
     inner_rings.push_back(geos_helper_t::from_striped_container(inner));
   }
-  auto* geos_poly = GEOSGeom_createPolygon(outer_ring, &inner_rings.front(), inner_rings.size());
-  auto* buffered = GEOSBuffer(geos_poly, 0, 8);
-  GEOSNormalize(buffered);
-  auto geom_type = GEOSGeomTypeId(buffered);
+  auto* geos_poly =
+      GEOSGeom_createPolygon_r(geos, outer_ring, &inner_rings.front(), inner_rings.size());
+  auto* buffered = GEOSBuffer_r(geos, geos_poly, 0, 8);
+  GEOSNormalize_r(geos, buffered);
+  auto geom_type = GEOSGeomTypeId_r(geos, buffered);
   switch (geom_type) {
     case GEOS_POLYGON: {
       add(buffered);
       break;
     }
     case GEOS_MULTIPOLYGON: {
-      for (int i = 0; i < GEOSGetNumGeometries(buffered); ++i) {
-        auto* geom = GEOSGetGeometryN(buffered, i);
-        if (GEOSGeomTypeId(geom) != GEOS_POLYGON)
+      for (int i = 0; i < GEOSGetNumGeometries_r(geos, buffered); ++i) {
+        auto* geom = GEOSGetGeometryN_r(geos, buffered, i);
+        if (GEOSGeomTypeId_r(geos, geom) != GEOS_POLYGON)
           throw std::runtime_error("Unusable geometry type after buffering");
         add(geom);
       }
@@ -172,8 +190,8 @@ void buffer_polygon(const polygon_t& polygon, multipolygon_t& multipolygon) {
       throw std::runtime_error("Unusable geometry type after buffering with inners size " +
                                unused_size);
   }
-  GEOSGeom_destroy(geos_poly);
-  GEOSGeom_destroy(buffered);
+  GEOSGeom_destroy_r(geos, geos_poly);
+  GEOSGeom_destroy_r(geos, buffered);
 }
 
 /**
@@ -358,6 +376,48 @@ multipolygon_t to_multipolygon(const std::pair<std::string, uint64_t>& admin_inf
   return multipolygon;
 }
 
+/**
+ * Assembles the multipolygon of an admin from the ways of its relation
+ * @param admin_data  used to look up the ways and nodes of the admin
+ * @param admin       the admin to assemble
+ * @return the multipolygon in wkt format or an empty string if the admin is degenerate
+ */
+std::string to_wkt(const OSMAdminData& admin_data, const OSMAdmin& admin) {
+  std::pair<std::string, uint64_t> admin_info(admin_data.name_offset_map.name(admin.name_index),
+                                              admin.id);
+  LOG_DEBUG("Building admin: " + admin_info.first);
+
+  // do inners and outers separately
+  bool complete = true;
+  std::array<std::vector<ring_t>, 2> outers_inners;
+  for (bool outer : {true, false}) {
+    // grab the ring segments and a lookup to find them when connecting them
+    std::vector<ring_t> lines;
+    std::unordered_multimap<valhalla::midgard::PointLL, size_t> line_lookup;
+    if (!to_segments(admin_data, admin, admin_info.first, outer, lines, line_lookup)) {
+      complete = false;
+      break;
+    }
+    // connect them into a series of one or more rings
+    to_rings(admin_info, lines, line_lookup, outers_inners[!outer], outers_inners[1]);
+  }
+
+  // if we didn't have a complete relation (ie some members were missing) we bail
+  if (!complete || outers_inners.front().empty()) {
+    LOG_WARN(admin_info.first + " (" + std::to_string(admin_info.second) +
+             ") is degenerate and will be skipped");
+    return "";
+  }
+
+  // convert the rings into multipolygons
+  auto multipolygon = to_multipolygon(admin_info, outers_inners.front(), outers_inners.back());
+
+  // convert that into wkt format so we can put it into sqlite
+  std::stringstream ss;
+  ss << std::setprecision(7) << boost::geometry::wkt(multipolygon);
+  return ss.str();
+}
+
 } // anonymous namespace
 
 namespace valhalla {
@@ -367,7 +427,8 @@ namespace mjolnir {
  * Build admins from protocol buffer input.
  */
 bool BuildAdminFromPBF(const boost::property_tree::ptree& pt,
-                       const std::vector<std::string>& input_files) {
+                       const std::vector<std::string>& input_files,
+                       const bool release_osmpbf_memory) {
 
   // Bail if bad path
   auto database = pt.get_optional<std::string>("admin");
@@ -388,7 +449,9 @@ bool BuildAdminFromPBF(const boost::property_tree::ptree& pt,
   OSMAdminData admin_data = PBFAdminParser::Parse(pt, input_files);
 
   // done with the protobuffer library, cant use it again after this
-  OSMPBF::Parser::free();
+  if (release_osmpbf_memory) {
+    OSMPBF::Parser::free();
+  }
 
   if (filesystem::exists(*database)) {
     filesystem::remove(*database);
@@ -517,47 +580,29 @@ bool BuildAdminFromPBF(const boost::property_tree::ptree& pt,
     return false;
   }
 
-  // initialize geos
-  geos_helper_t::get();
+  // assemble the polygons of a batch of admins on several threads, each with its own geos context,
+  // and then insert them in the same order no matter how many threads there are
+  const unsigned int concurrency =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+  const size_t batch_size = kAdminsPerThreadBatch * concurrency;
+  std::vector<std::string> wkts;
+  LOG_INFO("Assembling admin polygons with " + std::to_string(concurrency) + " threads");
 
   // for each admin area (relation)
   uint32_t count = 0;
-  for (const auto& admin : admin_data.admins) {
-    std::pair<std::string, uint64_t> admin_info(admin_data.name_offset_map.name(admin.name_index),
-                                                admin.id);
-    LOG_DEBUG("Building admin: " + admin_info.first);
-
-    // do inners and outers separately
-    bool complete = true;
-    std::array<std::vector<ring_t>, 2> outers_inners;
-    for (bool outer : {true, false}) {
-      // grab the ring segments and a lookup to find them when connecting them
-      std::vector<ring_t> lines;
-      std::unordered_multimap<valhalla::midgard::PointLL, size_t> line_lookup;
-      if (!to_segments(admin_data, admin, admin_info.first, outer, lines, line_lookup)) {
-        complete = false;
-        break;
-      }
-      // connect them into a series of one or more rings
-      to_rings(admin_info, lines, line_lookup, outers_inners[!outer], outers_inners[1]);
+  for (size_t i = 0; i < admin_data.admins.size(); ++i) {
+    if (i % batch_size == 0) {
+      wkts.assign(std::min(batch_size, admin_data.admins.size() - i), "");
+      parallel_for(wkts.size(), concurrency, [&admin_data, &wkts, i](size_t, size_t j) {
+        wkts[j] = to_wkt(admin_data, admin_data.admins[i + j]);
+      });
     }
-
-    // if we didn't have a complete relation (ie some members were missing) we bail
-    if (!complete || outers_inners.front().empty()) {
-      LOG_WARN(admin_info.first + " (" + std::to_string(admin_info.second) +
-               ") is degenerate and will be skipped");
-      continue;
-    }
-
-    // convert the rings into multipolygons
-    auto multipolygon = to_multipolygon(admin_info, outers_inners.front(), outers_inners.back());
-
-    // convert that into wkt format so we can put it into sqlite
-    std::stringstream ss;
-    ss << std::setprecision(7) << boost::geometry::wkt(multipolygon);
-    auto wkt = ss.str();
+    const auto& admin = admin_data.admins[i];
+    const auto& wkt = wkts[i % batch_size];
     if (wkt.empty())
       continue;
+    const auto& name = admin_data.name_offset_map.name(admin.name_index);
 
     // load it into sqlite
     count++;
@@ -575,7 +620,7 @@ bool BuildAdminFromPBF(const boost::property_tree::ptree& pt,
 
     sqlite3_bind_null(stmt, 3);
 
-    sqlite3_bind_text(stmt, 4, admin_info.first.c_str(), admin_info.first.length(), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, name.c_str(), name.length(), SQLITE_STATIC);
 
     std::string name_en, default_language;
     if (admin.name_en_index) {
@@ -819,6 +864,11 @@ bool BuildAdminFromPBF(const boost::property_tree::ptree& pt,
     return false;
   }
 
+  // index the finished db so that graph building need not query it for every tile
+  if (!AdminIndex::Build(db_handle, AdminIndex::Kind::kAdmins, AdminIndex::IndexPath(*database))) {
+    LOG_WARN("Could not index " + *database + ". Graph building will query it instead.");
+  }
+
   sqlite3_close(db_handle);
 
   LOG_INFO("Finished.");
@@ -0,0 +1,556 @@
+#include "mjolnir/adminindex.h"
+#include "baldr/datetime.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "mjolnir/util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+#include <sys/stat.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+struct AdminIndex::Header {
+  uint64_t magic;
+  uint32_t kind;
+  uint32_t entry_count;
+  uint32_t node_count;
+  uint32_t leaf_count; // the first leaf_count nodes hold entries, the rest hold other nodes
+  uint32_t access_count;
+  uint32_t spare;
+  uint64_t ring_count;
+  uint64_t point_count;
+  uint64_t string_size;
+  int64_t source_size; // size and modification time of the db the index was built from
+  int64_t source_mtime;
+};
+
+struct AdminIndex::Node {
+  double minx, miny, maxx, maxy;
+  uint32_t first;
+  uint32_t count;
+};
+
+struct AdminIndex::Entry {
+  double minx, miny, maxx, maxy;
+  uint64_t ring_begin;
+  uint32_t ring_count;
+  uint32_t order;    // the position in which the SQL queries returned this polygon
+  uint32_t category; // which of the SQL queries returned this polygon
+  uint32_t tz_index;
+  // offsets into the string table
+  uint32_t country_name;
+  uint32_t state_name;
+  uint32_t country_iso;
+  uint32_t state_iso;
+  uint32_t supported_languages;
+  uint32_t default_language;
+  uint8_t drive_on_right;
+  uint8_t allow_intersection_names;
+  uint8_t spare[6];
+};
+
+struct AdminIndex::Ring {
+  uint64_t point_begin;
+  uint32_t point_count;
+  uint32_t outer; // whether this ring starts a new polygon
+};
+
+struct AdminIndex::Access {
+  uint32_t iso_code;
+  int32_t values[9];
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+// "ADMINDX1" marks (and versions) the file layout
+constexpr uint64_t kMagic = 0x3158444E494D4441;
+constexpr size_t kFanout = 16;
+
+// Which query of GetAdminInfo or GetTimeZones an entry belongs to
+enum Category : uint32_t {
+  kLanguagePolys = 0,
+  kStatePolys = 1,
+  kCountryPolys = 2,
+  kTimezonePolys = 3
+};
+
+using box_type = bg::model::box<point_type>;
+
+template <typename T> size_t padded(size_t count) {
+  return (count * sizeof(T) + 7) & ~size_t(7);
+}
+
+template <typename box_t> bool intersects(const box_t& a, const AABB2<PointLL>& b) {
+  return a.minx <= b.maxx() && b.minx() <= a.maxx && a.miny <= b.maxy() && b.miny() <= a.maxy;
+}
+
+// Size and modification time of a file, zeros if it cant be stat'd
+std::pair<int64_t, int64_t> stamp(const std::string& file) {
+  struct stat s;
+  if (file.empty() || stat(file.c_str(), &s) != 0) {
+    return {0, 0};
+  }
+  return {static_cast<int64_t>(s.st_size), static_cast<int64_t>(s.st_mtime)};
+}
+
+std::string column_text(sqlite3_stmt* stmt, int column) {
+  if (sqlite3_column_type(stmt, column) == SQLITE_TEXT) {
+    return reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+  }
+  return "";
+}
+
+bool column_bool(sqlite3_stmt* stmt, int column, bool null_value) {
+  if (sqlite3_column_type(stmt, column) == SQLITE_INTEGER) {
+    return sqlite3_column_int(stmt, column);
+  }
+  return null_value;
+}
+
+// Runs a query handing each row to the callback
+template <typename row_t> bool for_each_row(sqlite3* db_handle, const std::string& sql, row_t row) {
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db_handle, sql.c_str(), sql.length(), &stmt, nullptr) != SQLITE_OK) {
+    LOG_ERROR("SQL error: " + sql);
+    LOG_ERROR(std::string(sqlite3_errmsg(db_handle)));
+    sqlite3_finalize(stmt);
+    return false;
+  }
+  std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)> guard(stmt, sqlite3_finalize);
+  int result;
+  while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
+    row(stmt);
+  }
+  if (result != SQLITE_DONE) {
+    LOG_ERROR("sqlite3_step() error: " + std::string(sqlite3_errmsg(db_handle)));
+    return false;
+  }
+  return true;
+}
+
+// Sort tile recursive ordering of boxes: sorted into vertical slices by their centers' x and
+// within each slice by their centers' y, so that each run of kFanout boxes is spatially compact
+template <typename box_t> void str_sort(std::vector<box_t>& boxes) {
+  auto cx = [](const box_t& b) { return b.minx + b.maxx; };
+  auto cy = [](const box_t& b) { return b.miny + b.maxy; };
+  std::sort(boxes.begin(), boxes.end(),
+            [&cx](const box_t& a, const box_t& b) { return cx(a) < cx(b); });
+  size_t groups = (boxes.size() + kFanout - 1) / kFanout;
+  size_t slice = kFanout * static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(groups))));
+  for (size_t i = 0; i < boxes.size(); i += slice) {
+    auto end = boxes.begin() + std::min(i + slice, boxes.size());
+    std::sort(boxes.begin() + i, end,
+              [&cy](const box_t& a, const box_t& b) { return cy(a) < cy(b); });
+  }
+}
+
+// Collects the parts of the index in memory before writing them out
+struct index_builder_t {
+  std::vector<AdminIndex::Entry> entries;
+  std::vector<AdminIndex::Ring> rings;
+  std::vector<double> points;
+  std::vector<AdminIndex::Access> access;
+  std::string strings = std::string(1, '\0');
+  std::unordered_map<std::string, uint32_t> string_offsets = {{"", 0}};
+
+  uint32_t add_string(const std::string& str) {
+    auto inserted = string_offsets.emplace(str, strings.size());
+    if (inserted.second) {
+      strings.append(str.c_str(), str.size() + 1);
+    }
+    return inserted.first->second;
+  }
+
+  // adds an entry for the polygons, nullptr if there are none
+  AdminIndex::Entry* add_polygons(const std::string& wkt, Category category) {
+    multi_polygon_type multi_poly;
+    bg::read_wkt(wkt, multi_poly);
+    if (multi_poly.empty()) {
+      return nullptr;
+    }
+
+    AdminIndex::Entry entry{};
+    box_type box;
+    bg::envelope(multi_poly, box);
+    entry.minx = box.min_corner().x();
+    entry.miny = box.min_corner().y();
+    entry.maxx = box.max_corner().x();
+    entry.maxy = box.max_corner().y();
+    entry.ring_begin = rings.size();
+    entry.order = entries.size();
+    entry.category = category;
+    auto add_ring = [this](const auto& ring, bool outer) {
+      rings.push_back({points.size() / 2, static_cast<uint32_t>(ring.size()), outer});
+      for (const auto& p : ring) {
+        points.push_back(p.x());
+        points.push_back(p.y());
+      }
+    };
+    for (const auto& poly : multi_poly) {
+      add_ring(poly.outer(), true);
+      for (const auto& inner : poly.inners()) {
+        add_ring(inner, false);
+      }
+    }
+    entry.ring_count = rings.size() - entry.ring_begin;
+    entries.push_back(entry);
+    return &entries.back();
+  }
+
+  // orders the entries spatially and packs the tree on top of them
+  std::vector<AdminIndex::Node> pack() {
+    str_sort(entries);
+    std::vector<AdminIndex::Node> nodes, level;
+    auto bound = [](auto begin, auto end, uint32_t first) {
+      AdminIndex::Node node{begin->minx, begin->miny, begin->maxx, begin->maxy, first,
+                            static_cast<uint32_t>(end - begin)};
+      for (auto b = begin; b != end; ++b) {
+        node.minx = std::min(node.minx, b->minx);
+        node.miny = std::min(node.miny, b->miny);
+        node.maxx = std::max(node.maxx, b->maxx);
+        node.maxy = std::max(node.maxy, b->maxy);
+      }
+      return node;
+    };
+    for (size_t i = 0; i < entries.size(); i += kFanout) {
+      auto end = entries.begin() + std::min(i + kFanout, entries.size());
+      level.push_back(bound(entries.begin() + i, end, i));
+    }
+    // each level is sorted before its parents point at runs of it, the root ends up last
+    while (!level.empty()) {
+      if (level.size() > 1) {
+        str_sort(level);
+      }
+      uint32_t first = nodes.size();
+      nodes.insert(nodes.end(), level.begin(), level.end());
+      if (level.size() == 1) {
+        break;
+      }
+      std::vector<AdminIndex::Node> parents;
+      for (size_t i = 0; i < level.size(); i += kFanout) {
+        auto end = level.begin() + std::min(i + kFanout, level.size());
+        parents.push_back(bound(level.begin() + i, end, first + i));
+      }
+      level.swap(parents);
+    }
+    return nodes;
+  }
+};
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+AdminIndex::AdminIndex(const std::string& file) {
+  auto size = static_cast<size_t>(stamp(file).first);
+  if (size < sizeof(Header)) {
+    throw std::runtime_error("Not a valid admin index: " + file);
+  }
+  memmap_.map_readonly(file, size, POSIX_MADV_RANDOM);
+  header_ = reinterpret_cast<const Header*>(memmap_.get());
+  const char* section = memmap_.get() + sizeof(Header);
+  nodes_ = reinterpret_cast<const Node*>(section);
+  section += padded<Node>(header_->node_count);
+  entries_ = reinterpret_cast<const Entry*>(section);
+  section += padded<Entry>(header_->entry_count);
+  access_ = reinterpret_cast<const Access*>(section);
+  section += padded<Access>(header_->access_count);
+  rings_ = reinterpret_cast<const Ring*>(section);
+  section += padded<Ring>(header_->ring_count);
+  points_ = reinterpret_cast<const double*>(section);
+  section += padded<double>(header_->point_count * 2);
+  strings_ = section;
+  if (header_->magic != kMagic ||
+      static_cast<size_t>(section - memmap_.get()) + header_->string_size != size) {
+    throw std::runtime_error("Not a valid admin index: " + file);
+  }
+}
+
+bool AdminIndex::Build(sqlite3* db_handle, Kind kind, const std::string& file) {
+  index_builder_t builder;
+  bool ok = true;
+  if (kind == Kind::kTimezones) {
+    ok = for_each_row(db_handle, "select TZID, st_astext(geom) from tz_world;",
+                      [&builder](sqlite3_stmt* stmt) {
+                        auto tz_id = column_text(stmt, 0);
+                        uint32_t idx = DateTime::get_tz_db().to_index(tz_id);
+                        if (idx == 0) {
+                          throw std::runtime_error("Can't find timezone ID " + tz_id);
+                        }
+                        auto* entry = builder.add_polygons(column_text(stmt, 1), kTimezonePolys);
+                        if (entry) {
+                          entry->tz_index = idx;
+                        }
+                      });
+  } else {
+    // these are the queries of GetAdminInfo without the tile bounding box
+    ok = for_each_row(db_handle,
+                      "SELECT supported_languages, default_language, st_astext(geom) from admins "
+                      "where (supported_languages is NOT NULL or default_language is NOT NULL) "
+                      "and admin_level>4 order by admin_level desc, name;",
+                      [&builder](sqlite3_stmt* stmt) {
+                        auto* entry = builder.add_polygons(column_text(stmt, 2), kLanguagePolys);
+                        if (entry) {
+                          entry->supported_languages = builder.add_string(column_text(stmt, 0));
+                          entry->default_language = builder.add_string(column_text(stmt, 1));
+                        }
+                      });
+    auto add_admin = [&builder](Category category) {
+      return [&builder, category](sqlite3_stmt* stmt) {
+        auto* entry = builder.add_polygons(column_text(stmt, 8), category);
+        if (entry) {
+          entry->country_name = builder.add_string(column_text(stmt, 0));
+          entry->state_name = builder.add_string(column_text(stmt, 1));
+          entry->country_iso = builder.add_string(column_text(stmt, 2));
+          entry->state_iso = builder.add_string(column_text(stmt, 3));
+          entry->drive_on_right = column_bool(stmt, 4, true);
+          entry->allow_intersection_names = column_bool(stmt, 5, false);
+          entry->supported_languages = builder.add_string(column_text(stmt, 6));
+          entry->default_language = builder.add_string(column_text(stmt, 7));
+        }
+      };
+    };
+    ok = ok && for_each_row(db_handle,
+                            "SELECT country.name, state.name, country.iso_code, state.iso_code, "
+                            "state.drive_on_right, state.allow_intersection_names, "
+                            "state.supported_languages, state.default_language, "
+                            "st_astext(state.geom) from admins state, admins country where "
+                            "country.rowid = state.parent_admin and state.admin_level=4 "
+                            "order by state.name, country.name;",
+                            add_admin(kStatePolys));
+    ok = ok && for_each_row(db_handle,
+                            "SELECT name, \"\", iso_code, \"\", drive_on_right, "
+                            "allow_intersection_names, supported_languages, default_language, "
+                            "st_astext(geom) from admins where admin_level=2 order by name;",
+                            add_admin(kCountryPolys));
+    for (const auto& country : mjolnir::GetCountryAccess(db_handle)) {
+      Access access{builder.add_string(country.first), {}};
+      std::fill(std::begin(access.values), std::end(access.values), -1);
+      std::copy_n(country.second.begin(), std::min<size_t>(country.second.size(), 9),
+                  access.values);
+      builder.access.push_back(access);
+    }
+  }
+  if (!ok) {
+    return false;
+  }
+
+  auto nodes = builder.pack();
+  Header header{};
+  header.magic = kMagic;
+  header.kind = static_cast<uint32_t>(kind);
+  header.entry_count = builder.entries.size();
+  header.node_count = nodes.size();
+  header.leaf_count = (builder.entries.size() + kFanout - 1) / kFanout;
+  header.access_count = builder.access.size();
+  header.ring_count = builder.rings.size();
+  header.point_count = builder.points.size() / 2;
+  header.string_size = builder.strings.size();
+  std::tie(header.source_size, header.source_mtime) =
+      stamp(sqlite3_db_filename(db_handle, "main") ? sqlite3_db_filename(db_handle, "main") : "");
+
+  // write next to the final file and move it into place so no one maps a partial index
+  auto temp_file = file + ".tmp";
+  {
+    std::ofstream out(temp_file, std::ios::out | std::ios::binary | std::ios::trunc);
+    auto write = [&out](const auto& items, size_t size) {
+      out.write(reinterpret_cast<const char*>(items.data()), size);
+      static const char zeros[8] = {};
+      out.write(zeros, (8 - size % 8) % 8);
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write(nodes, nodes.size() * sizeof(Node));
+    write(builder.entries, builder.entries.size() * sizeof(Entry));
+    write(builder.access, builder.access.size() * sizeof(Access));
+    write(builder.rings, builder.rings.size() * sizeof(Ring));
+    write(builder.points, builder.points.size() * sizeof(double));
+    out.write(builder.strings.data(), builder.strings.size());
+    out.close();
+    if (out.fail()) {
+      LOG_ERROR("Failed writing admin index " + temp_file);
+      filesystem::remove(temp_file);
+      return false;
+    }
+  }
+  if (!filesystem::rename(temp_file, file)) {
+    LOG_ERROR("Failed moving admin index into place " + file);
+    filesystem::remove(temp_file);
+    return false;
+  }
+  LOG_INFO("Indexed " + std::to_string(header.entry_count) + " polygons in " + file);
+  return true;
+}
+
+std::string AdminIndex::IndexPath(const std::string& database) {
+  return database + ".idx";
+}
+
+std::unique_ptr<AdminIndex> AdminIndex::Open(const std::string& database, Kind kind) {
+  if (database.empty() || !filesystem::exists(database)) {
+    return nullptr;
+  }
+
+  // use what is there if it was built from this very db
+  auto file = IndexPath(database);
+  if (filesystem::exists(file)) {
+    try {
+      std::unique_ptr<AdminIndex> index(new AdminIndex(file));
+      if (index->kind() == kind &&
+          stamp(database) == std::make_pair(index->header_->source_size,
+                                            index->header_->source_mtime)) {
+        return index;
+      }
+    } catch (const std::exception& e) { LOG_WARN(e.what()); }
+  }
+
+  sqlite3* db_handle = GetDBHandle(database);
+  if (!db_handle) {
+    return nullptr;
+  }
+  bool built = false;
+  try {
+    auto db_conn = make_spatialite_cache(db_handle);
+    built = Build(db_handle, kind, file);
+  } catch (const std::exception& e) { LOG_ERROR(e.what()); }
+  sqlite3_close(db_handle);
+  if (!built) {
+    return nullptr;
+  }
+  return std::unique_ptr<AdminIndex>(new AdminIndex(file));
+}
+
+std::vector<std::pair<const AdminIndex::Entry*, multi_polygon_type>>
+AdminIndex::Query(const AABB2<PointLL>& aabb) const {
+  std::vector<std::pair<const Entry*, multi_polygon_type>> found;
+  if (header_->node_count == 0) {
+    return found;
+  }
+
+  // walk down from the root, last in the file, to the entries whose boxes intersect
+  std::vector<const Entry*> candidates;
+  std::vector<uint32_t> stack{header_->node_count - 1};
+  while (!stack.empty()) {
+    auto index = stack.back();
+    stack.pop_back();
+    const auto& node = nodes_[index];
+    if (!intersects(node, aabb)) {
+      continue;
+    }
+    for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+      if (index >= header_->leaf_count) {
+        stack.push_back(i);
+      } else if (intersects(entries_[i], aabb)) {
+        candidates.push_back(entries_ + i);
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Entry* a, const Entry* b) { return a->order < b->order; });
+
+  // only those whose polygons actually intersect, like ST_Intersects would have
+  box_type box(point_type(aabb.minx(), aabb.miny()), point_type(aabb.maxx(), aabb.maxy()));
+  for (const auto* entry : candidates) {
+    auto multi_poly = Polygons(*entry);
+    if (bg::intersects(box, multi_poly)) {
+      found.emplace_back(entry, std::move(multi_poly));
+    }
+  }
+  return found;
+}
+
+multi_polygon_type AdminIndex::Polygons(const Entry& entry) const {
+  multi_polygon_type multi_poly;
+  for (const auto* ring = rings_ + entry.ring_begin;
+       ring != rings_ + entry.ring_begin + entry.ring_count; ++ring) {
+    if (ring->outer) {
+      multi_poly.emplace_back();
+    }
+    auto& poly = multi_poly.back();
+    auto& points = ring->outer ? poly.outer() : *poly.inners().emplace(poly.inners().end());
+    points.reserve(ring->point_count);
+    for (const auto* p = points_ + ring->point_begin * 2;
+         p != points_ + (ring->point_begin + ring->point_count) * 2; p += 2) {
+      points.emplace_back(p[0], p[1]);
+    }
+  }
+  return multi_poly;
+}
+
+std::string AdminIndex::String(uint32_t offset) const {
+  return strings_ + offset;
+}
+
+std::multimap<uint32_t, multi_polygon_type>
+AdminIndex::GetAdminInfo(std::unordered_map<uint32_t, bool>& drive_on_right,
+                         std::unordered_map<uint32_t, bool>& allow_intersection_names,
+                         language_poly_index& language_polys,
+                         const AABB2<PointLL>& aabb,
+                         GraphTileBuilder& tilebuilder) const {
+  std::multimap<uint32_t, multi_polygon_type> polys;
+  for (auto& found : Query(aabb)) {
+    const auto& entry = *found.first;
+    box_type box(point_type(entry.minx, entry.miny), point_type(entry.maxx, entry.maxy));
+    if (entry.default_language) {
+      language_polys.insert(std::make_tuple(box, found.second,
+                                            ParseLanguageTokens(String(entry.default_language)),
+                                            true));
+    }
+    if (entry.supported_languages) {
+      language_polys.insert(std::make_tuple(box, found.second,
+                                            ParseLanguageTokens(String(entry.supported_languages)),
+                                            false));
+    }
+    if (entry.category == kLanguagePolys) {
+      continue;
+    }
+    uint32_t index = tilebuilder.AddAdmin(String(entry.country_name), String(entry.state_name),
+                                          String(entry.country_iso), String(entry.state_iso));
+    polys.emplace(index, std::move(found.second));
+    drive_on_right.emplace(index, entry.drive_on_right);
+    allow_intersection_names.emplace(index, entry.allow_intersection_names);
+  }
+  return polys;
+}
+
+std::multimap<uint32_t, multi_polygon_type>
+AdminIndex::GetTimeZones(const AABB2<PointLL>& aabb) const {
+  std::multimap<uint32_t, multi_polygon_type> polys;
+  for (auto& found : Query(aabb)) {
+    polys.emplace(found.first->tz_index, std::move(found.second));
+  }
+  return polys;
+}
+
+std::unordered_map<std::string, std::vector<int>> AdminIndex::GetCountryAccess() const {
+  std::unordered_map<std::string, std::vector<int>> country_access;
+  for (const auto* access = access_; access != access_ + header_->access_count; ++access) {
+    country_access.emplace(String(access->iso_code),
+                           std::vector<int>(std::begin(access->values), std::end(access->values)));
+  }
+  return country_access;
+}
+
+AdminIndex::Kind AdminIndex::kind() const {
+  return static_cast<Kind>(header_->kind);
+}
+
+size_t AdminIndex::size() const {
+  return header_->entry_count;
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -1,13 +1,18 @@
 #include "mjolnir/elevationbuilder.h"
 
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
 #include <future>
-#include <random>
+#include <mutex>
 #include <thread>
+#include <unordered_set>
 #include <utility>
 
 #include "baldr/graphconstants.h"
 #include "baldr/graphid.h"
 #include "baldr/graphreader.h"
+#include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/elevation_encoding.h"
 #include "midgard/encoded.h"
@@ -32,9 +37,156 @@ constexpr double POSTING_INTERVAL = 60;
 // Do not compute grade for intervals less than 10 meters.
 constexpr double kMinimumInterval = 10.0f;
 
+
 using cache_t =
     std::unordered_map<uint32_t, std::tuple<uint32_t, uint32_t, float, float, float, float>>;
 
+// The elevation cells (the 1x1 degree tiles of the elevation data) that a graph tile covers
+std::vector<uint16_t> get_tile_cells(const GraphId& tile_id) {
+  auto bounds = TileHierarchy::get_tiling(tile_id.level()).TileBounds(tile_id.tileid());
+  std::vector<uint16_t> cells;
+  for (double lat = std::floor(bounds.miny()); lat < bounds.maxy() && lat < 90; ++lat) {
+    for (double lng = std::floor(bounds.minx()); lng < bounds.maxx() && lng < 180; ++lng) {
+      cells.push_back(valhalla::skadi::sample::get_tile_index(PointLL(lng, lat)));
+    }
+  }
+  return cells;
+}
+
+/**
+ * Hands out the tiles to the threads in the order of the elevation cells they start in so that
+ * the threads sample the same few cells at a time rather than the whole data set. Meanwhile its
+ * own thread loads, and decompresses, the cells of the next few runs of tiles that start in the
+ * same cell so that the threads rarely have to wait for one. The runs prefetched ahead of the one
+ * being handed out cover at most half of the decompressed cells the sampler keeps, the other half
+ * is left to the cells the threads are still sampling, so prefetched cells aren't evicted before
+ * they are used.
+ */
+class tile_scheduler_t {
+public:
+  tile_scheduler_t(std::deque<GraphId> tile_ids, valhalla::skadi::sample& sample)
+      : sample_(sample), max_prefetched_cells_(std::max<size_t>(
+                             valhalla::skadi::sample::unpacked_cache_size() / 2, 1)),
+        next_(0), stop_(false) {
+    // order the tiles by the first cell they cover
+    std::vector<std::pair<uint16_t, GraphId>> ordered;
+    ordered.reserve(tile_ids.size());
+    for (const auto& tile_id : tile_ids) {
+      auto cells = get_tile_cells(tile_id);
+      ordered.emplace_back(cells.empty() ? 0 : cells.front(), tile_id);
+    }
+    std::sort(ordered.begin(), ordered.end());
+
+    // remember which cells each run of tiles starting in the same cell covers
+    for (size_t i = 0; i < ordered.size(); ++i) {
+      if (i == 0 || ordered[i].first != ordered[i - 1].first) {
+        runs_.emplace_back();
+      }
+      tiles_.push_back(ordered[i].second);
+      auto& run = runs_.back();
+      for (auto cell : get_tile_cells(ordered[i].second)) {
+        if (std::find(run.cells.begin(), run.cells.end(), cell) == run.cells.end()) {
+          run.cells.push_back(cell);
+        }
+      }
+      run.end = tiles_.size();
+    }
+
+    // how many cells the runs before each one cover, a cell shared by runs counts once per run
+    cells_before_.reserve(runs_.size() + 1);
+    cells_before_.push_back(0);
+    for (const auto& run : runs_) {
+      cells_before_.push_back(cells_before_.back() + run.cells.size());
+    }
+
+    prefetcher_ = std::thread(&tile_scheduler_t::prefetch, this);
+  }
+
+  ~tile_scheduler_t() {
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      stop_ = true;
+    }
+    handed_out_.notify_one();
+    prefetcher_.join();
+  }
+
+  size_t size() const {
+    return tiles_.size();
+  }
+
+  /**
+   * Gets the next tile to add elevation to.
+   * @return false when there are no more tiles
+   */
+  bool next(GraphId& tile_id) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (next_ >= tiles_.size()) {
+      return false;
+    }
+    tile_id = tiles_[next_++];
+    handed_out_.notify_one();
+    return true;
+  }
+
+private:
+  struct run_t {
+    std::vector<uint16_t> cells;
+    size_t end; // position just past the last tile of the run
+  };
+
+  void prefetch() {
+    try {
+      for (size_t run = 0; run < runs_.size(); ++run) {
+        // a run covering too many cells by itself would evict its own first cells
+        if (runs_[run].cells.size() > max_prefetched_cells_) {
+          continue;
+        }
+        {
+          // wait until the cells from the run being handed out up to this one fit the budget
+          std::unique_lock<std::mutex> guard(lock_);
+          handed_out_.wait(guard, [this, run]() {
+            const auto current = handing_out();
+            return stop_ || current > run ||
+                   cells_before_[run + 1] - cells_before_[current] <= max_prefetched_cells_;
+          });
+          if (stop_) {
+            return;
+          }
+          // all of the tiles of this run have been handed out already
+          if (runs_[run].end <= next_) {
+            continue;
+          }
+        }
+        for (auto cell : runs_[run].cells) {
+          sample_.prefetch(cell);
+        }
+      }
+    } catch (const std::exception& e) {
+      // the threads will just load the cells themselves
+      LOG_WARN(std::string("Stopped prefetching elevation: ") + e.what());
+    }
+  }
+
+  // the run of the next tile to hand out, or the number of runs if there is none left
+  size_t handing_out() const {
+    return std::upper_bound(runs_.begin(), runs_.end(), next_,
+                            [](size_t next, const run_t& run) { return next < run.end; }) -
+           runs_.begin();
+  }
+
+  valhalla::skadi::sample& sample_;
+  const size_t max_prefetched_cells_;
+  std::vector<GraphId> tiles_;
+  std::vector<run_t> runs_;
+  std::vector<size_t> cells_before_;
+  size_t next_;
+  bool stop_;
+  std::mutex lock_;
+  std::condition_variable handed_out_;
+  std::thread prefetcher_;
+};
+
 /**
  * Encode elevation along an edge to store in tiles.
  */
@@ -107,12 +259,41 @@ std::vector<int8_t> encode_btf_elevation(const std::unique_ptr<valhalla::skadi::
   return e;
 }
 
+/**
+ * Returns the directed edge at the same index in the previous build of the tile if its
+ * elevation can be copied, that is if nothing the elevation is computed from has changed.
+ */
+const DirectedEdge* unchanged_edge(const graph_tile_ptr& previous,
+                                   GraphTileBuilder& tilebuilder,
+                                   const uint32_t index,
+                                   const DirectedEdge& directededge,
+                                   const bool store_elevation_along_edges) {
+  if (previous == nullptr || index >= previous->header()->directededgecount()) {
+    return nullptr;
+  }
+  const DirectedEdge* edge = previous->directededge(index);
+  if (edge->length() != directededge.length() || edge->forward() != directededge.forward() ||
+      edge->bridge() != directededge.bridge() || edge->tunnel() != directededge.tunnel() ||
+      edge->use() != directededge.use()) {
+    return nullptr;
+  }
+  auto edgeinfo = previous->edgeinfo(edge);
+  auto new_edgeinfo = tilebuilder.edgeinfo(&directededge);
+  if (edgeinfo.has_elevation() != store_elevation_along_edges ||
+      edgeinfo.wayid() != new_edgeinfo.wayid() ||
+      edgeinfo.encoded_shape() != new_edgeinfo.encoded_shape()) {
+    return nullptr;
+  }
+  return edge;
+}
+
 void add_elevations_to_single_tile(GraphReader& graphreader,
                                    std::mutex& graphreader_lck,
                                    cache_t& cache,
                                    const std::unique_ptr<valhalla::skadi::sample>& sample,
-                                   GraphId& tile_id, 
-                                   boost::optional<bool> store_elevation_along_edges) {
+                                   GraphId& tile_id,
+                                   boost::optional<bool> store_elevation_along_edges,
+                                   const graph_tile_ptr& previous) {
   // Get the tile. Serialize the entire tile?
   GraphTileBuilder tilebuilder(graphreader.tile_dir(), tile_id, true);
 
@@ -121,11 +302,17 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
   tilebuilder.header_builder().set_has_elevation(true);
 
   // Iterate through the nodes edges, get the node lat,lng, sample and store elevation.
+  // Nodes that did not move since the previous build keep their elevation.
   for (uint32_t i = 0; i < tilebuilder.header()->nodecount(); ++i) {
     // Get a writeable reference to the node edge
     NodeInfo& nodeinfo = tilebuilder.node_builder(i);
     PointLL ll = nodeinfo.latlng(tilebuilder.header()->base_ll());
-    nodeinfo.set_elevation(sample->get(ll));
+    if (previous != nullptr && i < previous->header()->nodecount() &&
+        previous->node(i)->latlng(previous->header()->base_ll()) == ll) {
+      nodeinfo.set_elevation(previous->node(i)->elevation());
+    } else {
+      nodeinfo.set_elevation(sample->get(ll));
+    }
   }
 
   // Reserve twice the number of directed edges in the tile. We do not directly know
@@ -154,6 +341,28 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
     // Get the edge info offset
     uint32_t edge_info_offset = directededge.edgeinfo_offset();
 
+    // Copy the elevation of edges that did not change since the previous build
+    const DirectedEdge* unchanged =
+        unchanged_edge(previous, tilebuilder, elem.second, directededge,
+                       static_cast<bool>(store_elevation_along_edges));
+    if (unchanged != nullptr) {
+      if (new_offsets.find(edge_info_offset) == new_offsets.cend()) {
+        new_offsets[edge_info_offset] = ei_offset;
+        auto edgeinfo = previous->edgeinfo(unchanged);
+        double interval = 0.0;
+        std::vector<int8_t> encoded;
+        if (edgeinfo.has_elevation()) {
+          encoded = edgeinfo.encoded_elevation(unchanged->length(), interval);
+        }
+        ei_offset +=
+            tilebuilder.set_elevation(edge_info_offset, edgeinfo.mean_elevation(), encoded);
+      }
+      directededge.set_weighted_grade(unchanged->weighted_grade());
+      directededge.set_max_up_slope(unchanged->max_up_slope());
+      directededge.set_max_down_slope(unchanged->max_down_slope());
+      continue;
+    }
+
     // Check if this edge has been cached (based on edge info offset)
     auto found = cache.find(edge_info_offset);
     if (found == cache.cend()) {
@@ -214,21 +423,23 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
                                         std::get<2>(reverse_grades))});
       found = inserted.first;
 
-      // Store the new edge info offset
-      new_offsets[edge_info_offset] = ei_offset;
-
-      // Encode elevation along the edge and add to EdgeInfo along with the mean elevation.
-      // Bridges, tunnels, ferries are special cases. Increment the new edge info offset.
-      std::vector<int8_t> encoded;
-      if (store_elevation_along_edges) {
-        auto wayid = tilebuilder.edgeinfo(&directededge).wayid();
-        if (directededge.bridge() || directededge.tunnel() || directededge.use() == Use::kFerry) {
-          encoded = encode_btf_elevation(sample, shape, length, wayid);
-        } else {
-          encoded = encode_edge_elevation(sample, shape, length, wayid);
+      // Store the new edge info offset, unless the other direction already copied it
+      if (new_offsets.find(edge_info_offset) == new_offsets.cend()) {
+        new_offsets[edge_info_offset] = ei_offset;
+
+        // Encode elevation along the edge and add to EdgeInfo along with the mean elevation.
+        // Bridges, tunnels, ferries are special cases. Increment the new edge info offset.
+        std::vector<int8_t> encoded;
+        if (store_elevation_along_edges) {
+          auto wayid = tilebuilder.edgeinfo(&directededge).wayid();
+          if (directededge.bridge() || directededge.tunnel() || directededge.use() == Use::kFerry) {
+            encoded = encode_btf_elevation(sample, shape, length, wayid);
+          } else {
+            encoded = encode_edge_elevation(sample, shape, length, wayid);
+          }
         }
+        ei_offset += tilebuilder.set_elevation(edge_info_offset, mean_elevation, encoded);
       }
-      ei_offset += tilebuilder.set_elevation(edge_info_offset, mean_elevation, encoded);
     }
 
     // Edge elevation information. If the edge is forward (with respect to the shape)
@@ -266,49 +477,59 @@ void add_elevations_to_single_tile(GraphReader& graphreader,
 }
 
 /**
- * Adds elevation to a set of tiles. Each thread pulls a tile of the queue
+ * Adds elevation to a set of tiles. Each thread pulls the next tile from the scheduler
  */
 void add_elevations_to_multiple_tiles(const boost::property_tree::ptree& pt,
-                                      std::deque<GraphId>& tilequeue,
+                                      tile_scheduler_t& scheduler,
                                       std::mutex& lock,
                                       const std::unique_ptr<valhalla::skadi::sample>& sample,
+                                      const std::unordered_set<GraphId>& affected_tiles,
                                       std::promise<uint32_t>& /*result*/) {
   // Local Graphreader
   GraphReader graphreader(pt.get_child("mjolnir"));
   boost::optional<bool> store_elevation_along_edges = pt.get_optional<bool>("mjolnir.store_elevation_along_edges");
 
+  // Reader of the previous build, if any, to copy the elevation of unchanged edges from
+  std::unique_ptr<GraphReader> previous_reader;
+  auto previous_tile_dir = pt.get_optional<std::string>("mjolnir.previous_build.tile_dir");
+  if (previous_tile_dir) {
+    auto previous_config = pt.get_child("mjolnir");
+    previous_config.put("tile_dir", *previous_tile_dir);
+    previous_reader.reset(new GraphReader(previous_config));
+  }
+
   // We usually end up accessing the same shape twice (once for each direction along an edge).
   // Use a cache to record elevation attributes based on the EdgeInfo offset. This includes
   // weighted grade (forward and reverse) as well as max slopes (up/down for forward and reverse).
   cache_t geo_attribute_cache;
 
-  // Check for more tiles
-  while (true) {
-    lock.lock();
-    if (tilequeue.empty()) {
-      lock.unlock();
-      break;
+  // Get the next tile Id while there are more tiles
+  GraphId tile_id;
+  while (scheduler.next(tile_id)) {
+    // Tiles affected by the change are always sampled
+    graph_tile_ptr previous;
+    if (previous_reader && affected_tiles.find(tile_id) == affected_tiles.cend() &&
+        previous_reader->DoesTileExist(tile_id)) {
+      previous = previous_reader->GetGraphTile(tile_id);
     }
-    // Get the next tile Id
-    GraphId tile_id = tilequeue.front();
-    tilequeue.pop_front();
-    lock.unlock();
 
-    add_elevations_to_single_tile(graphreader, lock, geo_attribute_cache, sample, tile_id, store_elevation_along_edges.get_value_or(true));
+    add_elevations_to_single_tile(graphreader, lock, geo_attribute_cache, sample, tile_id,
+                                  store_elevation_along_edges.get_value_or(true), previous);
+
+    if (previous_reader && previous_reader->OverCommitted()) {
+      previous_reader->Trim();
+    }
   }
 }
 
 std::deque<GraphId> get_tile_ids(const boost::property_tree::ptree& pt) {
   std::deque<GraphId> tilequeue;
   GraphReader reader(pt.get_child("mjolnir"));
-  // Create a randomized queue of tiles (at all levels) to work from
+  // Create a queue of tiles (at all levels) to work from, the scheduler orders them
   auto tileset = reader.GetTileSet();
   for (const auto& id : tileset)
     tilequeue.emplace_back(id);
 
-  std::random_device rd;
-  std::shuffle(tilequeue.begin(), tilequeue.end(), std::mt19937(rd()));
-
   return tilequeue;
 }
 
@@ -318,7 +539,8 @@ namespace valhalla {
 namespace mjolnir {
 
 void ElevationBuilder::Build(const boost::property_tree::ptree& pt,
-                             std::deque<baldr::GraphId> tile_ids) {
+                             std::deque<baldr::GraphId> tile_ids,
+                             const std::unordered_set<baldr::GraphId>& affected_tiles) {
   boost::optional<std::string> elevation = pt.get_optional<std::string>("additional_data.elevation");
   if (!elevation || !filesystem::exists(*elevation)) {
     LOG_WARN("Elevation storage directory does not exist");
@@ -336,13 +558,15 @@ void ElevationBuilder::Build(const boost::property_tree::ptree& pt,
   std::vector<std::shared_ptr<std::thread>> threads(nthreads);
   std::vector<std::promise<uint32_t>> results(nthreads);
 
-  LOG_INFO("Adding elevation to " + std::to_string(tile_ids.size()) + " tiles with " +
+  tile_scheduler_t scheduler(std::move(tile_ids), *sample);
+  LOG_INFO("Adding elevation to " + std::to_string(scheduler.size()) + " tiles with " +
            std::to_string(nthreads) + " threads...");
   std::mutex lock;
   for (auto& thread : threads) {
     results.emplace_back();
-    thread.reset(new std::thread(add_elevations_to_multiple_tiles, std::cref(pt), std::ref(tile_ids),
-                                 std::ref(lock), std::ref(sample), std::ref(results.back())));
+    thread.reset(new std::thread(add_elevations_to_multiple_tiles, std::cref(pt),
+                                 std::ref(scheduler), std::ref(lock), std::ref(sample),
+                                 std::cref(affected_tiles), std::ref(results.back())));
   }
 
   for (auto& thread : threads) {
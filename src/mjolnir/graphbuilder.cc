@@ -1,5 +1,6 @@
 #include <future>
 #include <memory>
+#include <queue>
 #include <thread>
 #include <utility>
 
@@ -23,6 +24,7 @@
 #include "midgard/tiles.h"
 #include "midgard/util.h"
 #include "mjolnir/admin.h"
+#include "mjolnir/adminindex.h"
 #include "mjolnir/edgeinfobuilder.h"
 #include "mjolnir/ferry_connections.h"
 #include "mjolnir/graphbuilder.h"
@@ -37,79 +39,141 @@ using namespace valhalla::mjolnir;
 
 namespace {
 
+using edge_ends_t = sequence<std::pair<uint32_t, uint32_t>>;
+
+// Name of the temporary file holding one part of a file that is built on several threads
+std::string PartFile(const std::string& file, const std::string& kind, const size_t part) {
+  auto path = filesystem::path(file);
+  path.replace_filename(path.filename().string() + "." + kind + "." + std::to_string(part) +
+                        ".tmp");
+  return path.string();
+}
+
+// Appends the contents of a part file to a sequence and removes the part file
+template <class T, class Transform>
+void AppendPart(sequence<T>& all, const std::string& part_file, const Transform& transform) {
+  {
+    sequence<T> part(part_file, false);
+    part.enumerate([&all, &transform](T item) {
+      transform(item);
+      all.push_back(item);
+    });
+  }
+  filesystem::remove(part_file);
+}
+
+template <class T> void AppendPart(sequence<T>& all, const std::string& part_file) {
+  AppendPart(all, part_file, [](T&) {});
+}
+
 /**
  * we need the nodes to be sorted by graphid and then by osmid to make a set of tiles
  * we also need to then update the edges that pointed to them
  *
+ * node ids restart within each tile so the sorted nodes are split into ranges starting at tile
+ * boundaries which are numbered on their own threads, giving the same result as a single pass
  */
-std::map<GraphId, size_t> SortGraph(const std::string& nodes_file, const std::string& edges_file) {
+std::map<GraphId, size_t>
+SortGraph(const std::string& nodes_file, const std::string& edges_file, const size_t concurrency) {
   LOG_INFO("Sorting graph...");
 
   // Sort nodes by graphid then by grid within the tile. This sorts nodes geo-spatially which
   // helps performance by improving memory coherence.
   sequence<Node> nodes(nodes_file, false);
-  nodes.sort([](const Node& a, const Node& b) {
-    if (a.graph_id == b.graph_id) {
-      if (a.grid_id == b.grid_id) {
-        return a.node.osmid_ < b.node.osmid_;
-      } else {
-        return a.grid_id < b.grid_id;
-      }
+  nodes.sort(
+      [](const Node& a, const Node& b) {
+        if (a.graph_id == b.graph_id) {
+          if (a.grid_id == b.grid_id) {
+            return a.node.osmid_ < b.node.osmid_;
+          } else {
+            return a.grid_id < b.grid_id;
+          }
+        }
+        return a.graph_id < b.graph_id;
+      },
+      sequence<Node>::default_sort_buffer, concurrency);
+
+  // split the nodes into ranges that each begin with the first node of a tile
+  std::vector<size_t> bounds{0};
+  for (size_t part = 1; part < concurrency; ++part) {
+    size_t index = std::max(bounds.back(), nodes.size() * part / concurrency);
+    if (index == 0 || index == bounds.back()) {
+      continue;
     }
-    return a.graph_id < b.graph_id;
-  });
+    const GraphId tile = (*nodes[index - 1]).graph_id;
+    while (index < nodes.size() && (*nodes[index]).graph_id == tile) {
+      ++index;
+    }
+    if (index < nodes.size()) {
+      bounds.push_back(index);
+    }
+  }
+  bounds.push_back(nodes.size());
 
   // run through the sorted nodes, going back to the edges they reference and updating each edge
   // to point to the first (out of the duplicates) nodes index. at the end of this there will be
   // tons of nodes that no edges reference, but we need them because they are the means by which
   // we know what edges connect to a given node from the nodes perspective
+  std::vector<std::map<GraphId, size_t>> range_tiles(bounds.size() - 1);
+  std::vector<size_t> range_node_counts(bounds.size() - 1, 0);
+  parallel_for(range_tiles.size(), range_tiles.size(), [&](size_t, size_t range) {
+    edge_ends_t starts(PartFile(edges_file, "starts", range), true);
+    edge_ends_t ends(PartFile(edges_file, "ends", range), true);
+    auto& tiles = range_tiles[range];
+    auto& node_count = range_node_counts[range];
+    uint32_t run_index = 0;
+    Node last_node{};
+    for (size_t node_index = bounds[range]; node_index < bounds[range + 1]; ++node_index) {
+      auto element = nodes[node_index];
+      Node node = *element;
+      // remember if this was a new tile
+      if (node_index == bounds[range] || node.graph_id != (--tiles.end())->first) {
+        tiles.insert({node.graph_id, node_index});
+        node.graph_id.set_id(0);
+        run_index = node_index;
+        ++node_count;
+      } // but is it a new node
+      else if (last_node.node.osmid_ != node.node.osmid_) {
+        node.graph_id.set_id(last_node.graph_id.id() + 1);
+        run_index = node_index;
+        ++node_count;
+      } // not new keep the same graphid
+      else {
+        node.graph_id.set_id(last_node.graph_id.id());
+      }
 
+      // if this node marks the start of an edge, keep track of the edge and the node
+      // so we can later tell the edge where the first node in the series is
+      if (node.is_start()) {
+        starts.push_back(std::make_pair(node.start_of, run_index));
+      }
+      // if this node marks the end of an edge, keep track of the edge and the node
+      // so we can later tell the edge where the final node in the series is
+      if (node.is_end()) {
+        ends.push_back(std::make_pair(node.end_of, run_index));
+      }
+
+      // next node
+      element = node;
+      last_node = node;
+    }
+  });
+
+  // gather up the tiles and the edge ends of all the ranges
   auto start_node_edge_file = filesystem::path(edges_file);
   start_node_edge_file.replace_filename(start_node_edge_file.filename().string() + ".starts.tmp");
   auto end_node_edge_file = filesystem::path(edges_file);
   end_node_edge_file.replace_filename(end_node_edge_file.filename().string() + ".ends.tmp");
-  using edge_ends_t = sequence<std::pair<uint32_t, uint32_t>>;
   std::unique_ptr<edge_ends_t> starts(new edge_ends_t(start_node_edge_file.string(), true));
   std::unique_ptr<edge_ends_t> ends(new edge_ends_t(end_node_edge_file.string(), true));
-
-  uint32_t run_index = 0;
-  uint32_t node_index = 0;
-  size_t node_count = 0;
-  Node last_node{};
   std::map<GraphId, size_t> tiles;
-  nodes.transform(
-      [&starts, &ends, &run_index, &node_index, &node_count, &last_node, &tiles](Node& node) {
-        // remember if this was a new tile
-        if (node_index == 0 || node.graph_id != (--tiles.end())->first) {
-          tiles.insert({node.graph_id, node_index});
-          node.graph_id.set_id(0);
-          run_index = node_index;
-          ++node_count;
-        } // but is it a new node
-        else if (last_node.node.osmid_ != node.node.osmid_) {
-          node.graph_id.set_id(last_node.graph_id.id() + 1);
-          run_index = node_index;
-          ++node_count;
-        } // not new keep the same graphid
-        else {
-          node.graph_id.set_id(last_node.graph_id.id());
-        }
-
-        // if this node marks the start of an edge, keep track of the edge and the node
-        // so we can later tell the edge where the first node in the series is
-        if (node.is_start()) {
-          starts->push_back(std::make_pair(node.start_of, run_index));
-        }
-        // if this node marks the end of an edge, keep track of the edge and the node
-        // so we can later tell the edge where the final node in the series is
-        if (node.is_end()) {
-          ends->push_back(std::make_pair(node.end_of, run_index));
-        }
-
-        // next node
-        last_node = node;
-        ++node_index;
-      });
+  size_t node_count = 0;
+  for (size_t range = 0; range < range_tiles.size(); ++range) {
+    tiles.insert(range_tiles[range].begin(), range_tiles[range].end());
+    node_count += range_node_counts[range];
+    AppendPart(*starts, PartFile(edges_file, "starts", range));
+    AppendPart(*ends, PartFile(edges_file, "ends", range));
+  }
 
   // every edge should have a begin and end node
   assert(starts->size() == ends->size());
@@ -120,25 +184,29 @@ std::map<GraphId, size_t> SortGraph(const std::string& nodes_file, const std::st
   auto cmp = [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
     return a.first < b.first;
   };
-  starts->sort(cmp);
-  ends->sort(cmp);
+  starts->sort(cmp, 1024 * 1024 * 512 / sizeof(std::pair<uint32_t, uint32_t>), concurrency);
+  ends->sort(cmp, 1024 * 1024 * 512 / sizeof(std::pair<uint32_t, uint32_t>), concurrency);
 
   sequence<Edge> edges(edges_file, false);
 
   LOG_INFO("Sorting begin and end nodes done. Populating edges...");
 
-  auto s_it = starts->begin(), e_it = ends->begin();
-  while (s_it != starts->end() && e_it != ends->end()) {
-    // there should be exactly one edge per begin and end node sequence and we sorted them the same
-    assert((*s_it).first == (*e_it).first);
-    auto element = edges[(*s_it).first];
-    auto edge = *element;
-    edge.sourcenode_ = (*s_it).second;
-    edge.targetnode_ = (*e_it).second;
-    element = edge;
-    ++s_it;
-    ++e_it;
-  }
+  // each thread updates a contiguous run of the edges, every edge has exactly one entry in each
+  const size_t count = std::min(starts->size(), ends->size());
+  parallel_for(concurrency, concurrency, [&](size_t, size_t part) {
+    for (size_t i = count * part / concurrency; i < count * (part + 1) / concurrency; ++i) {
+      const auto start = *(*starts)[i];
+      const auto end = *(*ends)[i];
+      // there should be exactly one edge per begin and end node sequence and we sorted them the
+      // same
+      assert(start.first == end.first);
+      auto element = edges[start.first];
+      auto edge = *element;
+      edge.sourcenode_ = start.second;
+      edge.targetnode_ = end.second;
+      element = edge;
+    }
+  });
 
   // clean up tmp files
   starts.reset();
@@ -150,16 +218,18 @@ std::map<GraphId, size_t> SortGraph(const std::string& nodes_file, const std::st
   return tiles;
 }
 
-// Construct edges in the graph and assign nodes to tiles.
-void ConstructEdges(const std::string& ways_file,
-                    const std::string& way_nodes_file,
-                    const std::string& nodes_file,
-                    const std::string& edges_file,
-                    const std::function<GraphId(const OSMNode&)>& graph_id_predicate,
-                    const std::function<uint32_t(const OSMNode&)>& grid_id_predicate,
-                    const bool infer_turn_channels) {
-  LOG_INFO("Creating graph edges from ways...");
-
+// Construct edges in the graph from the way nodes in [begin, end), which has to start and end at
+// way boundaries, and assign nodes to tiles. The edges the nodes refer to are counted from 0.
+// Returns the number of edges.
+size_t ConstructEdges(const std::string& ways_file,
+                      const std::string& way_nodes_file,
+                      const size_t begin,
+                      const size_t end,
+                      const std::string& nodes_file,
+                      const std::string& edges_file,
+                      const std::function<GraphId(const OSMNode&)>& graph_id_predicate,
+                      const std::function<uint32_t(const OSMNode&)>& grid_id_predicate,
+                      const bool infer_turn_channels) {
   // so we can read ways and nodes and write edges
   sequence<OSMWay> ways(ways_file, false);
   sequence<OSMWayNode> way_nodes(way_nodes_file, false);
@@ -174,8 +244,8 @@ void ConstructEdges(const std::string& ways_file,
 
   // For each way traversed via the nodes
   GraphId graphid;
-  size_t current_way_node_index = 0;
-  while (current_way_node_index < way_nodes.size()) {
+  size_t current_way_node_index = begin;
+  while (current_way_node_index < end) {
     // Grab the way and its first node
     auto way_node = *way_nodes[current_way_node_index];
     const auto way = *ways[way_node.way_index];
@@ -284,6 +354,72 @@ void ConstructEdges(const std::string& ways_file,
       }
     }
   }
+  return edges.size();
+}
+
+// Construct edges in the graph and assign nodes to tiles. The way nodes are split into parts at
+// way boundaries which are made into edges on their own threads. The parts are then appended in
+// order, offsetting the edges the nodes refer to, so the result is the same as a single pass.
+void ConstructEdges(const std::string& ways_file,
+                    const std::string& way_nodes_file,
+                    const std::string& nodes_file,
+                    const std::string& edges_file,
+                    const std::function<GraphId(const OSMNode&)>& graph_id_predicate,
+                    const std::function<uint32_t(const OSMNode&)>& grid_id_predicate,
+                    const bool infer_turn_channels,
+                    const size_t concurrency) {
+  LOG_INFO("Creating graph edges from ways...");
+
+  // split the way nodes into parts that each begin with the first node of a way
+  std::vector<size_t> bounds{0};
+  {
+    sequence<OSMWayNode> way_nodes(way_nodes_file, false);
+    for (size_t part = 1; part < concurrency; ++part) {
+      size_t index = std::max(bounds.back(), way_nodes.size() * part / concurrency);
+      if (index == 0 || index == bounds.back()) {
+        continue;
+      }
+      const auto way_index = (*way_nodes[index - 1]).way_index;
+      while (index < way_nodes.size() && (*way_nodes[index]).way_index == way_index) {
+        ++index;
+      }
+      if (index < way_nodes.size()) {
+        bounds.push_back(index);
+      }
+    }
+    bounds.push_back(way_nodes.size());
+  }
+
+  // a single part is written straight to the output
+  const size_t parts = bounds.size() - 1;
+  if (parts == 1) {
+    auto edge_count = ConstructEdges(ways_file, way_nodes_file, bounds[0], bounds[1], nodes_file,
+                                     edges_file, graph_id_predicate, grid_id_predicate,
+                                     infer_turn_channels);
+    LOG_INFO("Finished with " + std::to_string(edge_count) + " graph edges");
+    return;
+  }
+
+  parallel_for(parts, parts, [&](size_t, size_t part) {
+    ConstructEdges(ways_file, way_nodes_file, bounds[part], bounds[part + 1],
+                   PartFile(nodes_file, "part", part), PartFile(edges_file, "part", part),
+                   graph_id_predicate, grid_id_predicate, infer_turn_channels);
+  });
+
+  sequence<Edge> edges(edges_file, true);
+  sequence<Node> nodes(nodes_file, true);
+  for (size_t part = 0; part < parts; ++part) {
+    const auto offset = static_cast<uint32_t>(edges.size());
+    AppendPart(edges, PartFile(edges_file, "part", part));
+    AppendPart(nodes, PartFile(nodes_file, "part", part), [offset](Node& node) {
+      if (node.is_start()) {
+        node.start_of += offset;
+      }
+      if (node.is_end()) {
+        node.end_of += offset;
+      }
+    });
+  }
   LOG_INFO("Finished with " + std::to_string(edges.size()) + " graph edges");
 }
 
@@ -410,6 +546,8 @@ void BuildTileSet(const std::string& ways_file,
                   std::mutex& tiles_lock,
                   const uint32_t tile_creation_date,
                   const boost::property_tree::ptree& pt,
+                  const AdminIndex* admin_polys_index,
+                  const AdminIndex* tz_polys_index,
                   std::promise<DataQuality>& result) {
 
   sequence<OSMWay> ways(ways_file, false);
@@ -426,21 +564,22 @@ void BuildTileSet(const std::string& ways_file,
   bool use_urban_tag = pt.get<bool>("data_processing.use_urban_tag", false);
   bool use_admin_db = pt.get<bool>("data_processing.use_admin_db", true);
 
-  // Initialize the admin DB (if it exists)
-  sqlite3* admin_db_handle = (database && use_admin_db) ? GetDBHandle(*database) : nullptr;
+  // Initialize the admin DB (if it exists), unless we can use its index
+  sqlite3* admin_db_handle =
+      (database && use_admin_db && !admin_polys_index) ? GetDBHandle(*database) : nullptr;
   if (!database && use_admin_db) {
     LOG_WARN("Admin db not found.  Not saving admin information.");
-  } else if (!admin_db_handle && use_admin_db) {
+  } else if (!admin_polys_index && !admin_db_handle && use_admin_db) {
     LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
   }
   auto admin_conn = make_spatialite_cache(admin_db_handle);
 
   database = pt.get_optional<std::string>("timezone");
-  // Initialize the tz DB (if it exists)
-  sqlite3* tz_db_handle = database ? GetDBHandle(*database) : nullptr;
+  // Initialize the tz DB (if it exists), unless we can use its index
+  sqlite3* tz_db_handle = (database && !tz_polys_index) ? GetDBHandle(*database) : nullptr;
   if (!database) {
     LOG_WARN("Time zone db not found.  Not saving time zone information.");
-  } else if (!tz_db_handle) {
+  } else if (!tz_polys_index && !tz_db_handle) {
     LOG_WARN("Time zone db " + *database + " not found.  Not saving time zone information.");
   }
   auto tz_conn = make_spatialite_cache(tz_db_handle);
@@ -504,9 +643,15 @@ void BuildTileSet(const std::string& ways_file,
       std::unordered_map<uint32_t, bool> allow_intersection_names;
       language_poly_index language_polys;
 
-      if (admin_db_handle) {
-        admin_polys = GetAdminInfo(admin_db_handle, drive_on_right, allow_intersection_names,
-                                   language_polys, tiling.TileBounds(id), graphtile);
+      if (admin_polys_index || admin_db_handle) {
+        if (admin_polys_index) {
+          admin_polys = admin_polys_index->GetAdminInfo(drive_on_right, allow_intersection_names,
+                                                        language_polys, tiling.TileBounds(id),
+                                                        graphtile);
+        } else {
+          admin_polys = GetAdminInfo(admin_db_handle, drive_on_right, allow_intersection_names,
+                                     language_polys, tiling.TileBounds(id), graphtile);
+        }
         if (admin_polys.size() == 1) {
           // TODO - check if tile bounding box is entirely inside the polygon...
           tile_within_one_admin = true;
@@ -514,7 +659,8 @@ void BuildTileSet(const std::string& ways_file,
       }
 
       bool tile_within_one_tz = false;
-      auto tz_polys = GetTimeZones(tz_db_handle, tiling.TileBounds(id));
+      auto tz_polys = tz_polys_index ? tz_polys_index->GetTimeZones(tiling.TileBounds(id))
+                                     : GetTimeZones(tz_db_handle, tiling.TileBounds(id));
       if (tz_polys.size() == 1) {
         tile_within_one_tz = true;
       }
@@ -1337,6 +1483,18 @@ void BuildLocalTiles(const unsigned int thread_count,
   uint32_t tile_creation_date =
       DateTime::days_from_pivot_date(DateTime::get_formatted_date(DateTime::iso_date_time(tz)));
 
+  // Map the indexes of the admin and timezone dbs once for all threads, building them from the dbs
+  // if need be. Threads fall back to querying the dbs per tile if an index can't be had
+  std::unique_ptr<AdminIndex> admin_polys_index, tz_polys_index;
+  auto database = pt.get_optional<std::string>("mjolnir.admin");
+  if (database && pt.get<bool>("mjolnir.data_processing.use_admin_db", true)) {
+    admin_polys_index = AdminIndex::Open(*database, AdminIndex::Kind::kAdmins);
+  }
+  database = pt.get_optional<std::string>("mjolnir.timezone");
+  if (database) {
+    tz_polys_index = AdminIndex::Open(*database, AdminIndex::Kind::kTimezones);
+  }
+
   LOG_INFO("Building " + std::to_string(tiles.size()) + " tiles with " +
            std::to_string(thread_count) + " threads...");
 
@@ -1364,6 +1522,7 @@ void BuildLocalTiles(const unsigned int thread_count,
                                       std::cref(linguistic_node_file), std::cref(tile_dir),
                                       std::cref(osmdata), std::ref(tile_queue), std::ref(tile_lock),
                                       tile_creation_date, std::cref(pt.get_child("mjolnir")),
+                                      admin_polys_index.get(), tz_polys_index.get(),
                                       std::ref(results[i]));
   }
 
@@ -1436,6 +1595,11 @@ std::map<GraphId, size_t> GraphBuilder::BuildEdges(const boost::property_tree::p
     LOG_INFO("Spatial sorting of nodes within each tile is disabled");
   }
 
+  // Both steps are split over threads
+  const size_t concurrency =
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency()));
+
   // Make the edges and nodes in the graph
   ConstructEdges(
       ways_file, way_nodes_file, nodes_file, edges_file,
@@ -1443,9 +1607,9 @@ std::map<GraphId, size_t> GraphBuilder::BuildEdges(const boost::property_tree::p
       [&tiling, &grid_divisions](const OSMNode& node) {
         return GetGridId(node.latlng(), tiling, grid_divisions);
       },
-      pt.get<bool>("mjolnir.data_processing.infer_turn_channels", true));
+      pt.get<bool>("mjolnir.data_processing.infer_turn_channels", true), concurrency);
 
-  return SortGraph(nodes_file, edges_file);
+  return SortGraph(nodes_file, edges_file, concurrency);
 }
 
 // Build the graph from the input
@@ -1,5 +1,6 @@
 #include "mjolnir/graphenhancer.h"
 #include "mjolnir/admin.h"
+#include "mjolnir/adminindex.h"
 #include "mjolnir/countryaccess.h"
 #include "mjolnir/graphtilebuilder.h"
 #include "mjolnir/util.h"
@@ -1274,6 +1275,7 @@ void enhance(const boost::property_tree::ptree& pt,
              const OSMData& osmdata,
              const std::string& access_file,
              const boost::property_tree::ptree& hierarchy_properties,
+             const std::unordered_map<std::string, std::vector<int>>& country_access,
              std::queue<GraphId>& tilequeue,
              std::mutex& lock,
              std::promise<enhancer_stats>& result) {
@@ -1281,24 +1283,11 @@ void enhance(const boost::property_tree::ptree& pt,
   auto less_than = [](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); };
   sequence<OSMAccess> access_tags(access_file, false);
 
-  auto database = pt.get_optional<std::string>("admin");
   bool infer_internal_intersections =
       pt.get<bool>("data_processing.infer_internal_intersections", true);
   bool infer_turn_channels = pt.get<bool>("data_processing.infer_turn_channels", true);
   bool apply_country_overrides = pt.get<bool>("data_processing.apply_country_overrides", true);
   bool use_urban_tag = pt.get<bool>("data_processing.use_urban_tag", false);
-  bool use_admin_db = pt.get<bool>("data_processing.use_admin_db", true);
-  // Initialize the admin DB (if it exists)
-  sqlite3* admin_db_handle = (database && use_admin_db) ? GetDBHandle(*database) : nullptr;
-  if (!database && use_admin_db) {
-    LOG_WARN("Admin db not found.  Not saving admin information.");
-  } else if (!admin_db_handle && use_admin_db) {
-    LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
-  }
-  auto admin_conn = make_spatialite_cache(admin_db_handle);
-
-  std::unordered_map<std::string, std::vector<int>> country_access =
-      GetCountryAccess(admin_db_handle);
 
   // Local Graphreader
   GraphReader reader(hierarchy_properties);
@@ -1698,10 +1687,6 @@ void enhance(const boost::property_tree::ptree& pt,
     lock.unlock();
   }
 
-  if (admin_db_handle) {
-    sqlite3_close(admin_db_handle);
-  }
-
   // Send back the statistics
   result.set_value(stats);
 }
@@ -1738,6 +1723,28 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
   std::shuffle(tempqueue.begin(), tempqueue.end(), std::mt19937(rd()));
   std::queue<GraphId> tilequeue(tempqueue);
 
+  // Read the country access records once for all threads, from the index of the admin db if
+  // there is one
+  std::unordered_map<std::string, std::vector<int>> country_access;
+  auto database = pt.get_optional<std::string>("mjolnir.admin");
+  bool use_admin_db = pt.get<bool>("mjolnir.data_processing.use_admin_db", true);
+  auto admin_index = (database && use_admin_db)
+                         ? AdminIndex::Open(*database, AdminIndex::Kind::kAdmins)
+                         : nullptr;
+  sqlite3* admin_db_handle =
+      (database && use_admin_db && !admin_index) ? GetDBHandle(*database) : nullptr;
+  if (!database && use_admin_db) {
+    LOG_WARN("Admin db not found.  Not saving admin information.");
+  } else if (!admin_index && !admin_db_handle && use_admin_db) {
+    LOG_WARN("Admin db " + *database + " not found.  Not saving admin information.");
+  }
+  if (admin_index) {
+    country_access = admin_index->GetCountryAccess();
+  } else if (admin_db_handle) {
+    country_access = GetCountryAccess(admin_db_handle);
+    sqlite3_close(admin_db_handle);
+  }
+
   // An atomic object we can use to do the synchronization
   std::mutex lock;
 
@@ -1746,7 +1753,8 @@ void GraphEnhancer::Enhance(const boost::property_tree::ptree& pt,
     results.emplace_back();
     thread.reset(new std::thread(enhance, std::cref(hierarchy_properties), std::cref(osmdata),
                                  std::cref(access_file), std::ref(hierarchy_properties),
-                                 std::ref(tilequeue), std::ref(lock), std::ref(results.back())));
+                                 std::cref(country_access), std::ref(tilequeue), std::ref(lock),
+                                 std::ref(results.back())));
   }
 
   // Wait for them to finish up their work
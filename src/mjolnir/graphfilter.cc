@@ -3,7 +3,11 @@
 #include "mjolnir/util.h"
 
 #include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -24,12 +28,13 @@ using namespace valhalla::mjolnir;
 
 namespace {
 
-uint32_t n_original_edges = 0;
-uint32_t n_original_nodes = 0;
-uint32_t n_filtered_edges = 0;
-uint32_t n_filtered_nodes = 0;
-uint32_t can_aggregate = 0;
-uint32_t aggregated = 0;
+// Stats, tiles are filtered and aggregated on several threads at once
+std::atomic<uint32_t> n_original_edges(0);
+std::atomic<uint32_t> n_original_nodes(0);
+std::atomic<uint32_t> n_filtered_edges(0);
+std::atomic<uint32_t> n_filtered_nodes(0);
+std::atomic<uint32_t> can_aggregate(0);
+std::atomic<uint32_t> aggregated(0);
 
 // Group wheelchair and pedestrian access together
 constexpr uint32_t kAllPedestrianAccess = (kPedestrianAccess | kWheelchairAccess);
@@ -219,18 +224,20 @@ bool Aggregate(GraphId& start_node,
 }
 
 /**
- * Filter edges to optionally remove edges by access.
+ * Filter the edges of a tile to optionally remove edges by access.
  * @param  reader  Graph reader.
+ * @param  tile_id  Tile to filter.
  * @param  old_to_new  Map of original node Ids to new nodes Ids (after filtering).
  * @param  include_driving  Include edge if driving (any vehicular) access in either direction.
  * @param  include_bicycle  Include edge if bicycle access in either direction.
  * @param  include_pedestrian  Include edge if pedestrian or wheelchair access in either direction.
  */
-void FilterTiles(GraphReader& reader,
-                 std::unordered_map<GraphId, GraphId>& old_to_new,
-                 const bool include_driving,
-                 const bool include_bicycle,
-                 const bool include_pedestrian) {
+void FilterTile(GraphReader& reader,
+                const GraphId& tile_id,
+                std::unordered_map<GraphId, GraphId>& old_to_new,
+                const bool include_driving,
+                const bool include_bicycle,
+                const bool include_pedestrian) {
 
   // lambda to check if an edge should be included
   auto include_edge = [&include_driving, &include_bicycle,
@@ -246,194 +253,236 @@ void FilterTiles(GraphReader& reader,
            (pedestrian_access && include_pedestrian);
   };
 
-  // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet(TileHierarchy::levels().back().level);
-  for (const auto& tile_id : local_tiles) {
-    // Create a new tilebuilder - should copy header information
-    GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
-    n_original_nodes += tilebuilder.header()->nodecount();
-    n_original_edges += tilebuilder.header()->directededgecount();
-
-    // Get the graph tile. Read from this tile to create the new tile.
-    graph_tile_ptr tile = reader.GetGraphTile(tile_id);
-    assert(tile);
-
-    std::hash<std::string> hasher;
-    GraphId nodeid(tile_id.tileid(), tile_id.level(), 0);
-    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
-      bool diff_names = false;
-      bool diff_tile = false;
-      bool edge_filtered = false;
-      // Count of edges added for this node
-      uint32_t edge_count = 0;
-
-      // Current edge index for first edge from this node
-      uint32_t edge_index = tilebuilder.directededges().size();
-
-      // Iterate through directed edges outbound from this node
-      std::vector<uint64_t> wayid;
-      std::vector<RoadClass> classification;
-      std::vector<GraphId> endnode;
-      const NodeInfo* nodeinfo = tile->node(nodeid);
-      std::string begin_node_iso = tile->admin(nodeinfo->admin_index())->country_iso();
-
-      GraphId edgeid(nodeid.tileid(), nodeid.level(), nodeinfo->edge_index());
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); ++j, ++edgeid) {
-        // Check if the directed edge should be included
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        if (!include_edge(directededge)) {
-          ++n_filtered_edges;
-          edge_filtered = true;
-          continue;
-        }
+  // Counts for this tile, added to the stats once the tile is done
+  uint32_t filtered_edges = 0;
+  uint32_t filtered_nodes = 0;
+  uint32_t aggregatable = 0;
+
+  // Create a new tilebuilder - should copy header information
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+
+  // Get the graph tile. Read from this tile to create the new tile.
+  graph_tile_ptr tile = reader.GetGraphTile(tile_id);
+  assert(tile);
+
+  std::hash<std::string> hasher;
+  GraphId nodeid(tile_id.tileid(), tile_id.level(), 0);
+  for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
+    bool diff_names = false;
+    bool diff_tile = false;
+    bool edge_filtered = false;
+    // Count of edges added for this node
+    uint32_t edge_count = 0;
+
+    // Current edge index for first edge from this node
+    uint32_t edge_index = tilebuilder.directededges().size();
+
+    // Iterate through directed edges outbound from this node
+    std::vector<uint64_t> wayid;
+    std::vector<RoadClass> classification;
+    std::vector<GraphId> endnode;
+    const NodeInfo* nodeinfo = tile->node(nodeid);
+    std::string begin_node_iso = tile->admin(nodeinfo->admin_index())->country_iso();
+
+    GraphId edgeid(nodeid.tileid(), nodeid.level(), nodeinfo->edge_index());
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); ++j, ++edgeid) {
+      // Check if the directed edge should be included
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      if (!include_edge(directededge)) {
+        ++filtered_edges;
+        edge_filtered = true;
+        continue;
+      }
 
-        // Copy the directed edge information
-        DirectedEdge newedge = *directededge;
+      // Copy the directed edge information
+      DirectedEdge newedge = *directededge;
 
-        // Set opposing edge indexes to 0 (gets set in graph validator).
-        newedge.set_opp_index(0);
+      // Set opposing edge indexes to 0 (gets set in graph validator).
+      newedge.set_opp_index(0);
 
-        // Get signs from the base directed edge
-        if (directededge->sign()) {
-          std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
-          if (signs.size() == 0) {
-            LOG_ERROR("Base edge should have signs, but none found");
-          }
-          tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
+      // Get signs from the base directed edge
+      if (directededge->sign()) {
+        std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
+        if (signs.size() == 0) {
+          LOG_ERROR("Base edge should have signs, but none found");
         }
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
+      }
 
-        // Get turn lanes from the base directed edge
-        if (directededge->turnlanes()) {
-          uint32_t offset = tile->turnlanes_offset(edgeid.id());
-          tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
-        }
+      // Get turn lanes from the base directed edge
+      if (directededge->turnlanes()) {
+        uint32_t offset = tile->turnlanes_offset(edgeid.id());
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      }
 
-        // Get access restrictions from the base directed edge. Add these to
-        // the list of access restrictions in the new tile. Update the
-        // edge index in the restriction to be the current directed edge Id
-        if (directededge->access_restriction()) {
-          auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
-          for (const auto& res : restrictions) {
-            tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
-                                                               res.type(), res.modes(), res.value()));
-          }
+      // Get access restrictions from the base directed edge. Add these to
+      // the list of access restrictions in the new tile. Update the
+      // edge index in the restriction to be the current directed edge Id
+      if (directededge->access_restriction()) {
+        auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
+        for (const auto& res : restrictions) {
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
+                                                             res.type(), res.modes(), res.value()));
         }
+      }
 
-        // Copy lane connectivity
-        if (directededge->laneconnectivity()) {
-          auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
-          if (laneconnectivity.size() == 0) {
-            LOG_ERROR("Base edge should have lane connectivity, but none found");
-          }
-          for (auto& lc : laneconnectivity) {
-            lc.set_to(tilebuilder.directededges().size());
-          }
-          tilebuilder.AddLaneConnectivity(laneconnectivity);
+      // Copy lane connectivity
+      if (directededge->laneconnectivity()) {
+        auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
+        if (laneconnectivity.size() == 0) {
+          LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
-
-        // Names can be different in the forward and backward direction
-        diff_names = tilebuilder.OpposingEdgeInfoDiffers(tile, directededge);
-
-        // Get edge info, shape, and names from the old tile and add to the
-        // new. Cannot use edge info offset since edges in arterial and
-        // highway hierarchy can cross base tiles! Use a hash based on the
-        // encoded shape plus way Id.
-        bool added;
-        const auto& edgeinfo = tile->edgeinfo(directededge);
-        std::string encoded_shape = edgeinfo.encoded_shape();
-        uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
-        uint32_t edge_info_offset =
-            tilebuilder.AddEdgeInfo(w, nodeid, directededge->endnode(), edgeinfo.wayid(),
-                                    edgeinfo.mean_elevation(), edgeinfo.bike_network(),
-                                    edgeinfo.speed_limit(), encoded_shape, edgeinfo.GetNames(),
-                                    edgeinfo.GetTaggedValues(), edgeinfo.GetLinguisticTaggedValues(),
-                                    edgeinfo.GetTypes(), added, diff_names);
-        newedge.set_edgeinfo_offset(edge_info_offset);
-        wayid.push_back(edgeinfo.wayid());
-        classification.push_back(directededge->classification());
-        endnode.push_back(directededge->endnode());
-
-        if (directededge->endnode().tile_value() != tile->header()->graphid().tile_value()) {
-          diff_tile = true;
+        for (auto& lc : laneconnectivity) {
+          lc.set_to(tilebuilder.directededges().size());
         }
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
+      }
 
-        // Add directed edge
-        tilebuilder.directededges().emplace_back(std::move(newedge));
-        ++edge_count;
+      // Names can be different in the forward and backward direction
+      diff_names = tilebuilder.OpposingEdgeInfoDiffers(tile, directededge);
+
+      // Get edge info, shape, and names from the old tile and add to the
+      // new. Cannot use edge info offset since edges in arterial and
+      // highway hierarchy can cross base tiles! Use a hash based on the
+      // encoded shape plus way Id.
+      bool added;
+      const auto& edgeinfo = tile->edgeinfo(directededge);
+      std::string encoded_shape = edgeinfo.encoded_shape();
+      uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
+      uint32_t edge_info_offset =
+          tilebuilder.AddEdgeInfo(w, nodeid, directededge->endnode(), edgeinfo.wayid(),
+                                  edgeinfo.mean_elevation(), edgeinfo.bike_network(),
+                                  edgeinfo.speed_limit(), encoded_shape, edgeinfo.GetNames(),
+                                  edgeinfo.GetTaggedValues(), edgeinfo.GetLinguisticTaggedValues(),
+                                  edgeinfo.GetTypes(), added, diff_names);
+      newedge.set_edgeinfo_offset(edge_info_offset);
+      wayid.push_back(edgeinfo.wayid());
+      classification.push_back(directededge->classification());
+      endnode.push_back(directededge->endnode());
+
+      if (directededge->endnode().tile_value() != tile->header()->graphid().tile_value()) {
+        diff_tile = true;
       }
 
-      // Add the node to the tilebuilder unless no edges remain
-      if (edge_count > 0) {
-        // Add a node builder to the tile. Update the edge count and edgeindex
-        GraphId new_node(nodeid.tileid(), nodeid.level(), tilebuilder.nodes().size());
-        tilebuilder.nodes().push_back(*nodeinfo);
-        NodeInfo& node = tilebuilder.nodes().back();
-        node.set_edge_count(edge_count);
-        node.set_edge_index(edge_index);
-        const auto& admin = tile->admininfo(nodeinfo->admin_index());
-        node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
-                                                  admin.country_iso(), admin.state_iso()));
-
-        // Get named signs from the base node
-        if (nodeinfo->named_intersection()) {
-          std::vector<SignInfo> signs = tile->GetSigns(nodeid.id(), true);
-          if (signs.size() == 0) {
-            LOG_ERROR("Base node should have signs, but none found");
-          }
-          node.set_named_intersection(true);
-          tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
-        }
+      // Add directed edge
+      tilebuilder.directededges().emplace_back(std::move(newedge));
+      ++edge_count;
+    }
 
-        // Associate the old node to the new node.
-        old_to_new[nodeid] = new_node;
-
-        // Check if edges at this node can be aggregated. Only 2 edges, same way Id (so that
-        // edge attributes should match), don't end at same node (no loops), no traffic signal,
-        // no signs exist at the node(named_intersection), does not have different
-        // names, and end node of edges are not in a different tile.
-        //
-        // Note: The classification check is here due to the reclassification of ferries.  Found
-        // that some edges that were split at pedestrian edges had different classifications due to
-        // the reclassification of ferry edges (e.g., https://www.openstreetmap.org/way/204337649)
-        if (edge_filtered && edge_count == 2 && wayid[0] == wayid[1] &&
-            classification[0] == classification[1] && endnode[0] != endnode[1] &&
-            !nodeinfo->traffic_signal() && !nodeinfo->named_intersection() && !diff_names &&
-            !diff_tile) {
-
-          // one more check on intersection and node type.  similar to shortcuts
-          bool aggregate =
-              (nodeinfo->intersection() != IntersectionType::kFork &&
-               nodeinfo->type() != NodeType::kGate && nodeinfo->type() != NodeType::kTollBooth &&
-               nodeinfo->type() != NodeType::kTollGantry && nodeinfo->type() != NodeType::kBollard &&
-               nodeinfo->type() != NodeType::kSumpBuster &&
-               nodeinfo->type() != NodeType::kBorderControl);
-
-          if (aggregate) {
-            // temporarily used to check aggregating edges from this node
-            node.set_mode_change(true);
-            ++can_aggregate;
-          }
+    // Add the node to the tilebuilder unless no edges remain
+    if (edge_count > 0) {
+      // Add a node builder to the tile. Update the edge count and edgeindex
+      GraphId new_node(nodeid.tileid(), nodeid.level(), tilebuilder.nodes().size());
+      tilebuilder.nodes().push_back(*nodeinfo);
+      NodeInfo& node = tilebuilder.nodes().back();
+      node.set_edge_count(edge_count);
+      node.set_edge_index(edge_index);
+      const auto& admin = tile->admininfo(nodeinfo->admin_index());
+      node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                                admin.country_iso(), admin.state_iso()));
+
+      // Get named signs from the base node
+      if (nodeinfo->named_intersection()) {
+        std::vector<SignInfo> signs = tile->GetSigns(nodeid.id(), true);
+        if (signs.size() == 0) {
+          LOG_ERROR("Base node should have signs, but none found");
         }
-      } else {
-        ++n_filtered_nodes;
+        node.set_named_intersection(true);
+        tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
       }
-    }
 
-    // Store the updated tile data (or remove tile if all edges are filtered)
-    if (tilebuilder.nodes().size() > 0) {
-      tilebuilder.StoreTileData();
+      // Associate the old node to the new node.
+      old_to_new[nodeid] = new_node;
+
+      // Check if edges at this node can be aggregated. Only 2 edges, same way Id (so that
+      // edge attributes should match), don't end at same node (no loops), no traffic signal,
+      // no signs exist at the node(named_intersection), does not have different
+      // names, and end node of edges are not in a different tile.
+      //
+      // Note: The classification check is here due to the reclassification of ferries.  Found
+      // that some edges that were split at pedestrian edges had different classifications due to
+      // the reclassification of ferry edges (e.g., https://www.openstreetmap.org/way/204337649)
+      if (edge_filtered && edge_count == 2 && wayid[0] == wayid[1] &&
+          classification[0] == classification[1] && endnode[0] != endnode[1] &&
+          !nodeinfo->traffic_signal() && !nodeinfo->named_intersection() && !diff_names &&
+          !diff_tile) {
+
+        // one more check on intersection and node type.  similar to shortcuts
+        bool aggregate =
+            (nodeinfo->intersection() != IntersectionType::kFork &&
+             nodeinfo->type() != NodeType::kGate && nodeinfo->type() != NodeType::kTollBooth &&
+             nodeinfo->type() != NodeType::kTollGantry && nodeinfo->type() != NodeType::kBollard &&
+             nodeinfo->type() != NodeType::kSumpBuster &&
+             nodeinfo->type() != NodeType::kBorderControl);
+
+        if (aggregate) {
+          // temporarily used to check aggregating edges from this node
+          node.set_mode_change(true);
+          ++aggregatable;
+        }
+      }
     } else {
-      // Remove the tile - all nodes and edges were filtered
-      std::string file_location =
-          reader.tile_dir() + filesystem::path::preferred_separator + GraphTile::FileSuffix(tile_id);
-      remove(file_location.c_str());
-      LOG_INFO("Remove file: " + file_location + " all edges were filtered");
+      ++filtered_nodes;
     }
+  }
 
-    if (reader.OverCommitted()) {
-      reader.Trim();
-    }
+  // Store the updated tile data (or remove tile if all edges are filtered)
+  if (tilebuilder.nodes().size() > 0) {
+    tilebuilder.StoreTileData();
+  } else {
+    // Remove the tile - all nodes and edges were filtered
+    std::string file_location =
+        reader.tile_dir() + filesystem::path::preferred_separator + GraphTile::FileSuffix(tile_id);
+    remove(file_location.c_str());
+    LOG_INFO("Remove file: " + file_location + " all edges were filtered");
   }
+
+  n_original_nodes += tilebuilder.header()->nodecount();
+  n_original_edges += tilebuilder.header()->directededgecount();
+  n_filtered_edges += filtered_edges;
+  n_filtered_nodes += filtered_nodes;
+  can_aggregate += aggregatable;
+
+  if (reader.OverCommitted()) {
+    reader.Trim();
+  }
+}
+
+// Get the tiles in the local level, sorted so work is handed out in the same order every run
+std::vector<GraphId> GetLocalTiles(GraphReader& reader) {
+  auto tileset = reader.GetTileSet(TileHierarchy::levels().back().level);
+  std::vector<GraphId> tiles(tileset.begin(), tileset.end());
+  std::sort(tiles.begin(), tiles.end());
+  return tiles;
+}
+
+/**
+ * Filter edges to optionally remove edges by access. Each tile only depends on
+ * itself so they are filtered in parallel, each thread collecting its own node
+ * associations which are merged once all tiles are done.
+ * @param  readers  Graph reader for each thread.
+ * @param  old_to_new  Map of original node Ids to new nodes Ids (after filtering).
+ * @param  include_driving  Include edge if driving (any vehicular) access in either direction.
+ * @param  include_bicycle  Include edge if bicycle access in either direction.
+ * @param  include_pedestrian  Include edge if pedestrian or wheelchair access in either direction.
+ */
+void FilterTiles(std::vector<std::unique_ptr<GraphReader>>& readers,
+                 std::unordered_map<GraphId, GraphId>& old_to_new,
+                 const bool include_driving,
+                 const bool include_bicycle,
+                 const bool include_pedestrian) {
+  // Iterate through all tiles in the local level
+  auto local_tiles = GetLocalTiles(*readers.front());
+  std::vector<std::unordered_map<GraphId, GraphId>> thread_old_to_new(readers.size());
+  parallel_for(local_tiles.size(), readers.size(), [&](size_t thread, size_t i) {
+    FilterTile(*readers[thread], local_tiles[i], thread_old_to_new[thread], include_driving,
+               include_bicycle, include_pedestrian);
+  });
+  for (auto& associations : thread_old_to_new) {
+    old_to_new.insert(associations.begin(), associations.end());
+    associations.clear();
+  }
+
   LOG_INFO("Filtered " + std::to_string(n_filtered_nodes) + " nodes out of " +
            std::to_string(n_original_nodes));
   LOG_INFO("Filtered " + std::to_string(n_filtered_edges) + " directededges out of " +
@@ -537,365 +586,482 @@ void ValidateData(GraphReader& reader,
   }
 }
 
-void AggregateTiles(GraphReader& reader, std::unordered_map<GraphId, GraphId>& old_to_new) {
-
-  LOG_INFO("Validating edges for aggregation");
-  // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet(TileHierarchy::levels().back().level);
-  for (const auto& tile_id : local_tiles) {
-    // Get the graph tile. Read from this tile to create the new tile.
-    graph_tile_ptr tile = reader.GetGraphTile(tile_id);
-    assert(tile);
-
-    std::unordered_set<GraphId> processed_nodes;
-    std::unordered_set<uint64_t> no_agg_ways;
-    processed_nodes.reserve(tile->header()->nodecount());
-    no_agg_ways.reserve(tile->header()->directededgecount());
-
-    GraphId nodeid = GraphId(tile_id.tileid(), tile_id.level(), 0);
-    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
-      const NodeInfo* nodeinfo = tile->node(i);
-      uint32_t idx = nodeinfo->edge_index();
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, idx++) {
-        const DirectedEdge* directededge = tile->directededge(idx);
-        if (processed_nodes.find(nodeid) == processed_nodes.end()) {
-          GraphId en = directededge->endnode();
-          std::list<PointLL> shape;
-          // check if we can aggregate the edges at this node.
-          ValidateData(reader, shape, en, processed_nodes, no_agg_ways, nodeid, tile, directededge);
-        }
-      }
-    }
-
-    // Now loop again double checking the ways.
-    nodeid = GraphId(tile_id.tileid(), tile_id.level(), 0);
-    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
-      const NodeInfo* nodeinfo = tile->node(i);
-      uint32_t idx = nodeinfo->edge_index();
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, idx++) {
-        const DirectedEdge* directededge = tile->directededge(idx);
-        if (no_agg_ways.find(tile->edgeinfo(directededge).wayid()) != no_agg_ways.end()) {
-          processed_nodes.insert(directededge->endnode());
-        }
+/**
+ * Find the nodes of a tile that were marked for aggregation but whose edges
+ * cannot be aggregated after all.
+ * @param  reader  Graph reader.
+ * @param  tile_id  Tile to validate.
+ * @return Returns the indexes of the nodes that need their mark removed.
+ */
+std::vector<uint32_t> ValidateTile(GraphReader& reader, const GraphId& tile_id) {
+  // Get the graph tile. Read from this tile to create the new tile.
+  graph_tile_ptr tile = reader.GetGraphTile(tile_id);
+  assert(tile);
+
+  std::unordered_set<GraphId> processed_nodes;
+  std::unordered_set<uint64_t> no_agg_ways;
+  processed_nodes.reserve(tile->header()->nodecount());
+  no_agg_ways.reserve(tile->header()->directededgecount());
+
+  GraphId nodeid = GraphId(tile_id.tileid(), tile_id.level(), 0);
+  for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
+    const NodeInfo* nodeinfo = tile->node(i);
+    uint32_t idx = nodeinfo->edge_index();
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, idx++) {
+      const DirectedEdge* directededge = tile->directededge(idx);
+      if (processed_nodes.find(nodeid) == processed_nodes.end()) {
+        GraphId en = directededge->endnode();
+        std::list<PointLL> shape;
+        // check if we can aggregate the edges at this node.
+        ValidateData(reader, shape, en, processed_nodes, no_agg_ways, nodeid, tile, directededge);
       }
     }
+  }
 
-    // Create a new tile builder
-    GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
-    std::vector<NodeInfo> nodes;
-
-    // Copy edges (they do not change)
-    std::vector<DirectedEdge> directededges;
-    size_t n = tile->header()->directededgecount();
-    directededges.reserve(n);
-    const DirectedEdge* orig_edges = tile->directededge(0);
-    std::copy(orig_edges, orig_edges + n, std::back_inserter(directededges));
-
-    nodeid = GraphId(tile_id.tileid(), tile_id.level(), 0);
-    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
-      NodeInfo nodeinfo = tilebuilder.node(i);
-      bool found = (processed_nodes.find(nodeid) != processed_nodes.end());
-
-      // We can not aggregate at this node.  Turn off the mode change(aggregation) bit
-      if (found) {
-        nodeinfo.set_mode_change(false);
+  // Now loop again double checking the ways.
+  nodeid = GraphId(tile_id.tileid(), tile_id.level(), 0);
+  for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
+    const NodeInfo* nodeinfo = tile->node(i);
+    uint32_t idx = nodeinfo->edge_index();
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, idx++) {
+      const DirectedEdge* directededge = tile->directededge(idx);
+      if (no_agg_ways.find(tile->edgeinfo(directededge).wayid()) != no_agg_ways.end()) {
+        processed_nodes.insert(directededge->endnode());
       }
-      // Add the node to the local list
-      nodes.emplace_back(std::move(nodeinfo));
     }
-    tilebuilder.Update(nodes, directededges);
+  }
 
-    if (reader.OverCommitted()) {
-      reader.Trim();
+  // We can not aggregate at these nodes
+  std::vector<uint32_t> not_aggregated;
+  nodeid = GraphId(tile_id.tileid(), tile_id.level(), 0);
+  for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
+    if (tile->node(i)->mode_change() && processed_nodes.find(nodeid) != processed_nodes.end()) {
+      not_aggregated.push_back(i);
     }
   }
 
-  LOG_INFO("Aggregating edges");
-  reader.Clear();
-  // Iterate through all tiles in the local level
-  local_tiles = reader.GetTileSet(TileHierarchy::levels().back().level);
-  // Iterate through all tiles in the local level
-  for (const auto& tile_id : local_tiles) {
-    // Create a new tilebuilder - should copy header information
-    GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+  if (reader.OverCommitted()) {
+    reader.Trim();
+  }
+  return not_aggregated;
+}
 
-    // Get the graph tile. Read from this tile to create the new tile.
-    graph_tile_ptr tile = reader.GetGraphTile(tile_id);
-    assert(tile);
+/**
+ * Aggregate the edges at the marked nodes of a tile. The new tile is stored
+ * below the staging directory since other threads may still be reading the
+ * original while aggregating their own tiles.
+ * @param  reader  Graph reader.
+ * @param  tile_id  Tile to aggregate.
+ * @param  old_to_new  Map of original node Ids to new nodes Ids (after aggregation).
+ * @param  staging_dir  Tile directory to store the new tile in.
+ * @return Returns false if all nodes were removed and nothing was stored.
+ */
+bool AggregateTile(GraphReader& reader,
+                   const GraphId& tile_id,
+                   std::unordered_map<GraphId, GraphId>& old_to_new,
+                   const std::string& staging_dir) {
+  // Create a new tilebuilder - should copy header information
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+
+  // Get the graph tile. Read from this tile to create the new tile.
+  graph_tile_ptr tile = reader.GetGraphTile(tile_id);
+  assert(tile);
+
+  std::hash<std::string> hasher;
+  GraphId nodeid(tile_id.tileid(), tile_id.level(), 0);
+  for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
+    bool diff_names = false;
+
+    // Count of edges added for this node
+    uint32_t edge_count = 0;
+
+    // Current edge index for first edge from this node
+    uint32_t edge_index = tilebuilder.directededges().size();
+
+    // Iterate through directed edges outbound from this node
+    std::vector<uint64_t> wayid;
+    std::vector<GraphId> endnode;
+    const NodeInfo* nodeinfo = tile->node(nodeid);
+
+    // Nodes marked with mode_change = true are tossed.
+    if (nodeinfo->mode_change()) {
+      continue;
+    }
 
-    std::hash<std::string> hasher;
-    GraphId nodeid(tile_id.tileid(), tile_id.level(), 0);
-    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
-      bool diff_names = false;
+    GraphId edgeid(nodeid.tileid(), nodeid.level(), nodeinfo->edge_index());
 
-      // Count of edges added for this node
-      uint32_t edge_count = 0;
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); ++j, ++edgeid) {
+      // Check if the directed edge should be included
+      const DirectedEdge* directededge = tile->directededge(edgeid);
 
-      // Current edge index for first edge from this node
-      uint32_t edge_index = tilebuilder.directededges().size();
+      // Copy the directed edge information
+      DirectedEdge newedge = *directededge;
 
-      // Iterate through directed edges outbound from this node
-      std::vector<uint64_t> wayid;
-      std::vector<GraphId> endnode;
-      const NodeInfo* nodeinfo = tile->node(nodeid);
+      // Set opposing edge indexes to 0 (gets set in graph validator).
+      newedge.set_opp_index(0);
 
-      // Nodes marked with mode_change = true are tossed.
-      if (nodeinfo->mode_change()) {
-        continue;
+      // Get signs from the base directed edge
+      if (directededge->sign()) {
+        std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
+        if (signs.size() == 0) {
+          LOG_ERROR("Base edge should have signs, but none found");
+        }
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
       }
 
-      GraphId edgeid(nodeid.tileid(), nodeid.level(), nodeinfo->edge_index());
-
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); ++j, ++edgeid) {
-        // Check if the directed edge should be included
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-
-        // Copy the directed edge information
-        DirectedEdge newedge = *directededge;
-
-        // Set opposing edge indexes to 0 (gets set in graph validator).
-        newedge.set_opp_index(0);
-
-        // Get signs from the base directed edge
-        if (directededge->sign()) {
-          std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
-          if (signs.size() == 0) {
-            LOG_ERROR("Base edge should have signs, but none found");
-          }
-          tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
-        }
+      // Get turn lanes from the base directed edge
+      if (directededge->turnlanes()) {
+        uint32_t offset = tile->turnlanes_offset(edgeid.id());
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      }
 
-        // Get turn lanes from the base directed edge
-        if (directededge->turnlanes()) {
-          uint32_t offset = tile->turnlanes_offset(edgeid.id());
-          tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      // Get access restrictions from the base directed edge. Add these to
+      // the list of access restrictions in the new tile. Update the
+      // edge index in the restriction to be the current directed edge Id
+      if (directededge->access_restriction()) {
+        auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
+        for (const auto& res : restrictions) {
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
+                                                             res.type(), res.modes(), res.value()));
         }
+      }
 
-        // Get access restrictions from the base directed edge. Add these to
-        // the list of access restrictions in the new tile. Update the
-        // edge index in the restriction to be the current directed edge Id
-        if (directededge->access_restriction()) {
-          auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
-          for (const auto& res : restrictions) {
-            tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
-                                                               res.type(), res.modes(), res.value()));
-          }
+      // Copy lane connectivity
+      if (directededge->laneconnectivity()) {
+        auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
+        if (laneconnectivity.size() == 0) {
+          LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
-
-        // Copy lane connectivity
-        if (directededge->laneconnectivity()) {
-          auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
-          if (laneconnectivity.size() == 0) {
-            LOG_ERROR("Base edge should have lane connectivity, but none found");
-          }
-          for (auto& lc : laneconnectivity) {
-            lc.set_to(tilebuilder.directededges().size());
-          }
-          tilebuilder.AddLaneConnectivity(laneconnectivity);
+        for (auto& lc : laneconnectivity) {
+          lc.set_to(tilebuilder.directededges().size());
         }
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
+      }
 
-        // Names can be different in the forward and backward direction
-        diff_names = tilebuilder.OpposingEdgeInfoDiffers(tile, directededge);
+      // Names can be different in the forward and backward direction
+      diff_names = tilebuilder.OpposingEdgeInfoDiffers(tile, directededge);
 
-        const auto& edgeinfo = tile->edgeinfo(directededge);
-        std::string encoded_shape = edgeinfo.encoded_shape();
-        std::list<PointLL> shape = valhalla::midgard::decode7<std::list<PointLL>>(encoded_shape);
+      const auto& edgeinfo = tile->edgeinfo(directededge);
+      std::string encoded_shape = edgeinfo.encoded_shape();
+      std::list<PointLL> shape = valhalla::midgard::decode7<std::list<PointLL>>(encoded_shape);
 
-        // Aggregate if end node is marked and in same tile
-        bool aggregated = false;
-        GraphId en = directededge->endnode();
+      // Aggregate if end node is marked and in same tile
+      bool aggregated = false;
+      GraphId en = directededge->endnode();
 
-        if (en.tile_value() == tile_id) {
-          if (tile->node(en.id())->mode_change()) {
-            GetAggregatedData(reader, shape, en, nodeid, tile, directededge);
-            newedge.set_endnode(en);
-            aggregated = true;
-          }
-        }
-
-        // Hammerhead specific.  bike network not saved to edgeinfo
-        bool added;
-        encoded_shape = encode7(shape);
-        uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
-        uint32_t edge_info_offset =
-            tilebuilder.AddEdgeInfo(w, nodeid, en, edgeinfo.wayid(), edgeinfo.mean_elevation(),
-                                    edgeinfo.bike_network(), edgeinfo.speed_limit(), encoded_shape,
-                                    edgeinfo.GetNames(), edgeinfo.GetTaggedValues(),
-                                    edgeinfo.GetLinguisticTaggedValues(), edgeinfo.GetTypes(), added,
-                                    diff_names);
-        newedge.set_edgeinfo_offset(edge_info_offset);
-
-        // Update length and curvature if the edge was aggregated
-        if (aggregated) {
-          newedge.set_length(valhalla::midgard::length(shape));
-          newedge.set_curvature(compute_curvature(shape));
+      if (en.tile_value() == tile_id) {
+        if (tile->node(en.id())->mode_change()) {
+          GetAggregatedData(reader, shape, en, nodeid, tile, directededge);
+          newedge.set_endnode(en);
+          aggregated = true;
         }
+      }
 
-        // Add directed edge
-        tilebuilder.directededges().emplace_back(std::move(newedge));
-        ++edge_count;
+      // Hammerhead specific.  bike network not saved to edgeinfo
+      bool added;
+      encoded_shape = encode7(shape);
+      uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
+      uint32_t edge_info_offset =
+          tilebuilder.AddEdgeInfo(w, nodeid, en, edgeinfo.wayid(), edgeinfo.mean_elevation(),
+                                  edgeinfo.bike_network(), edgeinfo.speed_limit(), encoded_shape,
+                                  edgeinfo.GetNames(), edgeinfo.GetTaggedValues(),
+                                  edgeinfo.GetLinguisticTaggedValues(), edgeinfo.GetTypes(), added,
+                                  diff_names);
+      newedge.set_edgeinfo_offset(edge_info_offset);
+
+      // Update length and curvature if the edge was aggregated
+      if (aggregated) {
+        newedge.set_length(valhalla::midgard::length(shape));
+        newedge.set_curvature(compute_curvature(shape));
       }
 
-      // Add the node to the tilebuilder unless no edges remain
-      if (edge_count > 0) {
-        // Add a node builder to the tile. Update the edge count and edgeindex
-        GraphId new_node(nodeid.tileid(), nodeid.level(), tilebuilder.nodes().size());
-        tilebuilder.nodes().push_back(*nodeinfo);
-        NodeInfo& node = tilebuilder.nodes().back();
-        node.set_edge_count(edge_count);
-        node.set_edge_index(edge_index);
-        const auto& admin = tile->admininfo(nodeinfo->admin_index());
-        node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
-                                                  admin.country_iso(), admin.state_iso()));
-
-        // Get named signs from the base node
-        if (nodeinfo->named_intersection()) {
-          std::vector<SignInfo> signs = tile->GetSigns(nodeid.id(), true);
-          if (signs.size() == 0) {
-            LOG_ERROR("Base node should have signs, but none found");
-          }
-          node.set_named_intersection(true);
-          tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
+      // Add directed edge
+      tilebuilder.directededges().emplace_back(std::move(newedge));
+      ++edge_count;
+    }
+
+    // Add the node to the tilebuilder unless no edges remain
+    if (edge_count > 0) {
+      // Add a node builder to the tile. Update the edge count and edgeindex
+      GraphId new_node(nodeid.tileid(), nodeid.level(), tilebuilder.nodes().size());
+      tilebuilder.nodes().push_back(*nodeinfo);
+      NodeInfo& node = tilebuilder.nodes().back();
+      node.set_edge_count(edge_count);
+      node.set_edge_index(edge_index);
+      const auto& admin = tile->admininfo(nodeinfo->admin_index());
+      node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                                admin.country_iso(), admin.state_iso()));
+
+      // Get named signs from the base node
+      if (nodeinfo->named_intersection()) {
+        std::vector<SignInfo> signs = tile->GetSigns(nodeid.id(), true);
+        if (signs.size() == 0) {
+          LOG_ERROR("Base node should have signs, but none found");
         }
-        // Associate the old node to the new node.
-        old_to_new[nodeid] = new_node;
+        node.set_named_intersection(true);
+        tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
       }
+      // Associate the old node to the new node.
+      old_to_new[nodeid] = new_node;
     }
+  }
 
-    // Store the updated tile data (or remove tile if all edges are filtered)
-    if (tilebuilder.nodes().size() > 0) {
-      tilebuilder.StoreTileData();
-    } else {
-      // Remove the tile - all nodes and edges were filtered
-      std::string file_location =
-          reader.tile_dir() + filesystem::path::preferred_separator + GraphTile::FileSuffix(tile_id);
-      remove(file_location.c_str());
-      LOG_INFO("Remove file: " + file_location + " all edges were filtered");
+  // Store the updated tile data unless all edges are filtered
+  bool stored = tilebuilder.nodes().size() > 0;
+  if (stored) {
+    tilebuilder.StoreTileData(staging_dir);
+  }
+
+  if (reader.OverCommitted()) {
+    reader.Trim();
+  }
+  return stored;
+}
+
+/**
+ * Aggregate edges at nodes where filtering left just the 2 edges of a single
+ * way. Validation reads the tiles around each node so all tiles are validated
+ * before any of the marks are removed. Likewise the aggregated tiles are staged
+ * and only moved into place once all of them are done, so no matter the number
+ * of threads every tile sees the same input.
+ * @param  readers  Graph reader for each thread.
+ * @param  old_to_new  Map of original node Ids to new nodes Ids (after aggregation).
+ */
+void AggregateTiles(std::vector<std::unique_ptr<GraphReader>>& readers,
+                    std::unordered_map<GraphId, GraphId>& old_to_new) {
+
+  LOG_INFO("Validating edges for aggregation");
+  // Iterate through all tiles in the local level
+  auto local_tiles = GetLocalTiles(*readers.front());
+  std::vector<std::vector<uint32_t>> not_aggregated(local_tiles.size());
+  parallel_for(local_tiles.size(), readers.size(), [&](size_t thread, size_t i) {
+    not_aggregated[i] = ValidateTile(*readers[thread], local_tiles[i]);
+  });
+
+  // Turn off the mode change (aggregation) bit where we can not aggregate
+  parallel_for(local_tiles.size(), readers.size(), [&](size_t thread, size_t i) {
+    if (not_aggregated[i].empty()) {
+      return;
     }
+    graph_tile_ptr tile = readers[thread]->GetGraphTile(local_tiles[i]);
+    GraphTileBuilder tilebuilder(readers[thread]->tile_dir(), local_tiles[i], false);
 
-    if (reader.OverCommitted()) {
-      reader.Trim();
+    // Copy nodes and edges (the edges do not change)
+    const NodeInfo* orig_nodes = tile->node(0);
+    std::vector<NodeInfo> nodes(orig_nodes, orig_nodes + tile->header()->nodecount());
+    const DirectedEdge* orig_edges = tile->directededge(0);
+    std::vector<DirectedEdge> directededges(orig_edges,
+                                            orig_edges + tile->header()->directededgecount());
+    for (auto node_index : not_aggregated[i]) {
+      nodes[node_index].set_mode_change(false);
+    }
+    tilebuilder.Update(nodes, directededges);
+  });
+  not_aggregated.clear();
+
+  LOG_INFO("Aggregating edges");
+  const auto& tile_dir = readers.front()->tile_dir();
+  std::string staging_dir = tile_dir + filesystem::path::preferred_separator + "filter.tmp";
+  filesystem::remove_all(staging_dir);
+  std::vector<std::unordered_map<GraphId, GraphId>> thread_old_to_new(readers.size());
+  std::vector<char> stored(local_tiles.size(), false);
+  for (auto& reader : readers) {
+    reader->Clear();
+  }
+  parallel_for(local_tiles.size(), readers.size(), [&](size_t thread, size_t i) {
+    stored[i] = AggregateTile(*readers[thread], local_tiles[i], thread_old_to_new[thread],
+                              staging_dir);
+  });
+  for (auto& associations : thread_old_to_new) {
+    old_to_new.insert(associations.begin(), associations.end());
+    associations.clear();
+  }
+
+  // Move the aggregated tiles into place (or remove tile if all edges are filtered)
+  for (size_t i = 0; i < local_tiles.size(); ++i) {
+    auto suffix = GraphTile::FileSuffix(local_tiles[i]);
+    std::string file_location = tile_dir + filesystem::path::preferred_separator + suffix;
+    remove(file_location.c_str());
+    if (!stored[i]) {
+      LOG_INFO("Remove file: " + file_location + " all edges were filtered");
+    } else if (!filesystem::rename(staging_dir + filesystem::path::preferred_separator + suffix,
+                                   file_location)) {
+      throw std::runtime_error("Could not move aggregated tile into place: " + file_location);
     }
   }
+  filesystem::remove_all(staging_dir);
 
   LOG_INFO("Aggregated " + std::to_string(aggregated) + " directededges out of " +
            std::to_string(n_original_edges));
 }
 
 /**
- * Update end nodes of all directed edges.
+ * Update end nodes of the directed edges in a tile.
  * @param  reader  Graph reader.
+ * @param  tile_id  Tile to update.
  * @param  old_to_new  Map of original node Ids to new nodes Ids (after filtering).
  */
-void UpdateEndNodes(GraphReader& reader, std::unordered_map<GraphId, GraphId>& old_to_new) {
+void UpdateTileEndNodes(GraphReader& reader,
+                        const GraphId& tile_id,
+                        const std::unordered_map<GraphId, GraphId>& old_to_new) {
+  // Get the graph tile. Skip if no tile exists (should not happen!?)
+  graph_tile_ptr tile = reader.GetGraphTile(tile_id);
+  assert(tile);
+
+  // Create a new tilebuilder - should copy header information
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+
+  // Copy nodes (they do not change)
+  std::vector<NodeInfo> nodes;
+  size_t n = tile->header()->nodecount();
+  nodes.reserve(n);
+  const NodeInfo* orig_nodes = tile->node(0);
+  std::copy(orig_nodes, orig_nodes + n, std::back_inserter(nodes));
+
+  // Iterate through all directed edges - update end nodes
+  std::vector<DirectedEdge> directededges;
+  GraphId edgeid(tile_id.tileid(), tile_id.level(), 0);
+  for (uint32_t j = 0; j < tile->header()->directededgecount(); ++j, ++edgeid) {
+    const DirectedEdge* edge = tile->directededge(j);
+
+    // Find the end node in the old_to_new mapping
+    GraphId end_node;
+    auto iter = old_to_new.find(edge->endnode());
+    if (iter == old_to_new.end()) {
+      LOG_ERROR("UpdateEndNodes - failed to find associated node");
+      std::cout << std::to_string(edge->endnode().value) << " "
+                << std::to_string(tile->edgeinfo(edge).wayid()) << std::endl;
+    } else {
+      end_node = iter->second;
+    }
+
+    // Copy the edge to the directededges vector and update the end node
+    directededges.push_back(*edge);
+    DirectedEdge& new_edge = directededges.back();
+    new_edge.set_endnode(end_node);
+  }
+
+  // Update the tile with new directededges.
+  tilebuilder.Update(nodes, directededges);
+
+  if (reader.OverCommitted()) {
+    reader.Trim();
+  }
+}
+
+/**
+ * Update end nodes of all directed edges. Tiles only read and write themselves
+ * so they are updated in parallel.
+ * @param  readers  Graph reader for each thread.
+ * @param  old_to_new  Map of original node Ids to new nodes Ids (after filtering).
+ */
+void UpdateEndNodes(std::vector<std::unique_ptr<GraphReader>>& readers,
+                    const std::unordered_map<GraphId, GraphId>& old_to_new) {
   LOG_INFO("Update end nodes of directed edges");
   // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet(TileHierarchy::levels().back().level);
-  for (const auto& tile_id : local_tiles) {
-    // Get the graph tile. Skip if no tile exists (should not happen!?)
-    graph_tile_ptr tile = reader.GetGraphTile(tile_id);
-    assert(tile);
-
-    // Create a new tilebuilder - should copy header information
-    GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
-
-    // Copy nodes (they do not change)
-    std::vector<NodeInfo> nodes;
-    size_t n = tile->header()->nodecount();
-    nodes.reserve(n);
-    const NodeInfo* orig_nodes = tile->node(0);
-    std::copy(orig_nodes, orig_nodes + n, std::back_inserter(nodes));
-
-    // Iterate through all directed edges - update end nodes
-    std::vector<DirectedEdge> directededges;
-    GraphId edgeid(tile_id.tileid(), tile_id.level(), 0);
-    for (uint32_t j = 0; j < tile->header()->directededgecount(); ++j, ++edgeid) {
-      const DirectedEdge* edge = tile->directededge(j);
-
-      // Find the end node in the old_to_new mapping
-      GraphId end_node;
-      auto iter = old_to_new.find(edge->endnode());
-      if (iter == old_to_new.end()) {
-        LOG_ERROR("UpdateEndNodes - failed to find associated node");
-        std::cout << std::to_string(edge->endnode().value) << " "
-                  << std::to_string(tile->edgeinfo(edge).wayid()) << std::endl;
-      } else {
-        end_node = iter->second;
+  auto local_tiles = GetLocalTiles(*readers.front());
+  parallel_for(local_tiles.size(), readers.size(), [&](size_t thread, size_t i) {
+    UpdateTileEndNodes(*readers[thread], local_tiles[i], old_to_new);
+  });
+}
+
+/**
+ * Find the opposing local index of every directed edge in a tile. Only reads tiles so all tiles
+ * can be done at once without any locking.
+ * @param  reader  Graph reader.
+ * @param  tile_id  Tile whose edges to find the opposing indexes of.
+ * @return the opposing local index of each directed edge of the tile, in the order of the edges
+ */
+std::vector<uint8_t> FindTileOpposingEdgeIndexes(GraphReader& reader, const GraphId& tile_id) {
+  // Get the graph tile
+  graph_tile_ptr tile = reader.GetGraphTile(tile_id);
+  assert(tile);
+
+  // Iterate through all directed edges, local indexes fit in a byte (kMaxEdgesPerNode)
+  std::vector<uint8_t> opp_indexes;
+  opp_indexes.reserve(tile->header()->directededgecount());
+  GraphId nodeid(tile_id.tileid(), tile_id.level(), 0);
+  for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
+    const NodeInfo* nodeinfo = tile->node(nodeid);
+    GraphId edgeid(nodeid.tileid(), nodeid.level(), nodeinfo->edge_index());
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); ++j, ++edgeid) {
+      const DirectedEdge* edge = tile->directededge(edgeid);
+
+      // Get the tile at the end node
+      graph_tile_ptr endnodetile = tile;
+      if (tile->id() != edge->endnode().Tile_Base()) {
+        endnodetile = reader.GetGraphTile(edge->endnode());
       }
 
-      // Copy the edge to the directededges vector and update the end node
-      directededges.push_back(*edge);
-      DirectedEdge& new_edge = directededges.back();
-      new_edge.set_endnode(end_node);
+      // Find the opposing index on the local level
+      opp_indexes.push_back(GetOpposingEdgeIndex(endnodetile, nodeid, tile, *edge));
     }
+  }
 
-    // Update the tile with new directededges.
-    tilebuilder.Update(nodes, directededges);
-
-    if (reader.OverCommitted()) {
-      reader.Trim();
-    }
+  if (reader.OverCommitted()) {
+    reader.Trim();
   }
+  return opp_indexes;
 }
 
 /**
- * Update Opposing Edge Index of all directed edges.
+ * Update Opposing Edge Index of the directed edges in a tile.
  * @param  reader  Graph reader.
+ * @param  tile_id  Tile to update.
+ * @param  opp_indexes  The opposing local index of each directed edge of the tile.
  */
-void UpdateOpposingEdgeIndex(GraphReader& reader) {
-  LOG_INFO("Update Opposing Edge Index of directed edges");
+void UpdateTileOpposingEdgeIndex(GraphReader& reader,
+                                 const GraphId& tile_id,
+                                 const std::vector<uint8_t>& opp_indexes) {
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+
+  // Get the graph tile. Read from this tile to create the new tile.
+  graph_tile_ptr tile = reader.GetGraphTile(tile_id);
+  assert(tile);
+
+  // Copy nodes (they do not change)
+  std::vector<NodeInfo> nodes;
+  size_t n = tile->header()->nodecount();
+  nodes.reserve(n);
+  const NodeInfo* orig_nodes = tile->node(0);
+  std::copy(orig_nodes, orig_nodes + n, std::back_inserter(nodes));
+
+  // Copy the directed edges (they are in node order) and set their opposing index
+  std::vector<DirectedEdge> directededges;
+  const DirectedEdge* orig_edges = tile->directededge(0);
+  directededges.reserve(opp_indexes.size());
+  for (size_t i = 0; i < opp_indexes.size(); ++i) {
+    directededges.push_back(orig_edges[i]);
+    directededges.back().set_opp_local_idx(opp_indexes[i]);
+  }
 
-  // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet(TileHierarchy::levels().back().level);
-  for (const auto& tile_id : local_tiles) {
-    GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
-
-    // Get the graph tile. Read from this tile to create the new tile.
-    graph_tile_ptr tile = reader.GetGraphTile(tile_id);
-    assert(tile);
-
-    // Copy nodes (they do not change)
-    std::vector<NodeInfo> nodes;
-    size_t n = tile->header()->nodecount();
-    nodes.reserve(n);
-    const NodeInfo* orig_nodes = tile->node(0);
-    std::copy(orig_nodes, orig_nodes + n, std::back_inserter(nodes));
-
-    // Iterate through all directed edges - update end nodes
-    std::vector<DirectedEdge> directededges;
-
-    GraphId nodeid(tile_id.tileid(), tile_id.level(), 0);
-    for (uint32_t i = 0; i < tile->header()->nodecount(); ++i, ++nodeid) {
-      const NodeInfo* nodeinfo = tile->node(nodeid);
-      GraphId edgeid(nodeid.tileid(), nodeid.level(), nodeinfo->edge_index());
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); ++j, ++edgeid) {
-        // Check if the directed edge should be included
-        const DirectedEdge* edge = tile->directededge(edgeid);
-
-        // Copy the edge to the directededges vector and update the end node
-        directededges.push_back(*edge);
-        DirectedEdge& new_edge = directededges.back();
-
-        // Get the tile at the end node
-        graph_tile_ptr endnodetile;
-        if (tile->id() == edge->endnode().Tile_Base()) {
-          endnodetile = tile;
-        } else {
-          endnodetile = reader.GetGraphTile(edge->endnode());
-        }
+  // Update the tile with new directededges.
+  tilebuilder.Update(nodes, directededges);
 
-        // Set the opposing index on the local level
-        new_edge.set_opp_local_idx(GetOpposingEdgeIndex(endnodetile, nodeid, tile, *edge));
-      }
-    }
+  if (reader.OverCommitted()) {
+    reader.Trim();
+  }
+}
 
-    // Update the tile with new directededges.
-    tilebuilder.Update(nodes, directededges);
+/**
+ * Update Opposing Edge Index of all directed edges. The indexes of all tiles are found before
+ * any tile is written, so no tile is read while another thread writes it. Both passes then run
+ * fully in parallel, only the indexes (a byte per edge) are kept in between.
+ * @param  readers  Graph reader for each thread.
+ */
+void UpdateOpposingEdgeIndex(std::vector<std::unique_ptr<GraphReader>>& readers) {
+  LOG_INFO("Update Opposing Edge Index of directed edges");
 
-    if (reader.OverCommitted()) {
-      reader.Trim();
-    }
-  }
+  // Iterate through all tiles in the local level
+  auto local_tiles = GetLocalTiles(*readers.front());
+  std::vector<std::vector<uint8_t>> opp_indexes(local_tiles.size());
+  parallel_for(local_tiles.size(), readers.size(), [&](size_t thread, size_t i) {
+    opp_indexes[i] = FindTileOpposingEdgeIndexes(*readers[thread], local_tiles[i]);
+  });
+  parallel_for(local_tiles.size(), readers.size(), [&](size_t thread, size_t i) {
+    UpdateTileOpposingEdgeIndex(*readers[thread], local_tiles[i], opp_indexes[i]);
+    std::vector<uint8_t>().swap(opp_indexes[i]);
+  });
 }
 
 } // namespace
@@ -906,8 +1072,6 @@ namespace mjolnir {
 // Optionally filter edges and nodes based on access.
 void GraphFilter::Filter(const boost::property_tree::ptree& pt) {
 
-  // TODO: thread this. Could be difficult due to sequence creates to associate nodes
-
   // Edge filtering (optionally exclude edges)
   bool include_driving = pt.get_child("mjolnir").get<bool>("include_driving", true);
   if (!include_driving) {
@@ -930,27 +1094,37 @@ void GraphFilter::Filter(const boost::property_tree::ptree& pt) {
   // Map of old node Ids to new node Ids (after filtering).
   std::unordered_map<baldr::GraphId, baldr::GraphId> old_to_new;
 
-  // Construct GraphReader
-  GraphReader reader(pt.get_child("mjolnir"));
+  // Construct a GraphReader per thread
+  std::vector<std::unique_ptr<GraphReader>> readers(
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency())));
+  for (auto& reader : readers) {
+    reader.reset(new GraphReader(pt.get_child("mjolnir")));
+  }
+  auto clear_readers = [&readers]() {
+    for (auto& reader : readers) {
+      reader->Clear();
+    }
+  };
 
   // Filter edges (and nodes) by access
-  FilterTiles(reader, old_to_new, include_driving, include_bicycle, include_pedestrian);
+  FilterTiles(readers, old_to_new, include_driving, include_bicycle, include_pedestrian);
 
   // Update end nodes. Clear the GraphReader cache first.
-  reader.Clear();
-  UpdateEndNodes(reader, old_to_new);
+  clear_readers();
+  UpdateEndNodes(readers, old_to_new);
 
-  reader.Clear();
+  clear_readers();
   old_to_new.clear();
-  AggregateTiles(reader, old_to_new);
+  AggregateTiles(readers, old_to_new);
 
   // Update end nodes. Clear the GraphReader cache first.
-  reader.Clear();
-  UpdateEndNodes(reader, old_to_new);
+  clear_readers();
+  UpdateEndNodes(readers, old_to_new);
 
   // Update Opposing Edge Index. Clear the GraphReader cache first.
-  reader.Clear();
-  UpdateOpposingEdgeIndex(reader);
+  clear_readers();
+  UpdateOpposingEdgeIndex(readers);
 
   LOG_INFO("Done GraphFilter");
 }
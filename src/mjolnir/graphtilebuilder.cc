@@ -244,8 +244,13 @@ GraphTileBuilder::GraphTileBuilder(const std::string& tile_dir,
 
 // Output the tile to file. Stores as binary data.
 void GraphTileBuilder::StoreTileData() {
+  StoreTileData(tile_dir_);
+}
+
+// Output the tile to file below the given tile directory
+void GraphTileBuilder::StoreTileData(const std::string& tile_dir) {
   // Get the name of the file
-  filesystem::path filename(tile_dir_ + filesystem::path::preferred_separator +
+  filesystem::path filename(tile_dir + filesystem::path::preferred_separator +
                             GraphTile::FileSuffix(header_builder_.graphid()));
 
   // Make sure the directory exists on the system
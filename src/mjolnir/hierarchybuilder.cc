@@ -3,7 +3,10 @@
 
 #include <boost/property_tree/ptree.hpp>
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -16,6 +19,7 @@
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
 #include "midgard/sequence.h"
+#include "mjolnir/util.h"
 
 using namespace valhalla::midgard;
 using namespace valhalla::baldr;
@@ -63,23 +67,29 @@ bool AddUpwardTransition(const GraphId& node, GraphTileBuilder* tilebuilder) {
   }
 }
 
-void SortSequences(const std::string& new_to_old_file, const std::string& old_to_new_file) {
+void SortSequences(const std::string& new_to_old_file,
+                   const std::string& old_to_new_file,
+                   const size_t concurrency) {
   // Sort the new nodes. Sort so highway level is first
-  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-  new_to_old.sort([](const std::pair<GraphId, GraphId>& a, const std::pair<GraphId, GraphId>& b) {
-    if (a.first.level() == b.first.level()) {
-      if (a.first.tileid() == b.first.tileid()) {
-        return a.first.id() < b.first.id();
-      }
-      return a.first.tileid() < b.first.tileid();
-    }
-    return a.first.level() < b.first.level();
-  });
+  using node_pair_t = std::pair<GraphId, GraphId>;
+  sequence<node_pair_t> new_to_old(new_to_old_file, false);
+  new_to_old.sort(
+      [](const node_pair_t& a, const node_pair_t& b) {
+        if (a.first.level() == b.first.level()) {
+          if (a.first.tileid() == b.first.tileid()) {
+            return a.first.id() < b.first.id();
+          }
+          return a.first.tileid() < b.first.tileid();
+        }
+        return a.first.level() < b.first.level();
+      },
+      sequence<node_pair_t>::default_sort_buffer, concurrency);
 
   // Sort old to new by node Id
   sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
   old_to_new.sort(
-      [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; });
+      [](const OldToNewNodes& a, const OldToNewNodes& b) { return a.node_id < b.node_id; },
+      sequence<OldToNewNodes>::default_sort_buffer, concurrency);
 }
 
 // Convenience method to find the node association.
@@ -96,16 +106,18 @@ OldToNewNodes find_nodes(sequence<OldToNewNodes>& old_to_new, const GraphId& nod
   }
 }
 
-// Form tiles in the new level.
-void FormTilesInNewLevel(GraphReader& reader,
-                         const std::string& new_to_old_file,
-                         const std::string& old_to_new_file) {
-  // Use the sequence that associate new nodes to old nodes
-  sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
-
-  // Use the sorted sequence that associates old nodes to new nodes
-  sequence<OldToNewNodes> old_to_new(old_to_new_file, false);
+// A contiguous range of the sorted new to old sequence that makes up one new tile
+struct NewTile {
+  GraphId tile_id;
+  size_t begin;
+  size_t end;
+};
 
+// Form a single tile in the new level from its range of new nodes.
+void FormTileInNewLevel(GraphReader& reader,
+                        sequence<std::pair<GraphId, GraphId>>& new_to_old,
+                        sequence<OldToNewNodes>& old_to_new,
+                        const NewTile& new_tile) {
   // lambda to indicate whether a directed edge should be included
   auto include_edge = [&old_to_new](const DirectedEdge* directededge, const GraphId& base_node,
                                     const uint8_t current_level) {
@@ -133,39 +145,19 @@ void FormTilesInNewLevel(GraphReader& reader,
     }
   };
 
-  // Iterate through the new nodes. They have been sorted by level so that
-  // highway level is done first.
-  reader.Clear();
+  // New tilebuilder for this tile. Set the base ll for the tile
   bool added = false;
-  uint8_t current_level = std::numeric_limits<uint8_t>::max();
-  GraphId tile_id;
   std::hash<std::string> hasher;
-  PointLL base_ll;
-  GraphTileBuilder* tilebuilder = nullptr;
-  for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); new_node++) {
-    // Get the node - check if a new tile
+  GraphId tile_id = new_tile.tile_id;
+  uint8_t current_level = tile_id.level();
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
+  PointLL base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
+  tilebuilder.header_builder().set_base_ll(base_ll);
+
+  // Iterate through the new nodes of this tile
+  for (size_t n = new_tile.begin; n < new_tile.end; ++n) {
+    auto new_node = new_to_old.at(n);
     GraphId nodea = (*new_node).first;
-    if (nodea.Tile_Base() != tile_id) {
-      // Store the prior tile
-      if (tilebuilder != nullptr) {
-        tilebuilder->StoreTileData();
-        delete tilebuilder;
-      }
-
-      // New tilebuilder for the next tile. Update current level.
-      tile_id = nodea.Tile_Base();
-      tilebuilder = new GraphTileBuilder(reader.tile_dir(), tile_id, false);
-      current_level = nodea.level();
-
-      // Set the base ll for this tile
-      base_ll = TileHierarchy::get_tiling(current_level).Base(tile_id.tileid());
-      tilebuilder->header_builder().set_base_ll(base_ll);
-
-      // Check if we need to clear the base/local tile cache
-      if (reader.OverCommitted()) {
-        reader.Trim();
-      }
-    }
 
     // Get the node in the base level
     GraphId base_node = (*new_node).second;
@@ -176,25 +168,25 @@ void FormTilesInNewLevel(GraphReader& reader,
     }
 
     // Copy the data version
-    tilebuilder->header_builder().set_dataset_id(tile->header()->dataset_id());
+    tilebuilder.header_builder().set_dataset_id(tile->header()->dataset_id());
 
     // Copy node information and set the node lat,lon offsets within the new tile
     NodeInfo baseni = *(tile->node(base_node.id()));
-    tilebuilder->nodes().push_back(baseni);
+    tilebuilder.nodes().push_back(baseni);
     const auto& admin = tile->admininfo(baseni.admin_index());
-    NodeInfo& node = tilebuilder->nodes().back();
+    NodeInfo& node = tilebuilder.nodes().back();
     node.set_latlng(base_ll, baseni.latlng(tile->header()->base_ll()));
-    node.set_edge_index(tilebuilder->directededges().size());
+    node.set_edge_index(tilebuilder.directededges().size());
     node.set_timezone(baseni.timezone());
-    node.set_admin_index(tilebuilder->AddAdmin(admin.country_text(), admin.state_text(),
-                                               admin.country_iso(), admin.state_iso()));
+    node.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                              admin.country_iso(), admin.state_iso()));
 
     // Update node LL based on tile base
     // Density at this node
     uint32_t density1 = baseni.density();
 
     // Current edge count
-    size_t edge_count = tilebuilder->directededges().size();
+    size_t edge_count = tilebuilder.directededges().size();
 
     // Iterate through directed edges of the base node to get remaining
     // directed edges (based on classification/importance cutoff)
@@ -248,13 +240,13 @@ void FormTilesInNewLevel(GraphReader& reader,
         if (signs.size() == 0) {
           LOG_ERROR("Base edge should have signs, but none found");
         }
-        tilebuilder->AddSigns(tilebuilder->directededges().size(), signs);
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
       }
 
       // Get turn lanes from the base directed edge
       if (directededge->turnlanes()) {
         uint32_t offset = tile->turnlanes_offset(base_edge_id.id());
-        tilebuilder->AddTurnLanes(tilebuilder->directededges().size(), tile->GetName(offset));
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
       }
 
       // Get access restrictions from the base directed edge. Add these to
@@ -263,8 +255,8 @@ void FormTilesInNewLevel(GraphReader& reader,
       if (directededge->access_restriction()) {
         auto restrictions = tile->GetAccessRestrictions(base_edge_id.id(), kAllAccess);
         for (const auto& res : restrictions) {
-          tilebuilder->AddAccessRestriction(AccessRestriction(tilebuilder->directededges().size(),
-                                                              res.type(), res.modes(), res.value()));
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
+                                                             res.type(), res.modes(), res.value()));
         }
       }
 
@@ -275,13 +267,13 @@ void FormTilesInNewLevel(GraphReader& reader,
           LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
         for (auto& lc : laneconnectivity) {
-          lc.set_to(tilebuilder->directededges().size());
+          lc.set_to(tilebuilder.directededges().size());
         }
-        tilebuilder->AddLaneConnectivity(laneconnectivity);
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
       }
 
       // Names can be different in the forward and backward direction
-      bool diff_names = tilebuilder->OpposingEdgeInfoDiffers(tile, directededge);
+      bool diff_names = tilebuilder.OpposingEdgeInfoDiffers(tile, directededge);
 
       // Get edge info, shape, and names from the old tile and add to the
       // new. Cannot use edge info offset since edges in arterial and
@@ -291,7 +283,7 @@ void FormTilesInNewLevel(GraphReader& reader,
       std::string encoded_shape = edgeinfo.encoded_shape();
       uint32_t w = hasher(encoded_shape + std::to_string(edgeinfo.wayid()));
       uint32_t edge_info_offset =
-          tilebuilder->AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
+          tilebuilder.AddEdgeInfo(w, nodea, nodeb, edgeinfo.wayid(), edgeinfo.mean_elevation(),
                                    edgeinfo.bike_network(), edgeinfo.speed_limit(), encoded_shape,
                                    edgeinfo.GetNames(), edgeinfo.GetTaggedValues(),
                                    edgeinfo.GetLinguisticTaggedValues(), edgeinfo.GetTypes(), added,
@@ -300,34 +292,34 @@ void FormTilesInNewLevel(GraphReader& reader,
       newedge.set_edgeinfo_offset(edge_info_offset);
 
       // Add directed edge
-      tilebuilder->directededges().emplace_back(std::move(newedge));
+      tilebuilder.directededges().emplace_back(std::move(newedge));
     }
 
     // Add node transitions
-    uint32_t index = tilebuilder->transitions().size();
+    uint32_t index = tilebuilder.transitions().size();
     auto new_nodes = find_nodes(old_to_new, base_node);
     if (current_level == 0) {
-      AddDownwardTransition(new_nodes.arterial_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
+      AddDownwardTransition(new_nodes.arterial_node, &tilebuilder);
+      AddDownwardTransition(new_nodes.local_node, &tilebuilder);
     } else if (current_level == 1) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddDownwardTransition(new_nodes.local_node, tilebuilder);
+      AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+      AddDownwardTransition(new_nodes.local_node, &tilebuilder);
     } else if (current_level == 2) {
-      AddUpwardTransition(new_nodes.highway_node, tilebuilder);
-      AddUpwardTransition(new_nodes.arterial_node, tilebuilder);
+      AddUpwardTransition(new_nodes.highway_node, &tilebuilder);
+      AddUpwardTransition(new_nodes.arterial_node, &tilebuilder);
     } else {
       throw std::logic_error("current_level was never set");
     }
 
     // Set the node transition count and index
-    uint32_t count = tilebuilder->transitions().size() - index;
+    uint32_t count = tilebuilder.transitions().size() - index;
     if (count > 0) {
       node.set_transition_count(count);
       node.set_transition_index(index);
     }
 
     // Set the edge count for the new node
-    node.set_edge_count(tilebuilder->directededges().size() - edge_count);
+    node.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
     // Get named signs from the base node
     if (baseni.named_intersection()) {
@@ -336,25 +328,129 @@ void FormTilesInNewLevel(GraphReader& reader,
         LOG_ERROR("Base node should have signs, but none found");
       }
       node.set_named_intersection(true);
-      tilebuilder->AddSigns(tilebuilder->nodes().size() - 1, signs);
+      tilebuilder.AddSigns(tilebuilder.nodes().size() - 1, signs);
     }
   }
 
-  // Delete the tile builder
-  if (tilebuilder != nullptr) {
-    tilebuilder->StoreTileData();
-    delete tilebuilder;
+  // Store the tile
+  tilebuilder.StoreTileData();
+
+  // Check if we need to clear the base/local tile cache
+  if (reader.OverCommitted()) {
+    reader.Trim();
   }
 }
 
+// Form tiles in the new levels. Every new tile only depends on the sorted
+// associations and the base tiles so they are formed in parallel. The
+// highway and arterial tiles are all formed before any of the local tiles
+// since forming a local tile overwrites the base tile it is formed from.
+void FormTilesInNewLevel(std::vector<std::unique_ptr<GraphReader>>& readers,
+                         const std::string& new_to_old_file,
+                         const std::string& old_to_new_file) {
+  // Split the sequence that associates new nodes to old nodes into tiles.
+  // It has been sorted by level so that highway level is first.
+  std::vector<NewTile> upper_tiles, local_tiles;
+  uint8_t local_level = TileHierarchy::levels().back().level;
+  {
+    sequence<std::pair<GraphId, GraphId>> new_to_old(new_to_old_file, false);
+    size_t index = 0;
+    for (auto new_node = new_to_old.begin(); new_node != new_to_old.end(); new_node++, ++index) {
+      GraphId tile_id = (*new_node).first.Tile_Base();
+      auto& tiles = tile_id.level() == local_level ? local_tiles : upper_tiles;
+      if (tiles.empty() || tiles.back().tile_id != tile_id) {
+        tiles.push_back({tile_id, index, index});
+      }
+      tiles.back().end = index + 1;
+    }
+  }
+
+  // Each thread reads the sequences on its own
+  std::vector<std::unique_ptr<sequence<std::pair<GraphId, GraphId>>>> new_to_olds;
+  std::vector<std::unique_ptr<sequence<OldToNewNodes>>> old_to_news;
+  for (const auto& reader : readers) {
+    reader->Clear();
+    new_to_olds.emplace_back(new sequence<std::pair<GraphId, GraphId>>(new_to_old_file, false));
+    old_to_news.emplace_back(new sequence<OldToNewNodes>(old_to_new_file, false));
+  }
+
+  for (const auto* tiles : {&upper_tiles, &local_tiles}) {
+    parallel_for(tiles->size(), readers.size(), [&](size_t thread, size_t i) {
+      FormTileInNewLevel(*readers[thread], *new_to_olds[thread], *old_to_news[thread], (*tiles)[i]);
+    });
+  }
+}
+
+// The levels a base node exists on along with the tiles it falls in on the
+// highway and arterial levels. Scanned from the base tiles in parallel
+// before the new node Ids are assigned.
+struct NodeLevels {
+  bool levels[3];
+  uint32_t highway_tile;
+  uint32_t arterial_tile;
+  uint32_t density;
+};
+
+// Find the levels each node in a base tile exists on.
+std::vector<NodeLevels> ScanNodeLevels(GraphReader& reader, const GraphId& base_tile_id) {
+  // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
+  std::vector<NodeLevels> node_levels;
+  graph_tile_ptr tile = reader.GetGraphTile(base_tile_id);
+  if (!tile) {
+    return node_levels;
+  }
+
+  // Hierarchy level information
+  const auto& arterial_level = TileHierarchy::levels()[1];
+  const auto& highway_level = TileHierarchy::levels()[0];
+
+  // Iterate through the nodes. Add nodes to the new level when
+  // best road class <= the new level classification cutoff
+  uint32_t nodecount = tile->header()->nodecount();
+  node_levels.resize(nodecount);
+  GraphId edgeid = base_tile_id;
+  PointLL base_ll = tile->header()->base_ll();
+  const NodeInfo* nodeinfo = tile->node(base_tile_id);
+  for (uint32_t i = 0; i < nodecount; i++, nodeinfo++) {
+    // Iterate through the edges to see which levels this node exists.
+    bool* levels = node_levels[i].levels;
+    levels[0] = levels[1] = levels[2] = false;
+    for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
+      // Update the flag for the level of this edge (skip transit
+      // connection edges)
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      if (directededge->bss_connection()) {
+        // Despite the road class, Bike Share Stations' connections are always at local level
+        levels[2] = true;
+      } else if (directededge->use() != Use::kTransitConnection &&
+                 directededge->use() != Use::kEgressConnection &&
+                 directededge->use() != Use::kPlatformConnection) {
+        levels[TileHierarchy::get_level(directededge->classification())] = true;
+      }
+    }
+    PointLL ll = nodeinfo->latlng(base_ll);
+    node_levels[i].highway_tile = levels[0] ? highway_level.tiles.TileId(ll) : 0;
+    node_levels[i].arterial_tile = levels[1] ? arterial_level.tiles.TileId(ll) : 0;
+    node_levels[i].density = nodeinfo->density();
+  }
+
+  // Check if we need to clear the tile cache
+  if (reader.OverCommitted()) {
+    reader.Trim();
+  }
+  return node_levels;
+}
+
 /**
  * Create node associations between "new" nodes placed into respective
  * hierarchy levels and the existing nodes on the base/local level. The
  * associations go both ways: from the "old" nodes on the base/local level
  * to new nodes (using a mapping in memory) and from new nodes to old nodes
- * using a sequence (file).
+ * using a sequence (file). Batches of base tiles are scanned in parallel
+ * and the new node Ids are then assigned serially in tile order so that
+ * they are the same no matter how many threads are used.
  */
-void CreateNodeAssociations(GraphReader& reader,
+void CreateNodeAssociations(std::vector<std::unique_ptr<GraphReader>>& readers,
                             const std::string& new_to_old_file,
                             const std::string& old_to_new_file) {
   // Map of tiles vs. count of nodes. Used to construct new node Ids.
@@ -381,83 +477,60 @@ void CreateNodeAssociations(GraphReader& reader,
   sequence<OldToNewNodes> old_to_new(old_to_new_file, true);
 
   // Hierarchy level information
-  const auto& arterial_level = TileHierarchy::levels()[1];
-  uint32_t al = static_cast<uint32_t>(arterial_level.level);
-  const auto& highway_level = TileHierarchy::levels()[0];
-  uint32_t hl = static_cast<uint32_t>(highway_level.level);
-
-  // Iterate through all tiles in the local level
-  auto local_tiles = reader.GetTileSet();
-  for (const auto& base_tile_id : local_tiles) {
-    // We keep all transit data inside the transit hierarchy
-    if (base_tile_id.level() == TileHierarchy::GetTransitLevel().level) {
-      continue;
-    }
-
-    // Get the graph tile. Skip if no tile exists or no nodes exist in the tile.
-    graph_tile_ptr tile = reader.GetGraphTile(base_tile_id);
-    if (!tile) {
-      continue;
+  uint32_t al = static_cast<uint32_t>(TileHierarchy::levels()[1].level);
+  uint32_t hl = static_cast<uint32_t>(TileHierarchy::levels()[0].level);
+
+  // All tiles in the local level. We keep all transit data inside the transit hierarchy
+  std::vector<GraphId> local_tiles;
+  for (const auto& base_tile_id : readers.front()->GetTileSet()) {
+    if (base_tile_id.level() != TileHierarchy::GetTransitLevel().level) {
+      local_tiles.push_back(base_tile_id);
     }
+  }
 
-    // Iterate through the nodes. Add nodes to the new level when
-    // best road class <= the new level classification cutoff
-    bool levels[3];
-    uint32_t nodecount = tile->header()->nodecount();
-    GraphId basenode = base_tile_id;
-    GraphId edgeid = base_tile_id;
-    PointLL base_ll = tile->header()->base_ll();
-    const NodeInfo* nodeinfo = tile->node(basenode);
-    for (uint32_t i = 0; i < nodecount; i++, nodeinfo++, ++basenode) {
-      // Iterate through the edges to see which levels this node exists.
-      levels[0] = levels[1] = levels[2] = false;
-      for (uint32_t j = 0; j < nodeinfo->edge_count(); j++, ++edgeid) {
-        // Update the flag for the level of this edge (skip transit
-        // connection edges)
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        if (directededge->bss_connection()) {
-          // Despite the road class, Bike Share Stations' connections are always at local level
-          levels[2] = true;
-        } else if (directededge->use() != Use::kTransitConnection &&
-                   directededge->use() != Use::kEgressConnection &&
-                   directededge->use() != Use::kPlatformConnection) {
-          levels[TileHierarchy::get_level(directededge->classification())] = true;
+  // Scan a batch of tiles in parallel then assign their nodes in order
+  const size_t batch_size = readers.size() * 64;
+  std::vector<std::vector<NodeLevels>> batch(batch_size);
+  for (size_t first = 0; first < local_tiles.size(); first += batch_size) {
+    size_t count = std::min(batch_size, local_tiles.size() - first);
+    parallel_for(count, readers.size(), [&](size_t thread, size_t i) {
+      batch[i] = ScanNodeLevels(*readers[thread], local_tiles[first + i]);
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+      const GraphId& base_tile_id = local_tiles[first + i];
+      GraphId basenode = base_tile_id;
+      for (const auto& node_levels : batch[i]) {
+        // Associate new nodes to base nodes and base node to new nodes
+        const bool* levels = node_levels.levels;
+        GraphId highway_node, arterial_node, local_node;
+        if (levels[0]) {
+          // New node is on the highway level. Associate back to base/local node
+          highway_node = get_new_node(GraphId(node_levels.highway_tile, hl, 0));
+          new_to_old.push_back(std::make_pair(highway_node, basenode));
+        }
+        if (levels[1]) {
+          // New node is on the arterial level. Associate back to base/local node
+          arterial_node = get_new_node(GraphId(node_levels.arterial_tile, al, 0));
+          new_to_old.push_back(std::make_pair(arterial_node, basenode));
+        }
+        if (levels[2]) {
+          // New node is on the local level. Associate back to base/local node
+          local_node = get_new_node(base_tile_id);
+          new_to_old.push_back(std::make_pair(local_node, basenode));
         }
-      }
 
-      // Associate new nodes to base nodes and base node to new nodes
-      GraphId highway_node, arterial_node, local_node;
-      if (levels[0]) {
-        // New node is on the highway level. Associate back to base/local node
-        GraphId new_tile(highway_level.tiles.TileId(nodeinfo->latlng(base_ll)), hl, 0);
-        highway_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(highway_node, basenode));
-      }
-      if (levels[1]) {
-        // New node is on the arterial level. Associate back to base/local node
-        GraphId new_tile(arterial_level.tiles.TileId(nodeinfo->latlng(base_ll)), al, 0);
-        arterial_node = get_new_node(new_tile);
-        new_to_old.push_back(std::make_pair(arterial_node, basenode));
-      }
-      if (levels[2]) {
-        // New node is on the local level. Associate back to base/local node
-        local_node = get_new_node(base_tile_id);
-        new_to_old.push_back(std::make_pair(local_node, basenode));
-      }
+        if (!levels[0] && !levels[1] && !levels[2]) {
+          LOG_ERROR("No valid level for this node!");
+        }
 
-      if (!levels[0] && !levels[1] && !levels[2]) {
-        LOG_ERROR("No valid level for this node!");
+        // Associate the old node to the new node(s). Entries in the tuple
+        // that are invalid nodes indicate no node exists in the new level.
+        OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, node_levels.density);
+        old_to_new.push_back(assoc);
+        ++basenode;
       }
-
-      // Associate the old node to the new node(s). Entries in the tuple
-      // that are invalid nodes indicate no node exists in the new level.
-      OldToNewNodes assoc(basenode, highway_node, arterial_node, local_node, nodeinfo->density());
-      old_to_new.push_back(assoc);
-    }
-
-    // Check if we need to clear the tile cache
-    if (reader.OverCommitted()) {
-      reader.Trim();
+      batch[i].clear();
     }
   }
 }
@@ -558,22 +631,25 @@ void HierarchyBuilder::Build(const boost::property_tree::ptree& pt,
                              const std::string& new_to_old_file,
                              const std::string& old_to_new_file) {
 
-  // TODO: thread this. Might be more possible now that we don't create
-  // shortcuts in the HierarchyBuilder
-
-  // Construct GraphReader
+  // Construct a GraphReader per thread
   LOG_INFO("HierarchyBuilder");
-  GraphReader reader(pt.get_child("mjolnir"));
+  std::vector<std::unique_ptr<GraphReader>> readers(
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency())));
+  for (auto& reader : readers) {
+    reader.reset(new GraphReader(pt.get_child("mjolnir")));
+  }
+  GraphReader& reader = *readers.front();
 
   // Association of old nodes to new nodes
-  CreateNodeAssociations(reader, new_to_old_file, old_to_new_file);
+  CreateNodeAssociations(readers, new_to_old_file, old_to_new_file);
 
   // Sort the sequences
-  SortSequences(new_to_old_file, old_to_new_file);
+  SortSequences(new_to_old_file, old_to_new_file, readers.size());
 
   // Iterate through the hierarchy (from highway down to local) and build
   // new tiles
-  FormTilesInNewLevel(reader, new_to_old_file, old_to_new_file);
+  FormTilesInNewLevel(readers, new_to_old_file, old_to_new_file);
 
   // Remove any base tiles that no longer have any data (nodes and edges
   // only exist on arterial and highway levels)
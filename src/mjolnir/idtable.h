@@ -2,9 +2,13 @@
 #define VALHALLA_MJOLNIR_IDTABLE_H
 
 #include <algorithm>
+#include <bitset>
 #include <cmath>
 #include <cstdint>
-#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <robin_hood.h>
 
@@ -13,21 +17,36 @@
 namespace valhalla {
 namespace mjolnir {
 
+/**
+ * A set of OSM ids. Ids are set into a hash map of 64 bit words while parsing. Once no
+ * more ids will be set the table can be frozen into a rank-select layout, a bitmap of
+ * which 64 bit words have any id set plus a running count of those words, followed by
+ * only the words that have ids set. Lookups stay constant time: one bit test, one
+ * popcount and one word read.
+ */
 class UnorderedIdTable final {
 public:
   /**
    * Constructor
    * @param   size_hint   Hint about the total number of ids.
    */
-  UnorderedIdTable(const uint64_t size_hint) {
-    bitmarkers_.reserve((size_hint / 64) + 1);
+  UnorderedIdTable(const uint64_t size_hint)
+      : top_(nullptr), ranks_(nullptr), words_(nullptr), top_count_(0), word_count_(0) {
+    // ids are usually sparse, only reserve up front for the first few million of them
+    bitmarkers_.reserve(std::min((size_hint / 64) + 1, kMaxReservedWords));
   }
 
+  UnorderedIdTable(const UnorderedIdTable&) = delete;
+  UnorderedIdTable& operator=(const UnorderedIdTable&) = delete;
+
   /**
-   * Sets the OSM Id as used.
+   * Sets the OSM Id as used. Setting an id in a frozen table thaws it first.
    * @param   osmid   OSM Id of the way/node/relation.
    */
   inline void set(const uint64_t id) {
+    if (top_) {
+      thaw();
+    }
     uint64_t idx = id / 64;
     bitmarkers_[idx] |= static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64));
   }
@@ -40,57 +59,62 @@ public:
 
   inline bool get(const uint64_t id) const {
     uint64_t idx = id / 64;
+    if (top_) {
+      // is there a word for this id at all
+      uint64_t top = idx / 64;
+      if (top >= top_count_) {
+        return false;
+      }
+      uint64_t word_bit = static_cast<uint64_t>(1) << (idx % static_cast<uint64_t>(64));
+      if (!(top_[top] & word_bit)) {
+        return false;
+      }
+      // the words before it in this part of the bitmap tell us where it is
+      uint64_t rank = ranks_[top] + std::bitset<64>(top_[top] & (word_bit - 1)).count();
+      return words_[rank] & (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64)));
+    }
     auto found = bitmarkers_.find(idx);
     return found != bitmarkers_.cend() &&
            found->second & (static_cast<uint64_t>(1) << (id % static_cast<uint64_t>(64)));
   }
 
   /**
-   * Serializes the table to file
-   * @param file_name  the file to which we should serialize the table
-   * @return true if the table could be serialized
+   * Compacts the table into its rank-select layout and frees the hash map. Lookups
+   * remain constant time, call this once no more ids are going to be set.
    */
-  bool serialize(const std::string& file_name) {
-    std::ofstream file(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
-    if (!file.is_open()) {
-      return false;
+  void freeze() {
+    if (top_) {
+      return;
     }
-    // TODO: do more than one entry at a time, buffer 10k of them into a vector and write that
-    // Write key/value pairs
-    for (const auto& i : bitmarkers_) {
-      // key
-      file.write(reinterpret_cast<const char*>(&i.first), sizeof(uint64_t));
-      // value
-      file.write(reinterpret_cast<const char*>(&i.second), sizeof(uint64_t));
-    }
-    file.close();
-    return true;
-  }
 
-  /**
-   * Deserializes the table from file
-   * @param file_name  the file from which to deserialize the table
-   * @return true if it was successfully deserialized
-   */
-  bool deserialize(const std::string& file_name) {
-    std::ifstream file(file_name, std::ios::in | std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-      return false;
+    // the non-empty words in order
+    auto words = this->words();
+    if (words.size() > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error("Too many ids to freeze the id table");
     }
-    uint64_t entries = static_cast<uint64_t>(file.tellg()) / 2;
-    file.seekg(0, std::ios::beg);
-
-    // TODO: do more than one entry at a time, buffer 10k of them into a vector and read that
-    // Read the count and then the via ids
-    bitmarkers_.reserve(entries);
-    uint64_t key, value;
-    while (file && entries--) {
-      file.read(reinterpret_cast<char*>(&key), sizeof(key));
-      file.read(reinterpret_cast<char*>(&value), sizeof(value));
-      bitmarkers_[key] = value;
+    robin_hood::unordered_map<uint64_t, uint64_t>().swap(bitmarkers_);
+
+    // header, bitmap of non-empty words, ranks (2 per uint64) and the non-empty words
+    const uint64_t top_count = words.empty() ? 0 : words.back().first / 64 + 1;
+    frozen_.assign(kHeaderSize + top_count + (top_count + 1) / 2 + words.size(), 0);
+    frozen_[0] = top_count;
+    frozen_[1] = words.size();
+    auto* top = frozen_.data() + kHeaderSize;
+    auto* ranks = reinterpret_cast<uint32_t*>(top + top_count);
+    auto* packed = top + top_count + (top_count + 1) / 2;
+    uint64_t last_top = 0;
+    for (uint64_t i = 0; i < words.size(); ++i) {
+      uint64_t t = words[i].first / 64;
+      // a new part of the bitmap, parts with no words in between start at the current rank
+      for (; last_top < t; ++last_top) {
+        ranks[last_top + 1] = static_cast<uint32_t>(i);
+      }
+      top[t] |= static_cast<uint64_t>(1) << (words[i].first % 64);
+      packed[i] = words[i].second;
     }
-    file.close();
-    return true;
+    LOG_DEBUG("Froze id table into " + std::to_string(frozen_.size() * sizeof(uint64_t)) +
+              " bytes");
+    attach(frozen_.data());
   }
 
   /**
@@ -99,11 +123,69 @@ public:
    * @return
    */
   bool operator==(const UnorderedIdTable& other) const {
-    return bitmarkers_ == other.bitmarkers_;
+    return words() == other.words();
   }
 
 private:
+  // the header holds the number of uint64s of the bitmap and the number of words
+  static constexpr uint64_t kHeaderSize = 2;
+  static constexpr uint64_t kMaxReservedWords = 1 << 20;
+
+  // Points the lookups at a frozen layout
+  void attach(const uint64_t* data) {
+    top_count_ = data[0];
+    word_count_ = data[1];
+    top_ = data + kHeaderSize;
+    ranks_ = reinterpret_cast<const uint32_t*>(top_ + top_count_);
+    words_ = top_ + top_count_ + (top_count_ + 1) / 2;
+  }
+
+  // Moves the frozen words back into the hash map so more ids can be set
+  void thaw() {
+    for (const auto& word : words()) {
+      bitmarkers_.emplace(word.first, word.second);
+    }
+    top_ = words_ = nullptr;
+    ranks_ = nullptr;
+    top_count_ = word_count_ = 0;
+    std::vector<uint64_t>().swap(frozen_);
+  }
+
+  // The non-empty words and their indexes in order
+  std::vector<std::pair<uint64_t, uint64_t>> words() const {
+    std::vector<std::pair<uint64_t, uint64_t>> words;
+    if (top_) {
+      words.reserve(word_count_);
+      for (uint64_t t = 0; t < top_count_; ++t) {
+        // visit only the set bits, lowest first
+        for (uint64_t bits = top_[t]; bits; bits &= bits - 1) {
+          uint64_t b = std::bitset<64>((bits & (~bits + 1)) - 1).count();
+          uint64_t rank = words.size();
+          words.emplace_back(t * 64 + b, words_[rank]);
+        }
+      }
+    } else {
+      words.reserve(bitmarkers_.size());
+      for (const auto& word : bitmarkers_) {
+        words.emplace_back(word.first, word.second);
+      }
+      std::sort(words.begin(), words.end());
+    }
+    return words;
+  }
+
+  // The words while ids are being set
   robin_hood::unordered_map<uint64_t, uint64_t> bitmarkers_;
+
+  // The frozen layout
+  std::vector<uint64_t> frozen_;
+
+  // Views into the frozen layout
+  const uint64_t* top_;
+  const uint32_t* ranks_;
+  const uint64_t* words_;
+  uint64_t top_count_;
+  uint64_t word_count_;
 };
 
 } // namespace mjolnir
@@ -530,7 +530,9 @@ bool AddLandmarks(const boost::property_tree::ptree& pt) {
   seq_file.close();
 
   midgard::sequence<std::pair<GraphId, uint64_t>> merged_sequence_file(merged_seq_file, false);
-  merged_sequence_file.sort(sort_seq_file);
+  merged_sequence_file.sort(sort_seq_file,
+                            midgard::sequence<std::pair<GraphId, uint64_t>>::default_sort_buffer,
+                            num_threads);
 
   LOG_INFO("Updating tiles...");
 
@@ -11,9 +11,6 @@ OSMAccessRestriction::OSMAccessRestriction() {
   memset(this, 0, sizeof(OSMAccessRestriction));
 }
 
-OSMAccessRestriction::~OSMAccessRestriction() {
-}
-
 // Set the restriction type
 void OSMAccessRestriction::set_type(AccessType type) {
   attributes_.type_ = static_cast<uint16_t>(type);
@@ -0,0 +1,184 @@
+#include "mjolnir/osmchange.h"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include <osmium/handler.hpp>
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/visitor.hpp>
+
+#include "baldr/graphreader.h"
+#include "baldr/tilehierarchy.h"
+#include "filesystem.h"
+#include "midgard/logging.h"
+#include "midgard/sequence.h"
+#include "mjolnir/util.h"
+
+using namespace valhalla::baldr;
+using namespace valhalla::midgard;
+
+namespace {
+
+/**
+ * Collects the objects of an osmChange document as libosmium's xml parser hands them over.
+ * Creations, modifications and deletions all come through the same callbacks.
+ */
+class ChangeHandler : public osmium::handler::Handler {
+public:
+  explicit ChangeHandler(valhalla::mjolnir::OSMChange& change) : change_(change) {
+  }
+
+  void node(const osmium::Node& node) {
+    change_.nodes.insert(node.positive_id());
+    // deletions usually come without a location
+    if (node.location().valid()) {
+      change_.locations.emplace_back(node.location().lon(), node.location().lat());
+    }
+  }
+
+  void way(const osmium::Way& way) {
+    change_.ways.insert(way.positive_id());
+  }
+
+  void relation(const osmium::Relation& relation) {
+    change_.relations.insert(relation.positive_id());
+    // the ways of a changed relation, i.e. a restriction, change along with it
+    for (const auto& member : relation.members()) {
+      if (member.type() == osmium::item_type::way) {
+        change_.ways.insert(member.positive_ref());
+      }
+    }
+  }
+
+private:
+  valhalla::mjolnir::OSMChange& change_;
+};
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+OSMChange OSMChange::Read(const std::string& filename) {
+  if (!filesystem::exists(filename)) {
+    throw std::runtime_error("Could not open OSM change file: " + filename);
+  }
+
+  OSMChange change;
+  ChangeHandler handler(change);
+  try {
+    // the format and compression come from the suffix, without one it is taken for an osmChange
+    osmium::io::File file(filename);
+    if (file.format() == osmium::io::file_format::unknown) {
+      file.set_format(osmium::io::file_format::xml);
+      file.set_has_multiple_object_versions(true);
+    }
+    osmium::io::Reader reader(file, osmium::osm_entity_bits::nwr);
+    osmium::apply(reader, handler);
+    reader.close();
+  } catch (const std::exception& e) {
+    throw std::runtime_error("Could not read OSM change file " + filename + ": " + e.what());
+  }
+
+  LOG_INFO("Read " + std::to_string(change.nodes.size()) + " nodes, " +
+           std::to_string(change.ways.size()) + " ways and " +
+           std::to_string(change.relations.size()) + " relations from " + filename);
+  return change;
+}
+
+std::unordered_set<GraphId> OSMChange::AffectedTiles(const boost::property_tree::ptree& pt,
+                                                     const std::string& previous_tile_dir) const {
+  // Tiles are only ever read from the tile directories
+  auto current_config = pt.get_child("mjolnir");
+  current_config.erase("tile_extract");
+  current_config.erase("tile_url");
+  current_config.erase("traffic_extract");
+  auto previous_config = current_config;
+  previous_config.put("tile_dir", previous_tile_dir);
+
+  // One pair of readers per thread
+  unsigned int concurrency = std::max(static_cast<unsigned int>(1),
+                                      pt.get<unsigned int>("mjolnir.concurrency",
+                                                           std::thread::hardware_concurrency()));
+  std::vector<std::unique_ptr<GraphReader>> current, previous;
+  for (unsigned int i = 0; i < concurrency; ++i) {
+    current.emplace_back(new GraphReader(current_config));
+    previous.emplace_back(new GraphReader(previous_config));
+  }
+
+  // Scan the tiles of both builds for edges of the changed ways. Edges of a removed way
+  // are only found in the previous build, edges of a new way only in the current one
+  std::set<GraphId> tile_set;
+  for (const auto& reader : {current.front().get(), previous.front().get()}) {
+    for (const auto& tile_id : reader->GetTileSet()) {
+      tile_set.insert(tile_id);
+    }
+  }
+  std::vector<GraphId> tiles(tile_set.begin(), tile_set.end());
+  std::vector<uint8_t> has_changed_way(tiles.size(), false);
+  if (!ways.empty()) {
+    parallel_for(tiles.size(), concurrency, [&](size_t thread, size_t i) {
+      for (auto* reader : {current[thread].get(), previous[thread].get()}) {
+        if (!reader->DoesTileExist(tiles[i])) {
+          continue;
+        }
+        auto tile = reader->GetGraphTile(tiles[i]);
+        if (tile == nullptr) {
+          continue;
+        }
+        for (const auto& edge : tile->GetDirectedEdges()) {
+          if (ways.find(tile->edgeinfo(&edge).wayid()) != ways.cend()) {
+            has_changed_way[i] = true;
+            break;
+          }
+        }
+        if (reader->OverCommitted()) {
+          reader->Trim();
+        }
+        if (has_changed_way[i]) {
+          break;
+        }
+      }
+    });
+  }
+
+  std::unordered_set<GraphId> affected;
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    if (has_changed_way[i]) {
+      affected.insert(tiles[i]);
+    }
+  }
+
+  // Changed nodes touch the tile they lie in at every level
+  for (const auto& location : locations) {
+    for (const auto& level : TileHierarchy::levels()) {
+      auto tile_id = TileHierarchy::GetGraphId(location, level.level);
+      if (tile_id.Is_Valid()) {
+        affected.insert(tile_id);
+      }
+    }
+  }
+
+  // Finally the hierarchy parents, the tiles of a level nest within the tiles of the level above
+  std::vector<GraphId> children(affected.begin(), affected.end());
+  for (const auto& child : children) {
+    auto center = TileHierarchy::get_tiling(child.level()).Center(child.tileid());
+    for (const auto& level : TileHierarchy::levels()) {
+      if (level.level < child.level()) {
+        affected.insert(TileHierarchy::GetGraphId(center, level.level));
+      }
+    }
+  }
+
+  LOG_INFO(std::to_string(affected.size()) + " of " + std::to_string(tiles.size()) +
+           " tiles are affected by the change");
+  return affected;
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -11,6 +11,7 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <fstream>
 #include <utility>
 
 using namespace valhalla::midgard;
@@ -126,8 +127,8 @@ public:
   // Lua Tag Transformation class
   LuaTagTransform lua_;
 
-  // Mark the OSM Ids used by the ways and relations
-  // TODO: just use robin_hood::unordered_set<uint64_t> since these are probably relatively small
+  // Mark the OSM Ids used by the ways and relations. Each is frozen into its compact
+  // layout once the pass that sets it is done
   UnorderedIdTable shape_, members_;
 
   // Pointer to all the OSM data (for use by callbacks)
@@ -168,6 +169,7 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.admins.size()) +
            " admin polygons comprised of " + std::to_string(osmdata.osm_way_count) + " ways");
+  callback.members_.freeze();
 
   // Parse the ways.
   LOG_INFO("Parsing ways...");
@@ -179,6 +181,7 @@ OSMAdminData PBFAdminParser::Parse(const boost::property_tree::ptree& pt,
   }
   LOG_INFO("Finished with " + std::to_string(osmdata.way_map.size()) + " ways comprised of " +
            std::to_string(osmdata.node_count) + " nodes");
+  callback.shape_.freeze();
 
   // Parse node in all the input files. Skip any that are not marked from
   // being used in a way.
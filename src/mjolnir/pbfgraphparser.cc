@@ -5038,6 +5038,12 @@ public:
   }
 };
 
+// the sorts of the parsed data run on as many threads as the rest of the build
+size_t sort_concurrency(const boost::property_tree::ptree& pt) {
+  return std::max(static_cast<unsigned int>(1),
+                  pt.get<unsigned int>("concurrency", std::thread::hardware_concurrency()));
+}
+
 } // namespace
 
 namespace valhalla {
@@ -5097,9 +5103,13 @@ OSMData PBFGraphParser::ParseWays(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm access tags by way id...");
   {
     sequence<OSMAccess> access(access_file, false);
-    access.sort([](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); });
+    access.sort([](const OSMAccess& a, const OSMAccess& b) { return a.way_id() < b.way_id(); },
+                sequence<OSMAccess>::default_sort_buffer, sort_concurrency(pt));
   }
 
+  // sort the restrictions and linguistics so they can be looked up
+  osmdata.sort();
+
   LOG_INFO("Finished");
 
   // Return OSM data
@@ -5152,6 +5162,7 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
                                                         OSMPBF::Interest::CHANGESETS),
                           callback);
   }
+  osmdata.sort();
   LOG_INFO("Finished with " + std::to_string(osmdata.restrictions.size()) +
            " simple turn restrictions");
   LOG_INFO("Finished with " + std::to_string(osmdata.lane_connectivity_map.size()) +
@@ -5164,7 +5175,8 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
   {
     sequence<OSMRestriction> complex_restrictions_from(complex_restriction_from_file, false);
     complex_restrictions_from.sort(
-        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; },
+        sequence<OSMRestriction>::default_sort_buffer, sort_concurrency(pt));
   }
 
   // Sort complex restrictions. Keep this scoped so the file handles are closed when done sorting.
@@ -5172,7 +5184,8 @@ void PBFGraphParser::ParseRelations(const boost::property_tree::ptree& pt,
   {
     sequence<OSMRestriction> complex_restrictions_to(complex_restriction_to_file, false);
     complex_restrictions_to.sort(
-        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; });
+        [](const OSMRestriction& a, const OSMRestriction& b) { return a < b; },
+        sequence<OSMRestriction>::default_sort_buffer, sort_concurrency(pt));
   }
   LOG_INFO("Finished");
 }
@@ -5237,7 +5250,8 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
     way_nodes.sort(
-        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid_ < b.node.osmid_; });
+        [](const OSMWayNode& a, const OSMWayNode& b) { return a.node.osmid_ < b.node.osmid_; },
+        sequence<OSMWayNode>::default_sort_buffer, sort_concurrency(pt));
   }
 
   // Parse node in all the input files. Skip any that are not marked from
@@ -5266,13 +5280,15 @@ void PBFGraphParser::ParseNodes(const boost::property_tree::ptree& pt,
   LOG_INFO("Sorting osm way node references by way index and node shape index...");
   {
     sequence<OSMWayNode> way_nodes(way_nodes_file, false);
-    way_nodes.sort([](const OSMWayNode& a, const OSMWayNode& b) {
-      if (a.way_index == b.way_index) {
-        // TODO: if its equal we have screwed something up, should we check and throw here?
-        return a.way_shape_node_index < b.way_shape_node_index;
-      }
-      return a.way_index < b.way_index;
-    });
+    way_nodes.sort(
+        [](const OSMWayNode& a, const OSMWayNode& b) {
+          if (a.way_index == b.way_index) {
+            // TODO: if its equal we have screwed something up, should we check and throw here?
+            return a.way_shape_node_index < b.way_shape_node_index;
+          }
+          return a.way_index < b.way_index;
+        },
+        sequence<OSMWayNode>::default_sort_buffer, sort_concurrency(pt));
   }
 
   // Some OSM extracts do not have changeset Ids. For these set the max changeset Id
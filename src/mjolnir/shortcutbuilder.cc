@@ -3,7 +3,14 @@
 
 #include <boost/format.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -12,6 +19,7 @@
 #include "baldr/graphreader.h"
 #include "baldr/graphtile.h"
 #include "baldr/tilehierarchy.h"
+#include "filesystem.h"
 #include "midgard/encoded.h"
 #include "midgard/logging.h"
 #include "midgard/pointll.h"
@@ -585,163 +593,243 @@ std::pair<uint32_t, uint32_t> AddShortcutEdges(GraphReader& reader,
   return {shortcut_count, total_edge_count};
 }
 
-// Form shortcuts for tiles in this level.
-std::pair<uint32_t, uint32_t> FormShortcuts(GraphReader& reader, const TileLevel& level) {
-  // Iterate through the tiles at this level (TODO - can we mark the tiles
-  // the tiles that shortcuts end within?)
-  reader.Clear();
+// Form shortcuts for a single tile and store the result below the staging directory.
+std::pair<uint32_t, uint32_t> FormShortcutsInTile(GraphReader& reader,
+                                                  const graph_tile_ptr& tile,
+                                                  const GraphId& tile_id,
+                                                  const std::string& staging_dir) {
   bool added = false;
   uint32_t shortcut_count = 0;
   uint32_t total_edge_count = 0;
-  uint32_t ntiles = level.tiles.TileCount();
-  uint32_t tile_level = (uint32_t)level.level;
-  graph_tile_ptr tile;
-  for (uint32_t tileid = 0; tileid < ntiles; tileid++) {
-    // Get the graph tile. Skip if no tile exists (common case)
-    tile = reader.GetGraphTile(GraphId(tileid, tile_level, 0));
-    if (!tile) {
-      continue;
-    }
 
-    // Create GraphTileBuilder for the new tile
-    GraphId new_tile(tileid, tile_level, 0);
-    GraphTileBuilder tilebuilder(reader.tile_dir(), new_tile, false);
+  // Create GraphTileBuilder for the new tile
+  GraphTileBuilder tilebuilder(reader.tile_dir(), tile_id, false);
 
-    // Since the old tile is not serialized we must copy any data that is not
-    // dependent on edge Id into the new builders (e.g., node transitions)
-    if (tile->header()->transitioncount() > 0) {
-      for (uint32_t i = 0; i < tile->header()->transitioncount(); ++i) {
-        tilebuilder.transitions().emplace_back(std::move(*(tile->transition(i))));
-      }
+  // Since the old tile is not serialized we must copy any data that is not
+  // dependent on edge Id into the new builders (e.g., node transitions)
+  if (tile->header()->transitioncount() > 0) {
+    for (uint32_t i = 0; i < tile->header()->transitioncount(); ++i) {
+      tilebuilder.transitions().emplace_back(std::move(*(tile->transition(i))));
     }
+  }
 
-    // Iterate through the nodes in the tile
-    GraphId node_id(tileid, tile_level, 0);
-    for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
-      // Get the node info, copy node index and count from old tile
-      NodeInfo nodeinfo = *(tile->node(node_id));
-      uint32_t old_edge_index = nodeinfo.edge_index();
-      uint32_t old_edge_count = nodeinfo.edge_count();
-
-      // Update node information
-      const auto& admin = tile->admininfo(nodeinfo.admin_index());
-      nodeinfo.set_edge_index(tilebuilder.directededges().size());
-      nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
-                                                    admin.country_iso(), admin.state_iso()));
-
-      // Current edge count
-      size_t edge_count = tilebuilder.directededges().size();
-
-      // Add shortcut edges first.
-      std::unordered_map<uint32_t, uint32_t> shortcuts;
-      auto stats = AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
-                                    old_edge_count, shortcuts);
-      shortcut_count += stats.first;
-      total_edge_count += stats.second;
-
-      // Copy the rest of the directed edges from this node
-      GraphId edgeid(tileid, tile_level, old_edge_index);
-      for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
-        // Copy the directed edge information and update end node,
-        // edge data offset, and opp_index
-        const DirectedEdge* directededge = tile->directededge(edgeid);
-        DirectedEdge newedge = *directededge;
-
-        // Get signs from the base directed edge
-        if (directededge->sign()) {
-          std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
-          if (signs.size() == 0) {
-            LOG_ERROR("Base edge should have signs, but none found");
-          }
-          tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
-        }
+  // Iterate through the nodes in the tile
+  GraphId node_id = tile_id;
+  for (uint32_t n = 0; n < tile->header()->nodecount(); n++, ++node_id) {
+    // Get the node info, copy node index and count from old tile
+    NodeInfo nodeinfo = *(tile->node(node_id));
+    uint32_t old_edge_index = nodeinfo.edge_index();
+    uint32_t old_edge_count = nodeinfo.edge_count();
+
+    // Update node information
+    const auto& admin = tile->admininfo(nodeinfo.admin_index());
+    nodeinfo.set_edge_index(tilebuilder.directededges().size());
+    nodeinfo.set_admin_index(tilebuilder.AddAdmin(admin.country_text(), admin.state_text(),
+                                                  admin.country_iso(), admin.state_iso()));
+
+    // Current edge count
+    size_t edge_count = tilebuilder.directededges().size();
+
+    // Add shortcut edges first.
+    std::unordered_map<uint32_t, uint32_t> shortcuts;
+    auto stats = AddShortcutEdges(reader, tile, tilebuilder, node_id, old_edge_index,
+                                  old_edge_count, shortcuts);
+    shortcut_count += stats.first;
+    total_edge_count += stats.second;
+
+    // Copy the rest of the directed edges from this node
+    GraphId edgeid(tile_id.tileid(), tile_id.level(), old_edge_index);
+    for (uint32_t i = 0; i < old_edge_count; i++, ++edgeid) {
+      // Copy the directed edge information and update end node,
+      // edge data offset, and opp_index
+      const DirectedEdge* directededge = tile->directededge(edgeid);
+      DirectedEdge newedge = *directededge;
 
-        // Get turn lanes from the base directed edge
-        if (directededge->turnlanes()) {
-          uint32_t offset = tile->turnlanes_offset(edgeid.id());
-          tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      // Get signs from the base directed edge
+      if (directededge->sign()) {
+        std::vector<SignInfo> signs = tile->GetSigns(edgeid.id());
+        if (signs.size() == 0) {
+          LOG_ERROR("Base edge should have signs, but none found");
         }
+        tilebuilder.AddSigns(tilebuilder.directededges().size(), signs);
+      }
 
-        // Get access restrictions from the base directed edge. Add these to
-        // the list of access restrictions in the new tile. Update the
-        // edge index in the restriction to be the current directed edge Id
-        if (directededge->access_restriction()) {
-          auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
-          for (const auto& res : restrictions) {
-            tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
-                                                               res.type(), res.modes(), res.value()));
-          }
-        }
+      // Get turn lanes from the base directed edge
+      if (directededge->turnlanes()) {
+        uint32_t offset = tile->turnlanes_offset(edgeid.id());
+        tilebuilder.AddTurnLanes(tilebuilder.directededges().size(), tile->GetName(offset));
+      }
 
-        // Copy lane connectivity
-        if (directededge->laneconnectivity()) {
-          auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
-          if (laneconnectivity.size() == 0) {
-            LOG_ERROR("Base edge should have lane connectivity, but none found");
-          }
-          for (auto& lc : laneconnectivity) {
-            lc.set_to(tilebuilder.directededges().size());
-          }
-          tilebuilder.AddLaneConnectivity(laneconnectivity);
+      // Get access restrictions from the base directed edge. Add these to
+      // the list of access restrictions in the new tile. Update the
+      // edge index in the restriction to be the current directed edge Id
+      if (directededge->access_restriction()) {
+        auto restrictions = tile->GetAccessRestrictions(edgeid.id(), kAllAccess);
+        for (const auto& res : restrictions) {
+          tilebuilder.AddAccessRestriction(AccessRestriction(tilebuilder.directededges().size(),
+                                                             res.type(), res.modes(), res.value()));
         }
+      }
 
-        // Names can be different in the forward and backward direction
-        bool diff_names = tilebuilder.OpposingEdgeInfoDiffers(tile, directededge);
-
-        // Get edge info, shape, and names from the old tile and add
-        // to the new. Use prior edgeinfo offset as the key to make sure
-        // edges that have the same end nodes are differentiated (this
-        // should be a valid key since tile sizes aren't changed)
-        auto edgeinfo = tile->edgeinfo(directededge);
-        uint32_t edge_info_offset =
-            tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id, directededge->endnode(),
-                                    edgeinfo.wayid(), edgeinfo.mean_elevation(),
-                                    edgeinfo.bike_network(), edgeinfo.speed_limit(),
-                                    edgeinfo.encoded_shape(), edgeinfo.GetNames(),
-                                    edgeinfo.GetTaggedValues(), edgeinfo.GetLinguisticTaggedValues(),
-                                    edgeinfo.GetTypes(), added, diff_names);
-
-        newedge.set_edgeinfo_offset(edge_info_offset);
-
-        // Set the superseded mask - this is the shortcut mask that supersedes this edge
-        // (outbound from the node). Do not set (keep as 0) if maximum number of shortcuts
-        // from a node has been exceeded.
-        auto s = shortcuts.find(i);
-        uint32_t superseded_idx = (s != shortcuts.end()) ? s->second : 0;
-        if (superseded_idx <= kMaxShortcutsFromNode) {
-          newedge.set_superseded(superseded_idx);
+      // Copy lane connectivity
+      if (directededge->laneconnectivity()) {
+        auto laneconnectivity = tile->GetLaneConnectivity(edgeid.id());
+        if (laneconnectivity.size() == 0) {
+          LOG_ERROR("Base edge should have lane connectivity, but none found");
         }
+        for (auto& lc : laneconnectivity) {
+          lc.set_to(tilebuilder.directededges().size());
+        }
+        tilebuilder.AddLaneConnectivity(laneconnectivity);
+      }
+
+      // Names can be different in the forward and backward direction
+      bool diff_names = tilebuilder.OpposingEdgeInfoDiffers(tile, directededge);
+
+      // Get edge info, shape, and names from the old tile and add
+      // to the new. Use prior edgeinfo offset as the key to make sure
+      // edges that have the same end nodes are differentiated (this
+      // should be a valid key since tile sizes aren't changed)
+      auto edgeinfo = tile->edgeinfo(directededge);
+      uint32_t edge_info_offset =
+          tilebuilder.AddEdgeInfo(directededge->edgeinfo_offset(), node_id, directededge->endnode(),
+                                  edgeinfo.wayid(), edgeinfo.mean_elevation(),
+                                  edgeinfo.bike_network(), edgeinfo.speed_limit(),
+                                  edgeinfo.encoded_shape(), edgeinfo.GetNames(),
+                                  edgeinfo.GetTaggedValues(), edgeinfo.GetLinguisticTaggedValues(),
+                                  edgeinfo.GetTypes(), added, diff_names);
+
+      newedge.set_edgeinfo_offset(edge_info_offset);
 
-        // Add directed edge
-        tilebuilder.directededges().emplace_back(std::move(newedge));
+      // Set the superseded mask - this is the shortcut mask that supersedes this edge
+      // (outbound from the node). Do not set (keep as 0) if maximum number of shortcuts
+      // from a node has been exceeded.
+      auto s = shortcuts.find(i);
+      uint32_t superseded_idx = (s != shortcuts.end()) ? s->second : 0;
+      if (superseded_idx <= kMaxShortcutsFromNode) {
+        newedge.set_superseded(superseded_idx);
       }
 
-      // Set the edge count for the new node
-      nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
+      // Add directed edge
+      tilebuilder.directededges().emplace_back(std::move(newedge));
+    }
 
-      // Get named signs from the base node
-      if (nodeinfo.named_intersection()) {
+    // Set the edge count for the new node
+    nodeinfo.set_edge_count(tilebuilder.directededges().size() - edge_count);
 
-        std::vector<SignInfo> signs = tile->GetSigns(n, true);
-        if (signs.size() == 0) {
-          LOG_ERROR("Base node should have signs, but none found");
-        }
-        tilebuilder.AddSigns(tilebuilder.nodes().size(), signs);
+    // Get named signs from the base node
+    if (nodeinfo.named_intersection()) {
+
+      std::vector<SignInfo> signs = tile->GetSigns(n, true);
+      if (signs.size() == 0) {
+        LOG_ERROR("Base node should have signs, but none found");
       }
-      tilebuilder.nodes().emplace_back(std::move(nodeinfo));
+      tilebuilder.AddSigns(tilebuilder.nodes().size(), signs);
+    }
+    tilebuilder.nodes().emplace_back(std::move(nodeinfo));
+  }
+
+  // Store the new tile in the staging directory, other threads may still read the original
+  tilebuilder.StoreTileData(staging_dir);
+  LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
+             tilebuilder.header_builder().end_offset())
+                .str());
+
+  return {shortcut_count, total_edge_count};
+}
+
+// Shortcut and superseded edge counts along with the tiles that were staged
+using shortcut_stats_t = std::tuple<uint32_t, uint32_t, std::vector<GraphId>>;
+
+// Form shortcuts for tiles taken off the shared queue until it is empty. Only original tiles
+// are read here so the threads never see each other's partially written output.
+void FormShortcutsInTiles(const boost::property_tree::ptree& pt,
+                          std::deque<GraphId>& tilequeue,
+                          std::mutex& lock,
+                          const std::string& staging_dir,
+                          std::promise<shortcut_stats_t>& result) {
+  GraphReader reader(pt.get_child("mjolnir"));
+  uint32_t shortcut_count = 0;
+  uint32_t total_edge_count = 0;
+  std::vector<GraphId> staged;
+  while (true) {
+    // Get the next tile to work on
+    lock.lock();
+    if (tilequeue.empty()) {
+      lock.unlock();
+      break;
+    }
+    GraphId tile_id = tilequeue.front();
+    tilequeue.pop_front();
+    lock.unlock();
+
+    // Get the graph tile. Skip if no tile exists
+    graph_tile_ptr tile = reader.GetGraphTile(tile_id);
+    if (!tile) {
+      continue;
     }
 
-    // Store the new tile
-    tilebuilder.StoreTileData();
-    LOG_DEBUG((boost::format("ShortcutBuilder created tile %1%: %2% bytes") % tile %
-               tilebuilder.header_builder().end_offset())
-                  .str());
+    auto stats = FormShortcutsInTile(reader, tile, tile_id, staging_dir);
+    shortcut_count += stats.first;
+    total_edge_count += stats.second;
+    staged.push_back(tile_id);
 
     // Check if we need to clear the tile cache.
     if (reader.OverCommitted()) {
       reader.Trim();
     }
   }
+  result.set_value(std::make_tuple(shortcut_count, total_edge_count, std::move(staged)));
+}
+
+// Form shortcuts for tiles in this level. Tiles are formed in parallel against the original
+// tiles of the level and staged, only once every thread is done are the staged tiles moved
+// over the originals. Every tile therefore sees the same input regardless of scheduling.
+std::pair<uint32_t, uint32_t> FormShortcuts(const boost::property_tree::ptree& pt,
+                                            const std::string& tile_dir,
+                                            const TileLevel& level) {
+  // Queue up the tiles of this level
+  GraphReader reader(pt.get_child("mjolnir"));
+  auto tileset = reader.GetTileSet(level.level);
+  std::deque<GraphId> tilequeue(tileset.begin(), tileset.end());
+  std::sort(tilequeue.begin(), tilequeue.end());
+
+  // Start from a clean staging area
+  std::string staging_dir = tile_dir + filesystem::path::preferred_separator + "shortcuts.tmp";
+  filesystem::remove_all(staging_dir);
+
+  // Setup threads and their results
+  std::mutex lock;
+  std::vector<std::shared_ptr<std::thread>> threads(
+      std::max(static_cast<unsigned int>(1),
+               pt.get<unsigned int>("mjolnir.concurrency", std::thread::hardware_concurrency())));
+  std::list<std::promise<shortcut_stats_t>> results;
+  for (auto& thread : threads) {
+    results.emplace_back();
+    thread.reset(new std::thread(FormShortcutsInTiles, std::cref(pt), std::ref(tilequeue),
+                                 std::ref(lock), std::cref(staging_dir), std::ref(results.back())));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+
+  // Total the stats and move the staged tiles into place
+  uint32_t shortcut_count = 0;
+  uint32_t total_edge_count = 0;
+  for (auto& result : results) {
+    auto data = result.get_future().get();
+    shortcut_count += std::get<0>(data);
+    total_edge_count += std::get<1>(data);
+    for (const auto& tile_id : std::get<2>(data)) {
+      auto suffix = GraphTile::FileSuffix(tile_id);
+      std::string file = tile_dir + filesystem::path::preferred_separator + suffix;
+      filesystem::remove(file);
+      if (!filesystem::rename(staging_dir + filesystem::path::preferred_separator + suffix, file)) {
+        throw std::runtime_error("Could not move shortcut tile into place: " + file);
+      }
+    }
+  }
+  filesystem::remove_all(staging_dir);
   return {shortcut_count, total_edge_count};
 }
 
@@ -754,20 +842,15 @@ namespace mjolnir {
 // only connect to 2 edges on the hierarchy level, and have compatible
 // attributes. Shortcut edges are inserted before regular edges.
 void ShortcutBuilder::Build(const boost::property_tree::ptree& pt) {
-
-  // TODO: thread this. would need to make sure we dont make shortcuts
-  // across tile boundaries so that we are only messing with one tile
-  // in one thread at a time
-
-  // Get GraphReader
-  GraphReader reader(pt.get_child("mjolnir"));
+  // Tiles of a level are formed in parallel, see FormShortcuts
+  std::string tile_dir = pt.get<std::string>("mjolnir.tile_dir");
 
   auto tile_level = TileHierarchy::levels().rbegin();
   tile_level++;
   for (; tile_level != TileHierarchy::levels().rend(); ++tile_level) {
     // Create shortcuts on this level
     LOG_INFO("Creating shortcuts on level " + std::to_string(tile_level->level));
-    [[maybe_unused]] auto stats = FormShortcuts(reader, *tile_level);
+    [[maybe_unused]] auto stats = FormShortcuts(pt, tile_dir, *tile_level);
     [[maybe_unused]] uint32_t avg = stats.first ? (stats.second / stats.first) : 0;
     LOG_INFO("Finished with " + std::to_string(stats.first) + " shortcuts superseding " +
              std::to_string(stats.second) + " edges, average ~" + std::to_string(avg) +
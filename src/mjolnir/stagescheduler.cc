@@ -0,0 +1,161 @@
+#include "mjolnir/stagescheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Resets the peak resident set size of the process so that the next reading covers only what
+// follows. Only linux allows this, elsewhere readings are the peak since the process started
+void reset_peak_rss() {
+#ifdef __linux__
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (clear_refs.is_open()) {
+    clear_refs << "5";
+  }
+#endif
+}
+
+double seconds(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration_cast<std::chrono::duration<double>>(d).count();
+}
+
+} // namespace
+
+namespace valhalla {
+namespace mjolnir {
+
+void StageScheduler::add(const std::string& name,
+                         const std::function<void()>& work,
+                         const std::vector<std::string>& dependencies) {
+  stages_.push_back({name, work, dependencies});
+}
+
+std::vector<StageTiming> StageScheduler::run(unsigned int concurrency) {
+  concurrency = std::max(concurrency, 1u);
+
+  // Figure out how many stages each stage waits on and which stages wait on it
+  std::unordered_map<std::string, size_t> indices;
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    if (!indices.emplace(stages_[i].name, i).second) {
+      throw std::logic_error("Duplicate build stage " + stages_[i].name);
+    }
+  }
+  std::vector<size_t> waiting(stages_.size(), 0);
+  std::vector<std::vector<size_t>> dependents(stages_.size());
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    for (const auto& dependency : stages_[i].dependencies) {
+      auto found = indices.find(dependency);
+      if (found != indices.cend()) {
+        ++waiting[i];
+        dependents[found->second].push_back(i);
+      }
+    }
+  }
+
+  std::mutex lock;
+  std::condition_variable finished_one;
+  std::vector<bool> started(stages_.size(), false);
+  size_t running = 0, finished = 0;
+  std::exception_ptr error;
+  std::vector<StageTiming> timings;
+  std::list<std::thread> threads;
+  const auto begin = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> guard(lock);
+  while (true) {
+    // Start every stage that is ready, as long as there is room and nothing failed
+    for (size_t i = 0; i < stages_.size() && running < concurrency && !error; ++i) {
+      if (started[i] || waiting[i] > 0) {
+        continue;
+      }
+      started[i] = true;
+      if (running++ == 0) {
+        reset_peak_rss();
+      }
+      threads.emplace_back([&, i]() {
+        const auto start = std::chrono::steady_clock::now();
+        std::exception_ptr stage_error;
+        try {
+          stages_[i].work();
+        } catch (...) { stage_error = std::current_exception(); }
+        const auto end = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> stage_guard(lock);
+        timings.push_back({stages_[i].name, seconds(start - begin), seconds(end - start),
+                           peak_rss()});
+        if (stage_error && !error) {
+          error = stage_error;
+        }
+        for (auto dependent : dependents[i]) {
+          --waiting[dependent];
+        }
+        --running;
+        ++finished;
+        finished_one.notify_one();
+      });
+    }
+
+    // Nothing running means either all is done, a stage failed or the rest wait on a cycle
+    if (running == 0) {
+      break;
+    }
+    finished_one.wait(guard);
+  }
+  guard.unlock();
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  if (finished < stages_.size()) {
+    throw std::logic_error("Build stages depend on each other in a cycle");
+  }
+  return timings;
+}
+
+uint64_t StageScheduler::peak_rss() {
+#ifdef __linux__
+  // the high water mark of the resident set, in kB
+  std::ifstream status("/proc/self/status");
+  for (std::string line; std::getline(status, line);) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      std::istringstream value(line.substr(6));
+      uint64_t kb = 0;
+      value >> kb;
+      return kb * 1024;
+    }
+  }
+#endif
+#if defined(_WIN32)
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+} // namespace mjolnir
+} // namespace valhalla
@@ -1,11 +1,13 @@
 #include "mjolnir/util.h"
 
+#include "baldr/graphtile.h"
 #include "baldr/tilehierarchy.h"
 #include "filesystem.h"
 #include "midgard/aabb2.h"
 #include "midgard/logging.h"
 #include "midgard/point2.h"
 #include "midgard/polyline2.h"
+#include "mjolnir/adminbuilder.h"
 #include "mjolnir/bssbuilder.h"
 #include "mjolnir/elevationbuilder.h"
 #include "mjolnir/graphbuilder.h"
@@ -13,16 +15,24 @@
 #include "mjolnir/graphfilter.h"
 #include "mjolnir/graphvalidator.h"
 #include "mjolnir/hierarchybuilder.h"
+#include "mjolnir/osmchange.h"
 #include "mjolnir/osmpbfparser.h"
 #include "mjolnir/pbfgraphparser.h"
 #include "mjolnir/restrictionbuilder.h"
 #include "mjolnir/shortcutbuilder.h"
+#include "mjolnir/stagescheduler.h"
 #include "mjolnir/transitbuilder.h"
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <fstream>
+#include <functional>
+#include <limits>
 #include <regex>
+#include <set>
+#include <stdexcept>
+#include <unordered_set>
 
 using namespace valhalla::midgard;
 
@@ -58,6 +68,26 @@ const std::string cr_to_file = "complex_to_restrictions.bin";
 const std::string new_to_old_file = "new_nodes_to_old_nodes.bin";
 const std::string old_to_new_file = "old_nodes_to_new_nodes.bin";
 const std::string intersections_file = "intersections.bin";
+const std::string affected_tiles_file = "affected_tiles.txt";
+
+// Finds the tiles touched by the OSM change since the previous build and lists them, one tile
+// path per line, in the tile directory so that caches of the previous build can be refreshed
+std::unordered_set<valhalla::baldr::GraphId>
+get_affected_tiles(const boost::property_tree::ptree& pt, const std::string& tile_dir) {
+  auto previous_tile_dir = pt.get_optional<std::string>("mjolnir.previous_build.tile_dir");
+  auto osc = pt.get_optional<std::string>("mjolnir.previous_build.osc");
+  if (!previous_tile_dir || !osc) {
+    return {};
+  }
+
+  auto affected = valhalla::mjolnir::OSMChange::Read(*osc).AffectedTiles(pt, *previous_tile_dir);
+  std::set<valhalla::baldr::GraphId> sorted(affected.begin(), affected.end());
+  std::ofstream file(tile_dir + affected_tiles_file, std::ios::trunc);
+  for (const auto& tile_id : sorted) {
+    file << valhalla::baldr::GraphTile::FileSuffix(tile_id) << std::endl;
+  }
+  return affected;
+}
 const std::string shapes_file = "shapes.bin";
 
 } // namespace
@@ -288,64 +318,80 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
   // OSMData class
   OSMData osm_data{0};
 
+  // The stages run as a graph. Each stage of the pipeline depends on all of the stages before it,
+  // other work only on what it actually needs so that it can overlap with the pipeline
+  StageScheduler scheduler;
+  std::vector<std::string> pipeline;
+  auto add_stage = [&](BuildStage stage, const std::function<void()>& work,
+                       std::vector<std::string> dependencies = {}) {
+    if (start_stage <= stage && stage <= end_stage) {
+      dependencies.insert(dependencies.end(), pipeline.begin(), pipeline.end());
+      scheduler.add(to_string(stage), work, dependencies);
+      pipeline.push_back(to_string(stage));
+    }
+  };
+
+  // Build the admin database from the same extracts while the graph is parsed. Only the build
+  // stage needs it. The protobuf library is released once both are done with it
+  const bool parsing =
+      start_stage <= BuildStage::kParseNodes && BuildStage::kParseWays <= end_stage;
+  const bool build_admins = parsing && config.get<bool>("mjolnir.build_admins", false);
+  if (build_admins) {
+    scheduler.add("admins", [&]() {
+      if (!BuildAdminFromPBF(config.get_child("mjolnir"), input_files, false)) {
+        throw std::runtime_error("Failed to build the admin database");
+      }
+    });
+  }
+
   // Parse the ways
-  if (start_stage <= BuildStage::kParseWays && BuildStage::kParseWays <= end_stage) {
+  add_stage(BuildStage::kParseWays, [&]() {
     // Read the OSM protocol buffer file. Callbacks for ways are defined within the PBFParser class
     osm_data = PBFGraphParser::ParseWays(config.get_child("mjolnir"), input_files, ways_bin,
                                          way_nodes_bin, access_bin);
 
-    // Free all protobuf memory - cannot use the protobuffer lib after this!
-    if (release_osmpbf_memory && BuildStage::kParseWays == end_stage) {
-      OSMPBF::Parser::free();
-    }
-
     // Write the OSMData to files if the end stage is less than enhancing
     if (end_stage <= BuildStage::kEnhance) {
       osm_data.write_to_temp_files(tile_dir);
     }
-  }
+  });
 
   // Parse OSM data
-  if (start_stage <= BuildStage::kParseRelations && BuildStage::kParseRelations <= end_stage) {
-
+  add_stage(BuildStage::kParseRelations, [&]() {
     // Read the OSM protocol buffer file. Callbacks for relations are defined within the PBFParser
     // class
     PBFGraphParser::ParseRelations(config.get_child("mjolnir"), input_files, cr_from_bin, cr_to_bin,
                                    osm_data);
 
-    // Free all protobuf memory - cannot use the protobuffer lib after this!
-    if (release_osmpbf_memory && BuildStage::kParseRelations == end_stage) {
-      OSMPBF::Parser::free();
-    }
-
     // Write the OSMData to files if the end stage is less than enhancing
     if (end_stage <= BuildStage::kEnhance) {
       osm_data.write_to_temp_files(tile_dir);
     }
-  }
+  });
 
   // Parse OSM data
-  if (start_stage <= BuildStage::kParseNodes && BuildStage::kParseNodes <= end_stage) {
+  add_stage(BuildStage::kParseNodes, [&]() {
     // Read the OSM protocol buffer file. Callbacks for nodes
     // are defined within the PBFParser class
     PBFGraphParser::ParseNodes(config.get_child("mjolnir"), input_files, way_nodes_bin, bss_nodes_bin,
                                linguistic_node_bin, osm_data);
 
-    // Free all protobuf memory - cannot use the protobuffer lib after this!
-    if (release_osmpbf_memory) {
-      OSMPBF::Parser::free();
-    }
-
     // Write the OSMData to files if the end stage is less than enhancing
     if (end_stage <= BuildStage::kEnhance) {
       osm_data.write_to_temp_files(tile_dir);
     }
+  });
+
+  // Free all protobuf memory - cannot use the protobuf lib after this!
+  if (release_osmpbf_memory && parsing) {
+    scheduler.add("releasepbf", []() { OSMPBF::Parser::free(); },
+                  {"admins", to_string(BuildStage::kParseWays),
+                   to_string(BuildStage::kParseRelations), to_string(BuildStage::kParseNodes)});
   }
 
   // Construct edges
   std::map<baldr::GraphId, size_t> tiles;
-  if (start_stage <= BuildStage::kConstructEdges && BuildStage::kConstructEdges <= end_stage) {
-
+  add_stage(BuildStage::kConstructEdges, [&]() {
     // Read OSMData from files if construct edges is the first stage
     if (start_stage == BuildStage::kConstructEdges)
       osm_data.read_from_temp_files(tile_dir);
@@ -354,72 +400,68 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     // Output manifest
     TileManifest manifest{tiles};
     manifest.LogToFile(tile_manifest);
-  }
+  });
 
   // Build Valhalla routing tiles
-  if (start_stage <= BuildStage::kBuild && BuildStage::kBuild <= end_stage) {
-    if (start_stage == BuildStage::kBuild) {
-      // Read OSMData from files if building tiles is the first stage
-      osm_data.read_from_temp_files(tile_dir);
-      if (filesystem::exists(tile_manifest)) {
-        tiles = TileManifest::ReadFromFile(tile_manifest).tileset;
-      } else {
-        // TODO: Remove this backfill in the future, and make calling constructedges stage
-        // explicitly required in the future.
-        LOG_WARN("Tile manifest not found, rebuilding edges and manifest");
-        tiles = GraphBuilder::BuildEdges(config, ways_bin, way_nodes_bin, nodes_bin, edges_bin);
-      }
-    }
+  add_stage(
+      BuildStage::kBuild,
+      [&]() {
+        if (start_stage == BuildStage::kBuild) {
+          // Read OSMData from files if building tiles is the first stage
+          osm_data.read_from_temp_files(tile_dir);
+          if (filesystem::exists(tile_manifest)) {
+            tiles = TileManifest::ReadFromFile(tile_manifest).tileset;
+          } else {
+            // TODO: Remove this backfill in the future, and make calling constructedges stage
+            // explicitly required in the future.
+            LOG_WARN("Tile manifest not found, rebuilding edges and manifest");
+            tiles = GraphBuilder::BuildEdges(config, ways_bin, way_nodes_bin, nodes_bin, edges_bin);
+          }
+        }
 
-    // Build the graph using the OSMNodes and OSMWays from the parser
-    GraphBuilder::Build(config, osm_data, ways_bin, way_nodes_bin, nodes_bin, edges_bin, cr_from_bin,
-                        cr_to_bin, linguistic_node_bin, tiles);
-  }
+        // Build the graph using the OSMNodes and OSMWays from the parser
+        GraphBuilder::Build(config, osm_data, ways_bin, way_nodes_bin, nodes_bin, edges_bin,
+                            cr_from_bin, cr_to_bin, linguistic_node_bin, tiles);
+      },
+      {"admins"});
 
   // Enhance the local level of the graph. This adds information to the local
   // level that is usable across all levels (density, administrative
   // information (and country based attribution), edge transition logic, etc.
-  if (start_stage <= BuildStage::kEnhance && BuildStage::kEnhance <= end_stage) {
+  add_stage(BuildStage::kEnhance, [&]() {
     // Read OSMData names from file if enhancing tiles is the first stage
     if (start_stage == BuildStage::kEnhance) {
       osm_data.read_from_unique_names_file(tile_dir);
     }
     GraphEnhancer::Enhance(config, osm_data, access_bin);
-  }
+  });
 
   // Perform optional edge filtering (remove edges and nodes for specific access modes)
-  if (start_stage <= BuildStage::kFilter && BuildStage::kFilter <= end_stage) {
-    GraphFilter::Filter(config);
-  }
+  add_stage(BuildStage::kFilter, [&]() { GraphFilter::Filter(config); });
 
   // Add transit
-  if (start_stage <= BuildStage::kTransit && BuildStage::kTransit <= end_stage) {
-    TransitBuilder::Build(config);
-  }
+  add_stage(BuildStage::kTransit, [&]() { TransitBuilder::Build(config); });
 
   // Build bike share stations
-  if (start_stage <= BuildStage::kBss && BuildStage::kBss <= end_stage) {
+  add_stage(BuildStage::kBss, [&]() {
     if (start_stage == BuildStage::kBss) {
       osm_data.read_from_unique_names_file(tile_dir);
     }
     BssBuilder::Build(config, osm_data, bss_nodes_bin);
-  }
+  });
 
   // Builds additional hierarchies if specified within config file. Connections
   // (directed edges) are formed between nodes at adjacent levels.
   auto build_hierarchy = config.get<bool>("mjolnir.hierarchy", true);
   if (build_hierarchy) {
-    if (start_stage <= BuildStage::kHierarchy && BuildStage::kHierarchy <= end_stage) {
-      HierarchyBuilder::Build(config, new_to_old_bin, old_to_new_bin);
-    }
+    add_stage(BuildStage::kHierarchy,
+              [&]() { HierarchyBuilder::Build(config, new_to_old_bin, old_to_new_bin); });
 
     // Build shortcuts if specified in the config file. Shortcuts can only be
     // applied if hierarchies are also generated.
     auto build_shortcuts = config.get<bool>("mjolnir.shortcuts", true);
     if (build_shortcuts) {
-      if (start_stage <= BuildStage::kShortcuts && BuildStage::kShortcuts <= end_stage) {
-        ShortcutBuilder::Build(config);
-      }
+      add_stage(BuildStage::kShortcuts, [&]() { ShortcutBuilder::Build(config); });
     } else {
       LOG_INFO("Skipping shortcut builder");
     }
@@ -427,26 +469,24 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     LOG_INFO("Skipping hierarchy builder and shortcut builder");
   }
 
-  // Add elevation to the tiles
-  if (start_stage <= BuildStage::kElevation && BuildStage::kElevation <= end_stage) {
-    ElevationBuilder::Build(config);
-  }
+  // Add elevation to the tiles. Given a previous build only the tiles touched by the change are
+  // sampled from scratch, the others copy what did not change from the previous build
+  add_stage(BuildStage::kElevation, [&]() {
+    ElevationBuilder::Build(config, {}, get_affected_tiles(config, tile_dir));
+  });
 
   // Build the Complex Restrictions
   // ComplexRestrictions must be done after elevation. The reason is that building
   // elevation into the tiles reads each tile and serializes the data to "builders"
   // within the tile. However, there is no serialization currently available for complex restrictions.
-  if (start_stage <= BuildStage::kRestrictions && BuildStage::kRestrictions <= end_stage) {
-    RestrictionBuilder::Build(config, cr_from_bin, cr_to_bin);
-  }
+  add_stage(BuildStage::kRestrictions,
+            [&]() { RestrictionBuilder::Build(config, cr_from_bin, cr_to_bin); });
 
   // Validate the graph and add information that cannot be added until full graph is formed.
-  if (start_stage <= BuildStage::kValidate && BuildStage::kValidate <= end_stage) {
-    GraphValidator::Validate(config);
-  }
+  add_stage(BuildStage::kValidate, [&]() { GraphValidator::Validate(config); });
 
   // Cleanup bin files
-  if (start_stage <= BuildStage::kCleanup && BuildStage::kCleanup <= end_stage) {
+  add_stage(BuildStage::kCleanup, [&]() {
     LOG_INFO("Cleaning up temporary *.bin files within " + tile_dir);
     remove_temp_file(ways_bin);
     remove_temp_file(way_nodes_bin);
@@ -461,6 +501,15 @@ bool build_tile_set(const boost::property_tree::ptree& original_config,
     remove_temp_file(old_to_new_bin);
     remove_temp_file(tile_manifest);
     OSMData::cleanup_temp_files(tile_dir);
+  });
+
+  // Stages are multithreaded themselves, the scheduler only needs a thread per stage that can
+  // run at the same time as another
+  auto timings = scheduler.run(std::numeric_limits<unsigned int>::max());
+  for (const auto& timing : timings) {
+    LOG_INFO("Stage " + timing.name + " started at " + std::to_string(timing.start) +
+             "s and took " + std::to_string(timing.duration) + "s, peak RSS " +
+             std::to_string(timing.peak_rss / (1024 * 1024)) + " MB");
   }
   return true;
 }
@@ -50,6 +50,9 @@ int main(int argc, char** argv) {
       ("i,inline-config", "Inline JSON config", cxxopts::value<std::string>())
       ("s,start", "Starting stage of the build pipeline", cxxopts::value<std::string>()->default_value("initialize"))
       ("e,end", "End stage of the build pipeline", cxxopts::value<std::string>()->default_value("cleanup"))
+      ("previous-tile-dir", "Tile directory of a previous build. Nodes and edges that did not change since then copy their elevation from it instead of sampling it again. Every other stage still builds the whole graph from the input file(s).", cxxopts::value<std::string>())
+      ("osc", "OSM change file (.osc or .osc.gz) the input file(s) received since the previous build. The tiles it touches are sampled for elevation from scratch and listed in affected_tiles.txt. Only the elevation stage makes use of it.", cxxopts::value<std::string>())
+      ("build-admins", "Build the admin database (mjolnir.admin) from the input file(s) while the graph is parsed, instead of running valhalla_build_admins beforehand.")
       ("input_files", "positional arguments", cxxopts::value<std::vector<std::string>>(input_files))
       ("j,concurrency", "Number of threads to use. Defaults to all threads.", cxxopts::value<uint32_t>());
     // clang-format on
@@ -77,6 +80,33 @@ int main(int argc, char** argv) {
     }
     LOG_INFO("Start stage = " + to_string(start_stage) + " End stage = " + to_string(end_stage));
 
+    // The elevation stage reads the previous tiles, which must therefore survive this build
+    if (result.count("previous-tile-dir")) {
+      auto previous_tile_dir = result["previous-tile-dir"].as<std::string>();
+      auto tile_dir = config.get<std::string>("mjolnir.tile_dir");
+      auto trim = [](std::string dir) {
+        while (dir.size() > 1 && dir.back() == filesystem::path::preferred_separator) {
+          dir.pop_back();
+        }
+        return dir;
+      };
+      if (trim(previous_tile_dir) == trim(tile_dir)) {
+        throw cxxopts::exceptions::exception(
+            "The previous tile directory must differ from mjolnir.tile_dir");
+      }
+      config.put("mjolnir.previous_build.tile_dir", previous_tile_dir);
+    }
+    if (result.count("osc")) {
+      if (!result.count("previous-tile-dir")) {
+        throw cxxopts::exceptions::exception("An OSM change file requires --previous-tile-dir");
+      }
+      config.put("mjolnir.previous_build.osc", result["osc"].as<std::string>());
+    }
+
+    if (result.count("build-admins")) {
+      config.put("mjolnir.build_admins", true);
+    }
+
     // Make sure start stage < end stage
     if (static_cast<int>(start_stage) > static_cast<int>(end_stage)) {
       list_stages();
@@ -1,3 +1,13 @@
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "odin/directionsbuilder.h"
 #include "midgard/logging.h"
 #include "odin/enhancedtrippath.h"
@@ -13,6 +23,119 @@ namespace {
 // Minimum edge length to verify heading (~3 feet)
 constexpr auto kMinEdgeLength = 0.001f;
 
+// Helper threads shared by all the requests of the process. The pool only ever grows to the largest
+// concurrency asked of it (less the calling thread), so however many workers narrate at once the
+// process never has more helpers than that. A request doesn't wait for the helpers, it does all of
+// its work itself if they are busy with other requests
+class helper_pool_t {
+public:
+  static helper_pool_t& get() {
+    static helper_pool_t pool;
+    return pool;
+  }
+
+  // queues tasks for up to helpers of the threads, adding threads if there are fewer than that
+  void submit(size_t helpers, const std::function<void()>& task) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      while (threads.size() < helpers) {
+        threads.emplace_back(&helper_pool_t::work, this);
+      }
+      tasks.insert(tasks.end(), helpers, task);
+    }
+    ready.notify_all();
+  }
+
+  ~helper_pool_t() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      done = true;
+      tasks.clear();
+    }
+    ready.notify_all();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+private:
+  helper_pool_t() : done(false) {
+  }
+
+  void work() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        ready.wait(guard, [this] { return done || !tasks.empty(); });
+        if (done) {
+          return;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> threads;
+  std::deque<std::function<void()>> tasks;
+  std::mutex lock;
+  std::condition_variable ready;
+  bool done;
+};
+
+// The legs of one request, whoever takes a leg builds it. A helper may only get to its task after
+// the request is done, so the helpers hold on to this and only touch the request through the legs
+// they take, of which there are none left by then
+struct leg_queue_t {
+  leg_queue_t(size_t count, std::function<void(size_t)> build)
+      : next(0), count(count), finished(0), build(std::move(build)) {
+  }
+
+  // builds legs until there are none left, a leg after the first failure is only counted
+  void take() {
+    for (size_t i = next++; i < count; i = next++) {
+      bool failed;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        failed = static_cast<bool>(failure);
+      }
+      if (!failed) {
+        try {
+          build(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(lock);
+          if (!failure) {
+            failure = std::current_exception();
+          }
+        }
+      }
+      std::lock_guard<std::mutex> guard(lock);
+      if (++finished == count) {
+        all_finished.notify_all();
+      }
+    }
+  }
+
+  // waits until every leg has been built (or skipped) and rethrows the first failure
+  void wait() {
+    std::unique_lock<std::mutex> guard(lock);
+    all_finished.wait(guard, [this] { return finished == count; });
+    if (failure) {
+      std::rethrow_exception(failure);
+    }
+  }
+
+  std::atomic<size_t> next;
+  const size_t count;
+  size_t finished;
+  std::function<void(size_t)> build;
+  std::exception_ptr failure;
+  std::mutex lock;
+  std::condition_variable all_finished;
+};
+
 } // namespace
 
 namespace valhalla {
@@ -22,9 +145,16 @@ namespace odin {
 // and trip path. This method calls ManeuversBuilder::Build and
 // NarrativeBuilder::Build to form the maneuver list. This method
 // calls PopulateDirectionsLeg to transform the maneuver list into the
-// trip directions.
-void DirectionsBuilder::Build(Api& api, const MarkupFormatter& markup_formatter) {
+// trip directions. The legs are independent of each other so they are
+// built concurrently when there is more than one of them.
+void DirectionsBuilder::Build(Api& api,
+                              const MarkupFormatter& markup_formatter,
+                              size_t concurrency) {
   const auto& options = api.options();
+
+  // Add the directions of every leg of every route up front so that the legs can be built in any
+  // order while the directions keep the order of the trip
+  std::vector<std::pair<TripLeg*, DirectionsLeg*>> legs;
   for (auto& trip_route : *api.mutable_trip()->mutable_routes()) {
     auto& directions_route = *api.mutable_directions()->mutable_routes()->Add();
     for (auto& trip_path : *trip_route.mutable_legs()) {
@@ -34,31 +164,53 @@ void DirectionsBuilder::Build(Api& api, const MarkupFormatter& markup_formatter)
       if (trip_path.node_size() < 1) {
         throw valhalla_exception_t{210};
       }
+      legs.emplace_back(&trip_path, &trip_directions);
+    }
+  }
 
-      // Create an enhanced trip path from the specified trip_path
-      EnhancedTripLeg etp(trip_path);
-
-      // Produce maneuvers if desired
-      std::list<Maneuver> maneuvers;
-      if (options.directions_type() != DirectionsType::none) {
-        // Update the heading of ~0 length edges
-        UpdateHeading(&etp);
-
-        ManeuversBuilder maneuversBuilder(options, &etp);
-        maneuvers = maneuversBuilder.Build();
-
-        // Create the instructions if desired
-        if (options.directions_type() == DirectionsType::instructions) {
-          std::unique_ptr<NarrativeBuilder> narrative_builder =
-              NarrativeBuilderFactory::Create(options, &etp, markup_formatter);
-          narrative_builder->Build(maneuvers);
-        }
-      }
+  // One leg is built right here, more than that are shared with the helpers of the process. The
+  // calling thread takes legs too, so the request finishes even if the helpers are all busy
+  if (concurrency <= 1 || legs.size() <= 1) {
+    for (auto& leg : legs) {
+      BuildLeg(options, *leg.first, markup_formatter, *leg.second);
+    }
+    return;
+  }
+  auto queue = std::make_shared<leg_queue_t>(legs.size(), [&](size_t i) {
+    BuildLeg(options, *legs[i].first, markup_formatter, *legs[i].second);
+  });
+  helper_pool_t::get().submit(std::min(concurrency, legs.size()) - 1, [queue]() { queue->take(); });
+  queue->take();
+  queue->wait();
+}
 
-      // Return trip directions
-      PopulateDirectionsLeg(options, &etp, maneuvers, trip_directions);
+// Returns the directions of a single trip leg
+void DirectionsBuilder::BuildLeg(const Options& options,
+                                 TripLeg& trip_path,
+                                 const MarkupFormatter& markup_formatter,
+                                 DirectionsLeg& trip_directions) {
+  // Create an enhanced trip path from the specified trip_path
+  EnhancedTripLeg etp(trip_path);
+
+  // Produce maneuvers if desired
+  std::list<Maneuver> maneuvers;
+  if (options.directions_type() != DirectionsType::none) {
+    // Update the heading of ~0 length edges
+    UpdateHeading(&etp);
+
+    ManeuversBuilder maneuversBuilder(options, &etp);
+    maneuvers = maneuversBuilder.Build();
+
+    // Create the instructions if desired
+    if (options.directions_type() == DirectionsType::instructions) {
+      std::unique_ptr<NarrativeBuilder> narrative_builder =
+          NarrativeBuilderFactory::Create(options, &etp, markup_formatter);
+      narrative_builder->Build(maneuvers);
     }
   }
+
+  // Return trip directions
+  PopulateDirectionsLeg(options, &etp, maneuvers, trip_directions);
 }
 
 // Update the heading of ~0 length edges.
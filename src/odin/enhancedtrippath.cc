@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 
@@ -226,30 +227,46 @@ namespace odin {
 // EnhancedTripLeg
 
 EnhancedTripLeg::EnhancedTripLeg(TripLeg& trip_path) : trip_path_(trip_path) {
+  nodes_.reserve(node_size());
+  edges_.reserve(std::max(node_size() - 1, 0));
+  for (int i = 0; i < node_size(); ++i) {
+    nodes_.emplace_back(mutable_node(i));
+    if (!IsLastNodeIndex(i)) {
+      edges_.emplace_back(mutable_node(i)->mutable_edge());
+    }
+  }
 }
 
-std::unique_ptr<EnhancedTripLeg_Node> EnhancedTripLeg::GetEnhancedNode(const int node_index) {
-  return std::make_unique<EnhancedTripLeg_Node>(mutable_node(node_index));
+EnhancedTripLeg_Node* EnhancedTripLeg::GetEnhancedNode(const int node_index) {
+  return &nodes_[node_index];
 }
 
-std::unique_ptr<EnhancedTripLeg_Edge> EnhancedTripLeg::GetPrevEdge(const int node_index, int delta) {
+EnhancedTripLeg_Edge* EnhancedTripLeg::GetPrevEdge(const int node_index, int delta) {
   int index = node_index - delta;
   if (IsValidNodeIndex(index)) {
-    return std::make_unique<EnhancedTripLeg_Edge>(mutable_node(index)->mutable_edge());
+    return &edges_[index];
   } else {
     return nullptr;
   }
 }
 
-std::unique_ptr<EnhancedTripLeg_Edge> EnhancedTripLeg::GetCurrEdge(const int node_index) const {
+EnhancedTripLeg_Edge* EnhancedTripLeg::GetCurrEdge(const int node_index) {
+  return GetNextEdge(node_index, 0);
+}
+
+const EnhancedTripLeg_Edge* EnhancedTripLeg::GetCurrEdge(const int node_index) const {
   return GetNextEdge(node_index, 0);
 }
 
-std::unique_ptr<EnhancedTripLeg_Edge> EnhancedTripLeg::GetNextEdge(const int node_index,
-                                                                   int delta) const {
+EnhancedTripLeg_Edge* EnhancedTripLeg::GetNextEdge(const int node_index, int delta) {
+  return const_cast<EnhancedTripLeg_Edge*>(
+      static_cast<const EnhancedTripLeg&>(*this).GetNextEdge(node_index, delta));
+}
+
+const EnhancedTripLeg_Edge* EnhancedTripLeg::GetNextEdge(const int node_index, int delta) const {
   int index = node_index + delta;
   if (IsValidNodeIndex(index) && !IsLastNodeIndex(index)) {
-    return std::make_unique<EnhancedTripLeg_Edge>(mutable_node(index)->mutable_edge());
+    return &edges_[index];
   } else {
     return nullptr;
   }
@@ -1441,6 +1458,10 @@ EnhancedTripLeg_IntersectingEdge::GetTravelModeTraversability(const TravelMode t
 // EnhancedTripLeg_Node
 
 EnhancedTripLeg_Node::EnhancedTripLeg_Node(TripLeg_Node* mutable_node) : mutable_node_(mutable_node) {
+  intersecting_edges_.reserve(intersecting_edge_size());
+  for (int i = 0; i < intersecting_edge_size(); ++i) {
+    intersecting_edges_.emplace_back(mutable_intersecting_edge(i));
+  }
 }
 
 bool EnhancedTripLeg_Node::HasIntersectingEdges() const {
@@ -1487,9 +1508,8 @@ bool EnhancedTripLeg_Node::HasNonBackwardTraversableSameNameRampIntersectingEdge
   return false;
 }
 
-std::unique_ptr<EnhancedTripLeg_IntersectingEdge>
-EnhancedTripLeg_Node::GetIntersectingEdge(size_t index) {
-  return std::make_unique<EnhancedTripLeg_IntersectingEdge>(mutable_intersecting_edge(index));
+EnhancedTripLeg_IntersectingEdge* EnhancedTripLeg_Node::GetIntersectingEdge(size_t index) {
+  return &intersecting_edges_[index];
 }
 
 void EnhancedTripLeg_Node::CalculateRightLeftIntersectingEdgeCounts(
@@ -1774,7 +1774,7 @@ void ManeuversBuilder::SetManeuverType(Maneuver& maneuver, bool none_type_allowe
     }
   }
   // Process merge
-  else if (IsMergeManeuverType(maneuver, prev_edge.get(), curr_edge.get())) {
+  else if (IsMergeManeuverType(maneuver, prev_edge, curr_edge)) {
     switch (maneuver.merge_to_relative_direction()) {
       case Maneuver::RelativeDirection::kKeepRight: {
         maneuver.set_type(DirectionsLeg_Maneuver_Type_kMergeRight);
@@ -1830,7 +1830,7 @@ void ManeuversBuilder::SetManeuverType(Maneuver& maneuver, bool none_type_allowe
   // Process simple direction
   else {
     LOG_TRACE("ManeuverType=SIMPLE");
-    SetSimpleDirectionalManeuverType(maneuver, prev_edge.get(), curr_edge.get());
+    SetSimpleDirectionalManeuverType(maneuver, prev_edge, curr_edge);
   }
 }
 
@@ -2258,8 +2258,8 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Process fork
-  if (IsFork(node_index, prev_edge.get(), curr_edge.get()) ||
-      IsPedestrianFork(node_index, prev_edge.get(), curr_edge.get())) {
+  if (IsFork(node_index, prev_edge, curr_edge) ||
+      IsPedestrianFork(node_index, prev_edge, curr_edge)) {
     maneuver.set_fork(true);
     return false;
   }
@@ -2348,12 +2348,12 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Process pencil point u-turns
-  if (IsLeftPencilPointUturn(node_index, prev_edge.get(), curr_edge.get())) {
+  if (IsLeftPencilPointUturn(node_index, prev_edge, curr_edge)) {
     maneuver.set_type(DirectionsLeg_Maneuver_Type_kUturnLeft);
     LOG_TRACE("ManeuverType=PENCIL_POINT_UTURN_LEFT");
     return false;
   }
-  if (IsRightPencilPointUturn(node_index, prev_edge.get(), curr_edge.get())) {
+  if (IsRightPencilPointUturn(node_index, prev_edge, curr_edge)) {
     maneuver.set_type(DirectionsLeg_Maneuver_Type_kUturnRight);
     LOG_TRACE("ManeuverType=PENCIL_POINT_UTURN_RIGHT");
     return false;
@@ -2361,7 +2361,7 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Intersecting forward edge
-  if (IsIntersectingForwardEdge(node_index, prev_edge.get(), curr_edge.get())) {
+  if (IsIntersectingForwardEdge(node_index, prev_edge, curr_edge)) {
     maneuver.set_intersecting_forward_edge(true);
     LOG_TRACE("IntersectingForwardEdge");
     return false;
@@ -2376,7 +2376,7 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
 
   /////////////////////////////////////////////////////////////////////////////
   // Process 'T' intersection
-  if (IsTee(node_index, prev_edge.get(), curr_edge.get(), !common_base_names->empty())) {
+  if (IsTee(node_index, prev_edge, curr_edge, !common_base_names->empty())) {
     maneuver.set_tee(true);
     LOG_TRACE("T intersection");
     return false;
@@ -2404,7 +2404,7 @@ bool ManeuversBuilder::CanManeuverIncludePrevEdge(Maneuver& maneuver, int node_i
   /////////////////////////////////////////////////////////////////////////////
   // Process unnamed edge
   if (!maneuver.HasStreetNames() && prev_edge->IsUnnamed() &&
-      IncludeUnnamedPrevEdge(node_index, prev_edge.get(), curr_edge.get())) {
+      IncludeUnnamedPrevEdge(node_index, prev_edge, curr_edge)) {
     return true;
   }
 
@@ -2463,7 +2463,7 @@ bool ManeuversBuilder::IsMergeManeuverType(Maneuver& maneuver,
         curr_edge->IsOneway() && curr_edge->IsForward(maneuver.turn_degree()) &&
         node->HasIntersectingEdgeCurrNameConsistency()))) {
     maneuver.set_merge_to_relative_direction(
-        DetermineMergeToRelativeDirection(node.get(), prev_edge));
+        DetermineMergeToRelativeDirection(node, prev_edge));
     return true;
   }
 
@@ -2610,7 +2610,7 @@ bool ManeuversBuilder::IsFork(int node_index,
     auto has_lane_bifurcation =
         [](EnhancedTripLeg* trip_path, int node_index, const EnhancedTripLeg_Edge* prev_edge,
            const EnhancedTripLeg_Edge* curr_edge,
-           const std::unique_ptr<EnhancedTripLeg_IntersectingEdge>& xedge) -> bool {
+           const EnhancedTripLeg_IntersectingEdge* xedge) -> bool {
       uint32_t prev_lane_count = prev_edge->lane_count();
       uint32_t curr_lane_count = curr_edge->lane_count();
 
@@ -3397,7 +3397,7 @@ void ManeuversBuilder::EnhanceSignlessInterchnages(std::list<Maneuver>& maneuver
 }
 
 uint16_t
-ManeuversBuilder::GetExpectedTurnLaneDirection(std::unique_ptr<EnhancedTripLeg_Edge>& turn_lane_edge,
+ManeuversBuilder::GetExpectedTurnLaneDirection(EnhancedTripLeg_Edge* turn_lane_edge,
                                                const Maneuver& maneuver) const {
   if (turn_lane_edge) {
     switch (maneuver.type()) {
@@ -3819,7 +3819,7 @@ void ManeuversBuilder::UpdateManeuverPlacementForInternalIntersectionTurns(
               is_relative_straight(GetTurnDegree(prev_edge->end_heading(), edge->begin_heading()))) {
             // Add straight internal edge to previous maneuver
             MoveInternalEdgeToPreviousManeuver(*prev_maneuver, maneuver, new_node_index,
-                                               prev_edge.get(), edge.get());
+                                               prev_edge, edge);
           } else {
             // Exit form the edge loop
             break;
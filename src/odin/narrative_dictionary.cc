@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <stdexcept>
+
 #include <boost/property_tree/ptree.hpp>
 
 #include "midgard/logging.h"
@@ -33,6 +36,56 @@ std::unordered_map<K, V> as_unordered_map(boost::property_tree::ptree const& pt,
 namespace valhalla {
 namespace odin {
 
+PhraseTemplate::PhraseTemplate(const std::string& phrase) : text_(phrase) {
+  // Split the phrase into literal spans and the <UPPER_CASE> tags between them
+  size_t literal = 0;
+  for (size_t open = text_.find('<'); open != std::string::npos; open = text_.find('<', open + 1)) {
+    size_t close = open + 1;
+    while (close < text_.size() &&
+           ((text_[close] >= 'A' && text_[close] <= 'Z') || text_[close] == '_')) {
+      ++close;
+    }
+    if (close == open + 1 || close == text_.size() || text_[close] != '>') {
+      continue;
+    }
+    if (open > literal) {
+      tokens_.push_back(
+          {static_cast<uint32_t>(literal), static_cast<uint32_t>(open - literal), false});
+    }
+    tokens_.push_back({static_cast<uint32_t>(open), static_cast<uint32_t>(close + 1 - open), true});
+    literal = close + 1;
+    open = close;
+  }
+  if (literal < text_.size()) {
+    tokens_.push_back(
+        {static_cast<uint32_t>(literal), static_cast<uint32_t>(text_.size() - literal), false});
+  }
+}
+
+void PhraseTemplate::Render(std::string& output, std::initializer_list<TagValue> values) const {
+  output.clear();
+  for (const auto& token : tokens_) {
+    std::string_view span(text_.data() + token.offset, token.length);
+    if (token.tag) {
+      const auto value = std::find_if(values.begin(), values.end(),
+                                      [&span](const TagValue& v) { return v.first == span; });
+      if (value != values.end()) {
+        output.append(value->second.data(), value->second.size());
+        continue;
+      }
+    }
+    output.append(span.data(), span.size());
+  }
+}
+
+const PhraseTemplate& PhraseSet::phrase(uint32_t phrase_id) const {
+  if (phrase_id >= templates.size() || (templates[phrase_id].text().empty() &&
+                                        phrases.find(std::to_string(phrase_id)) == phrases.end())) {
+    throw std::out_of_range("Phrase " + std::to_string(phrase_id) + " does not exist");
+  }
+  return templates[phrase_id];
+}
+
 NarrativeDictionary::NarrativeDictionary(const std::string& language_tag,
                                          const boost::property_tree::ptree& narrative_pt) {
   this->language_tag = language_tag;
@@ -343,6 +396,20 @@ void NarrativeDictionary::Load(PhraseSet& phrase_handle,
                                const boost::property_tree::ptree& phrase_pt) {
 
   phrase_handle.phrases = as_unordered_map<std::string, std::string>(phrase_pt, kPhrasesKey);
+
+  // Parse the phrases into templates indexed by phrase id, the ids are small and numeric
+  phrase_handle.templates.clear();
+  for (const auto& phrase : phrase_handle.phrases) {
+    if (phrase.first.empty() ||
+        phrase.first.find_first_not_of("0123456789") != std::string::npos) {
+      continue;
+    }
+    size_t phrase_id = std::stoul(phrase.first);
+    if (phrase_id >= phrase_handle.templates.size()) {
+      phrase_handle.templates.resize(phrase_id + 1);
+    }
+    phrase_handle.templates[phrase_id] = PhraseTemplate(phrase.second);
+  }
 }
 
 void NarrativeDictionary::Load(StartSubset& start_handle,
@@ -531,14 +531,15 @@ std::string NarrativeBuilder::FormVerbalAlertApproachInstruction(float distance,
   instruction.reserve(kInstructionInitialCapacity);
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.approach_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.approach_verbal_alert_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(distance, dictionary_.approach_verbal_alert_subset.metric_lengths,
-                                dictionary_.approach_verbal_alert_subset.us_customary_lengths));
-  boost::replace_all(instruction, kCurrentVerbalCueTag, verbal_cue);
+  // Set length value
+  std::string length = FormLength(distance, dictionary_.approach_verbal_alert_subset.metric_lengths,
+                                  dictionary_.approach_verbal_alert_subset.us_customary_lengths);
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kLengthTag, length}, {kCurrentVerbalCueTag, verbal_cue}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -596,13 +597,13 @@ std::string NarrativeBuilder::FormStartInstruction(Maneuver& maneuver) {
     phrase_id += 16;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.start_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kCardinalDirectionTag, cardinal_direction},
+                              {kStreetNamesTag, street_names},
+                              {kBeginStreetNamesTag, begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -683,16 +684,17 @@ std::string NarrativeBuilder::FormVerbalStartInstruction(Maneuver& maneuver,
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.start_verbal_subset.phrase(phrase_id);
+
+  // Set length value
+  std::string length = FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
+                                  dictionary_.start_verbal_subset.us_customary_lengths);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kCardinalDirectionTag, cardinal_direction},
+                              {kStreetNamesTag, street_names},
+                              {kBeginStreetNamesTag, begin_street_names}, {kLengthTag, length}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -736,14 +738,12 @@ std::string NarrativeBuilder::FormDestinationInstruction(Maneuver& maneuver) {
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.destination_subset.phrase(phrase_id);
 
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kDestinationTag, destination}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -792,14 +792,12 @@ std::string NarrativeBuilder::FormVerbalAlertDestinationInstruction(Maneuver& ma
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.destination_verbal_alert_subset.phrase(phrase_id);
 
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kDestinationTag, destination}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -848,14 +846,12 @@ std::string NarrativeBuilder::FormVerbalDestinationInstruction(Maneuver& maneuve
     relative_direction = dictionary_.destination_subset.relative_directions.at(1);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.destination_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.destination_verbal_subset.phrase(phrase_id);
 
-  if (phrase_id > 0) {
-    // Replace phrase tags with values
-    boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-    boost::replace_all(instruction, kDestinationTag, destination);
-  }
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kDestinationTag, destination}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -878,12 +874,12 @@ std::string NarrativeBuilder::FormBecomesInstruction(Maneuver& maneuver, Maneuve
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.becomes_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kPreviousStreetNamesTag, prev_street_names},
+                              {kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -913,12 +909,12 @@ std::string NarrativeBuilder::FormVerbalBecomesInstruction(Maneuver& maneuver,
   // Determine which phrase to use
   uint8_t phrase_id = 0;
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.becomes_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.becomes_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kPreviousStreetNamesTag, prev_street_names);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kPreviousStreetNamesTag, prev_street_names},
+                              {kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -964,13 +960,12 @@ std::string NarrativeBuilder::FormContinueInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.continue_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kStreetNamesTag, street_names}, {kJunctionNameTag, junction_name},
+                              {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1020,13 +1015,12 @@ std::string NarrativeBuilder::FormVerbalAlertContinueInstruction(Maneuver& maneu
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_alert_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.continue_verbal_alert_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kStreetNamesTag, street_names}, {kJunctionNameTag, junction_name},
+                              {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1085,16 +1079,16 @@ std::string NarrativeBuilder::FormVerbalContinueInstruction(Maneuver& maneuver,
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.continue_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.continue_verbal_subset.phrase(phrase_id);
+
+  // Set length value
+  std::string length = FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
+                                  dictionary_.continue_verbal_subset.us_customary_lengths);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.continue_verbal_subset.metric_lengths,
-                                dictionary_.continue_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kLengthTag, length}, {kStreetNamesTag, street_names},
+                              {kJunctionNameTag, junction_name}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1170,16 +1164,18 @@ std::string NarrativeBuilder::FormTurnInstruction(Maneuver& maneuver,
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = subset->phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), subset->relative_directions);
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kStreetNamesTag, street_names},
+                              {kBeginStreetNamesTag, begin_street_names},
+                              {kJunctionNameTag, junction_name}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1278,16 +1274,18 @@ std::string NarrativeBuilder::FormVerbalTurnInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = subset->phrase(phrase_id);
+
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), subset->relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kStreetNamesTag, street_names},
+                              {kBeginStreetNamesTag, begin_street_names},
+                              {kJunctionNameTag, junction_name}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1348,17 +1346,18 @@ std::string NarrativeBuilder::FormUturnInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.uturn_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_subset.relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), dictionary_.uturn_subset.relative_directions);
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kStreetNamesTag, street_names},
+                              {kCrossStreetNamesTag, cross_street_names},
+                              {kJunctionNameTag, junction_name}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1503,15 +1502,14 @@ std::string NarrativeBuilder::FormVerbalUturnInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.uturn_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kCrossStreetNamesTag, cross_street_names);
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_dir},
+                              {kStreetNamesTag, street_names},
+                              {kCrossStreetNamesTag, cross_street_names},
+                              {kJunctionNameTag, junction_name}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1557,13 +1555,12 @@ std::string NarrativeBuilder::FormRampStraightInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.ramp_straight_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kBranchSignTag, exit_branch_sign},
+                              {kTowardSignTag, exit_toward_sign}, {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1662,13 +1659,12 @@ std::string NarrativeBuilder::FormVerbalRampStraightInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_straight_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.ramp_straight_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kBranchSignTag, exit_branch_sign},
+                              {kTowardSignTag, exit_toward_sign}, {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1736,16 +1732,17 @@ std::string NarrativeBuilder::FormRampInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.ramp_subset.phrase(phrase_id);
+
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), dictionary_.ramp_subset.relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.ramp_subset.relative_directions));
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kBranchSignTag, exit_branch_sign},
+                              {kTowardSignTag, exit_toward_sign}, {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1896,14 +1893,13 @@ std::string NarrativeBuilder::FormVerbalRampInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.ramp_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.ramp_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_dir},
+                              {kBranchSignTag, exit_branch_sign},
+                              {kTowardSignTag, exit_toward_sign}, {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -1981,17 +1977,18 @@ std::string NarrativeBuilder::FormExitInstruction(Maneuver& maneuver,
         maneuver.signs().GetExitNameString(element_max_count, limit_by_consecutive_count);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.exit_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.exit_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), dictionary_.exit_subset.relative_directions);
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kNumberSignTag, exit_number_sign},
+                              {kBranchSignTag, exit_branch_sign},
+                              {kTowardSignTag, exit_toward_sign}, {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2152,15 +2149,14 @@ std::string NarrativeBuilder::FormVerbalExitInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.exit_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kBranchSignTag, exit_branch_sign);
-  boost::replace_all(instruction, kTowardSignTag, exit_toward_sign);
-  boost::replace_all(instruction, kNameSignTag, exit_name_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_dir},
+                              {kNumberSignTag, exit_number_sign},
+                              {kBranchSignTag, exit_branch_sign},
+                              {kTowardSignTag, exit_toward_sign}, {kNameSignTag, exit_name_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2241,16 +2237,17 @@ std::string NarrativeBuilder::FormKeepInstruction(Maneuver& maneuver,
     phrase_id += 4;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.keep_subset.phrase(phrase_id);
+
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_subset.relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(),
-                                                dictionary_.keep_subset.relative_directions));
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kNumberSignTag, exit_number_sign}, {kStreetNamesTag, street_names},
+                              {kTowardSignTag, toward_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2432,14 +2429,13 @@ std::string NarrativeBuilder::FormVerbalKeepInstruction(uint8_t phrase_id,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.keep_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_dir},
+                              {kNumberSignTag, exit_number_sign}, {kStreetNamesTag, street_names},
+                              {kTowardSignTag, toward_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2491,16 +2487,18 @@ std::string NarrativeBuilder::FormKeepToStayOnInstruction(Maneuver& maneuver,
     phrase_id += 2;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.keep_to_stay_on_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeThreeDirection(maneuver.type(), dictionary_.keep_to_stay_on_subset
-                                                                     .relative_directions));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeThreeDirection(maneuver.type(),
+                                 dictionary_.keep_to_stay_on_subset.relative_directions);
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kStreetNamesTag, street_names}, {kNumberSignTag, exit_number_sign},
+                              {kTowardSignTag, toward_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2590,14 +2588,13 @@ std::string NarrativeBuilder::FormVerbalKeepToStayOnInstruction(uint8_t phrase_i
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.keep_to_stay_on_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.keep_to_stay_on_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_dir);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kNumberSignTag, exit_number_sign);
-  boost::replace_all(instruction, kTowardSignTag, toward_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_dir},
+                              {kStreetNamesTag, street_names}, {kNumberSignTag, exit_number_sign},
+                              {kTowardSignTag, toward_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2648,13 +2645,12 @@ std::string NarrativeBuilder::FormMergeInstruction(Maneuver& maneuver,
         FormRelativeTwoDirection(maneuver.type(), dictionary_.merge_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.merge_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kStreetNamesTag, street_names}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2723,13 +2719,12 @@ std::string NarrativeBuilder::FormVerbalMergeInstruction(Maneuver& maneuver,
                                  dictionary_.merge_verbal_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.merge_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kStreetNamesTag, street_names}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2846,16 +2841,15 @@ std::string NarrativeBuilder::FormEnterRoundaboutInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.enter_roundabout_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
-  boost::replace_all(instruction, kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
-  boost::replace_all(instruction, kRoundaboutExitBeginStreetNamesTag,
-                     roundabout_exit_begin_street_names);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction,
+                {{kOrdinalValueTag, ordinal_value}, {kStreetNamesTag, street_names},
+                 {kTowardSignTag, guide_sign},
+                 {kRoundaboutExitStreetNamesTag, roundabout_exit_street_names},
+                 {kRoundaboutExitBeginStreetNamesTag, roundabout_exit_begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -2998,16 +2992,15 @@ std::string NarrativeBuilder::FormVerbalEnterRoundaboutInstruction(Maneuver& man
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.enter_roundabout_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
-  boost::replace_all(instruction, kRoundaboutExitStreetNamesTag, roundabout_exit_street_names);
-  boost::replace_all(instruction, kRoundaboutExitBeginStreetNamesTag,
-                     roundabout_exit_begin_street_names);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction,
+                {{kOrdinalValueTag, ordinal_value}, {kStreetNamesTag, street_names},
+                 {kTowardSignTag, guide_sign},
+                 {kRoundaboutExitStreetNamesTag, roundabout_exit_street_names},
+                 {kRoundaboutExitBeginStreetNamesTag, roundabout_exit_begin_street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3061,13 +3054,13 @@ std::string NarrativeBuilder::FormExitRoundaboutInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.exit_roundabout_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kStreetNamesTag, street_names},
+                              {kBeginStreetNamesTag, begin_street_names},
+                              {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3125,13 +3118,13 @@ std::string NarrativeBuilder::FormVerbalExitRoundaboutInstruction(Maneuver& mane
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.exit_roundabout_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kBeginStreetNamesTag, begin_street_names);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kStreetNamesTag, street_names},
+                              {kBeginStreetNamesTag, begin_street_names},
+                              {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3175,13 +3168,12 @@ std::string NarrativeBuilder::FormEnterFerryInstruction(Maneuver& maneuver,
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.enter_ferry_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kStreetNamesTag, street_names}, {kFerryLabelTag, ferry_label},
+                              {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3242,13 +3234,12 @@ std::string NarrativeBuilder::FormVerbalEnterFerryInstruction(Maneuver& maneuver
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_ferry_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.enter_ferry_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
-  boost::replace_all(instruction, kFerryLabelTag, ferry_label);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kStreetNamesTag, street_names}, {kFerryLabelTag, ferry_label},
+                              {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3281,12 +3272,12 @@ std::string NarrativeBuilder::FormTransitConnectionStartInstruction(Maneuver& ma
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_start_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_connection_start_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop},
+                              {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3319,13 +3310,12 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionStartInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_start_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_connection_start_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop},
+                              {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3358,12 +3348,12 @@ std::string NarrativeBuilder::FormTransitConnectionTransferInstruction(Maneuver&
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_connection_transfer_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_connection_transfer_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop},
+                              {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3396,13 +3386,12 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionTransferInstruction(Man
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_connection_transfer_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop},
+                              {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3435,13 +3424,12 @@ std::string NarrativeBuilder::FormTransitConnectionDestinationInstruction(Maneuv
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_destination_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_connection_destination_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop},
+                              {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3474,13 +3462,12 @@ std::string NarrativeBuilder::FormVerbalTransitConnectionDestinationInstruction(
     }
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.transit_connection_destination_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_connection_destination_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop);
-  boost::replace_all(instruction, kStationLabelTag, station_label);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop},
+                              {kStationLabelTag, station_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3503,13 +3490,15 @@ std::string NarrativeBuilder::FormDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.depart_subset.phrase(phrase_id);
+
+  // Set time value
+  std::string time =
+      get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale());
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop_name}, {kTimeTag, time}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3532,13 +3521,15 @@ std::string NarrativeBuilder::FormVerbalDepartInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.depart_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.depart_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale()));
+  // Set time value
+  std::string time =
+      get_localized_time(maneuver.GetTransitDepartureTime(), dictionary_.GetLocale());
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop_name}, {kTimeTag, time}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3561,13 +3552,14 @@ std::string NarrativeBuilder::FormArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.arrive_subset.phrase(phrase_id);
+
+  // Set time value
+  std::string time = get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale());
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop_name}, {kTimeTag, time}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3590,13 +3582,14 @@ std::string NarrativeBuilder::FormVerbalArriveInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.arrive_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.arrive_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformTag, transit_stop_name);
-  boost::replace_all(instruction, kTimeTag,
-                     get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale()));
+  // Set time value
+  std::string time = get_localized_time(maneuver.GetTransitArrivalTime(), dictionary_.GetLocale());
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitPlatformTag, transit_stop_name}, {kTimeTag, time}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3623,16 +3616,19 @@ std::string NarrativeBuilder::FormTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_subset.phrase(phrase_id);
+
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set instruction to the phrase with its tags replaced by values
+  // TODO: locale specific numerals for the stop count
+  phrase.Render(instruction, {{kTransitNameTag, transit_name},
+                              {kTransitHeadSignTag, transit_headsign},
+                              {kTransitPlatformCountTag, std::to_string(stop_count)},
+                              {kTransitPlatformCountLabelTag, stop_count_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3655,14 +3651,16 @@ std::string NarrativeBuilder::FormVerbalTransitInstruction(Maneuver& maneuver) {
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_verbal_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver, dictionary_.transit_verbal_subset.empty_transit_name_labels);
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitNameTag, transit_name},
+                              {kTransitHeadSignTag, transit_headsign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3690,17 +3688,19 @@ std::string NarrativeBuilder::FormTransitRemainOnInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_remain_on_subset.phrase(phrase_id);
+
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver, dictionary_.transit_remain_on_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_remain_on_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set instruction to the phrase with its tags replaced by values
+  // TODO: locale specific numerals for the stop count
+  phrase.Render(instruction, {{kTransitNameTag, transit_name},
+                              {kTransitHeadSignTag, transit_headsign},
+                              {kTransitPlatformCountTag, std::to_string(stop_count)},
+                              {kTransitPlatformCountLabelTag, stop_count_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3723,14 +3723,17 @@ std::string NarrativeBuilder::FormVerbalTransitRemainOnInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_remain_on_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_remain_on_verbal_subset.phrase(phrase_id);
+
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver,
+                      dictionary_.transit_remain_on_verbal_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_remain_on_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitNameTag, transit_name},
+                              {kTransitHeadSignTag, transit_headsign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3758,17 +3761,19 @@ std::string NarrativeBuilder::FormTransitTransferInstruction(Maneuver& maneuver)
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_transfer_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver,
-                                     dictionary_.transit_transfer_subset.empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver, dictionary_.transit_transfer_subset.empty_transit_name_labels);
+
+  // Set instruction to the phrase with its tags replaced by values
+  // TODO: locale specific numerals for the stop count
+  phrase.Render(instruction, {{kTransitNameTag, transit_name},
+                              {kTransitHeadSignTag, transit_headsign},
+                              {kTransitPlatformCountTag, std::to_string(stop_count)},
+                              {kTransitPlatformCountLabelTag, stop_count_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3791,14 +3796,17 @@ std::string NarrativeBuilder::FormVerbalTransitTransferInstruction(Maneuver& man
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.transit_transfer_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.transit_transfer_verbal_subset.phrase(phrase_id);
+
+  // Set transit_name value
+  std::string transit_name =
+      FormTransitName(maneuver,
+                      dictionary_.transit_transfer_verbal_subset.empty_transit_name_labels);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitNameTag,
-                     FormTransitName(maneuver, dictionary_.transit_transfer_verbal_subset
-                                                   .empty_transit_name_labels));
-  boost::replace_all(instruction, kTransitHeadSignTag, transit_headsign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTransitNameTag, transit_name},
+                              {kTransitHeadSignTag, transit_headsign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3839,14 +3847,16 @@ std::string NarrativeBuilder::FormVerbalPostTransitionInstruction(Maneuver& mane
     phrase_id = 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.post_transition_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.post_transition_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set length value
+  std::string length = FormLength(maneuver,
+                                  dictionary_.post_transition_verbal_subset.metric_lengths,
+                                  dictionary_.post_transition_verbal_subset.us_customary_lengths);
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kLengthTag, length}, {kStreetNamesTag, street_names}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3867,14 +3877,13 @@ std::string NarrativeBuilder::FormVerbalPostTransitionTransitInstruction(Maneuve
       FormTransitPlatformCountLabel(stop_count, dictionary_.post_transition_transit_verbal_subset
                                                     .transit_stop_count_labels);
 
-  // Set instruction to the determined tagged phrase
-  instruction =
-      dictionary_.post_transition_transit_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.post_transition_transit_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kTransitPlatformCountTag,
-                     std::to_string(stop_count)); // TODO: locale specific numerals
-  boost::replace_all(instruction, kTransitPlatformCountLabelTag, stop_count_label);
+  // Set instruction to the phrase with its tags replaced by values
+  // TODO: locale specific numerals for the stop count
+  phrase.Render(instruction, {{kTransitPlatformCountTag, std::to_string(stop_count)},
+                              {kTransitPlatformCountLabelTag, stop_count_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3918,14 +3927,15 @@ std::string NarrativeBuilder::FormVerbalSuccinctStartTransitionInstruction(Maneu
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.start_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.start_verbal_subset.phrase(phrase_id);
+
+  // Set length value
+  std::string length = FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
+                                  dictionary_.start_verbal_subset.us_customary_lengths);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCardinalDirectionTag, cardinal_direction);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.start_verbal_subset.metric_lengths,
-                                dictionary_.start_verbal_subset.us_customary_lengths));
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kCardinalDirectionTag, cardinal_direction}, {kLengthTag, length}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -3984,14 +3994,16 @@ NarrativeBuilder::FormVerbalSuccinctTurnTransitionInstruction(Maneuver& maneuver
                                                maneuver.verbal_formatter(), &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = subset->phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = subset->phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(), subset->relative_directions));
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(), subset->relative_directions);
+
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kJunctionNameTag, junction_name}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4030,15 +4042,17 @@ NarrativeBuilder::FormVerbalSuccinctUturnTransitionInstruction(Maneuver& maneuve
         maneuver.signs().GetJunctionNameString(element_max_count, limit_by_consecutive_count, delim,
                                                maneuver.verbal_formatter(), &markup_formatter_);
   }
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.uturn_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.uturn_verbal_subset.phrase(phrase_id);
+
+  // Set relative_direction value
+  std::string relative_direction =
+      FormRelativeTwoDirection(maneuver.type(),
+                               dictionary_.uturn_verbal_subset.relative_directions);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag,
-                     FormRelativeTwoDirection(maneuver.type(),
-                                              dictionary_.uturn_verbal_subset.relative_directions));
-  boost::replace_all(instruction, kJunctionNameTag, junction_name);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kJunctionNameTag, junction_name}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4082,12 +4096,12 @@ NarrativeBuilder::FormVerbalSuccinctMergeTransitionInstruction(Maneuver& maneuve
                                  dictionary_.merge_verbal_subset.relative_directions);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.merge_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.merge_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kRelativeDirectionTag, relative_direction);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kRelativeDirectionTag, relative_direction},
+                              {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4130,12 +4144,11 @@ std::string NarrativeBuilder::FormVerbalSuccinctEnterRoundaboutTransitionInstruc
                                                         &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.enter_roundabout_verbal_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kOrdinalValueTag, ordinal_value);
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kOrdinalValueTag, ordinal_value}, {kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4166,10 +4179,11 @@ std::string NarrativeBuilder::FormVerbalSuccinctExitRoundaboutTransitionInstruct
                                                  maneuver.verbal_formatter(), &markup_formatter_);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_roundabout_verbal_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.exit_roundabout_verbal_subset.phrase(phrase_id);
 
-  boost::replace_all(instruction, kTowardSignTag, guide_sign);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kTowardSignTag, guide_sign}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4195,11 +4209,11 @@ std::string NarrativeBuilder::FormElevatorInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.elevator_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.elevator_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kLevelTag, end_level}});
 
   return instruction;
 }
@@ -4220,11 +4234,11 @@ std::string NarrativeBuilder::FormStepsInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.steps_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.steps_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kLevelTag, end_level}});
 
   return instruction;
 }
@@ -4245,11 +4259,11 @@ std::string NarrativeBuilder::FormEscalatorInstruction(Maneuver& maneuver) {
     end_level = maneuver.end_level_ref();
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.escalator_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.escalator_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kLevelTag, end_level);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kLevelTag, end_level}});
 
   return instruction;
 }
@@ -4272,11 +4286,11 @@ std::string NarrativeBuilder::FormEnterBuildingInstruction(Maneuver& maneuver) {
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.enter_building_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.enter_building_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kStreetNamesTag, street_names}});
 
   return instruction;
 }
@@ -4299,11 +4313,11 @@ std::string NarrativeBuilder::FormExitBuildingInstruction(Maneuver& maneuver) {
     phrase_id += 1;
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.exit_building_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.exit_building_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kStreetNamesTag, street_names);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kStreetNamesTag, street_names}});
 
   return instruction;
 }
@@ -4352,11 +4366,11 @@ std::string NarrativeBuilder::FormPassInstruction(Maneuver& maneuver) {
       object_label = dictionary_.pass_subset.object_labels.at(dictionary_object_index);
   }
 
-  // Set instruction to the determined tagged phrase
-  instruction = dictionary_.pass_subset.phrases.at(std::to_string(phrase_id));
+  // Get the determined tagged phrase
+  const auto& phrase = dictionary_.pass_subset.phrase(phrase_id);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kObjectLabelTag, object_label);
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kObjectLabelTag, object_label}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
@@ -4779,19 +4793,21 @@ std::string NarrativeBuilder::FormVerbalMultiCue(Maneuver& maneuver,
   std::string instruction;
   instruction.reserve(kInstructionInitialCapacity);
 
-  // Set instruction to the proper verbal multi-cue
+  // Determine the proper verbal multi-cue phrase
   uint8_t phrase_id = 0;
   if (maneuver.distant_verbal_multi_cue()) {
     phrase_id = 1;
   }
-  instruction = dictionary_.verbal_multi_cue_subset.phrases.at(std::to_string(phrase_id));
+  const auto& phrase = dictionary_.verbal_multi_cue_subset.phrase(phrase_id);
+
+  // Set length value
+  std::string length = FormLength(maneuver,
+                                  dictionary_.post_transition_verbal_subset.metric_lengths,
+                                  dictionary_.post_transition_verbal_subset.us_customary_lengths);
 
-  // Replace phrase tags with values
-  boost::replace_all(instruction, kCurrentVerbalCueTag, first_verbal_cue);
-  boost::replace_all(instruction, kNextVerbalCueTag, second_verbal_cue);
-  boost::replace_all(instruction, kLengthTag,
-                     FormLength(maneuver, dictionary_.post_transition_verbal_subset.metric_lengths,
-                                dictionary_.post_transition_verbal_subset.us_customary_lengths));
+  // Set instruction to the phrase with its tags replaced by values
+  phrase.Render(instruction, {{kCurrentVerbalCueTag, first_verbal_cue},
+                              {kNextVerbalCueTag, second_verbal_cue}, {kLengthTag, length}});
 
   // If enabled, form articulated prepositions
   if (articulated_preposition_enabled_) {
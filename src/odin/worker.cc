@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <thread>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -23,7 +25,13 @@ namespace valhalla {
 namespace odin {
 
 odin_worker_t::odin_worker_t(const boost::property_tree::ptree& config)
-    : service_worker_t(config), markup_formatter_(config) {
+    : service_worker_t(config), markup_formatter_(config),
+      concurrency_(config.get<size_t>("odin.concurrency", 1)) {
+  // 0 means one per hardware thread
+  if (concurrency_ == 0) {
+    concurrency_ = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
   // signal that the worker started successfully
   started();
 }
@@ -37,7 +45,7 @@ std::string odin_worker_t::narrate(Api& request) const {
 
   // get some annotated directions
   try {
-    odin::DirectionsBuilder().Build(request, markup_formatter_);
+    odin::DirectionsBuilder().Build(request, markup_formatter_, concurrency_);
   } catch (...) { throw valhalla_exception_t{202}; }
 
   // serialize those to the proper format
@@ -62,14 +70,14 @@ odin_worker_t::work(const std::list<zmq::message_t>& job,
                     const std::function<void()>& interrupt_function) {
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Odin Request " + std::to_string(info.id));
-  Api request;
+  Api& request = make_request();
   prime_server::worker_t::result_t result{false, {}, {}};
   try {
     // Set the interrupt function
     service_worker_t::set_interrupt(&interrupt_function);
 
     // crack open the in progress request
-    bool success = request.ParseFromArray(job.front().data(), job.front().size());
+    bool success = receive_request(job.front(), request);
     if (!success) {
       LOG_ERROR("Failed parsing pbf in Odin::Worker");
       throw valhalla_exception_t{200, "Failed parsing pbf in Odin::Worker"};
@@ -279,8 +279,10 @@ public:
 struct cache_t {
   // Cached tiles
   std::vector<cache_item_t> cache;
-  // Set of reusable tile indexes
-  std::unordered_set<uint16_t> reusable;
+  // Indexes of the unpacked tiles and when they were last used, the least recently used one which
+  // is no longer being sampled gives up its memory once there are too many of them
+  std::unordered_map<uint16_t, uint64_t> reusable;
+  uint64_t uses = 0;
   // Map of pending tiles. No matter how many requests received, only one inflate job per tile
   // started.
   std::unordered_map<uint16_t, std::shared_future<tile_data>> pending_tiles;
@@ -320,11 +322,12 @@ bool cache_t::insert(size_t pos, const std::string& path, format_t format) {
 
 tile_data cache_t::source(uint16_t index) {
   // bail if it's out of bounds
-  if (index >= TILE_COUNT) {
+  if (index >= TILE_COUNT || index >= cache.size()) {
     return {};
   }
 
   // if we don't have anything maybe it's lazy loaded
+  std::unique_lock<std::recursive_mutex> lock(mutex);
   auto& item = cache[index];
   if (item.get_data() == nullptr) {
     auto f = data_source + get_hgt_file_name(index);
@@ -342,49 +345,51 @@ tile_data cache_t::source(uint16_t index) {
   }
 
   // we were able to load it but the format wasn't RAW, which only leaves compressed formats
-  mutex.lock();
   auto it = pending_tiles.find(index);
   if (it != pending_tiles.end()) {
     auto future = it->second;
-    mutex.unlock();
+    lock.unlock();
     return future.get();
   }
 
   // item in cache is already unpacked
   const char* unpacked = item.get_unpacked();
   if (unpacked) {
-    auto rv = tile_data(this, index, true, (const int16_t*)unpacked);
-    mutex.unlock();
-    return rv;
+    reusable[index] = ++uses;
+    return tile_data(this, index, true, (const int16_t*)unpacked);
   }
 
   std::promise<tile_data> promise;
   it = pending_tiles.emplace(index, promise.get_future()).first;
 
   if (reusable.size() >= UNPACKED_TILES_COUNT) {
-    for (auto i : reusable) {
-      if (cache[i].get_usages() <= 0) {
-        reusable.erase(i);
-        unpacked = cache[i].detach_unpacked();
-        break;
+    auto oldest = reusable.end();
+    for (auto i = reusable.begin(); i != reusable.end(); ++i) {
+      if (cache[i->first].get_usages() <= 0 &&
+          (oldest == reusable.end() || i->second < oldest->second)) {
+        oldest = i;
       }
     }
+    if (oldest != reusable.end()) {
+      unpacked = cache[oldest->first].detach_unpacked();
+      reusable.erase(oldest);
+    }
   }
   if (!unpacked) {
     unpacked = (char*)malloc(HGT_BYTES);
   }
-  reusable.insert(index);
+  reusable[index] = ++uses;
   auto rv = tile_data(this, index, true, (const int16_t*)unpacked);
-  mutex.unlock();
+  lock.unlock();
 
+  // unpack without holding the lock so that other tiles can be sampled or unpacked meanwhile
   if (!item.unpack(unpacked)) {
     rv = tile_data();
   }
 
-  mutex.lock();
+  lock.lock();
   promise.set_value(rv);
   pending_tiles.erase(it);
-  mutex.unlock();
   return rv;
 }
 
@@ -444,10 +449,8 @@ template <class coord_t> double sample::get(const coord_t& coord, tile_data& til
 
   // the caller can pass a cached tile, so we only fetch one if its not the one they already have
   if (index != tile.get_index()) {
-    {
-      std::lock_guard<std::mutex> _(cache_lck);
-      tile = cache_->source(index);
-    }
+    // the cache does its own locking so that tiles can be unpacked concurrently
+    tile = cache_->source(index);
     if (!tile) {
       if (!fetch(index))
         return get_no_data_value();
@@ -484,6 +487,18 @@ template <class coords_t> std::vector<double> sample::get_all(const coords_t& co
   return values;
 }
 
+bool sample::prefetch(uint16_t index) {
+  tile_data tile = cache_->source(index);
+  if (!tile && fetch(index)) {
+    tile = cache_->source(index);
+  }
+  return static_cast<bool>(tile);
+}
+
+size_t sample::unpacked_cache_size() {
+  return UNPACKED_TILES_COUNT;
+}
+
 bool sample::store(const std::string& elev, const std::vector<char>& raw_data) {
   // data_source never changes so we do not lock it. it is set only in sample constructor
   auto fpath = cache_->data_source + elev;
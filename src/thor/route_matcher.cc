@@ -283,6 +283,131 @@ valhalla::baldr::TimeInfo init_time_info(valhalla::baldr::GraphReader& reader,
   return TimeInfo::invalid();
 }
 
+// Find the correlated candidate of a location that is on the given edge
+const valhalla::PathEdge* find_candidate(const valhalla::Location& location,
+                                         const uint64_t edge_id) {
+  for (const auto& edge : location.correlation().edges()) {
+    if (edge.graph_id() == edge_id) {
+      return &edge;
+    }
+  }
+  return nullptr;
+}
+
+// Whether the path can continue from the end node of one edge with an edge leaving this node,
+// either directly or through a transition to another level
+bool is_connected(GraphReader& reader, const GraphId& end_node, const GraphId& start_node) {
+  if (end_node == start_node) {
+    return true;
+  }
+  graph_tile_ptr tile = reader.GetGraphTile(end_node);
+  if (tile == nullptr) {
+    return false;
+  }
+  const NodeInfo* nodeinfo = tile->node(end_node);
+  const NodeTransition* trans = tile->transition(nodeinfo->transition_index());
+  for (uint32_t i = 0; i < nodeinfo->transition_count(); ++i, ++trans) {
+    if (trans->endnode() == start_node) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Form the path directly from the edge ids of a prior route. This is a lookup of each edge rather
+// than a walk of the shape, the shape is only used to check that the edges make sense for it.
+// Returns false if the edges aren't a connected path from the origin to the destination
+bool form_path_from_edge_ids(const mode_costing_t& mode_costing,
+                             const TravelMode& mode,
+                             GraphReader& reader,
+                             valhalla::Options& options,
+                             const float shape_length,
+                             const valhalla::baldr::TimeInfo& time_info,
+                             std::vector<PathInfo>& path_infos) {
+  const auto& edge_ids = options.edge_ids();
+  const auto& origin = *options.locations().begin();
+  const auto& destination = *options.locations().rbegin();
+
+  // The first and last edges have to be candidates of the origin and destination to know how much
+  // of them is part of the path. An origin at the end of the first edge makes no sense
+  const auto* begin_edge = find_candidate(origin, *edge_ids.begin());
+  const auto* end_edge = find_candidate(destination, *edge_ids.rbegin());
+  if (!begin_edge || !end_edge || begin_edge->end_node() ||
+      (edge_ids.size() == 1 && begin_edge->percent_along() > end_edge->percent_along())) {
+    return false;
+  }
+
+  auto& costing = mode_costing[static_cast<int>(mode)];
+  EdgeLabel prev_edge_label;
+  Cost elapsed;
+  float path_length = 0.0f;
+  GraphId prev_end_node;
+  graph_tile_ptr tile;
+  for (int i = 0; i < edge_ids.size(); ++i) {
+    GraphId edge_id(edge_ids.Get(i));
+    const DirectedEdge* de = reader.directededge(edge_id, tile);
+    if (de == nullptr || de->is_shortcut() || de->use() == Use::kTransitConnection) {
+      return false;
+    }
+
+    // The portion of the edge on the path
+    float begin_pct = i == 0 ? begin_edge->percent_along() : 0.0f;
+    float end_pct = i == edge_ids.size() - 1 ? end_edge->percent_along() : 1.0f;
+    path_length += de->length() * (end_pct - begin_pct);
+
+    // The first edge starts along the edge so there is no node to transition through
+    const NodeInfo* nodeinfo = nullptr;
+    Cost transition_cost;
+    if (i > 0) {
+      graph_tile_ptr start_tile = tile;
+      GraphId start_node = reader.edge_startnode(edge_id, start_tile);
+      if (!start_node.Is_Valid() || !is_connected(reader, prev_end_node, start_node) ||
+          !reader.GetGraphTile(start_node, start_tile)) {
+        return false;
+      }
+      nodeinfo = start_tile->node(start_node);
+      transition_cost = costing->TransitionCost(de, nodeinfo, prev_edge_label);
+    }
+
+    // Figure out what time it is right now, the first iteration is a no-op
+    auto offset_time_info =
+        nodeinfo ? time_info.forward(elapsed.secs, nodeinfo->timezone()) : time_info;
+
+    // Get the cost of traversing the node and the portion of the edge
+    uint8_t flow_sources;
+    elapsed += transition_cost +
+               costing->EdgeCost(de, tile, offset_time_info, flow_sources) * (end_pct - begin_pct);
+    path_infos.emplace_back(mode, elapsed, edge_id, 0, 0.f, -1, transition_cost);
+
+    InternalTurn turn = nodeinfo ? costing->TurnType(prev_edge_label.opp_local_idx(), nodeinfo, de)
+                                 : InternalTurn::kNoTurn;
+    prev_edge_label = {kInvalidLabel,
+                       edge_id,
+                       de,
+                       {},
+                       0,
+                       mode,
+                       0,
+                       baldr::kInvalidRestriction,
+                       true,
+                       static_cast<bool>(flow_sources & kDefaultFlowMask),
+                       turn};
+    prev_end_node = de->endnode();
+  }
+
+  // The edges should be as long as the shape they came with
+  if (path_length > length_comparison(shape_length, true) ||
+      shape_length > length_comparison(path_length, true)) {
+    return false;
+  }
+
+  // Store the matching edge candidates in the shapes locations
+  options.mutable_shape(0)->mutable_correlation()->mutable_edges()->Add()->CopyFrom(*begin_edge);
+  options.mutable_shape()->rbegin()->mutable_correlation()->mutable_edges()->Add()->CopyFrom(
+      *end_edge);
+  return true;
+}
+
 } // namespace
 
 namespace valhalla {
@@ -332,6 +457,17 @@ bool RouteMatcher::FormPath(const sif::mode_costing_t& mode_costing,
   valhalla::baldr::DateTime::tz_sys_info_cache_t tz_cache;
   auto time_info = init_time_info(reader, options, &tz_cache);
 
+  // If we were given the edges of the prior route we only need to look them up. Timestamps need
+  // the shape to be walked to know which edge each of them belongs to though
+  if (options.edge_ids_size() > 0 && !options.use_timestamps()) {
+    if (form_path_from_edge_ids(mode_costing, mode, reader, options, total_distance, time_info,
+                                path_infos)) {
+      return true;
+    }
+    LOG_DEBUG("Edge ids don't form a path along the shape, walking the shape instead");
+    path_infos.clear();
+  }
+
   // Perform the edge walk by starting with one of the candidate edges and walking from it
   // if that walk fails we fall back to another candidate edge until we exhaust the candidates
   for (const auto& edge : options.locations().begin()->correlation().edges()) {
@@ -45,17 +45,6 @@ const std::unordered_map<std::string, float> kMaxDistances = {
 // a scale factor to apply to the score so that we bias towards closer results more
 constexpr float kDistanceScale = 10.f;
 
-#ifdef ENABLE_SERVICES
-std::string serialize_to_pbf(Api& request) {
-  std::string buf;
-  if (!request.SerializeToString(&buf)) {
-    LOG_ERROR("Failed serializing to pbf in Thor::Worker");
-    throw valhalla_exception_t{401, "Failed serializing to pbf in Thor::Worker"};
-  }
-  return buf;
-};
-#endif
-
 } // namespace
 
 namespace valhalla {
@@ -119,11 +108,11 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
   // get request info and make sure to record any metrics before we are done
   auto& info = *static_cast<prime_server::http_request_info_t*>(request_info);
   LOG_INFO("Got Thor Request " + std::to_string(info.id));
-  Api request;
+  Api& request = make_request();
   prime_server::worker_t::result_t result{true, {}, {}};
   try {
     // crack open the original request
-    bool success = request.ParseFromArray(job.front().data(), job.front().size());
+    bool success = receive_request(job.front(), request);
     if (!success) {
       LOG_ERROR("Failed parsing pbf in Thor::Worker");
       throw valhalla_exception_t{401, "Failed parsing pbf in Thor::Worker"};
@@ -140,7 +129,7 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
         break;
       case Options::optimized_route: {
         optimized_route(request);
-        result.messages.emplace_back(serialize_to_pbf(request));
+        result.messages.emplace_back(forward_request(request));
         break;
       }
       case Options::isochrone:
@@ -148,12 +137,12 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
         break;
       case Options::route: {
         route(request);
-        result.messages.emplace_back(serialize_to_pbf(request));
+        result.messages.emplace_back(forward_request(request));
         break;
       }
       case Options::trace_route: {
         trace_route(request);
-        result.messages.emplace_back(serialize_to_pbf(request));
+        result.messages.emplace_back(forward_request(request));
         break;
       }
       case Options::trace_attributes:
@@ -165,12 +154,12 @@ thor_worker_t::work(const std::list<zmq::message_t>& job,
       }
       case Options::centroid: {
         centroid(request);
-        result.messages.emplace_back(serialize_to_pbf(request));
+        result.messages.emplace_back(forward_request(request));
         break;
       }
       case Options::status: {
         status(request);
-        result.messages.emplace_back(serialize_to_pbf(request));
+        result.messages.emplace_back(forward_request(request));
         break;
       }
       default:
@@ -5,22 +5,162 @@
 #include "thor/worker.h"
 #include "tyr/serializers.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 using namespace valhalla;
 using namespace valhalla::loki;
 using namespace valhalla::thor;
 using namespace valhalla::odin;
 
+namespace {
+
+// Make a single trace_attributes request out of the options shared by the whole batch overridden
+// by the ones of the trace itself
+void make_trace_request(const rapidjson::Document& batch,
+                        const rapidjson::Value& trace,
+                        rapidjson::Document& request) {
+  if (!trace.IsObject()) {
+    throw valhalla_exception_t{116};
+  }
+
+  request.SetObject();
+  auto& allocator = request.GetAllocator();
+  for (const auto& member : batch.GetObject()) {
+    if (member.name != "traces" && !trace.HasMember(member.name)) {
+      request.AddMember(rapidjson::Value(member.name, allocator),
+                        rapidjson::Value(member.value, allocator), allocator);
+    }
+  }
+  for (const auto& member : trace.GetObject()) {
+    request.AddMember(rapidjson::Value(member.name, allocator),
+                      rapidjson::Value(member.value, allocator), allocator);
+  }
+}
+
+// Does a single json request of any action
+std::string act_on(tyr::actor_t& actor,
+                   Options::Action action,
+                   const std::string& request_str,
+                   const std::function<void()>* interrupt,
+                   Api* api) {
+  switch (action) {
+    case Options::route:
+      return actor.route(request_str, interrupt, api);
+    case Options::locate:
+      return actor.locate(request_str, interrupt, api);
+    case Options::sources_to_targets:
+      return actor.matrix(request_str, interrupt, api);
+    case Options::optimized_route:
+      return actor.optimized_route(request_str, interrupt, api);
+    case Options::isochrone:
+      return actor.isochrone(request_str, interrupt, api);
+    case Options::trace_route:
+      return actor.trace_route(request_str, interrupt, api);
+    case Options::trace_attributes:
+      return actor.trace_attributes(request_str, interrupt, api);
+    case Options::height:
+      return actor.height(request_str, interrupt, api);
+    case Options::transit_available:
+      return actor.transit_available(request_str, interrupt, api);
+    case Options::expansion:
+      return actor.expansion(request_str, interrupt, api);
+    case Options::centroid:
+      return actor.centroid(request_str, interrupt, api);
+    case Options::status:
+      return actor.status(request_str, interrupt, api);
+    default:
+      throw valhalla_exception_t{106};
+  }
+}
+
+// A pool of threads that each have an actor of their own and take the requests submitted to the
+// pool in the order they were submitted. The graph readers of the actors share the tiles of the
+// reader of the actor the pool belongs to
+class request_pool_t {
+public:
+  using task_t = std::packaged_task<std::string(tyr::actor_t&)>;
+
+  request_pool_t(const boost::property_tree::ptree& config,
+                 baldr::GraphReader& actor_reader,
+                 size_t concurrency)
+      : done(false) {
+    // the actors are made up front so that a bad config throws here rather than in the threads
+    for (size_t i = 0; i < concurrency; ++i) {
+      readers.emplace_back(actor_reader.ShareTiles());
+      actors.emplace_back(new tyr::actor_t(config, *readers.back(), true));
+    }
+    for (auto& actor : actors) {
+      threads.emplace_back(&request_pool_t::work, this, std::ref(*actor));
+    }
+  }
+
+  // the requests still queued are done before the threads stop
+  ~request_pool_t() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      done = true;
+    }
+    ready.notify_all();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::future<std::string> submit(task_t task) {
+    auto future = task.get_future();
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      tasks.emplace_back(std::move(task));
+    }
+    ready.notify_one();
+    return future;
+  }
+
+protected:
+  void work(tyr::actor_t& actor) {
+    while (true) {
+      task_t task;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        ready.wait(guard, [this] { return done || !tasks.empty(); });
+        if (tasks.empty()) {
+          return;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task(actor);
+    }
+  }
+
+  std::vector<std::unique_ptr<baldr::GraphReader>> readers;
+  std::vector<std::unique_ptr<tyr::actor_t>> actors;
+  std::vector<std::thread> threads;
+  std::deque<task_t> tasks;
+  std::mutex lock;
+  std::condition_variable ready;
+  bool done;
+};
+
+} // namespace
+
 namespace valhalla {
 namespace tyr {
 
 struct actor_t::pimpl_t {
   pimpl_t(const boost::property_tree::ptree& config)
       : reader(new baldr::GraphReader(config.get_child("mjolnir"))), loki_worker(config, reader),
-        thor_worker(config, reader), odin_worker(config) {
+        thor_worker(config, reader), odin_worker(config), config(config) {
   }
   pimpl_t(const boost::property_tree::ptree& config, baldr::GraphReader& graph_reader)
       : reader(&graph_reader, [](baldr::GraphReader*) {}), loki_worker(config, reader),
-        thor_worker(config, reader), odin_worker(config) {
+        thor_worker(config, reader), odin_worker(config), config(config) {
   }
   void set_interrupts(const std::function<void()>* interrupt_function) {
     loki_worker.set_interrupt(interrupt_function);
@@ -32,10 +172,32 @@ struct actor_t::pimpl_t {
     thor_worker.cleanup();
     odin_worker.cleanup();
   }
+  // the pool is only made once it is needed and then kept for reuse
+  request_pool_t& get_request_pool() {
+    std::lock_guard<std::mutex> guard(request_pool_lock);
+    if (!request_pool) {
+      // 0 means one per hardware thread
+      auto concurrency = config.get<size_t>("thor.batch_concurrency", 0);
+      if (concurrency == 0) {
+        concurrency = std::max(std::thread::hardware_concurrency(), 1u);
+      }
+      request_pool.reset(new request_pool_t(config, *reader, concurrency));
+    }
+    return *request_pool;
+  }
+  // the request objects the callers don't want back are made on an arena, each one frees the last
+  Api& make_dummy() {
+    arena.Reset();
+    return *google::protobuf::Arena::CreateMessage<Api>(&arena);
+  }
   std::shared_ptr<baldr::GraphReader> reader;
   loki::loki_worker_t loki_worker;
   thor::thor_worker_t thor_worker;
   odin_worker_t odin_worker;
+  boost::property_tree::ptree config;
+  std::unique_ptr<request_pool_t> request_pool;
+  std::mutex request_pool_lock;
+  google::protobuf::Arena arena;
 };
 
 actor_t::actor_t(const boost::property_tree::ptree& config, bool auto_cleanup)
@@ -90,9 +252,8 @@ actor_t::route(const std::string& request_str, const std::function<void()>* inte
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::route, *api);
@@ -114,9 +275,8 @@ actor_t::locate(const std::string& request_str, const std::function<void()>* int
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::locate, *api);
@@ -134,9 +294,8 @@ actor_t::matrix(const std::string& request_str, const std::function<void()>* int
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::sources_to_targets, *api);
@@ -157,9 +316,8 @@ std::string actor_t::optimized_route(const std::string& request_str,
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::optimized_route, *api);
@@ -181,9 +339,8 @@ actor_t::isochrone(const std::string& request_str, const std::function<void()>*
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::isochrone, *api);
@@ -204,9 +361,8 @@ std::string actor_t::trace_route(const std::string& request_str,
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::trace_route, *api);
@@ -229,9 +385,8 @@ std::string actor_t::trace_attributes(const std::string& request_str,
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::trace_attributes, *api);
@@ -246,14 +401,178 @@ std::string actor_t::trace_attributes(const std::string& request_str,
   return json;
 }
 
+std::string actor_t::trace_attributes_batch(const std::string& request_str,
+                                            const std::function<void()>* interrupt,
+                                            const trace_result_callback_t& on_result) {
+  // parse the batch once, each trace only copies the bits it needs from it
+  rapidjson::Document batch;
+  batch.Parse(request_str.c_str());
+  if (batch.HasParseError() || !batch.IsObject()) {
+    throw valhalla_exception_t{100};
+  }
+  const auto traces = batch.FindMember("traces");
+  if (traces == batch.MemberEnd() || !traces->value.IsArray() || traces->value.Empty()) {
+    throw valhalla_exception_t{116};
+  }
+
+  // each trace is a task of the pool, they all finish before we return
+  std::vector<std::string> results(traces->value.Size());
+  std::atomic<bool> aborted{false};
+  std::exception_ptr abort_reason;
+  std::mutex lock;
+
+  // whatever the caller's interrupt throws is kept to be rethrown once all tasks have stopped,
+  // the workers only see our own exception so that they can tell it apart from any other problem
+  struct batch_interrupted_t {};
+  const std::function<void()> batch_interrupt = [&]() {
+    if (aborted) {
+      throw batch_interrupted_t{};
+    }
+    try {
+      (*interrupt)();
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(lock);
+      if (!abort_reason) {
+        abort_reason = std::current_exception();
+      }
+      aborted = true;
+      throw batch_interrupted_t{};
+    }
+  };
+
+  std::vector<std::future<std::string>> futures;
+  futures.reserve(results.size());
+  auto& pool = pimpl->get_request_pool();
+  for (size_t i = 0; i < results.size(); ++i) {
+    futures.emplace_back(pool.submit(request_pool_t::task_t([&, i](actor_t& actor) {
+      // the rest of the batch is skipped once it has been aborted
+      if (aborted) {
+        return std::string();
+      }
+      auto& worker = *actor.pimpl;
+      worker.set_interrupts(interrupt ? &batch_interrupt : nullptr);
+      Api api;
+      std::string result;
+      try {
+        rapidjson::Document request;
+        make_trace_request(batch, traces->value[i], request);
+        ParseApi(request, Options::trace_attributes, api);
+        worker.loki_worker.trace(api);
+        result = worker.thor_worker.trace_attributes(api);
+      } // a problem with this trace only ends up in its result
+      catch (const valhalla_exception_t& e) {
+        result = serialize_error(e, api);
+      } catch (const std::exception& e) {
+        result = serialize_error({499, std::string(e.what())}, api);
+      } // the interrupt stops the whole batch
+      catch (const batch_interrupted_t&) {
+      } catch (...) {
+        result = serialize_error({499, std::string("Unknown exception thrown")}, api);
+      }
+      worker.cleanup();
+
+      std::lock_guard<std::mutex> guard(lock);
+      if (on_result && !aborted) {
+        on_result(i, result);
+      }
+      return result;
+    })));
+  }
+  for (size_t i = 0; i < futures.size(); ++i) {
+    results[i] = futures[i].get();
+  }
+  if (abort_reason) {
+    std::rethrow_exception(abort_reason);
+  }
+
+  // the responses are json already so we just put them into an array
+  size_t size = results.size() + 1;
+  for (const auto& result : results) {
+    size += result.size();
+  }
+  std::string json;
+  json.reserve(size);
+  json.push_back('[');
+  for (const auto& result : results) {
+    if (json.size() > 1) {
+      json.push_back(',');
+    }
+    json += result;
+  }
+  json.push_back(']');
+  return json;
+}
+
+std::future<std::string> actor_t::submit(Options::Action action, const std::string& request_str) {
+  return pimpl->get_request_pool().submit(
+      request_pool_t::task_t([action, request_str](actor_t& actor) {
+        return act_on(actor, action, request_str, nullptr, nullptr);
+      }));
+}
+
+std::vector<std::string> actor_t::batch(Options::Action action,
+                                        const std::vector<std::string>& requests,
+                                        const std::function<void()>* interrupt,
+                                        const result_callback_t& on_result) {
+  // each request of the batch is a task of the pool, they all finish before we return
+  std::vector<std::string> results(requests.size());
+  std::atomic<bool> aborted{false};
+  std::mutex lock;
+  std::vector<std::future<std::string>> futures;
+  futures.reserve(requests.size());
+  auto& pool = pimpl->get_request_pool();
+  for (size_t i = 0; i < requests.size(); ++i) {
+    futures.emplace_back(pool.submit(request_pool_t::task_t([&, i](actor_t& actor) {
+      // the rest of the batch is skipped once it has been aborted
+      if (aborted) {
+        return std::string();
+      }
+      Api api;
+      std::string result;
+      try {
+        result = act_on(actor, action, requests[i], interrupt, &api);
+      } // a problem with this request only ends up in its result
+      catch (const valhalla_exception_t& e) {
+        result = serialize_error(e, api);
+      } catch (const std::exception& e) {
+        result = serialize_error({499, std::string(e.what())}, api);
+      } // anything else (i.e. the interrupt) stops the whole batch
+      catch (...) {
+        aborted = true;
+        throw;
+      }
+      std::lock_guard<std::mutex> guard(lock);
+      if (on_result && !aborted) {
+        on_result(i, result);
+      }
+      return result;
+    })));
+  }
+
+  // wait for all of them and rethrow the first reason the batch was aborted for
+  std::exception_ptr abort_reason;
+  for (size_t i = 0; i < futures.size(); ++i) {
+    try {
+      results[i] = futures[i].get();
+    } catch (...) {
+      if (!abort_reason) {
+        abort_reason = std::current_exception();
+      }
+    }
+  }
+  if (abort_reason) {
+    std::rethrow_exception(abort_reason);
+  }
+  return results;
+}
+
 std::string
 actor_t::height(const std::string& request_str, const std::function<void()>* interrupt, Api* api) {
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::height, *api);
@@ -272,9 +591,8 @@ std::string actor_t::transit_available(const std::string& request_str,
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::transit_available, *api);
@@ -292,9 +610,8 @@ actor_t::expansion(const std::string& request_str, const std::function<void()>*
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::expansion, *api);
@@ -320,9 +637,8 @@ actor_t::centroid(const std::string& request_str, const std::function<void()>* i
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::centroid, *api);
@@ -344,9 +660,8 @@ actor_t::status(const std::string& request_str, const std::function<void()>* int
   // set the interrupts
   pimpl->set_interrupts(interrupt);
   // if the caller doesn't want a copy we'll use this dummy
-  Api dummy;
   if (!api) {
-    api = &dummy;
+    api = &pimpl->make_dummy();
   }
   // parse the request
   ParseApi(request_str, Options::status, *api);
@@ -1,6 +1,6 @@
-#include <sstream>
+#include <cmath>
 
-#include "baldr/json.h"
+#include "baldr/rapidjson_utils.h"
 #include "skadi/sample.h"
 #include "tyr/serializers.h"
 
@@ -10,51 +10,65 @@ using namespace valhalla::baldr;
 
 namespace {
 
-json::ArrayPtr serialize_range_height(const std::vector<double>& ranges,
-                                      const std::vector<double>& heights,
-                                      const uint32_t precision,
-                                      const double no_data_value) {
-  auto array = json::array({});
+// heights are rounded to the requested precision, without any decimals they are written as integers
+void serialize_posting(const double height,
+                       const uint32_t precision,
+                       const double no_data_value,
+                       rapidjson::writer_wrapper_t& writer) {
+  if (height == no_data_value) {
+    writer(nullptr);
+  } else if (precision == 0) {
+    writer(static_cast<int64_t>(std::round(height)));
+  } else {
+    const double scale = std::pow(10.0, precision);
+    writer(std::round(height * scale) / scale);
+  }
+}
+
+void serialize_range_height(const std::vector<double>& ranges,
+                            const std::vector<double>& heights,
+                            const uint32_t precision,
+                            const double no_data_value,
+                            rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("range_height");
+  writer.set_rounded_precision(precision);
   // for each posting
   auto range = ranges.cbegin();
 
   for (const auto height : heights) {
-    auto element = json::array({json::fixed_t{*range, 0}});
-    if (height == no_data_value) {
-      element->push_back(nullptr);
-    } else {
-      element->push_back({json::fixed_t{height, precision}});
-    }
-    array->push_back(element);
+    writer.start_array();
+    writer(static_cast<int64_t>(std::round(*range)));
+    serialize_posting(height, precision, no_data_value, writer);
+    writer.end_array();
     ++range;
   }
-  return array;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_height(const std::vector<double>& heights,
-                                const uint32_t precision,
-                                const double no_data_value) {
-  auto array = json::array({});
-
+void serialize_height(const std::vector<double>& heights,
+                      const uint32_t precision,
+                      const double no_data_value,
+                      rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("height");
+  writer.set_rounded_precision(precision);
   for (const auto height : heights) {
     // add all heights's to an array
-    if (height == no_data_value) {
-      array->push_back(nullptr);
-    } else {
-      array->push_back({json::fixed_t{height, precision}});
-    }
+    serialize_posting(height, precision, no_data_value, writer);
   }
-
-  return array;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_shape(const google::protobuf::RepeatedPtrField<valhalla::Location>& shape) {
-  auto array = json::array({});
+void serialize_shape(const google::protobuf::RepeatedPtrField<valhalla::Location>& shape,
+                     rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("shape");
+  writer.set_rounded_precision(6);
   for (const auto& p : shape) {
-    array->emplace_back(json::map(
-        {{"lon", json::fixed_t{p.ll().lng(), 6}}, {"lat", json::fixed_t{p.ll().lat(), 6}}}));
+    writer.start_object();
+    writer("lon", p.ll().lng());
+    writer("lat", p.ll().lat());
+    writer.end_object();
   }
-  return array;
+  writer.end_array();
 }
 
 } // namespace
@@ -71,37 +85,37 @@ namespace tyr {
 std::string serializeHeight(const Api& request,
                             const std::vector<double>& heights,
                             const std::vector<double>& ranges) {
-  auto json = json::map({});
+  // a posting with its range takes about 16 bytes, the shape point it came from about 40
+  rapidjson::writer_wrapper_t writer(64 * heights.size());
+  writer.start_object();
 
   // get the precision to use for returned heights
   uint32_t precision = request.options().height_precision();
 
   // get the distances between the postings
   if (ranges.size()) {
-    json = json::map({{"range_height", serialize_range_height(ranges, heights, precision,
-                                                              skadi::get_no_data_value())}});
+    serialize_range_height(ranges, heights, precision, skadi::get_no_data_value(), writer);
   } // just the postings
   else {
-    json = json::map({{"height", serialize_height(heights, precision, skadi::get_no_data_value())}});
+    serialize_height(heights, precision, skadi::get_no_data_value(), writer);
   }
   // send back the shape as well
   if (request.options().has_encoded_polyline_case()) {
-    json->emplace("encoded_polyline", request.options().encoded_polyline());
+    writer("encoded_polyline", request.options().encoded_polyline());
   } else {
-    json->emplace("shape", serialize_shape(request.options().shape()));
+    serialize_shape(request.options().shape(), writer);
   }
   if (request.options().has_id_case()) {
-    json->emplace("id", request.options().id());
+    writer("id", request.options().id());
   }
 
   // add warnings to json response
   if (request.info().warnings_size() >= 1) {
-    json->emplace("warnings", serializeWarnings(request));
+    serializeWarnings(request, writer);
   }
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  writer.end_object();
+  return writer.get_buffer();
 }
 } // namespace tyr
 } // namespace valhalla
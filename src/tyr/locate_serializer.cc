@@ -1,5 +1,5 @@
-#include "baldr/json.h"
 #include "baldr/openlr.h"
+#include "baldr/rapidjson_utils.h"
 #include "tyr/serializers.h"
 #include <cstdint>
 
@@ -25,13 +25,16 @@ OpenLR::LocationReferencePoint::FormOfWay get_fow(const baldr::DirectedEdge* de)
   return OpenLR::LocationReferencePoint::OTHER;
 }
 
-json::ArrayPtr get_access_restrictions(const graph_tile_ptr& tile, uint32_t edge_idx) {
-  auto arr = json::array({});
+void get_access_restrictions(const graph_tile_ptr& tile,
+                             uint32_t edge_idx,
+                             rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("access_restrictions");
   for (const auto& res : tile->GetAccessRestrictions(edge_idx, kAllAccess)) {
-    arr->emplace_back(res.json());
+    writer.start_object();
+    res.json(writer);
+    writer.end_object();
   };
-
-  return arr;
+  writer.end_array();
 }
 
 std::string
@@ -61,8 +64,11 @@ linear_reference(const baldr::DirectedEdge* de, float percent_along, const EdgeI
       .toBase64();
 }
 
-json::ArrayPtr serialize_edges(const PathLocation& location, GraphReader& reader, bool verbose) {
-  auto array = json::array({});
+void serialize_edges(const PathLocation& location,
+                     GraphReader& reader,
+                     bool verbose,
+                     rapidjson::writer_wrapper_t& writer) {
+  writer.start_array("edges");
   for (const auto& edge : location.edges) {
     try {
       // get the osm way id
@@ -71,67 +77,83 @@ json::ArrayPtr serialize_edges(const PathLocation& location, GraphReader& reader
       auto edge_info = tile->edgeinfo(directed_edge);
       // they want MOAR!
       if (verbose) {
-        // live traffic information
-        const volatile auto& traffic = tile->trafficspeed(directed_edge);
-        auto live_speed = traffic.json();
+        // everything that can fail happens before we start writing the edge
+        auto openlr = linear_reference(directed_edge, edge.percent_along, edge_info);
 
-        // incident information
-        if (traffic.has_incidents) {
-          // TODO: incidents
-        }
+        // basic rest of it plus edge metadata
+        writer.start_object();
+        writer.set_rounded_precision(6);
+        writer("correlated_lat", edge.projected.lat());
+        writer("correlated_lon", edge.projected.lng());
+        writer("side_of_street", edge.sos == PathLocation::LEFT
+                                     ? "left"
+                                     : (edge.sos == PathLocation::RIGHT ? "right" : "neither"));
+        writer.set_rounded_precision(5);
+        writer("percent_along", static_cast<double>(edge.percent_along));
+        writer.set_rounded_precision(1);
+        writer("distance", static_cast<double>(edge.distance));
+        writer("heading", static_cast<double>(edge.projected_heading));
+        writer("outbound_reach", static_cast<int64_t>(edge.outbound_reach));
+        writer("inbound_reach", static_cast<int64_t>(edge.inbound_reach));
+        writer.start_object("edge_id");
+        edge.id.json(writer);
+        writer.end_object();
+        writer.start_object("edge");
+        directed_edge->json(writer);
+        writer.end_object();
+        writer.start_object("edge_info");
+        edge_info.json(writer);
+        writer.end_object();
+        writer("linear_reference", openlr);
 
         // historical traffic information
-        auto predicted_speeds = json::array({});
+        writer.start_array("predicted_speeds");
         if (directed_edge->has_predicted_speed()) {
           for (auto sec = 0; sec < midgard::kSecondsPerWeek; sec += 5 * midgard::kSecPerMinute) {
-            predicted_speeds->emplace_back(
-                static_cast<uint64_t>(tile->GetSpeed(directed_edge, kPredictedFlowMask, sec)));
+            writer(static_cast<uint64_t>(tile->GetSpeed(directed_edge, kPredictedFlowMask, sec)));
           }
         }
+        writer.end_array();
 
-        // basic rest of it plus edge metadata
-        array->emplace_back(json::map({
-            {"correlated_lat", json::fixed_t{edge.projected.lat(), 6}},
-            {"correlated_lon", json::fixed_t{edge.projected.lng(), 6}},
-            {"side_of_street",
-             edge.sos == PathLocation::LEFT
-                 ? std::string("left")
-                 : (edge.sos == PathLocation::RIGHT ? std::string("right") : std::string("neither"))},
-            {"percent_along", json::fixed_t{edge.percent_along, 5}},
-            {"distance", json::fixed_t{edge.distance, 1}},
-            {"heading", json::fixed_t{edge.projected_heading, 1}},
-            {"outbound_reach", static_cast<int64_t>(edge.outbound_reach)},
-            {"inbound_reach", static_cast<int64_t>(edge.inbound_reach)},
-            {"edge_id", edge.id.json()},
-            {"edge", directed_edge->json()},
-            {"edge_info", edge_info.json()},
-            {"linear_reference", linear_reference(directed_edge, edge.percent_along, edge_info)},
-            {"predicted_speeds", predicted_speeds},
-            {"live_speed", live_speed},
-            {"access_restrictions", get_access_restrictions(tile, edge.id.id())},
-        }));
+        // live traffic information
+        const volatile auto& traffic = tile->trafficspeed(directed_edge);
+        writer.start_object("live_speed");
+        traffic.json(writer);
+        writer.end_object();
+
+        // incident information
+        if (traffic.has_incidents) {
+          // TODO: incidents
+        }
+
+        get_access_restrictions(tile, edge.id.id(), writer);
+        writer.end_object();
       } // they want it lean and mean
       else {
-        array->emplace_back(json::map({
-            {"way_id", static_cast<uint64_t>(edge_info.wayid())},
-            {"correlated_lat", json::fixed_t{edge.projected.lat(), 6}},
-            {"correlated_lon", json::fixed_t{edge.projected.lng(), 6}},
-            {"side_of_street",
-             edge.sos == PathLocation::LEFT
-                 ? std::string("left")
-                 : (edge.sos == PathLocation::RIGHT ? std::string("right") : std::string("neither"))},
-            {"percent_along", json::fixed_t{edge.percent_along, 5}},
-        }));
+        writer.start_object();
+        writer("way_id", static_cast<uint64_t>(edge_info.wayid()));
+        writer.set_rounded_precision(6);
+        writer("correlated_lat", edge.projected.lat());
+        writer("correlated_lon", edge.projected.lng());
+        writer("side_of_street", edge.sos == PathLocation::LEFT
+                                     ? "left"
+                                     : (edge.sos == PathLocation::RIGHT ? "right" : "neither"));
+        writer.set_rounded_precision(5);
+        writer("percent_along", static_cast<double>(edge.percent_along));
+        writer.end_object();
       }
     } catch (...) {
       // this really shouldnt ever get hit
       LOG_WARN("Expected edge not found in graph but found by loki::search!");
     }
   }
-  return array;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_nodes(const PathLocation& location, GraphReader& reader, bool verbose) {
+void serialize_nodes(const PathLocation& location,
+                     GraphReader& reader,
+                     bool verbose,
+                     rapidjson::writer_wrapper_t& writer) {
   // get the nodes we need
   std::unordered_set<uint64_t> nodes;
   for (const auto& e : location.edges) {
@@ -140,51 +162,57 @@ json::ArrayPtr serialize_nodes(const PathLocation& location, GraphReader& reader
     }
   }
   // ad them into an array of json
-  auto array = json::array({});
+  writer.start_array("nodes");
   for (auto node_id : nodes) {
     GraphId n(node_id);
     graph_tile_ptr tile = reader.GetGraphTile(n);
     auto* node_info = tile->node(n);
-    json::MapPtr node;
+    writer.start_object();
     if (verbose) {
-      node = node_info->json(tile);
-      node->emplace("node_id", n.json());
+      node_info->json(tile, writer);
+      writer.start_object("node_id");
+      n.json(writer);
+      writer.end_object();
     } else {
       midgard::PointLL node_ll = tile->get_node_ll(n);
-      node = json::map({
-          {"lon", json::fixed_t{node_ll.first, 6}}, {"lat", json::fixed_t{node_ll.second, 6}},
-          // TODO: osm_id
-      });
+      writer.set_rounded_precision(6);
+      writer("lon", node_ll.first);
+      writer("lat", node_ll.second);
+      // TODO: osm_id
     }
-    array->emplace_back(node);
+    writer.end_object();
   }
-  // give them back
-  return array;
+  writer.end_array();
 }
 
-json::MapPtr serialize(const PathLocation& location, GraphReader& reader, bool verbose) {
+void serialize(const PathLocation& location,
+               GraphReader& reader,
+               bool verbose,
+               rapidjson::writer_wrapper_t& writer) {
   // serialze all the edges
-  auto m = json::map({
-      {"edges", serialize_edges(location, reader, verbose)},
-      {"nodes", serialize_nodes(location, reader, verbose)},
-      {"input_lat", json::fixed_t{location.latlng_.lat(), 6}},
-      {"input_lon", json::fixed_t{location.latlng_.lng(), 6}},
-  });
-  return m;
+  writer.start_object();
+  serialize_edges(location, reader, verbose, writer);
+  serialize_nodes(location, reader, verbose, writer);
+  writer.set_rounded_precision(6);
+  writer("input_lat", location.latlng_.lat());
+  writer("input_lon", location.latlng_.lng());
+  writer.end_object();
 }
 
-json::MapPtr serialize(const midgard::PointLL& ll, const std::string& reason, bool verbose) {
-  auto m = json::map({
-      {"edges", static_cast<std::nullptr_t>(nullptr)},
-      {"nodes", static_cast<std::nullptr_t>(nullptr)},
-      {"input_lat", json::fixed_t{ll.lat(), 6}},
-      {"input_lon", json::fixed_t{ll.lng(), 6}},
-  });
+void serialize(const midgard::PointLL& ll,
+               const std::string& reason,
+               bool verbose,
+               rapidjson::writer_wrapper_t& writer) {
+  writer.start_object();
+  writer("edges", nullptr);
+  writer("nodes", nullptr);
+  writer.set_rounded_precision(6);
+  writer("input_lat", ll.lat());
+  writer("input_lon", ll.lng());
   if (verbose) {
-    m->emplace("reason", reason);
+    writer("reason", reason);
   }
-
-  return m;
+  writer.end_object();
 }
 } // namespace
 
@@ -195,19 +223,22 @@ std::string serializeLocate(const Api& request,
                             const std::vector<baldr::Location>& locations,
                             const std::unordered_map<baldr::Location, PathLocation>& projections,
                             GraphReader& reader) {
-  auto json = json::array({});
+  // verbose output carries whole edges and their predicted speeds
+  rapidjson::writer_wrapper_t writer((request.options().verbose() ? 16384 : 1024) *
+                                     locations.size());
+  writer.start_array();
   for (const auto& location : locations) {
-    try {
-      json->emplace_back(serialize(projections.at(location), reader, request.options().verbose()));
-    } catch (const std::exception& e) {
-      json->emplace_back(
-          serialize(location.latlng_, "No data found for location", request.options().verbose()));
+    auto projection = projections.find(location);
+    if (projection != projections.cend()) {
+      serialize(projection->second, reader, request.options().verbose(), writer);
+    } else {
+      serialize(location.latlng_, "No data found for location", request.options().verbose(),
+                writer);
     }
   }
+  writer.end_array();
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  return writer.get_buffer();
 }
 
 } // namespace tyr
@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 
-#include "baldr/json.h"
+#include "baldr/rapidjson_utils.h"
 #include "proto_conversions.h"
 #include "thor/matrixalgorithm.h"
 #include "tyr/serializers.h"
@@ -12,62 +16,73 @@ using namespace valhalla::thor;
 
 namespace {
 
-json::ArrayPtr
-serialize_duration(const valhalla::Matrix& matrix, size_t start_td, const size_t td_count) {
-  auto time = json::array({});
+// rough size of a serialized cell, used to size the buffer up front
+constexpr size_t kBytesPerCell = 32;
+
+void serialize_duration(const valhalla::Matrix& matrix,
+                        size_t start_td,
+                        const size_t td_count,
+                        rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for time in matrix result
     if (matrix.times()[i] != kMaxCost) {
-      time->emplace_back(static_cast<uint64_t>(matrix.times()[i]));
+      writer(static_cast<uint64_t>(matrix.times()[i]));
     } else {
-      time->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return time;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_distance(const valhalla::Matrix& matrix,
-                                  const size_t start_td,
-                                  const size_t td_count,
-                                  const size_t /* source_index */,
-                                  const size_t /* target_index */,
-                                  double distance_scale) {
-  auto distance = json::array({});
+void serialize_distance(const valhalla::Matrix& matrix,
+                        const size_t start_td,
+                        const size_t td_count,
+                        double distance_scale,
+                        rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
+  writer.set_rounded_precision(3);
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for distance in matrix result
     if (matrix.times()[i] != kMaxCost) {
-      distance->emplace_back(json::fixed_t{matrix.distances()[i] * distance_scale, 3});
+      writer(static_cast<double>(matrix.distances()[i] * distance_scale));
     } else {
-      distance->emplace_back(static_cast<std::nullptr_t>(nullptr));
+      writer(nullptr);
     }
   }
-  return distance;
+  writer.end_array();
 }
 
-json::ArrayPtr serialize_shape(const valhalla::Matrix& matrix,
-                               const size_t start_td,
-                               const size_t td_count,
-                               const ShapeFormat shape_format) {
+void serialize_shape(const valhalla::Matrix& matrix,
+                     const size_t start_td,
+                     const size_t td_count,
+                     const ShapeFormat shape_format,
+                     rapidjson::writer_wrapper_t& writer) {
   // TODO(nils): shapes aren't implemented yet in TDMatrix
-  auto shapes = json::array({});
-  if (shape_format == no_shape || (matrix.algorithm() != Matrix::CostMatrix))
-    return shapes;
+  writer.start_array();
+  if (shape_format == no_shape || (matrix.algorithm() != Matrix::CostMatrix)) {
+    writer.end_array();
+    return;
+  }
 
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     switch (shape_format) {
       // even if it source == target or no route found, we want to emplace an element
       case geojson:
-        if (!matrix.shapes()[i].empty())
-          shapes->emplace_back(tyr::geojson_shape(decode<std::vector<PointLL>>(matrix.shapes()[i])));
-        else
-          shapes->emplace_back(nullptr);
+        if (!matrix.shapes()[i].empty()) {
+          writer.start_object();
+          tyr::geojson_shape(decode<std::vector<PointLL>>(matrix.shapes()[i]), writer);
+          writer.end_object();
+        } else {
+          writer(nullptr);
+        }
         break;
       default:
         // this covers the polylines
-        shapes->emplace_back(matrix.shapes()[i]);
+        writer(matrix.shapes()[i]);
     }
   }
-  return shapes;
+  writer.end_array();
 }
 } // namespace
 
@@ -75,30 +90,39 @@ namespace osrm_serializers {
 
 // Serialize route response in OSRM compatible format.
 std::string serialize(const Api& request) {
-  auto json = json::map({});
-  auto time = json::array({});
-  auto distance = json::array({});
   const auto& options = request.options();
+  rapidjson::writer_wrapper_t writer(kBytesPerCell * options.sources_size() *
+                                     options.targets_size());
+  writer.start_object();
 
   // If here then the matrix succeeded. Set status code to OK and serialize
   // waypoints (locations).
-  json->emplace("code", std::string("Ok"));
-  json->emplace("sources", osrm::waypoints(options.sources()));
-  json->emplace("destinations", osrm::waypoints(options.targets()));
+  writer("code", "Ok");
+  writer.start_array("sources");
+  osrm::waypoints(options.sources(), writer);
+  writer.end_array();
+  writer.start_array("destinations");
+  osrm::waypoints(options.targets(), writer);
+  writer.end_array();
+
+  writer.start_array("durations");
+  for (int source_index = 0; source_index < options.sources_size(); ++source_index) {
+    serialize_duration(request.matrix(), source_index * options.targets_size(),
+                       options.targets_size(), writer);
+  }
+  writer.end_array();
 
+  writer.start_array("distances");
   for (int source_index = 0; source_index < options.sources_size(); ++source_index) {
-    time->emplace_back(serialize_duration(request.matrix(), source_index * options.targets_size(),
-                                          options.targets_size()));
-    distance->emplace_back(serialize_distance(request.matrix(), source_index * options.targets_size(),
-                                              options.targets_size(), source_index, 0, 1.0));
+    serialize_distance(request.matrix(), source_index * options.targets_size(),
+                       options.targets_size(), 1.0, writer);
   }
-  json->emplace("durations", time);
-  json->emplace("distances", distance);
-  json->emplace("algorithm", MatrixAlgoToString(request.matrix().algorithm()));
+  writer.end_array();
+
+  writer("algorithm", MatrixAlgoToString(request.matrix().algorithm()));
+  writer.end_object();
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  return writer.get_buffer();
 }
 } // namespace osrm_serializers
 
@@ -109,51 +133,55 @@ valhalla output looks like this:
 
 */
 
-json::ArrayPtr locations(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations) {
-  auto input_locs = json::array({});
+void locations(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+               rapidjson::writer_wrapper_t& writer) {
+  writer.set_rounded_precision(6);
   for (const auto& location : locations) {
     if (location.correlation().edges().size() == 0) {
-      input_locs->emplace_back(nullptr);
+      writer(nullptr);
     } else {
       auto& corr_ll = location.correlation().edges(0).ll();
-      input_locs->emplace_back(json::map(
-          {{"lat", json::fixed_t{corr_ll.lat(), 6}}, {"lon", json::fixed_t{corr_ll.lng(), 6}}}));
+      writer.start_object();
+      writer("lat", corr_ll.lat());
+      writer("lon", corr_ll.lng());
+      writer.end_object();
     }
   }
-  return input_locs;
 }
 
-json::ArrayPtr serialize_row(const valhalla::Matrix& matrix,
-                             size_t start_td,
-                             const size_t td_count,
-                             const size_t source_index,
-                             const size_t target_index,
-                             const double distance_scale,
-                             const ShapeFormat shape_format) {
-  auto row = json::array({});
+void serialize_row(const valhalla::Matrix& matrix,
+                   size_t start_td,
+                   const size_t td_count,
+                   const size_t source_index,
+                   const size_t target_index,
+                   const double distance_scale,
+                   const ShapeFormat shape_format,
+                   rapidjson::writer_wrapper_t& writer) {
+  writer.start_array();
   for (size_t i = start_td; i < start_td + td_count; ++i) {
     // check to make sure a route was found; if not, return null for distance & time in matrix
     // result
-    json::MapPtr map;
     const auto time = matrix.times()[i];
     const auto& date_time = matrix.date_times()[i];
     const auto& time_zone_offset = matrix.time_zone_offsets()[i];
     const auto& time_zone_name = matrix.time_zone_names()[i];
+    writer.start_object();
+    writer("from_index", static_cast<uint64_t>(source_index));
+    writer("to_index", static_cast<uint64_t>(target_index + (i - start_td)));
     if (time != kMaxCost) {
-      map = json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                       {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                       {"time", static_cast<uint64_t>(time)},
-                       {"distance", json::fixed_t{matrix.distances()[i] * distance_scale, 3}}});
+      writer("time", static_cast<uint64_t>(time));
+      writer.set_rounded_precision(3);
+      writer("distance", static_cast<double>(matrix.distances()[i] * distance_scale));
       if (!date_time.empty()) {
-        map->emplace("date_time", date_time);
+        writer("date_time", date_time);
       }
 
       if (!time_zone_offset.empty()) {
-        map->emplace("time_zone_offset", time_zone_offset);
+        writer("time_zone_offset", time_zone_offset);
       }
 
       if (!time_zone_name.empty()) {
-        map->emplace("time_zone_name", time_zone_name);
+        writer("time_zone_name", time_zone_name);
       }
 
       if (matrix.shapes().size() && shape_format != no_shape) {
@@ -161,82 +189,193 @@ json::ArrayPtr serialize_row(const valhalla::Matrix& matrix,
         if (!matrix.shapes()[i].empty()) {
           switch (shape_format) {
             case geojson:
-              map->emplace("shape",
-                           tyr::geojson_shape(decode<std::vector<PointLL>>(matrix.shapes()[i])));
+              writer.start_object("shape");
+              tyr::geojson_shape(decode<std::vector<PointLL>>(matrix.shapes()[i]), writer);
+              writer.end_object();
               break;
             default:
-              map->emplace("shape", matrix.shapes()[i]);
+              writer("shape", matrix.shapes()[i]);
           }
         }
       }
     } else {
-      map = json::map({{"from_index", static_cast<uint64_t>(source_index)},
-                       {"to_index", static_cast<uint64_t>(target_index + (i - start_td))},
-                       {"time", static_cast<std::nullptr_t>(nullptr)},
-                       {"distance", static_cast<std::nullptr_t>(nullptr)}});
+      writer("time", nullptr);
+      writer("distance", nullptr);
     }
-    row->emplace_back(map);
+    writer.end_object();
   }
-  return row;
+  writer.end_array();
 }
 
 std::string serialize(const Api& request, double distance_scale) {
-  auto json = json::map({});
   const auto& options = request.options();
+  // verbose rows spell out every cell as an object so they need a lot more room
+  rapidjson::writer_wrapper_t writer(kBytesPerCell * (options.verbose() ? 4 : 1) *
+                                     options.sources_size() * options.targets_size());
+  writer.start_object();
 
   if (options.verbose()) {
-    json::ArrayPtr matrix = json::array({});
+    writer.start_array("sources_to_targets");
     for (int source_index = 0; source_index < options.sources_size(); ++source_index) {
-      matrix->emplace_back(serialize_row(request.matrix(), source_index * options.targets_size(),
-                                         options.targets_size(), source_index, 0, distance_scale,
-                                         options.shape_format()));
+      serialize_row(request.matrix(), source_index * options.targets_size(),
+                    options.targets_size(), source_index, 0, distance_scale,
+                    options.shape_format(), writer);
     }
-
-    json->emplace("sources_to_targets", matrix);
-
-    json->emplace("targets", locations(options.targets()));
-    json->emplace("sources", locations(options.sources()));
+    writer.end_array();
+
+    writer.start_array("targets");
+    locations(options.targets(), writer);
+    writer.end_array();
+    writer.start_array("sources");
+    locations(options.sources(), writer);
+    writer.end_array();
   } // slim it down
   else {
-    auto matrix = json::map({});
-    auto time = json::array({});
-    auto distance = json::array({});
-    auto shapes = json::array({});
+    writer.start_object("sources_to_targets");
 
+    writer.start_array("distances");
     for (int source_index = 0; source_index < options.sources_size(); ++source_index) {
-      const auto first_td = source_index * options.targets_size();
-      time->emplace_back(serialize_duration(request.matrix(), first_td, options.targets_size()));
-      distance->emplace_back(serialize_distance(request.matrix(), first_td, options.targets_size(),
-                                                source_index, 0, distance_scale));
-      shapes->emplace_back(serialize_shape(request.matrix(), first_td, options.targets_size(),
-                                           options.shape_format()));
+      serialize_distance(request.matrix(), source_index * options.targets_size(),
+                         options.targets_size(), distance_scale, writer);
     }
-    matrix->emplace("distances", distance);
-    matrix->emplace("durations", time);
-    if (!(options.shape_format() == no_shape) && (request.matrix().algorithm() == Matrix::CostMatrix))
-      matrix->emplace("shapes", shapes);
+    writer.end_array();
 
-    json->emplace("sources_to_targets", matrix);
+    writer.start_array("durations");
+    for (int source_index = 0; source_index < options.sources_size(); ++source_index) {
+      serialize_duration(request.matrix(), source_index * options.targets_size(),
+                         options.targets_size(), writer);
+    }
+    writer.end_array();
+
+    if (!(options.shape_format() == no_shape) &&
+        (request.matrix().algorithm() == Matrix::CostMatrix)) {
+      writer.start_array("shapes");
+      for (int source_index = 0; source_index < options.sources_size(); ++source_index) {
+        serialize_shape(request.matrix(), source_index * options.targets_size(),
+                        options.targets_size(), options.shape_format(), writer);
+      }
+      writer.end_array();
+    }
+
+    writer.end_object();
   }
 
-  json->emplace("units", Options_Units_Enum_Name(options.units()));
-  json->emplace("algorithm", MatrixAlgoToString(request.matrix().algorithm()));
+  writer("units", Options_Units_Enum_Name(options.units()));
+  writer("algorithm", MatrixAlgoToString(request.matrix().algorithm()));
 
   if (options.has_id_case()) {
-    json->emplace("id", options.id());
+    writer("id", options.id());
   }
 
   // add warnings to json response
   if (request.info().warnings_size() >= 1) {
-    json->emplace("warnings", valhalla::tyr::serializeWarnings(request));
+    valhalla::tyr::serializeWarnings(request, writer);
   }
 
-  std::stringstream ss;
-  ss << *json;
-  return ss.str();
+  writer.end_object();
+  return writer.get_buffer();
 }
 } // namespace valhalla_serializers
 
+namespace binary_serializers {
+
+/*
+binary output is a small header followed by the times and then the distances as flat row major
+arrays. everything is little endian:
+
+  char[4]  "VMTX"
+  uint16   layout version
+  uint16   cell encoding, 0 = uint32 and 1 = uint16 (quantized)
+  uint32   number of sources
+  uint32   number of targets
+  float32  seconds per time unit
+  float32  meters per distance unit
+  times[sources * targets]
+  distances[sources * targets]
+
+unreachable cells hold the largest value of the cell type
+*/
+
+constexpr char kMagic[4] = {'V', 'M', 'T', 'X'};
+constexpr uint16_t kVersion = 1;
+constexpr uint16_t kUint32Cells = 0;
+constexpr uint16_t kUint16Cells = 1;
+
+// appends the bytes of an unsigned integer in little endian order
+template <typename T> void append(std::string& bytes, T value) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    bytes.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void append(std::string& bytes, float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  append(bytes, bits);
+}
+
+// the scale that fits the largest value into a cell, values below the cell max are kept exact
+template <typename T> float quantization_scale(double max_value) {
+  constexpr double kMaxCell = std::numeric_limits<T>::max() - 1;
+  return max_value > kMaxCell ? static_cast<float>(max_value / kMaxCell) : 1.f;
+}
+
+template <typename T>
+void append_cells(std::string& bytes, const valhalla::Matrix& matrix, bool times, float scale) {
+  constexpr T kUnreachable = std::numeric_limits<T>::max();
+  constexpr double kMaxCell = kUnreachable - 1;
+  for (int i = 0; i < matrix.times_size(); ++i) {
+    if (matrix.times(i) == kMaxCost) {
+      append(bytes, kUnreachable);
+      continue;
+    }
+    double value = times ? matrix.times(i) : matrix.distances(i);
+    // uint32 cells truncate like the json output does, quantized cells round to the nearest step
+    value = scale == 1.f ? std::floor(value) : std::round(value / scale);
+    append(bytes, static_cast<T>(std::min(value, kMaxCell)));
+  }
+}
+
+std::string serialize(const Api& request) {
+  const auto& options = request.options();
+  const auto& matrix = request.matrix();
+  bool quantize = options.quantize();
+  size_t cell_size = quantize ? sizeof(uint16_t) : sizeof(uint32_t);
+
+  // the largest reachable values decide the quantization
+  double max_time = 0, max_distance = 0;
+  if (quantize) {
+    for (int i = 0; i < matrix.times_size(); ++i) {
+      if (matrix.times(i) != kMaxCost) {
+        max_time = std::max(max_time, static_cast<double>(matrix.times(i)));
+        max_distance = std::max(max_distance, static_cast<double>(matrix.distances(i)));
+      }
+    }
+  }
+  float time_scale = quantize ? quantization_scale<uint16_t>(max_time) : 1.f;
+  float distance_scale = quantize ? quantization_scale<uint16_t>(max_distance) : 1.f;
+
+  std::string bytes;
+  bytes.reserve(24 + 2 * cell_size * matrix.times_size());
+  bytes.append(kMagic, sizeof(kMagic));
+  append(bytes, kVersion);
+  append(bytes, quantize ? kUint16Cells : kUint32Cells);
+  append(bytes, static_cast<uint32_t>(options.sources_size()));
+  append(bytes, static_cast<uint32_t>(options.targets_size()));
+  append(bytes, time_scale);
+  append(bytes, distance_scale);
+
+  if (quantize) {
+    append_cells<uint16_t>(bytes, matrix, true, time_scale);
+    append_cells<uint16_t>(bytes, matrix, false, distance_scale);
+  } else {
+    append_cells<uint32_t>(bytes, matrix, true, time_scale);
+    append_cells<uint32_t>(bytes, matrix, false, distance_scale);
+  }
+  return bytes;
+}
+} // namespace binary_serializers
+
 namespace valhalla {
 namespace tyr {
 
@@ -259,6 +398,8 @@ std::string serializeMatrix(Api& request) {
       return valhalla_serializers::serialize(request, distance_scale);
     case Options_Format_pbf:
       return serializePbf(request);
+    case Options_Format_binary:
+      return binary_serializers::serialize(request);
     default:
       throw;
   }
@@ -17,6 +17,9 @@ int main(int argc, char** argv) {
   boost::property_tree::ptree config;
   rapidjson::read_json(config_file, config);
 
+  // the other stages run in other processes so requests can't be handed on in memory
+  config.put("httpd.service.in_process", false);
+
   // run the service worker
   valhalla::odin::run_service(config);
 
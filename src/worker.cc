@@ -1,9 +1,17 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
 #include <sstream>
 #include <typeinfo>
 #include <unordered_map>
 
 #include "baldr/datetime.h"
 #include "baldr/graphconstants.h"
+#include "baldr/graphid.h"
 #include "baldr/location.h"
 #include "loki/worker.h"
 #include "midgard/encoded.h"
@@ -41,6 +49,7 @@ constexpr const char* OSRM_INVALID_VALUE = R"({"code":"InvalidValue","message":"
 constexpr const char* OSRM_NO_ROUTE = R"({"code":"NoRoute","message":"Impossible route between points"})";
 constexpr const char* OSRM_NO_SEGMENT = R"({"code":"NoSegment","message":"One of the supplied input coordinates could not snap to street segment."})";
 constexpr const char* OSRM_SHUTDOWN = R"({"code":"ServiceUnavailable","message":"The service is shutting down."})";
+constexpr const char* OSRM_BUSY = R"({"code":"ServiceUnavailable","message":"The service is too busy."})";
 constexpr const char* OSRM_SERVER_ERROR = R"({"code":"InvalidUrl","message":"Failed to serialize route."})";
 constexpr const char* OSRM_DISTANCE_EXCEEDED = R"({"code":"DistanceExceeded","message":"Path distance exceeds the max distance limit."})";
 constexpr const char* OSRM_PERIMETER_EXCEEDED = R"({"code":"PerimeterExceeded","message":"Perimeter of avoid polygons exceeds the max limit."})";
@@ -52,6 +61,8 @@ const std::unordered_map<unsigned, valhalla::valhalla_exception_t> error_codes{
     {101, {101, "Try a POST or GET request instead", 405, HTTP_405, OSRM_INVALID_URL, "wrong_http_method"}},
     {102, {102, "The service is shutting down", 503, HTTP_503, OSRM_SHUTDOWN, "shutting_down"}},
     {103, {103, "Failed to parse pbf request", 400, HTTP_400, OSRM_INVALID_URL, "pbf_parse_failed"}},
+    {104, {104, "The service is too busy to take on this request, try again later", 503, HTTP_503, OSRM_BUSY, "too_busy"}},
+    {105, {105, "The request is more work than the service takes on at once", 400, HTTP_400, OSRM_INVALID_OPTIONS, "too_much_work"}},
     {106, {106, "Try any of", 404, HTTP_404, OSRM_INVALID_SERVICE, "wrong_action"}},
     {107, {107, "Not Implemented", 501, HTTP_501, OSRM_INVALID_SERVICE, "empty_action"}},
     {110, {110, "Insufficiently specified required parameter 'locations'", 400, HTTP_400, OSRM_INVALID_OPTIONS, "locations_parse_failed"}},
@@ -60,6 +71,7 @@ const std::unordered_map<unsigned, valhalla::valhalla_exception_t> error_codes{
     {113, {113, "Insufficiently specified required parameter 'contours'", 400, HTTP_400, OSRM_INVALID_OPTIONS, "contours_parse_failed"}},
     {114, {114, "Insufficiently specified required parameter 'shape' or 'encoded_polyline'", 400, HTTP_400, OSRM_INVALID_OPTIONS, "shape_parse_failed"}},
     {115, {115, "Insufficiently specified required parameter 'action'", 400, HTTP_400, OSRM_INVALID_OPTIONS, "action_parse_failed"}},
+    {116, {116, "Insufficiently specified required parameter 'traces'", 400, HTTP_400, OSRM_INVALID_OPTIONS, "traces_parse_failed"}},
     {120, {120, "Insufficient number of locations provided", 400, HTTP_400, OSRM_INVALID_OPTIONS, "not_enough_locations"}},
     {121, {121, "Insufficient number of sources provided", 400, HTTP_400, OSRM_INVALID_OPTIONS, "not_enough_sources"}},
     {122, {122, "Insufficient number of targets provided", 400, HTTP_400, OSRM_INVALID_OPTIONS, "not_enough_targets"}},
@@ -98,6 +110,7 @@ const std::unordered_map<unsigned, valhalla::valhalla_exception_t> error_codes{
     {163, {163, "Invalid date_type", 400, HTTP_400, OSRM_INVALID_VALUE, "wrong_date_type"}},
     {164, {164, "Invalid shape format", 400, HTTP_400, OSRM_INVALID_VALUE, "wrong_shape_format"}},
     {165, {165, "Date and time required for destination for date_type of invariant", 400, HTTP_400, OSRM_INVALID_OPTIONS, "missing_invariant_date"}},
+    {166, {166, "Invalid edge_ids", 400, HTTP_400, OSRM_INVALID_VALUE, "wrong_edge_ids"}},
     {167, {167, "Exceeded maximum circumference for exclude_polygons", 400, HTTP_400, OSRM_PERIMETER_EXCEEDED, "too_large_polygon"}},
     {168, {168, "Invalid expansion property type", 400, HTTP_400, OSRM_INVALID_OPTIONS, "invalid_expansion_property"}},
     {170, {170, "Locations are in unconnected regions. Go check/edit the map at osm.org", 400, HTTP_400, OSRM_NO_ROUTE, "impossible_route"}},
@@ -169,19 +182,186 @@ const std::unordered_map<int, std::string> warning_codes = {
 };
 // clang-format on
 
-rapidjson::Document from_string(const std::string& json, const valhalla_exception_t& e) {
-  rapidjson::Document d;
+// Each thread keeps a copy of the last json it parsed and a pool for the values of the document
+// it parsed into. Both are reused by the next request on the thread. The allocator frees what it
+// had to allocate beyond the pool when it's cleared, so a request that outgrew the pool grows it
+// instead, up to a limit, and the next request of that size does not allocate. The json is parsed
+// in situ so that the strings of the document point into the copy instead of being copied out
+constexpr size_t kParsePoolSize = 64 * 1024;
+constexpr size_t kMaxParsePoolSize = 4 * 1024 * 1024;
+struct parse_buffer_t {
+  std::string json;
+  std::vector<char> pool;
+  std::unique_ptr<rapidjson::MemoryPoolAllocator<>> allocator;
+};
+
+// The document is only valid until the next call on the same thread
+rapidjson::Document parse_insitu(const std::string& json) {
+  thread_local parse_buffer_t buffer;
+  // the allocator has to go before the pool it keeps its first chunk in
+  const size_t capacity = buffer.allocator ? buffer.allocator->Capacity() : 0;
+  if (!buffer.allocator ||
+      (capacity > buffer.pool.size() && buffer.pool.size() < kMaxParsePoolSize)) {
+    buffer.allocator.reset();
+    buffer.pool.resize(std::min(std::max(capacity + 1024, kParsePoolSize), kMaxParsePoolSize));
+    buffer.allocator.reset(
+        new rapidjson::MemoryPoolAllocator<>(buffer.pool.data(), buffer.pool.size()));
+  } else {
+    buffer.allocator->Clear();
+  }
+  rapidjson::Document d(buffer.allocator.get());
   if (json.empty()) {
     d.SetObject();
     return d;
   }
-  d.Parse(json.c_str());
+  buffer.json.assign(json);
+  d.ParseInsitu(&buffer.json[0]);
+  return d;
+}
+
+rapidjson::Document from_string(const std::string& json, const valhalla_exception_t& e) {
+  auto d = parse_insitu(json);
   if (d.HasParseError()) {
     throw e;
   }
   return d;
 }
 
+// The first block of the arena of a service worker, big enough for the options and locations of
+// most requests. Larger payloads like paths and trips spill over into blocks freed on cleanup
+constexpr size_t kArenaBlockSize = 64 * 1024;
+
+google::protobuf::ArenaOptions arena_options(std::vector<char>& block) {
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block.data();
+  options.initial_block_size = block.size();
+  return options;
+}
+
+// The bounds on the work in flight are shared by all the workers of the process, which are made
+// from the same config
+std::shared_ptr<admission_t> shared_admission(const boost::property_tree::ptree& conf) {
+  static std::mutex mutex;
+  static std::weak_ptr<admission_t> shared;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto admission = shared.lock();
+  if (!admission) {
+    admission = std::make_shared<admission_t>(conf);
+    if (!admission->bounded()) {
+      return nullptr;
+    }
+    shared = admission;
+  }
+  return admission;
+}
+
+// What the stages hand on to each other when they run in the same process
+struct handed_on_t {
+  Api request;
+  std::unique_ptr<admission_t::ticket_t> admitted;
+};
+
+// How long a handed on request waits for the next stage when requests never time out
+constexpr std::chrono::seconds kHandoffExpiry{300};
+
+// The requests handed on between the stages of this process by the random id that is sent in their
+// place. Only ids that were handed out can be taken back, anything else on the wire is ignored. A
+// request the next stage never takes, for example because it was interrupted while queued, expires
+// along with its claim on the work in flight
+class handoffs_t {
+public:
+  uint64_t put(std::unique_ptr<handed_on_t> handed_on, std::chrono::seconds expiry) {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    expire(now);
+    uint64_t id;
+    do {
+      id = ids();
+    } while (!entries.emplace(id, std::move(handed_on)).second);
+    expiries.emplace_back(now + expiry, id);
+    return id;
+  }
+
+  std::unique_ptr<handed_on_t> take(uint64_t id) {
+    std::unique_ptr<handed_on_t> handed_on;
+    std::lock_guard<std::mutex> lock(mutex);
+    expire(std::chrono::steady_clock::now());
+    auto entry = entries.find(id);
+    if (entry != entries.end()) {
+      handed_on = std::move(entry->second);
+      entries.erase(entry);
+    }
+    return handed_on;
+  }
+
+  // Drops the requests that were handed on but never taken, which gives back their claim on the
+  // work in flight
+  void expire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    expire(std::chrono::steady_clock::now());
+  }
+
+protected:
+  // The expiries are nearly in order, a later one at the front only delays the ones behind it. The
+  // ids of requests that were already taken are dropped once they get to the front
+  void expire(std::chrono::steady_clock::time_point now) {
+    while (!expiries.empty() && expiries.front().first <= now) {
+      entries.erase(expiries.front().second);
+      expiries.pop_front();
+    }
+  }
+
+  std::mutex mutex;
+  std::mt19937_64 ids{std::random_device{}()};
+  std::unordered_map<uint64_t, std::unique_ptr<handed_on_t>> entries;
+  std::deque<std::pair<std::chrono::steady_clock::time_point, uint64_t>> expiries;
+};
+
+handoffs_t& handoffs() {
+  static handoffs_t handoffs;
+  return handoffs;
+}
+
+// The number of each kind of location in the request, at least one
+uint64_t count(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+               const google::protobuf::RepeatedPtrField<valhalla::Location>& fallback = {}) {
+  return std::max(locations.size() ? locations.size() : fallback.size(), 1);
+}
+
+// The work of a request in the units of the given action
+uint64_t estimate_work(const Options& options, Options::Action action) {
+  switch (action) {
+    // every source is expanded towards every target
+    case Options::sources_to_targets:
+      return count(options.sources(), options.locations()) *
+             count(options.targets(), options.locations());
+    // a matrix between all of the locations and then a path through them
+    case Options::optimized_route:
+      return count(options.locations()) * count(options.locations());
+    // the expansion goes out as far as the largest contour from every location
+    case Options::isochrone: {
+      float largest = 1.f;
+      for (const auto& contour : options.contours()) {
+        largest = std::max(largest, contour.has_time_case() ? contour.time() : contour.distance());
+      }
+      return count(options.locations()) * static_cast<uint64_t>(std::ceil(largest));
+    }
+    case Options::trace_route:
+    case Options::trace_attributes:
+      return count(options.shape(), options.trace());
+    case Options::height:
+      return count(options.shape());
+    case Options::expansion:
+      return options.expansion_action() == Options::expansion
+                 ? 1
+                 : estimate_work(options, options.expansion_action());
+    case Options::status:
+      return 1;
+    default:
+      return count(options.locations());
+  }
+}
+
 bool add_date_to_locations(Options& options,
                            google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
                            const std::string& node) {
@@ -718,6 +898,14 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api, odin:
       options.clear_jsonp();
     }
   }
+  // the binary format only exists for matrices and isnt javascript friendly either
+  else if (options.format() == Options::binary) {
+    if (options.action() != Options::sources_to_targets) {
+      options.set_format(Options::json);
+    } else {
+      options.clear_jsonp();
+    }
+  }
 #ifndef ENABLE_GDAL
   else if (options.format() == Options::geotiff) {
     throw valhalla_exception_t{504};
@@ -1044,6 +1232,9 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api, odin:
     options.set_verbose(rapidjson::get(doc, "/verbose", options.verbose()));
   }
 
+  // binary matrices can trade precision for size
+  options.set_quantize(rapidjson::get<bool>(doc, "/quantize", options.quantize()));
+
   // parse any named costings for re-costing a given path
   parse_recostings(doc, "/recostings", options);
 
@@ -1179,6 +1370,21 @@ void from_json(rapidjson::Document& doc, Options::Action action, Api& api, odin:
     }
   }
 
+  // if specified, get the edge ids of a prior route so edge_walk can skip walking the shape
+  auto edge_ids = rapidjson::get_child_optional(doc, "/edge_ids");
+  if (edge_ids) {
+    if (!edge_ids->IsArray()) {
+      throw valhalla_exception_t{166};
+    }
+    options.clear_edge_ids();
+    for (const auto& edge_id : edge_ids->GetArray()) {
+      if (!edge_id.IsUint64() || !baldr::GraphId(edge_id.GetUint64()).Is_Valid()) {
+        throw valhalla_exception_t{166};
+      }
+      options.add_edge_ids(edge_id.GetUint64());
+    }
+  }
+
   // if specified, get the trace gps_accuracy value in there
   auto gps_accuracy = rapidjson::get_optional<float>(doc, "/trace_options/gps_accuracy");
   if (gps_accuracy) {
@@ -1355,6 +1561,10 @@ void ParseApi(const std::string& request, Options::Action action, valhalla::Api&
   from_json(document, action, api, customLocales);
 }
 
+void ParseApi(rapidjson::Document& document, Options::Action action, valhalla::Api& api, odin::json_locales_map_t customLocales) {
+  from_json(document, action, api, customLocales);
+}
+
 #ifdef ENABLE_SERVICES
 void ParseApi(const http_request_t& request, valhalla::Api& api, odin::json_locales_map_t customLocales) {
   // block all but get and post
@@ -1384,19 +1594,13 @@ void ParseApi(const http_request_t& request, valhalla::Api& api, odin::json_loca
     return;
   }
 
-  // parse the json input
-  rapidjson::Document document;
-  auto& allocator = document.GetAllocator();
+  // parse the json input, from the json parameter or else the body or else there is none at all
   const auto& json = request.query.find("json");
-  if (json != request.query.end() && json->second.size() && json->second.front().size()) {
-    document.Parse(json->second.front().c_str());
-  } // no json parameter, check the body
-  else if (!request.body.empty()) {
-    document.Parse(request.body.c_str());
-  } // no json at all
-  else {
-    document.SetObject();
-  }
+  auto document =
+      parse_insitu(json != request.query.end() && json->second.size() && json->second.front().size()
+                       ? json->second.front()
+                       : request.body);
+  auto& allocator = document.GetAllocator();
 
   // if parsing failed
   if (document.HasParseError()) {
@@ -1451,7 +1655,9 @@ to_response(const std::string& data, http_request_info_t& request_info, const Ap
   auto fmt = request.options().format();
   const auto& mime = fmt == Options::json || fmt == Options::osrm
                          ? worker::JSON_MIME
-                         : (fmt == Options::pbf ? worker::PBF_MIME : worker::GPX_MIME);
+                         : (fmt == Options::pbf      ? worker::PBF_MIME
+                            : fmt == Options::binary ? worker::BINARY_MIME
+                                                     : worker::GPX_MIME);
   headers_t headers{CORS, mime};
   if (fmt == Options::gpx)
     headers.insert(ATTACHMENT);
@@ -1504,10 +1710,74 @@ struct statsd_client_t : public Statsd::StatsdClient {
   std::vector<std::string> tags;
 };
 
-service_worker_t::service_worker_t(const boost::property_tree::ptree& conf) : interrupt(nullptr) {
+admission_t::ticket_t::ticket_t(admission_t& admission, Options::Action action, uint64_t work)
+    : admission(admission), action(action), work(work) {
+}
+admission_t::ticket_t::~ticket_t() {
+  std::lock_guard<std::mutex> lock(admission.mutex);
+  admission.in_flight[action] -= work;
+}
+
+admission_t::admission_t(const boost::property_tree::ptree& conf)
+    : limits(Options::Action_ARRAYSIZE, 0), in_flight(Options::Action_ARRAYSIZE, 0) {
+  for (int action = Options::Action_MIN; action < Options::Action_ARRAYSIZE; ++action) {
+    if (Options::Action_IsValid(action)) {
+      const auto& name = Options_Action_Enum_Name(static_cast<Options::Action>(action));
+      limits[action] = conf.get<uint64_t>("httpd.service.admission." + name, 0);
+    }
+  }
+}
+
+uint64_t admission_t::estimate(const Options& options) {
+  // every recosting goes over the path again
+  return estimate_work(options, options.action()) * (1 + options.recostings_size());
+}
+
+std::unique_ptr<admission_t::ticket_t> admission_t::admit(const Options& options) {
+  const auto action = options.action();
+  if (!limits[action]) {
+    return nullptr;
+  }
+
+  // more work than the action can ever have in flight is never going to be taken on
+  const auto work = estimate(options);
+  if (work > limits[action]) {
+    throw valhalla_exception_t{105, std::to_string(work) + " > " + std::to_string(limits[action])};
+  }
+
+  // otherwise only take it on if it fits next to the work already in flight
+  std::lock_guard<std::mutex> lock(mutex);
+  if (in_flight[action] + work > limits[action]) {
+    throw valhalla_exception_t{104};
+  }
+  in_flight[action] += work;
+  return std::make_unique<ticket_t>(*this, action, work);
+}
+
+bool admission_t::bounded() const {
+  return std::any_of(limits.begin(), limits.end(), [](uint64_t limit) { return limit > 0; });
+}
+
+uint64_t admission_t::in_flight_work(Options::Action action) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return in_flight[action];
+}
+
+service_worker_t::service_worker_t(const boost::property_tree::ptree& conf)
+    : interrupt(nullptr), arena_block(kArenaBlockSize), arena(arena_options(arena_block)),
+      in_process(conf.get<bool>("httpd.service.in_process", false)),
+      handoff_expiry(kHandoffExpiry) {
+  // a handed on request that waited longer than requests may take has been given up on
+  auto timeout = conf.get<int>("httpd.service.timeout_seconds", -1);
+  if (timeout > 0) {
+    handoff_expiry = std::chrono::seconds(timeout);
+  }
   if (conf.count("statsd")) {
     statsd_client = std::make_unique<statsd_client_t>(conf);
   }
+  // the bounds are per process, with the stages in other processes a request only counts against
+  // them while the loki worker of this one is working on it
+  admission = shared_admission(conf);
 }
 service_worker_t::~service_worker_t() {
 }
@@ -1519,7 +1789,63 @@ void service_worker_t::cleanup() {
     // sends metrics to statsd server over udp
     statsd_client->flush();
   }
+  // frees the request objects of the last request
+  in_process_request.reset();
+  // unless the request was handed on its work is done
+  admitted.reset();
+  arena.Reset();
+}
+Api& service_worker_t::make_request() {
+  // requests handed on in memory are swapped between the stages, which is only cheap when they
+  // are all on the heap rather than each on the arena of its own stage
+  if (in_process) {
+    in_process_request.reset(new Api());
+    return *in_process_request;
+  }
+  return *google::protobuf::Arena::CreateMessage<Api>(&arena);
+}
+void service_worker_t::admit(const Api& request) {
+  if (admission) {
+    // while every request is turned away nothing is handed on, so nothing else would expire the
+    // requests that were lost on the way and their work would stay in flight for good
+    handoffs().expire();
+    admitted = admission->admit(request.options());
+  }
+}
+#ifdef ENABLE_SERVICES
+std::string service_worker_t::forward_request(Api& request) {
+  if (!in_process) {
+    return request.SerializeAsString();
+  }
+
+  // the token is a 0 byte followed by the id of the request, a pbf never starts with a 0 byte as
+  // there is no field number 0. the next stage takes the request and its claim on the work in
+  // flight back out of the registry
+  auto handed_on = std::make_unique<handed_on_t>();
+  handed_on->request.Swap(&request);
+  handed_on->admitted = std::move(admitted);
+  const uint64_t id = handoffs().put(std::move(handed_on), handoff_expiry);
+  std::string token(1 + sizeof(id), '\0');
+  std::memcpy(&token[1], &id, sizeof(id));
+  return token;
+}
+bool service_worker_t::receive_request(const zmq::message_t& message, Api& request) {
+  const auto* data = static_cast<const char*>(message.data());
+  if (in_process && message.size() == 1 + sizeof(uint64_t) && data[0] == '\0') {
+    uint64_t id;
+    std::memcpy(&id, data + 1, sizeof(id));
+    // unknown or expired ids are no request at all
+    auto handed_on = handoffs().take(id);
+    if (!handed_on) {
+      return false;
+    }
+    request.Swap(&handed_on->request);
+    admitted = std::move(handed_on->admitted);
+    return true;
+  }
+  return request.ParseFromArray(message.data(), message.size());
 }
+#endif
 void service_worker_t::enqueue_statistics(Api& api) const {
   // nothing to do without stats
   if (!statsd_client || !api.has_info() || api.info().statistics().empty())
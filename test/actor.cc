@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <vector>
 
+#include "baldr/rapidjson_utils.h"
 #include "tyr/actor.h"
+#include "worker.h"
 
 #include "test.h"
 
@@ -76,6 +80,120 @@ TEST(Actor, TraceAttributes) {
   EXPECT_THROW(actor.trace_attributes(request, &interrupt), test_exception_t);
 }
 
+TEST(Actor, TraceAttributesBatch) {
+  tyr::actor_t actor(conf);
+  std::string request = R"({"costing":"auto","shape_match":"map_snap","traces":[
+        {"shape":[{"lat":40.546115,"lon":-76.385076},{"lat":40.544232,"lon":-76.385752}]},
+        {"shape":[{"lat":40.546115,"lon":-76.385076}]},
+        {"shape":[{"lat":40.544232,"lon":-76.385752},{"lat":40.546115,"lon":-76.385076}],
+         "costing":"pedestrian"}]})";
+
+  std::vector<size_t> finished;
+  auto batch_json = actor.trace_attributes_batch(request, nullptr,
+                                                 [&finished](size_t i, const std::string& json) {
+                                                   finished.push_back(i);
+                                                   EXPECT_FALSE(json.empty());
+                                                 });
+  std::sort(finished.begin(), finished.end());
+  EXPECT_EQ(finished, (std::vector<size_t>{0, 1, 2}));
+
+  // results come back in request order and a bad trace doesn't spoil the others
+  rapidjson::Document batch;
+  batch.Parse(batch_json.c_str());
+  ASSERT_FALSE(batch.HasParseError());
+  ASSERT_TRUE(batch.IsArray());
+  ASSERT_EQ(batch.Size(), 3);
+  EXPECT_TRUE(batch[0].HasMember("edges"));
+  EXPECT_TRUE(batch[1].HasMember("error_code"));
+  EXPECT_TRUE(batch[2].HasMember("edges"));
+  EXPECT_NE(batch_json.find("Tulpehocken"), std::string::npos);
+
+  // the workers can share the tiles of a reader handed to the actor, which stays usable after
+  baldr::GraphReader reader(conf.get_child("mjolnir"));
+  tyr::actor_t reader_actor(conf, reader, true);
+  EXPECT_EQ(reader_actor.trace_attributes_batch(request), batch_json);
+  auto route_json = reader_actor.route(R"({"locations":[{"lat":40.546115,"lon":-76.385076},
+        {"lat":40.544232,"lon":-76.385752}],"costing":"auto"})");
+  EXPECT_NE(route_json.find("Tulpehocken"), std::string::npos);
+
+  // a batch without traces is an error of the whole request
+  EXPECT_THROW(actor.trace_attributes_batch(R"({"costing":"auto","traces":[]})"),
+               valhalla_exception_t);
+
+  std::function<void()> interrupt = [] { throw test_exception_t{}; };
+  EXPECT_THROW(actor.trace_attributes_batch(request, &interrupt), test_exception_t);
+}
+
+TEST(Actor, TraceAttributesBatchConcurrent) {
+  // many traces over the same few tiles so that the workers keep loading and dropping them at once
+  std::string traces;
+  for (size_t i = 0; i < 64; ++i) {
+    traces += std::string(i ? "," : "") +
+              (i % 2 ? R"({"shape":[{"lat":40.546115,"lon":-76.385076},
+                  {"lat":40.544232,"lon":-76.385752}]})"
+                     : R"({"shape":[{"lat":40.544232,"lon":-76.385752},
+                  {"lat":40.546115,"lon":-76.385076}]})");
+  }
+  std::string request =
+      R"({"costing":"auto","shape_match":"map_snap","traces":[)" + traces + "]}";
+
+  // every worker must come to the same answer as a single one does
+  tyr::actor_t serial(test::make_config(VALHALLA_SOURCE_DIR "test/traffic_matcher_tiles",
+                                        {{"thor.batch_concurrency", "1"}}));
+  tyr::actor_t concurrent(test::make_config(VALHALLA_SOURCE_DIR "test/traffic_matcher_tiles",
+                                            {{"thor.batch_concurrency", "4"}}));
+  auto expected = serial.trace_attributes_batch(request);
+  EXPECT_NE(expected.find("Tulpehocken"), std::string::npos);
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(concurrent.trace_attributes_batch(request), expected);
+    concurrent.cleanup();
+  }
+}
+
+TEST(Actor, Batch) {
+  tyr::actor_t actor(conf);
+  std::vector<std::string> requests{
+      R"({"locations":[{"lat":40.546115,"lon":-76.385076,"type":"break"},
+          {"lat":40.544232,"lon":-76.385752,"type":"break"}],"costing":"auto"})",
+      R"({"locations":[{"lat":40.546115,"lon":-76.385076}],"costing":"auto"})",
+      R"({"locations":[{"lat":40.544232,"lon":-76.385752,"type":"break"},
+          {"lat":40.546115,"lon":-76.385076,"type":"break"}],"costing":"pedestrian"})",
+  };
+
+  std::vector<size_t> finished;
+  auto results = actor.batch(Options::route, requests, nullptr,
+                             [&finished](size_t i, const std::string& json) {
+                               finished.push_back(i);
+                               EXPECT_FALSE(json.empty());
+                             });
+  std::sort(finished.begin(), finished.end());
+  EXPECT_EQ(finished, (std::vector<size_t>{0, 1, 2}));
+
+  // results come back in request order and a bad request doesn't spoil the others
+  ASSERT_EQ(results.size(), 3);
+  EXPECT_NE(results[0].find("Tulpehocken"), std::string::npos);
+  EXPECT_NE(results[1].find("error_code"), std::string::npos);
+  EXPECT_NE(results[2].find("Tulpehocken"), std::string::npos);
+
+  // the same as doing them one at a time
+  EXPECT_EQ(results[0], actor.route(requests[0]));
+  actor.cleanup();
+
+  std::function<void()> interrupt = [] { throw test_exception_t{}; };
+  EXPECT_THROW(actor.batch(Options::route, requests, &interrupt), test_exception_t);
+}
+
+TEST(Actor, Submit) {
+  tyr::actor_t actor(conf);
+  auto route = actor.submit(Options::route,
+                            R"({"locations":[{"lat":40.546115,"lon":-76.385076,"type":"break"},
+          {"lat":40.544232,"lon":-76.385752,"type":"break"}],"costing":"auto"})");
+  auto bad_route =
+      actor.submit(Options::route, R"({"locations":[{"lat":40.546115,"lon":-76.385076}]})");
+  EXPECT_NE(route.get().find("Tulpehocken"), std::string::npos);
+  EXPECT_THROW(bad_route.get(), valhalla_exception_t);
+}
+
 // TODO: test the rest of them
 
 } // namespace
@@ -89,6 +89,27 @@ class TestBindings(unittest.TestCase):
         # C++ JSON string has no whitespace, so need to make it json-y
         self.assertEqual(json.dumps(route), json.dumps(json.loads(route_str)))
 
+    def test_batch(self):
+        query = {
+            "locations": [
+                {"lat": 52.08813, "lon": 5.03231},
+                {"lat": 52.09987, "lon": 5.14913}
+            ],
+            "costing": "auto"
+        }
+        bad_query = {"locations": [{"lat": 52.08813, "lon": 5.03231}], "costing": "auto"}
+        routes = self.actor.batch("route", [query, bad_query, json.dumps(query)])
+
+        # responses come back in request order and a bad request doesn't spoil the others
+        self.assertEqual(len(routes), 3)
+        self.assertIn('trip', routes[0])
+        self.assertIn('error_code', routes[1])
+        self.assertIsInstance(routes[2], str)
+        self.assertEqual(json.dumps(routes[0]), json.dumps(json.loads(routes[2])))
+
+        with self.assertRaises(ValueError):
+            self.actor.batch("not_an_action", [query])
+
     def test_isochrone(self):
         query = {
             "locations": [
@@ -2,12 +2,16 @@
 #include "baldr/graphreader.h"
 #include "midgard/sequence.h"
 #include "mjolnir/admin.h"
+#include "mjolnir/adminindex.h"
 #include "mjolnir/directededgebuilder.h"
+#include "mjolnir/node_expander.h"
 #include "mjolnir/osmdata.h"
 #include "mjolnir/pbfgraphparser.h"
 #include "mjolnir/util.h"
 
+#include <set>
 #include <string>
+#include <tuple>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -92,6 +96,35 @@ TEST(Graphbuilder, TestConstructEdgesSubset) {
   EXPECT_TRUE(reader.DoesTileExist(GraphId{5993698}));
 }
 
+// Test that constructing edges on several threads gives the same graph as on one thread.
+TEST(Graphbuilder, TestConstructEdgesConcurrency) {
+  auto build_edges = [](unsigned int concurrency) {
+    ptree config;
+    config.put("mjolnir.tile_dir", tile_dir);
+    config.put("mjolnir.concurrency", concurrency);
+    auto tiles =
+        GraphBuilder::BuildEdges(config, ways_file, way_nodes_file, nodes_file, edges_file);
+    sequence<Node> nodes(nodes_file, false);
+    sequence<Edge> edges(edges_file, false);
+    std::vector<std::tuple<uint64_t, uint64_t, uint32_t, uint32_t>> node_values;
+    nodes.enumerate([&node_values](const Node& node) {
+      node_values.emplace_back(node.node.osmid_, node.graph_id.value, node.start_of, node.end_of);
+    });
+    std::vector<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> edge_values;
+    edges.enumerate([&edge_values](const Edge& edge) {
+      edge_values.emplace_back(edge.wayindex_, edge.llindex_, edge.sourcenode_, edge.targetnode_);
+    });
+    return std::make_tuple(tiles, node_values, edge_values);
+  };
+
+  auto single = build_edges(1);
+  EXPECT_EQ(std::get<0>(single).size(), 4);
+  EXPECT_FALSE(std::get<2>(single).empty());
+  for (unsigned int concurrency : {2, 3, 8}) {
+    EXPECT_EQ(build_edges(concurrency), single) << "concurrency " << concurrency;
+  }
+}
+
 TEST(Graphbuilder, TestDEBuilderLength) {
 
   std::vector<PointLL> shape1{{-160.096619f, 21.997619f},
@@ -151,6 +184,40 @@ TEST(Graphbuilder, NewTimezones) {
   sqlite3_close(sql_db);
 }
 
+// The mapped timezone index finds the same timezones as querying the db
+TEST(Graphbuilder, TimezoneIndex) {
+  const std::string tz_db = VALHALLA_BUILD_DIR "test/data/tz.sqlite";
+  auto index = AdminIndex::Open(tz_db, AdminIndex::Kind::kTimezones);
+  ASSERT_NE(index, nullptr);
+  EXPECT_EQ(index->kind(), AdminIndex::Kind::kTimezones);
+  EXPECT_GT(index->size(), 0);
+
+  auto* sql_db = GetDBHandle(tz_db);
+  auto sconn = make_spatialite_cache(sql_db);
+  std::vector<AABB2<PointLL>> boxes = {{-106.450948, 31.669746, -106.386046, 31.724371},
+                                       {62.41766759, 51.37601571, 64.83104595, 52.71089583},
+                                       {-77.0, 40.0, -76.75, 40.25},
+                                       {-74.25, 40.5, -73.5, 41.0},
+                                       {5.75, 45.75, 6.5, 46.5}};
+  for (const auto& box : boxes) {
+    std::multiset<uint32_t> from_db, from_index;
+    for (const auto& poly : GetTimeZones(sql_db, box)) {
+      from_db.insert(poly.first);
+    }
+    for (const auto& poly : index->GetTimeZones(box)) {
+      from_index.insert(poly.first);
+    }
+    EXPECT_FALSE(from_db.empty());
+    EXPECT_EQ(from_index, from_db);
+  }
+  sqlite3_close(sql_db);
+
+  // the index is mapped as is while the db doesn't change
+  auto reopened = AdminIndex::Open(tz_db, AdminIndex::Kind::kTimezones);
+  ASSERT_NE(reopened, nullptr);
+  EXPECT_EQ(reopened->size(), index->size());
+}
+
 class HarrisburgTestSuiteEnv : public ::testing::Environment {
 public:
   void SetUp() override {
@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <thread>
 
 #include "baldr/connectivity_map.h"
 #include "baldr/graphreader.h"
@@ -6,6 +7,11 @@
 #include "filesystem.h"
 
 #include <fcntl.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "test.h"
 
@@ -888,6 +894,166 @@ TEST(CacheLruSoft, TrimOnExactlyFullCache) {
   CheckGraphTile(cache.Get(tile2_id), tile2_id, tile2_size);
 }
 
+#ifndef _WIN32
+TEST(SharedCache, SharedBetweenCaches) {
+  // two caches of a process share its slot of the segment, but only the tiles in the segment
+  const std::string name = "/valhalla_test_" + std::to_string(getpid());
+  shm_unlink(name.c_str());
+  {
+    const size_t size = sizeof(GraphTileHeader);
+    SharedTileCache first(name, 1024 * 1024, 1024 * 1024);
+    SharedTileCache second(name, 1024 * 1024, 1024 * 1024);
+
+    GraphId id(100, 2, 0);
+    EXPECT_FALSE(second.Contains(id));
+    EXPECT_EQ(second.Get(id), nullptr);
+    auto put = first.Put(id, graph_tile_ptr{new TestGraphTile(id, size)}, size);
+    CheckGraphTile(put, id, size);
+    EXPECT_EQ(first.Get(id), put);
+
+    // the other one reads it out of the segment without ever having loaded it
+    EXPECT_TRUE(second.Contains(id));
+    auto got = second.Get(id);
+    CheckGraphTile(got, id, size);
+    EXPECT_EQ(second.Get(id), got);
+
+    // clearing only affects the local tiles
+    first.Clear();
+    EXPECT_TRUE(first.Contains(id));
+    CheckGraphTile(first.Get(id), id, size);
+  }
+  shm_unlink(name.c_str());
+}
+
+TEST(SharedCache, OneSlotPerProcess) {
+  const std::string name = "/valhalla_test_" + std::to_string(getpid());
+  shm_unlink(name.c_str());
+  {
+    // a service has a cache per thread, far more of them than there are process slots
+    const size_t size = sizeof(GraphTileHeader);
+    std::vector<std::unique_ptr<SharedTileCache>> caches;
+    for (size_t i = 0; i < 100; ++i) {
+      caches.emplace_back(new SharedTileCache(name, 1024 * 1024, 1024 * 1024));
+    }
+
+    // which are used at once, every tile in the segment keeps its contents throughout
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 8; ++t) {
+      threads.emplace_back([&caches, t, size]() {
+        auto& cache = *caches[t];
+        for (size_t round = 0; round < 100; ++round) {
+          for (uint32_t i = 0; i < 20; ++i) {
+            GraphId id(i, 2, 0);
+            auto tile = cache.Get(id);
+            if (!tile) {
+              tile = cache.Put(id, graph_tile_ptr{new TestGraphTile(id, size)}, size);
+            }
+            CheckGraphTile(tile, id, size);
+          }
+          cache.Clear();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_TRUE(caches.back()->Contains({0, 2, 0}));
+  }
+  shm_unlink(name.c_str());
+}
+
+TEST(SharedCache, EvictsOnlyUnusedTiles) {
+  const std::string name = "/valhalla_test_" + std::to_string(getpid());
+  shm_unlink(name.c_str());
+  {
+    // a segment of this size has room for 15 tiles of one block each
+    const size_t size = sizeof(GraphTileHeader);
+    SharedTileCache cache(name, 1024 * 1024, 1024 * 1024);
+    SharedTileCache other(name, 1024 * 1024, 1024 * 1024);
+
+    // while they are all in use the tiles that don't fit are only cached locally
+    std::vector<graph_tile_ptr> tiles;
+    for (uint32_t i = 0; i < 20; ++i) {
+      GraphId id(i, 2, 0);
+      tiles.push_back(cache.Put(id, graph_tile_ptr{new TestGraphTile(id, size)}, size));
+      CheckGraphTile(tiles.back(), id, size);
+    }
+    EXPECT_TRUE(other.Contains({0, 2, 0}));
+    EXPECT_FALSE(other.Contains({19, 2, 0}));
+
+    // once nobody uses them anymore the oldest make room for new ones
+    tiles.clear();
+    cache.Clear();
+    other.Clear();
+    GraphId id(100, 2, 0);
+    cache.Put(id, graph_tile_ptr{new TestGraphTile(id, size)}, size);
+    EXPECT_TRUE(other.Contains(id));
+    EXPECT_FALSE(other.Contains({0, 2, 0}));
+    EXPECT_TRUE(other.Contains({1, 2, 0}));
+  }
+  shm_unlink(name.c_str());
+}
+
+TEST(SharedCache, ReplacedForAnotherTileset) {
+  const std::string name = "/valhalla_test_" + std::to_string(getpid());
+  shm_unlink(name.c_str());
+  {
+    const size_t size = sizeof(GraphTileHeader);
+    SharedTileCache old_tiles(name, 1024 * 1024, 1024 * 1024, 1);
+    GraphId id(100, 2, 0);
+    old_tiles.Put(id, graph_tile_ptr{new TestGraphTile(id, size)}, size);
+    old_tiles.Clear();
+
+    // a process of another tileset gets a segment of its own under the same name
+    SharedTileCache new_tiles(name, 1024 * 1024, 1024 * 1024, 2);
+    EXPECT_FALSE(new_tiles.Contains(id));
+    GraphId other_id(200, 2, 0);
+    new_tiles.Put(other_id, graph_tile_ptr{new TestGraphTile(other_id, size)}, size);
+    SharedTileCache more_new_tiles(name, 1024 * 1024, 1024 * 1024, 2);
+    EXPECT_TRUE(more_new_tiles.Contains(other_id));
+    EXPECT_FALSE(more_new_tiles.Contains(id));
+
+    // while the ones still using the old segment keep their tiles
+    CheckGraphTile(old_tiles.Get(id), id, size);
+  }
+  shm_unlink(name.c_str());
+}
+
+TEST(SharedCache, ReclaimsTilesOfDeadProcesses) {
+  const std::string name = "/valhalla_test_" + std::to_string(getpid());
+  shm_unlink(name.c_str());
+  {
+    const size_t size = sizeof(GraphTileHeader);
+    SharedTileCache cache(name, 1024 * 1024, 1024 * 1024);
+
+    // another process fills the segment and dies while it still holds all of the tiles
+    pid_t child = fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+      SharedTileCache filler(name, 1024 * 1024, 1024 * 1024);
+      std::vector<graph_tile_ptr> tiles;
+      for (uint32_t i = 0; i < 15; ++i) {
+        GraphId id(i, 2, 0);
+        tiles.push_back(filler.Put(id, graph_tile_ptr{new TestGraphTile(id, size)}, size));
+      }
+      _exit(0);
+    }
+    int status;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    EXPECT_TRUE(cache.Contains({0, 2, 0}));
+
+    // its tiles are reclaimed to make room for new ones
+    GraphId id(100, 2, 0);
+    cache.Put(id, graph_tile_ptr{new TestGraphTile(id, size)}, size);
+    SharedTileCache other(name, 1024 * 1024, 1024 * 1024);
+    EXPECT_TRUE(other.Contains(id));
+    EXPECT_FALSE(other.Contains({0, 2, 0}));
+    EXPECT_TRUE(other.Contains({1, 2, 0}));
+  }
+  shm_unlink(name.c_str());
+}
+#endif
+
 } // namespace
 
 int main(int argc, char* argv[]) {
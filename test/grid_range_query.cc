@@ -3,6 +3,7 @@
 #include "midgard/linesegment2.h"
 #include "midgard/pointll.h"
 
+#include "meili/candidate_search.h"
 #include "meili/grid_range_query.h"
 
 #include "test.h"
@@ -68,6 +69,58 @@ TEST(GridRangeQuery, TestQuery) {
   EXPECT_NE(items.find(0), items.end()) << "query should get item 0";
 }
 
+TEST(GridRangeQuery, TestSharedCacheEviction) {
+  using grid_t = meili::CandidateGridCache::grid_t;
+  auto make_grid = [](int segments) {
+    auto grid = std::make_shared<grid_t>(BoundingBox(0, 0, 10, 10), 1.f, 1.f);
+    for (int i = 0; i < segments; ++i) {
+      grid->AddLineSegment(baldr::GraphId(i, 2, 0), LineSegment({0, 0.5f + i}, {10, 0.5f + i}));
+    }
+    return std::shared_ptr<const grid_t>(grid);
+  };
+  auto make_key = [](int32_t bin_index) {
+    return meili::CandidateGridCache::Key{"tiles", 1, baldr::GraphId(0, 2, 0).value, bin_index,
+                                          1.f, 1.f};
+  };
+
+  // room for two grids but not three
+  const auto grid_bytes = make_grid(5)->MemoryUsage();
+  meili::CandidateGridCache cache(grid_bytes * 2 + grid_bytes / 2);
+  auto a = cache.Insert(make_key(0), make_grid(5));
+  auto b = cache.Insert(make_key(1), make_grid(5));
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_LE(cache.bytes(), cache.max_bytes());
+
+  // the first one inserted for a key wins
+  EXPECT_EQ(cache.Insert(make_key(0), make_grid(5)), a);
+
+  // touch the first so the second is the least recently used
+  EXPECT_EQ(cache.Find(make_key(0)), a);
+  auto c = cache.Insert(make_key(2), make_grid(5));
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.Find(make_key(0)), a);
+  EXPECT_EQ(cache.Find(make_key(1)), nullptr);
+  EXPECT_EQ(cache.Find(make_key(2)), c);
+
+  // evicted grids are still usable by whoever holds them
+  EXPECT_EQ(b->Query(BoundingBox(0, 0, 10, 10)).size(), 5);
+
+  // a different tileset doesn't get the grids of another one
+  auto key = make_key(0);
+  key.tileset = "other_tiles";
+  EXPECT_EQ(cache.Find(key), nullptr);
+
+  // a grid too big for the cache is handed back but not cached
+  meili::CandidateGridCache tiny(grid_bytes / 2);
+  auto big = make_grid(5);
+  EXPECT_EQ(tiny.Insert(make_key(0), big), big);
+  EXPECT_EQ(tiny.size(), 0);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.bytes(), 0);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,163 @@
+#include "gurka.h"
+#include "test.h"
+
+#include "baldr/compression_utils.h"
+#include "baldr/graphtile.h"
+#include "baldr/tilehierarchy.h"
+#include "mjolnir/osmchange.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+using namespace valhalla;
+using namespace valhalla::baldr;
+
+const std::string workdir = "test/data/gurka_elevation_reuse";
+
+const std::string osc = R"(<?xml version="1.0" encoding="UTF-8"?>
+<osmChange version="0.6" generator="test">
+  <create>
+    <node id="10" version="1" user="a>b" lat="40.1" lon="-76.9"/>
+  </create>
+  <modify>
+    <way id="100" version="2">
+      <nd ref="1"/>
+      <nd ref="2"/>
+      <tag k="name" v="a > b"/>
+    </way>
+    <relation id="1000" version="2">
+      <member type="way" ref="300" role="from"/>
+      <member type="node" ref="3" role="via"/>
+      <tag k="type" v="restriction"/>
+    </relation>
+  </modify>
+  <delete>
+    <node id="11" version="3"/>
+    <way id="200" version="4"/>
+  </delete>
+</osmChange>
+)";
+
+void check_change(const mjolnir::OSMChange& change) {
+  EXPECT_EQ(change.nodes, (std::unordered_set<uint64_t>{10, 11}));
+  EXPECT_EQ(change.ways, (std::unordered_set<uint64_t>{100, 200, 300}));
+  EXPECT_EQ(change.relations, (std::unordered_set<uint64_t>{1000}));
+  ASSERT_EQ(change.locations.size(), 1);
+  EXPECT_NEAR(change.locations.front().lng(), -76.9, 1e-7);
+  EXPECT_NEAR(change.locations.front().lat(), 40.1, 1e-7);
+}
+
+TEST(ElevationReuse, ReadChange) {
+  std::filesystem::create_directories(workdir);
+  {
+    std::ofstream file(workdir + "/change.osc", std::ios::trunc);
+    file << osc;
+  }
+  check_change(mjolnir::OSMChange::Read(workdir + "/change.osc"));
+
+  // the same change gzipped
+  std::string src = osc, deflated;
+  auto src_func = [&src](z_stream& s) -> int {
+    s.next_in = static_cast<Byte*>(static_cast<void*>(&src[0]));
+    s.avail_in = static_cast<unsigned int>(src.size());
+    return Z_FINISH;
+  };
+  auto dst_func = [&deflated](z_stream& s) -> void {
+    auto size = deflated.size();
+    if (s.total_out < size) {
+      deflated.resize(s.total_out);
+    } else {
+      deflated.resize(size + 16);
+      s.next_out = static_cast<Byte*>(static_cast<void*>(&deflated[0] + size));
+      s.avail_out = 16;
+    }
+  };
+  ASSERT_TRUE(baldr::deflate(src_func, dst_func));
+  {
+    std::ofstream file(workdir + "/change.osc.gz", std::ios::binary | std::ios::trunc);
+    file << deflated;
+  }
+  check_change(mjolnir::OSMChange::Read(workdir + "/change.osc.gz"));
+
+  EXPECT_THROW(mjolnir::OSMChange::Read(workdir + "/missing.osc"), std::runtime_error);
+}
+
+// writes an srtm tile at N40W077 with the given height function of the pixel location
+template <class Height> void write_hgt(const std::string& dir, const Height& height) {
+  std::vector<int16_t> tile(3601 * 3601, 0);
+  for (size_t i = 0; i < 3601; ++i) {
+    for (size_t j = 0; j < 3601; ++j) {
+      double lon = (static_cast<double>(j) / 3601) - 77;
+      double lat = (static_cast<double>(i) / 3601) + 40;
+      int16_t h = height(lon, lat);
+      // srtm tiles are big endian
+      tile[i * 3601 + j] = ((h & 0xFF) << 8) | ((h >> 8) & 0xFF);
+    }
+  }
+  std::filesystem::create_directories(dir);
+  std::ofstream file(dir + "/N40W077.hgt", std::ios::binary | std::ios::trunc);
+  file.write(static_cast<const char*>(static_cast<void*>(tile.data())),
+             sizeof(int16_t) * tile.size());
+}
+
+TEST(ElevationReuse, AffectedTilesKeepPreviousElevation) {
+  // two roads far enough apart to land in different local tiles
+  const gurka::nodelayout layout = {
+      {"A", {-76.90, 40.10}},
+      {"B", {-76.89, 40.10}},
+      {"C", {-76.10, 40.90}},
+      {"D", {-76.09, 40.90}},
+  };
+  const gurka::ways ways = {
+      {"AB", {{"highway", "residential"}, {"osm_id", "100"}}},
+      {"CD", {{"highway", "residential"}, {"osm_id", "200"}}},
+  };
+
+  // the previous build samples a slope
+  write_hgt(workdir + "/dem_previous",
+            [](double lon, double lat) { return (lon + 77) * 1000 + (lat - 40) * 1000; });
+  auto previous_config = test::make_config(workdir + "/previous",
+                                           {{"additional_data.elevation",
+                                             workdir + "/dem_previous"}});
+  gurka::buildtiles(layout, ways, {}, {}, previous_config);
+
+  // the current build has a flat elevation model, which only the changed road gets to sample
+  write_hgt(workdir + "/dem_current", [](double, double) { return 100; });
+  {
+    std::ofstream file(workdir + "/current.osc", std::ios::trunc);
+    file << R"(<osmChange version="0.6"><modify><way id="100" version="2"/></modify></osmChange>)";
+  }
+  auto current_config =
+      test::make_config(workdir + "/current",
+                        {{"additional_data.elevation", workdir + "/dem_current"},
+                         {"mjolnir.previous_build.tile_dir", workdir + "/previous"},
+                         {"mjolnir.previous_build.osc", workdir + "/current.osc"}});
+  auto map = gurka::buildtiles(layout, ways, {}, {}, current_config);
+
+  // the tiles of the changed road and their hierarchy parents are listed
+  std::ifstream file(workdir + "/current/affected_tiles.txt");
+  std::unordered_set<std::string> listed;
+  for (std::string line; std::getline(file, line);) {
+    listed.insert(line);
+  }
+  for (uint8_t level = 0; level <= 2; ++level) {
+    auto tile_id = TileHierarchy::GetGraphId(layout.at("A"), level);
+    EXPECT_TRUE(listed.count(GraphTile::FileSuffix(tile_id))) << "level " << std::to_string(level);
+  }
+  EXPECT_FALSE(listed.count(GraphTile::FileSuffix(TileHierarchy::GetGraphId(layout.at("C"), 2))));
+
+  // the changed road is sampled again, the other one keeps its previous elevation
+  GraphReader previous_reader(previous_config.get_child("mjolnir"));
+  GraphReader current_reader(map.config.get_child("mjolnir"));
+  auto mean_elevation = [&layout](GraphReader& reader, const std::string& from,
+                                  const std::string& to) {
+    auto edge = gurka::findEdgeByNodes(reader, layout, from, to);
+    return reader.GetGraphTile(std::get<0>(edge))->edgeinfo(std::get<1>(edge)).mean_elevation();
+  };
+  EXPECT_NEAR(mean_elevation(current_reader, "A", "B"), 100, 2);
+  EXPECT_GT(mean_elevation(previous_reader, "C", "D"), 1000);
+  EXPECT_EQ(mean_elevation(current_reader, "C", "D"),
+            mean_elevation(previous_reader, "C", "D"));
+}
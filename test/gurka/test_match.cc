@@ -343,3 +343,49 @@ TEST(MapMatchRoute, IgnoreRestrictions) {
                                  {{"/costing_options/auto/ignore_restrictions", "1"}});
   gurka::assert::raw::expect_path(result, {"AB", "BC"});
 }
+
+TEST(MapMatch, ReusedRoutesAgreeWithFreshSearches) {
+  const std::string ascii_map = "xyzA--1-----B";
+  const gurka::ways ways = {{"AB", {{"highway", "primary"}}}};
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 10);
+  const auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/match_reused_routes");
+
+  // past the end of the road the trace keeps being snapped to A, the columns of those points have
+  // the same candidates so the searches between them can be reused if they have the same bounds
+  auto match = [&](const std::vector<double>& times) {
+    std::string shape;
+    const std::vector<std::string> points{"1", "z", "y", "x", "y"};
+    for (size_t i = 0; i < points.size(); ++i) {
+      const auto& point = layout.at(points[i]);
+      shape += std::string(i ? "," : "") + R"({"lon":)" + std::to_string(point.lng()) +
+               R"(,"lat":)" + std::to_string(point.lat()) + R"(,"time":)" +
+               std::to_string(times[i]) + "}";
+    }
+    std::string json;
+    gurka::do_action(Options::trace_attributes, map,
+                     R"({"costing":"auto","shape_match":"map_snap",)"
+                     R"("trace_options":{"interpolation_distance":0},"shape":[)" +
+                         shape + "]}",
+                     {}, &json);
+    rapidjson::Document result;
+    result.Parse(json.c_str());
+    EXPECT_FALSE(result.HasParseError());
+    std::vector<std::string> matches;
+    for (const auto& edge : result["edges"].GetArray()) {
+      matches.push_back(std::to_string(edge["id"].GetUint64()));
+    }
+    for (const auto& point : result["matched_points"].GetArray()) {
+      matches.push_back(std::string(point["type"].GetString()) + " " +
+                        std::to_string(point["edge_index"].GetUint()) + " " +
+                        std::to_string(point["distance_along_edge"].GetDouble()));
+    }
+    return matches;
+  };
+
+  // with equal gaps the routes of the middle columns are reused while the last search, whose time
+  // bound is much tighter, is done afresh. with gaps that all differ every search is done afresh
+  const auto reused = match({0, 10, 20, 30, 31});
+  const auto fresh = match({0, 10, 21, 33, 34});
+  ASSERT_FALSE(reused.empty());
+  EXPECT_EQ(reused, fresh);
+}
@@ -3,6 +3,8 @@
 #include <valhalla/midgard/encoded.h>
 #include <valhalla/thor/matrixalgorithm.h>
 
+#include <cstring>
+
 #include <gtest/gtest.h>
 
 using namespace valhalla;
@@ -916,3 +918,60 @@ TEST(StandAlone, HGVNoAccessPenalty) {
     }
   }
 }
+
+TEST(StandAlone, BinaryMatrix) {
+  const std::string ascii_map = R"(
+    A---B---C
+    |       |
+    D---E---F
+  )";
+  const gurka::ways ways = {
+      {"AB", {{"highway", "residential"}}}, {"BC", {{"highway", "residential"}}},
+      {"AD", {{"highway", "residential"}}}, {"CF", {{"highway", "residential"}}},
+      {"DE", {{"highway", "residential"}}}, {"EF", {{"highway", "residential"}}},
+  };
+  auto layout = gurka::detail::map_to_coordinates(ascii_map, 1000);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, VALHALLA_BUILD_DIR "test/data/matrix_binary");
+
+  // reads a little endian value out of the response
+  auto read = [](const std::string& bytes, size_t offset, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i)
+      value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[offset + i])) << (8 * i);
+    return value;
+  };
+  auto read_float = [&read](const std::string& bytes, size_t offset) {
+    uint32_t bits = read(bytes, offset, 4);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  };
+
+  for (bool quantize : {false, true}) {
+    std::unordered_map<std::string, std::string> options = {{"/format", "binary"},
+                                                            {"/quantize", quantize ? "1" : "0"}};
+    std::string res;
+    auto api = gurka::do_action(valhalla::Options::sources_to_targets, map, {"A", "C"},
+                                {"D", "E", "F"}, "auto", options, nullptr, &res);
+    const auto& matrix = api.matrix();
+    size_t cell = quantize ? 2 : 4;
+    size_t cells = 6;
+
+    ASSERT_EQ(res.size(), 24 + 2 * cell * cells);
+    EXPECT_EQ(res.substr(0, 4), "VMTX");
+    EXPECT_EQ(read(res, 4, 2), 1);
+    EXPECT_EQ(read(res, 6, 2), quantize ? 1 : 0);
+    EXPECT_EQ(read(res, 8, 4), 2);
+    EXPECT_EQ(read(res, 12, 4), 3);
+    auto time_scale = read_float(res, 16);
+    auto distance_scale = read_float(res, 20);
+
+    // the cells are the same values the json serializer writes, times are whole seconds
+    for (size_t i = 0; i < cells; ++i) {
+      auto time = read(res, 24 + i * cell, cell) * time_scale;
+      auto distance = read(res, 24 + (cells + i) * cell, cell) * distance_scale;
+      EXPECT_NEAR(time, matrix.times(i), quantize ? time_scale : 1.f);
+      EXPECT_NEAR(distance, matrix.distances(i), quantize ? distance_scale : 0.f);
+    }
+  }
+}
@@ -84,17 +84,22 @@ void assert_tile_equalish(const GraphTile& a, const GraphTile& b) {
   }
 }
 
-// 1. build tiles with the same input twice
+// 1. build tiles with the same input twice, optionally with different options each time
 // 2. check that the same tile sets are generated
 struct ReproducibleBuild : ::testing::Test {
-  void BuildTiles(const std::string& ascii_map, const gurka::ways& ways, const double gridsize) {
-    const auto build_tiles = [&](const std::string& dir) -> gurka::map {
+  void BuildTiles(const std::string& ascii_map,
+                  const gurka::ways& ways,
+                  const double gridsize,
+                  const std::unordered_map<std::string, std::string>& first_options = {},
+                  const std::unordered_map<std::string, std::string>& second_options = {}) {
+    const auto build_tiles = [&](const std::string& dir,
+                                 const std::unordered_map<std::string, std::string>& options) {
       const gurka::nodelayout layout = gurka::detail::map_to_coordinates(ascii_map, gridsize);
       const std::string workdir = "test/data/gurka_reproduce_tile_build/" + dir;
-      return gurka::buildtiles(layout, ways, {}, {}, workdir, {});
+      return gurka::buildtiles(layout, ways, {}, {}, workdir, options);
     };
-    const gurka::map first_map = build_tiles("1");
-    const gurka::map second_map = build_tiles("2");
+    const gurka::map first_map = build_tiles("1", first_options);
+    const gurka::map second_map = build_tiles("2", second_options);
 
     baldr::GraphReader first_reader(first_map.config.get_child("mjolnir"));
     baldr::GraphReader second_reader(second_map.config.get_child("mjolnir"));
@@ -155,3 +160,44 @@ TEST_F(ReproducibleBuild, BigGridSize) {
                             {"EH", {{"highway", "path"}}}};
   BuildTiles(ascii_map, ways, 100000);
 }
+
+TEST_F(ReproducibleBuild, ParallelHierarchyAndShortcuts) {
+  const std::string ascii_map = R"(
+    A--B--C--D--E--F
+    |     |     |
+    G--H--I--J--K--L
+    |     |     |
+    M--N--O--P--Q--R)";
+
+  // the motorways and trunks become shortcuts on the upper levels and the whole map spans a
+  // handful of tiles so the hierarchy and shortcut builders have work for several threads
+  const gurka::ways ways = {{"ABCDEF", {{"highway", "motorway"}}},
+                            {"GHIJKL", {{"highway", "trunk"}}},
+                            {"MNOPQR", {{"highway", "primary"}}},
+                            {"AGM", {{"highway", "residential"}}},
+                            {"CIO", {{"highway", "secondary"}}},
+                            {"EKQ", {{"highway", "tertiary"}}}};
+  BuildTiles(ascii_map, ways, 25000, {{"mjolnir.concurrency", "1"}}, {{"mjolnir.concurrency", "4"}});
+}
+
+TEST_F(ReproducibleBuild, ParallelFilterAndAggregate) {
+  const std::string ascii_map = R"(
+    M         P         R
+    |         |         |
+    A----B----C----D----E----F----G
+         |         |         |
+         N         O         Q)";
+
+  // the footways are filtered which leaves the residential way split at B, D and F so those
+  // nodes get aggregated, the map spans several local tiles to keep multiple threads busy
+  const gurka::ways ways = {{"ABCDEFG", {{"highway", "residential"}, {"osm_id", "100"}}},
+                            {"BN", {{"highway", "footway"}, {"foot", "yes"}}},
+                            {"DO", {{"highway", "footway"}, {"foot", "yes"}}},
+                            {"FQ", {{"highway", "footway"}, {"foot", "yes"}}},
+                            {"AM", {{"highway", "residential"}}},
+                            {"CP", {{"highway", "residential"}}},
+                            {"ER", {{"highway", "residential"}}}};
+  BuildTiles(ascii_map, ways, 5000,
+             {{"mjolnir.concurrency", "1"}, {"mjolnir.include_pedestrian", "false"}},
+             {{"mjolnir.concurrency", "4"}, {"mjolnir.include_pedestrian", "false"}});
+}
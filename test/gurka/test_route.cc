@@ -810,6 +810,47 @@ TEST(MultipointRoute, WithPointsOnDeadends) {
   }
 }
 
+TEST(MultipointRoute, ParallelDirections) {
+  const std::string ascii_map = R"(
+    A-1--B--2--C
+    |          |
+    6          3
+    |          |
+    F--5--E-4--D
+  )";
+
+  const gurka::ways ways = {
+      {"AB", {{"highway", "primary"}, {"name", "AB"}}},
+      {"BC", {{"highway", "primary"}, {"name", "BC"}}},
+      {"CD", {{"highway", "primary"}, {"name", "CD"}}},
+      {"DE", {{"highway", "primary"}, {"name", "DE"}}},
+      {"EF", {{"highway", "primary"}, {"name", "EF"}}},
+      {"FA", {{"highway", "primary"}, {"name", "FA"}}},
+  };
+  const auto layout = gurka::detail::map_to_coordinates(ascii_map, 100);
+  auto map = gurka::buildtiles(layout, ways, {}, {}, "test/data/multipoint_parallel_directions",
+                               {{"odin.concurrency", "4"}});
+  auto serial_map = map;
+  serial_map.config.put("odin.concurrency", 1);
+
+  // the legs are narrated on several threads but come back in the order of the locations
+  const std::vector<std::string> waypoints = {"1", "2", "3", "4", "5", "6", "1"};
+  auto parallel = gurka::do_action(valhalla::Options::route, map, waypoints, "auto");
+  auto serial = gurka::do_action(valhalla::Options::route, serial_map, waypoints, "auto");
+  gurka::assert::raw::expect_path(parallel, {"AB", "BC", "BC", "CD", "CD", "DE", "DE", "EF", "EF",
+                                             "FA", "FA", "AB"});
+
+  const auto& legs = parallel.directions().routes(0).legs();
+  const auto& serial_legs = serial.directions().routes(0).legs();
+  ASSERT_EQ(legs.size(), waypoints.size() - 1);
+  ASSERT_EQ(legs.size(), serial_legs.size());
+  for (int i = 0; i < legs.size(); ++i) {
+    EXPECT_EQ(legs.Get(i).SerializeAsString(), serial_legs.Get(i).SerializeAsString());
+    EXPECT_EQ(legs.Get(i).maneuver(0).street_name(0).value(),
+              parallel.trip().routes(0).legs(i).node(0).edge().name(0).value());
+  }
+}
+
 // prove that non-bidir A* algorithms allow destination-only routing in their first pass
 TEST(AlgorithmTestDest, TestAlgoSwapAndDestOnly) {
   constexpr double gridsize = 100;
@@ -2,7 +2,9 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <limits>
 #include <unordered_set>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -42,20 +44,46 @@ TEST(UnorderedIdTable, Random) {
   }
 }
 
-TEST(UnorderedIdTable, SerializeDeserialize) {
-  uint64_t node_count = 1300000000; // this is about how many there are in real life
-  node_count = 1000;
+TEST(UnorderedIdTable, Freeze) {
+  // sparse ids, some of them beyond 12 billion
+  std::vector<uint64_t> ids;
+  for (uint64_t i = 0; i < kTableSize; ++i) {
+    ids.push_back((static_cast<uint64_t>(rand()) * 7919) % 13000000000);
+  }
+  ids.push_back(0);
+  ids.push_back(4095);
+  ids.push_back(4096);
+
+  UnorderedIdTable t(kTableSize);
+  std::unordered_set<uint64_t> set;
+  for (auto id : ids) {
+    t.set(id);
+    set.insert(id);
+  }
+  t.freeze();
+  for (auto id : ids) {
+    EXPECT_TRUE(t.get(id));
+    EXPECT_EQ(t.get(id + 1), set.count(id + 1) > 0);
+  }
+  EXPECT_FALSE(t.get(std::numeric_limits<uint64_t>::max()));
 
-  UnorderedIdTable a(node_count);
-  for (uint64_t i = 0; i < node_count; ++i) {
-    a.set(i * 2);
-    EXPECT_FALSE(a.get(i * 2 - 1));
-    EXPECT_TRUE(a.get(i * 2));
+  // the frozen table holds the same ids as one that never was and thaws when set again
+  UnorderedIdTable m(kTableSize);
+  for (auto id : ids) {
+    m.set(id);
   }
-  a.serialize("foo.bar");
-  UnorderedIdTable b(node_count);
-  b.deserialize("foo.bar");
-  EXPECT_EQ(a, b);
+  EXPECT_EQ(t, m);
+  EXPECT_FALSE(t.get(1));
+  t.set(1);
+  EXPECT_TRUE(t.get(1));
+  for (auto id : ids) {
+    EXPECT_TRUE(t.get(id));
+  }
+
+  // an empty table freezes too
+  UnorderedIdTable e(kTableSize);
+  e.freeze();
+  EXPECT_FALSE(e.get(0));
 }
 
 int main(int argc, char* argv[]) {
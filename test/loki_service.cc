@@ -581,6 +581,30 @@ TEST(LokiService, test_actions_whitelist) {
   }
 }
 
+TEST(LokiService, test_admission) {
+  // the bounds apply to each process whether or not the stages run in it
+  for (bool in_process : {true, false}) {
+    // a matrix of 3 by 2 is more than the 4 the config allows in flight
+    auto cfg = make_config();
+    cfg.put("httpd.service.in_process", in_process);
+    cfg.put("httpd.service.admission.sources_to_targets", 4);
+    loki::loki_worker_t worker(cfg);
+
+    http_request_info_t info{};
+    http_request_t request(method_t::POST, "/sources_to_targets",
+                           R"({"sources":[{"lat":1,"lon":2},{"lat":3,"lon":4},{"lat":5,"lon":6}],
+                           "targets":[{"lat":1,"lon":2},{"lat":3,"lon":4}],"costing":"auto"})");
+    auto req_str = request.to_string();
+    auto msg = zmq::message_t{reinterpret_cast<void*>(&req_str.front()), req_str.size(),
+                              [](void*, void*) {}};
+    auto result = worker.work({msg}, reinterpret_cast<void*>(&info), []() {});
+    worker.cleanup();
+
+    EXPECT_FALSE(result.intermediate);
+    EXPECT_NE(result.messages.front().find(R"("error_code":105)"), std::string::npos);
+  }
+}
+
 TEST(LokiService, test_hierarchy_warning) {
   // all actions involving disable_hierarchy_pruning
   const std::vector<Options_Action> actions{Options_Action_route, Options_Action_sources_to_targets};
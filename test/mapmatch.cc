@@ -231,6 +231,22 @@ TEST(Mapmatch, test_matcher) {
          " != " + std::to_string(walked_shape.size()) + "\n" + encoded_shape +
          "\n" + walked_encoded_shape;*/
 
+    // re-hydrating the walked route from its edge ids gives the same edges
+    {
+      std::string edge_ids;
+      for (const auto& edge : walked.get_child("edges")) {
+        edge_ids += (edge_ids.empty() ? "" : ",") + edge.second.get<std::string>("id");
+      }
+      auto looked_up = test::json_to_pt(actor.trace_attributes(
+          R"({"date_time":{"type":1,"value":"2019-10-31T18:30"},"costing":"auto","shape_match":"edge_walk","encoded_polyline":")" +
+          json_escape(encoded_shape) + R"(","edge_ids":[)" + edge_ids + "]}"));
+      std::string looked_up_ids;
+      for (const auto& edge : looked_up.get_child("edges")) {
+        looked_up_ids += (looked_up_ids.empty() ? "" : ",") + edge.second.get<std::string>("id");
+      }
+      EXPECT_EQ(looked_up_ids, edge_ids);
+    }
+
     // build up some gps segments for simulation from the real shape
     std::vector<uint64_t> walked_edges;
     std::vector<gps_segment_t> segments;
@@ -607,6 +623,17 @@ TEST(Mapmatch, test_trace_route_edge_walk_expected_error_code) {
   FAIL() << "Expected trace_route edge_walk exception was not found";
 }
 
+TEST(Mapmatch, test_edge_walk_invalid_edge_ids) {
+  tyr::actor_t actor(conf, true);
+  for (const auto* edge_ids : {R"("edge_ids":"1,2")", R"("edge_ids":[1,-2])"}) {
+    try {
+      actor.trace_route(R"({"costing":"auto","shape_match":"edge_walk",)" + std::string(edge_ids) +
+                        R"(,"shape":[{"lat":52.088548,"lon":5.15357},{"lat":52.08851,"lon":5.15249}]})");
+      FAIL() << "Expected invalid edge_ids to be rejected";
+    } catch (const valhalla_exception_t& e) { EXPECT_EQ(e.code, 166); }
+  }
+}
+
 TEST(Mapmatch, test_trace_route_map_snap_expected_error_code) {
   // tests expected error_code for trace_route edge_walk
   auto expected_error_code = 442;
@@ -12,7 +12,13 @@ const auto fake_config = test::json_to_pt(R"({
     "mode": "auto",
     "grid": {
       "cache_size": 100500,
-      "size": 100
+      "size": 100,
+      "shared_cache_size": 1000000
+    },
+    "viterbi": {
+      "fixed_lag": true,
+      "beam_width": 8,
+      "beam_cost_margin": 50
     },
     "default": {
       "beta": 5,
@@ -39,6 +45,7 @@ TEST(MapmatchConfig, check_read_all_params) {
   EXPECT_EQ(candidate_search.max_search_radius_meters, 500.f);
   EXPECT_EQ(candidate_search.grid_size, 100);
   EXPECT_EQ(candidate_search.cache_size, 100500);
+  EXPECT_EQ(candidate_search.shared_cache_size, 1000000);
 
   // check transition params
   const auto& transition = config.transition_cost;
@@ -60,6 +67,12 @@ TEST(MapmatchConfig, check_read_all_params) {
   const auto& routing = config.routing;
   EXPECT_EQ(routing.interpolation_distance_meters, 5.f);
   EXPECT_FALSE(routing.is_interpolation_distance_customizable);
+
+  // check viterbi params
+  const auto& viterbi = config.viterbi;
+  EXPECT_TRUE(viterbi.fixed_lag);
+  EXPECT_EQ(viterbi.beam_width, 8);
+  EXPECT_EQ(viterbi.beam_cost_margin, 50.f);
 }
 
 TEST(MapmatchConfig, validate_candidate_search_params) {
@@ -124,6 +137,17 @@ TEST(MapmatchConfig, validate_routing_params) {
   EXPECT_THROW(config.Read(pt), std::exception);
 }
 
+TEST(MapmatchConfig, validate_viterbi_params) {
+  valhalla::meili::Config config;
+
+  auto pt = fake_config;
+  pt.put<float>("viterbi.beam_cost_margin", 0.f);
+  EXPECT_NO_THROW(config.Read(pt));
+
+  pt.put<float>("viterbi.beam_cost_margin", -1.f);
+  EXPECT_THROW(config.Read(pt), std::exception);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
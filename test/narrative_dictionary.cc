@@ -1340,6 +1340,30 @@ TEST(NarrativeDictionary, test_en_US_approach_verbal_alert) {
   validate(us_customary_lengths, kExpectedUsCustomaryLengths);
 }
 
+TEST(NarrativeDictionary, test_en_US_phrase_templates) {
+  const NarrativeDictionary& dictionary = GetNarrativeDictionary("en-US");
+
+  // every phrase has a template that renders back to the phrase without values
+  std::string instruction;
+  for (const auto& phrase : dictionary.destination_subset.phrases) {
+    const auto& phrase_template = dictionary.destination_subset.phrase(std::stoul(phrase.first));
+    phrase_template.Render(instruction);
+    validate(instruction, phrase.second);
+  }
+
+  // "3": "<DESTINATION> is on the <RELATIVE_DIRECTION>."
+  dictionary.destination_subset.phrase(3).Render(instruction, {{kRelativeDirectionTag, "left"},
+                                                               {kDestinationTag, "Main Street"}});
+  validate(instruction, "Main Street is on the left.");
+
+  // the same tag more than once and a tag without a value
+  PhraseTemplate phrase_template("<STREET_NAMES> <NOT_A_TAG <STREET_NAMES> <LENGTH>>");
+  phrase_template.Render(instruction, {{kStreetNamesTag, "A1"}});
+  validate(instruction, "A1 <NOT_A_TAG A1 <LENGTH>>");
+
+  EXPECT_THROW(dictionary.destination_subset.phrase(42), std::out_of_range);
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
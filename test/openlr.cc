@@ -4,6 +4,7 @@
 #include <string>
 
 #include "baldr/openlr.h"
+#include "baldr/rapidjson_utils.h"
 #include "midgard/encoded.h"
 #include "midgard/pointll.h"
 #include "proto/common.pb.h"
@@ -281,20 +282,22 @@ TripLeg CreateLeg(const std::vector<PointLL>& points) {
 
 std::vector<OpenLR::OpenLr> LegToOpenLrs(TripLeg&& leg) {
   // gin up a route/request for it
-  valhalla::Options options;
+  valhalla::Api api;
+  auto& options = *api.mutable_options();
   options.set_action(Options::route);
   options.set_linear_references(true);
-  valhalla::TripRoute route;
-  route.mutable_legs()->Add()->Swap(&leg);
-  baldr::json::MapPtr container = baldr::json::map({});
+  api.mutable_trip()->mutable_routes()->Add()->mutable_legs()->Add()->Swap(&leg);
 
   // serialize some b64 encoded openlrs and get them back out as openlr objects
-  tyr::route_references(container, route, options);
-  auto references = boost::get<baldr::json::ArrayPtr>(container->find("linear_references")->second);
+  rapidjson::writer_wrapper_t writer;
+  writer.start_object();
+  tyr::openlr(api, 0, writer);
+  writer.end_object();
+  rapidjson::Document container;
+  container.Parse(writer.get_buffer());
   std::vector<OpenLR::OpenLr> openlrs;
-  for (const auto& reference : *references) {
-    auto b64 = boost::get<std::string>(reference);
-    openlrs.emplace_back(b64, true);
+  for (const auto& reference : container["linear_references"].GetArray()) {
+    openlrs.emplace_back(reference.GetString(), true);
   }
 
   return openlrs;
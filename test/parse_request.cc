@@ -1649,6 +1649,87 @@ void create_costing_options(Options& options, Costing::Type type) {
   sif::ParseCosting(doc, "/costing_options", options);
 }
 
+TEST(ParseRequest, test_reused_parse_buffers) {
+  // the json buffer and value pool are reused by every parse on the thread, the requests must not
+  // leak into each other nor keep pointing into the buffer once parsed
+  google::protobuf::Arena arena;
+  auto& first = *google::protobuf::Arena::CreateMessage<Api>(&arena);
+  ParseApi(R"({"locations":[{"lat":52.1,"lon":5.1,"name":"a rather long name for the first"},
+    {"lat":52.2,"lon":5.2}],"costing":"auto","id":"first"})",
+           Options::route, first);
+  Api second;
+  ParseApi(R"({"locations":[{"lat":1,"lon":2},{"lat":3,"lon":4}],"costing":"pedestrian"})",
+           Options::route, second);
+
+  EXPECT_EQ(first.options().id(), "first");
+  EXPECT_EQ(first.options().locations(0).name(), "a rather long name for the first");
+  EXPECT_EQ(first.options().costing_type(), Costing::auto_);
+  EXPECT_EQ(second.options().id(), "");
+  EXPECT_EQ(second.options().locations(0).name(), "");
+  EXPECT_EQ(second.options().costing_type(), Costing::pedestrian);
+  EXPECT_EQ(second.options().locations(1).ll().lat(), 3);
+}
+
+TEST(ParseRequest, test_admission_estimate) {
+  Api matrix;
+  ParseApi(R"({"sources":[{"lat":1,"lon":2},{"lat":3,"lon":4},{"lat":5,"lon":6}],
+    "targets":[{"lat":1,"lon":2},{"lat":3,"lon":4}],"costing":"auto"})",
+           Options::sources_to_targets, matrix);
+  EXPECT_EQ(admission_t::estimate(matrix.options()), 6);
+
+  Api isochrone;
+  ParseApi(R"({"locations":[{"lat":1,"lon":2}],"costing":"auto",
+    "contours":[{"time":15},{"time":29.5}]})",
+           Options::isochrone, isochrone);
+  EXPECT_EQ(admission_t::estimate(isochrone.options()), 30);
+
+  Api route;
+  ParseApi(R"({"locations":[{"lat":1,"lon":2},{"lat":3,"lon":4}],"costing":"auto"})",
+           Options::route, route);
+  EXPECT_EQ(admission_t::estimate(route.options()), 2);
+}
+
+TEST(ParseRequest, test_admission_bounds) {
+  boost::property_tree::ptree config;
+  EXPECT_FALSE(admission_t(config).bounded());
+  config.put("httpd.service.admission.sources_to_targets", 10);
+  admission_t admission(config);
+  EXPECT_TRUE(admission.bounded());
+
+  Options matrix;
+  matrix.set_action(Options::sources_to_targets);
+  matrix.mutable_sources()->Add();
+  matrix.mutable_sources()->Add();
+  matrix.mutable_targets()->Add();
+  matrix.mutable_targets()->Add();
+  auto first = admission.admit(matrix);
+  auto second = admission.admit(matrix);
+  EXPECT_EQ(admission.in_flight_work(Options::sources_to_targets), 8);
+
+  // no room for another one until one of them is done
+  try {
+    admission.admit(matrix);
+    FAIL() << "Expected the request to be rejected";
+  } catch (const valhalla_exception_t& e) { EXPECT_EQ(e.code, 104); }
+  first.reset();
+  EXPECT_EQ(admission.in_flight_work(Options::sources_to_targets), 4);
+  EXPECT_NE(admission.admit(matrix), nullptr);
+  EXPECT_EQ(admission.in_flight_work(Options::sources_to_targets), 4);
+
+  // other actions are not held up
+  Options locate;
+  locate.set_action(Options::locate);
+  EXPECT_EQ(admission.admit(locate), nullptr);
+
+  // and requests that could never fit are turned away for good
+  matrix.mutable_sources()->Add();
+  matrix.mutable_sources()->Add();
+  try {
+    admission.admit(matrix);
+    FAIL() << "Expected the request to be rejected";
+  } catch (const valhalla_exception_t& e) { EXPECT_EQ(e.code, 105); }
+}
+
 // Set disable_hierarchy_pruning to true in costing options
 void set_disable_hierarchy_pruning(Options& options, Costing::Type type) {
   Costing* costing = &(*options.mutable_costings())[type];
@@ -157,6 +157,72 @@ TEST(Routing, Benchmark) {
   std::cout << ms << std::endl;
 }
 
+TEST(Routing, TestStatusTable) {
+  meili::StatusTable table;
+  std::vector<baldr::GraphId> nodes;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    nodes.emplace_back(i % 7, 2, i);
+  }
+
+  // enough nodes to make the table grow a few times
+  for (uint32_t generation = 0; generation < 3; ++generation) {
+    for (uint32_t i = 0; i < nodes.size(); i += 2) {
+      EXPECT_EQ(table.find(nodes[i]), nullptr);
+      table.emplace(nodes[i], i + generation);
+    }
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+      auto* status = table.find(nodes[i]);
+      if (i % 2) {
+        EXPECT_EQ(status, nullptr);
+      } else {
+        ASSERT_NE(status, nullptr);
+        EXPECT_EQ(status->label_idx, i + generation);
+        EXPECT_FALSE(status->permanent);
+      }
+    }
+    table.find(nodes.front())->permanent = true;
+    EXPECT_TRUE(table.find(nodes.front())->permanent);
+
+    EXPECT_EQ(table.find(uint16_t(3)), nullptr);
+    table.emplace(uint16_t(3), 42);
+    ASSERT_NE(table.find(uint16_t(3)), nullptr);
+    EXPECT_EQ(table.find(uint16_t(3))->label_idx, 42);
+    EXPECT_EQ(table.find(uint16_t(2)), nullptr);
+
+    // nothing survives a clear
+    table.clear();
+    EXPECT_EQ(table.find(nodes.front()), nullptr);
+    EXPECT_EQ(table.find(uint16_t(3)), nullptr);
+  }
+}
+
+TEST(Routing, TestLabelSetReusesStatus) {
+  auto status = std::make_shared<meili::StatusTable>();
+  sif::TravelMode travelmode = static_cast<sif::TravelMode>(0);
+  baldr::DirectedEdge de;
+
+  // two searches one after the other share the same status table
+  for (int search = 0; search < 2; ++search) {
+    meili::LabelSet labelset(100, 1.f, status);
+    labelset.put(baldr::GraphId(1, 2, 0), travelmode, nullptr);
+    labelset.put(baldr::GraphId(1, 2, 1), baldr::GraphId(1, 2, 5), 0.f, 1.f, {5.f, 5.f}, 0.f, 5.f,
+                 0, &de, travelmode, -1);
+    // a more expensive label for the same node is ignored
+    labelset.put(baldr::GraphId(1, 2, 1), baldr::GraphId(1, 2, 6), 0.f, 1.f, {9.f, 9.f}, 0.f, 9.f,
+                 0, &de, travelmode, -1);
+    EXPECT_EQ(labelset.size(), 2);
+    EXPECT_EQ(labelset.pop(), 0);
+    EXPECT_EQ(labelset.pop(), 1);
+    EXPECT_EQ(labelset.label(1).edgeid(), baldr::GraphId(1, 2, 5));
+    EXPECT_EQ(labelset.pop(), baldr::kInvalidLabel);
+    labelset.clear_queue();
+    labelset.clear_status();
+
+    // the labels are still there for path recovery
+    EXPECT_EQ(labelset.label(1).nodeid(), baldr::GraphId(1, 2, 1));
+  }
+}
+
 TEST(Routing, TestRoutePathIterator) {
   meili::LabelSet labelset(100);
   // Travel mode is insignificant in the tests
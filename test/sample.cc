@@ -7,6 +7,7 @@
 
 #include <cmath>
 #include <fstream>
+#include <future>
 #include <list>
 #include <lz4frame.h>
 
@@ -118,6 +119,24 @@ TEST(Sample, getlz4) {
   _get("test/data/samplelz4");
 };
 
+TEST(Sample, prefetch) {
+  skadi::sample s("test/data/samplegz");
+  EXPECT_TRUE(s.prefetch(skadi::sample::get_tile_index(std::make_pair(-76.5, 40.5))));
+  EXPECT_FALSE(s.prefetch(skadi::sample::get_tile_index(std::make_pair(0.5, 0.5))));
+
+  // threads unpacking and sampling the same tile all get the same heights
+  skadi::sample concurrent("test/data/samplegz");
+  std::vector<std::future<double>> heights;
+  for (size_t i = 0; i < 8; ++i) {
+    heights.emplace_back(std::async(std::launch::async, [&concurrent]() {
+      return concurrent.get(std::make_pair(-76.503915, 40.678783));
+    }));
+  }
+  for (auto& height : heights) {
+    EXPECT_NEAR(490, height.get(), 1.0);
+  }
+}
+
 struct testable_sample_t : public skadi::sample {
   testable_sample_t(const std::string& dir) : sample(dir) {
     {
@@ -1,5 +1,8 @@
 #include "midgard/sequence.h"
+#include <atomic>
 #include <cstdint>
+#include <stdexcept>
+#include <vector>
 
 #include "test.h"
 
@@ -54,6 +57,58 @@ TEST(Sequence, ReadWrite) {
   read_nodes(file_name, count);
 }
 
+TEST(Sequence, ParallelSort) {
+  // runs smaller than the input force the loser tree merge, with a remainder run at the end and
+  // lots of duplicate keys
+  {
+    sequence<uint64_t> sequence("sorted.bin", true, 512);
+    for (uint64_t i = 0; i < 10007; ++i)
+      sequence.push_back((i * 7919) % 1021);
+  }
+  for (size_t concurrency : {1, 4}) {
+    sequence<uint64_t> sequence("sorted.bin", false, 512);
+    sequence.sort([](uint64_t a, uint64_t b) { return a > b; }, 1000, concurrency);
+    sequence.sort(std::less<uint64_t>(), 1000, concurrency);
+    ASSERT_EQ(sequence.size(), 10007);
+    for (size_t i = 1; i < sequence.size(); ++i)
+      ASSERT_LE(*sequence[i - 1], *sequence[i]) << "Not sorted at: " + std::to_string(i);
+  }
+
+  // big enough to be split across threads and merged back in place
+  {
+    sequence<uint64_t> sequence("sorted.bin", true);
+    for (uint64_t i = 0; i < 300000; ++i)
+      sequence.push_back((i * 2654435761u) % 100003);
+  }
+  sequence<uint64_t> sequence("sorted.bin", false);
+  sequence.sort(std::less<uint64_t>(), sequence.size(), 4);
+  ASSERT_EQ(sequence.size(), 300000);
+  for (size_t i = 1; i < sequence.size(); ++i)
+    ASSERT_LE(*sequence[i - 1], *sequence[i]) << "Not sorted at: " + std::to_string(i);
+}
+
+TEST(Sequence, ParallelFor) {
+  // every item is done once and only by one of the threads it was allowed
+  std::vector<std::atomic<size_t>> done(1000);
+  std::vector<size_t> threads(done.size());
+  parallel_for(done.size(), 4, [&](size_t thread, size_t i) {
+    ++done[i];
+    threads[i] = thread;
+  });
+  for (size_t i = 0; i < done.size(); ++i) {
+    ASSERT_EQ(done[i], 1);
+    ASSERT_LT(threads[i], 4);
+  }
+
+  // the failure of an item is rethrown on the calling thread
+  EXPECT_THROW(parallel_for(done.size(), 4,
+                            [](size_t, size_t i) {
+                              if (i == 500)
+                                throw std::runtime_error("failed");
+                            }),
+               std::runtime_error);
+}
+
 TEST(Sequence, Iterator) {
   sequence<osm_node> sequence("nodes.nd", false, 512);
   auto i = sequence.begin();
@@ -0,0 +1,115 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "filesystem.h"
+#include "mjolnir/sortedmultimap.h"
+
+#include "test.h"
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+using TestMultiMap = SortedMultiMap<uint64_t, uint32_t>;
+
+std::vector<uint32_t> values(const TestMultiMap& map, uint64_t key) {
+  std::vector<uint32_t> v;
+  auto range = map.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    v.push_back(it->second);
+  }
+  return v;
+}
+
+TEST(SortedMultiMap, SortAndLookup) {
+  TestMultiMap map;
+  map.insert({5, 1});
+  map.emplace(3, 2);
+  map.insert(TestMultiMap::value_type(5, 3));
+  map.insert({1, 4});
+  map.insert({5, 5});
+
+  // lookups need sorted records
+  EXPECT_THROW(map.find(5), std::logic_error);
+  map.sort();
+
+  EXPECT_EQ(map.size(), 5);
+  EXPECT_EQ(values(map, 5), (std::vector<uint32_t>{1, 3, 5})) << "insertion order is kept";
+  EXPECT_EQ(values(map, 3), (std::vector<uint32_t>{2}));
+  EXPECT_EQ(map.count(1), 1);
+
+  // a missing key gives an empty range at the end
+  auto range = map.equal_range(2);
+  EXPECT_EQ(range.first, map.end());
+  EXPECT_EQ(range.second, map.end());
+  EXPECT_EQ(map.find(6), map.end());
+}
+
+TEST(SortedMultiMap, Unique) {
+  TestMultiMap map;
+  map.insert({7, 1});
+  map.insert({2, 10});
+  map.insert({7, 2});
+  map.insert({7, 3});
+  map.unique([](TestMultiMap::value_type& a, const TestMultiMap::value_type& b) {
+    a.second = a.second * 10 + b.second;
+  });
+
+  ASSERT_EQ(map.size(), 2);
+  EXPECT_EQ(map.find(2)->second, 10);
+  EXPECT_EQ(map.find(7)->second, 123);
+
+  SortedSet<uint64_t> set;
+  for (uint64_t id : {4, 1, 4, 9, 1}) {
+    set.insert(id);
+  }
+  set.unique([](uint64_t&, const uint64_t&) {});
+  EXPECT_EQ(std::vector<uint64_t>(set.begin(), set.end()), (std::vector<uint64_t>{1, 4, 9}));
+  EXPECT_NE(set.find(9), set.end());
+  EXPECT_EQ(set.find(5), set.end());
+}
+
+TEST(SortedMultiMap, WriteAndMap) {
+  const std::string file = "test/data/sortedmultimap.bin";
+  TestMultiMap map;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    map.insert({(i * 7919) % 101, i});
+  }
+  ASSERT_TRUE(map.write(file));
+
+  TestMultiMap mapped;
+  ASSERT_TRUE(mapped.read(file));
+  ASSERT_EQ(mapped.size(), map.size());
+  for (uint64_t key = 0; key < 101; ++key) {
+    EXPECT_EQ(values(mapped, key), values(map, key));
+  }
+
+  // adding to mapped records copies them and leaves the file alone
+  mapped.insert({200, 1});
+  mapped.sort();
+  EXPECT_EQ(mapped.size(), map.size() + 1);
+  EXPECT_EQ(mapped.find(200)->second, 1);
+  TestMultiMap reread;
+  ASSERT_TRUE(reread.read(file));
+  EXPECT_EQ(reread.size(), map.size());
+
+  // writing over the mapped file
+  ASSERT_TRUE(reread.write(file));
+  EXPECT_EQ(values(reread, 50), values(map, 50));
+
+  // empty files map to nothing
+  ASSERT_TRUE(TestMultiMap().write(file));
+  ASSERT_TRUE(reread.read(file));
+  EXPECT_TRUE(reread.empty());
+  EXPECT_FALSE(reread.read("test/data/does_not_exist.bin"));
+
+  filesystem::remove(file);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,96 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mjolnir/stagescheduler.h"
+
+#include "test.h"
+
+using namespace valhalla::mjolnir;
+
+namespace {
+
+TEST(StageScheduler, Dependencies) {
+  std::mutex lock;
+  std::vector<std::string> order;
+  auto stage = [&](const std::string& name) {
+    return [&, name]() {
+      std::lock_guard<std::mutex> guard(lock);
+      order.push_back(name);
+    };
+  };
+
+  StageScheduler scheduler;
+  scheduler.add("c", stage("c"), {"a", "b"});
+  scheduler.add("a", stage("a"));
+  scheduler.add("b", stage("b"), {"a", "not added"});
+  auto timings = scheduler.run(1);
+
+  EXPECT_EQ(order, (std::vector<std::string>{"a", "b", "c"}));
+  ASSERT_EQ(timings.size(), 3);
+  for (size_t i = 0; i < timings.size(); ++i) {
+    EXPECT_EQ(timings[i].name, order[i]);
+    EXPECT_GE(timings[i].duration, 0);
+  }
+  EXPECT_LE(timings[0].start, timings[1].start);
+}
+
+TEST(StageScheduler, IndependentStagesOverlap) {
+  // each of the two stages waits for the other to have started
+  std::atomic<int> started{0};
+  auto stage = [&started]() {
+    ++started;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (started < 2 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (started < 2) {
+      throw std::runtime_error("stages did not overlap");
+    }
+  };
+
+  StageScheduler scheduler;
+  scheduler.add("a", stage);
+  scheduler.add("b", stage);
+  bool after = false;
+  scheduler.add("after", [&]() { after = started == 2; }, {"a", "b"});
+  EXPECT_NO_THROW(scheduler.run(2));
+  EXPECT_TRUE(after);
+}
+
+TEST(StageScheduler, Errors) {
+  // a failing stage stops the stages that depend on it
+  bool ran = false;
+  StageScheduler failing;
+  failing.add("a", []() { throw std::runtime_error("a failed"); });
+  failing.add("b", [&ran]() { ran = true; }, {"a"});
+  EXPECT_THROW(failing.run(4), std::runtime_error);
+  EXPECT_FALSE(ran);
+
+  StageScheduler cycle;
+  cycle.add("a", []() {}, {"b"});
+  cycle.add("b", []() {}, {"a"});
+  EXPECT_THROW(cycle.run(4), std::logic_error);
+
+  StageScheduler duplicate;
+  duplicate.add("a", []() {});
+  duplicate.add("a", []() {});
+  EXPECT_THROW(duplicate.run(4), std::logic_error);
+}
+
+TEST(StageScheduler, PeakRss) {
+#ifdef __linux__
+  EXPECT_GT(StageScheduler::peak_rss(), 0);
+#endif
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -2,12 +2,20 @@
 
 #include "baldr/attributes_controller.h"
 #include "baldr/rapidjson_utils.h"
+#include "loki/worker.h"
 #include "midgard/logging.h"
+#include "odin/worker.h"
 #include "thor/worker.h"
 #include "tyr/actor.h"
 #include <algorithm>
+#include <chrono>
+#include <thread>
 #include <unistd.h>
 
+#ifdef ENABLE_SERVICES
+#include <prime_server/http_protocol.hpp>
+#endif
+
 using namespace valhalla;
 using namespace valhalla::midgard;
 using namespace valhalla::thor;
@@ -118,6 +126,98 @@ TEST(ThorWorker, test_linear_references) {
   }
 }
 
+#ifdef ENABLE_SERVICES
+TEST(ThorWorker, test_in_process_handoff) {
+  auto config = conf;
+  config.put("httpd.service.in_process", true);
+  loki::loki_worker_t loki_worker(config);
+  thor_worker_t thor_worker(config);
+  odin::odin_worker_t odin_worker(config);
+
+  prime_server::http_request_info_t info{};
+  prime_server::http_request_t request(prime_server::method_t::POST, "/route",
+                                       R"({"costing":"auto","locations":[
+          {"lat":52.09110,"lon":5.09806},
+          {"lat":52.09098,"lon":5.09679}]})");
+  auto request_str = request.to_string();
+  std::list<zmq::message_t> job;
+  job.emplace_back(request_str.data(), request_str.size());
+
+  // loki and thor only send on the id of the request
+  auto result = loki_worker.work(job, &info, []() {});
+  loki_worker.cleanup();
+  ASSERT_TRUE(result.intermediate);
+  ASSERT_EQ(result.messages.front().size(), 1 + sizeof(uint64_t));
+  EXPECT_EQ(result.messages.front().front(), '\0');
+  job.clear();
+  job.emplace_back(result.messages.front().data(), result.messages.front().size());
+
+  result = thor_worker.work(job, &info, []() {});
+  thor_worker.cleanup();
+  ASSERT_TRUE(result.intermediate);
+  ASSERT_EQ(result.messages.front().size(), 1 + sizeof(uint64_t));
+  const auto token = result.messages.front();
+  job.clear();
+  job.emplace_back(token.data(), token.size());
+
+  // odin gets the request loki parsed and thor routed
+  result = odin_worker.work(job, &info, []() {});
+  odin_worker.cleanup();
+  ASSERT_FALSE(result.intermediate);
+  auto response = result.messages.front();
+  EXPECT_NE(response.find("200 OK"), std::string::npos);
+  EXPECT_NE(response.find(R"("trip":)"), std::string::npos);
+
+  // the id is only good once, and ids that were never handed out are no request at all
+  job.clear();
+  job.emplace_back(token.data(), token.size());
+  result = odin_worker.work(job, &info, []() {});
+  odin_worker.cleanup();
+  EXPECT_EQ(result.messages.front().find("200 OK"), std::string::npos);
+  EXPECT_NE(result.messages.front().find(R"("error_code":299)"), std::string::npos);
+
+  std::string unknown(1 + sizeof(uint64_t), '\0');
+  job.clear();
+  job.emplace_back(unknown.data(), unknown.size());
+  result = thor_worker.work(job, &info, []() {});
+  thor_worker.cleanup();
+  EXPECT_NE(result.messages.front().find(R"("error_code":401)"), std::string::npos);
+}
+
+TEST(ThorWorker, test_lost_handoff_expires) {
+  auto config = conf;
+  config.put("httpd.service.in_process", true);
+  config.put("httpd.service.timeout_seconds", 1);
+  config.put("httpd.service.admission.route", 2);
+  loki::loki_worker_t loki_worker(config);
+
+  prime_server::http_request_info_t info{};
+  prime_server::http_request_t request(prime_server::method_t::POST, "/route",
+                                       R"({"costing":"auto","locations":[
+          {"lat":52.09110,"lon":5.09806},
+          {"lat":52.09098,"lon":5.09679}]})");
+  auto request_str = request.to_string();
+  std::list<zmq::message_t> job;
+  auto work = [&]() {
+    job.clear();
+    job.emplace_back(request_str.data(), request_str.size());
+    auto result = loki_worker.work(job, &info, []() {});
+    loki_worker.cleanup();
+    return result;
+  };
+
+  // the request is handed on but never gets to thor, its work stays in flight
+  EXPECT_TRUE(work().intermediate);
+  auto result = work();
+  ASSERT_FALSE(result.intermediate);
+  EXPECT_NE(result.messages.front().find(R"("error_code":104)"), std::string::npos);
+
+  // until it has waited as long as any request may take
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+  EXPECT_TRUE(work().intermediate);
+}
+#endif
+
 } // namespace
 
 int main(int argc, char* argv[]) {
@@ -533,6 +533,94 @@ TEST(ViterbiSearch, TestTopKSearch) {
   }
 }
 
+std::vector<StateId> search_path(IViterbiSearch& vs, const std::vector<Column>& columns) {
+  vs.set_emission_cost_model(EmissionCostModel(columns));
+  vs.set_transition_cost_model(TransitionCostModel(columns));
+  AddColumns(vs, columns);
+
+  std::vector<StateId> path;
+  std::copy(vs.SearchPathVS(columns.size() - 1), vs.PathEnd(), std::back_inserter(path));
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+size_t count_states(const IViterbiSearch& vs, const std::vector<Column>& columns) {
+  size_t count = 0;
+  for (StateId::Time time = 0; time < columns.size(); time++) {
+    for (uint32_t idx = 0; idx < columns[time].size(); ++idx) {
+      count += vs.HasStateId(StateId(time, idx));
+    }
+  }
+  return count;
+}
+
+template <typename viterbi_search_t> void test_fixed_lag(const std::vector<Column>& columns) {
+  viterbi_search_t vs;
+  const auto& path = search_path(vs, columns);
+
+  viterbi_search_t lagged;
+  lagged.set_fixed_lag(true);
+  const auto& lagged_path = search_path(lagged, columns);
+
+  // Committing columns as soon as they are decided must not make the result any worse. The costs
+  // are whole numbers so paths of equal cost are common and either search may pick any of them
+  validate_path(columns, lagged_path);
+  EXPECT_NEAR(total_cost(columns, path), total_cost(columns, lagged_path), 1e-6)
+      << "fixed lag decoding must find an optimal path";
+
+  // Only the committed path is kept for all columns but the last ones
+  EXPECT_LT(count_states(lagged, columns), count_states(vs, columns));
+  for (const auto& stateid : lagged_path) {
+    EXPECT_TRUE(lagged.HasStateId(stateid)) << "states of the path must be kept";
+  }
+}
+
+template <typename viterbi_search_t> void test_beam(const std::vector<Column>& columns) {
+  // A beam of one state per column is greedy and commits every column right away
+  viterbi_search_t vs;
+  vs.set_fixed_lag(true);
+  vs.set_beam(1, 0.0);
+  const auto& path = search_path(vs, columns);
+  validate_path(columns, path);
+  EXPECT_EQ(count_states(vs, columns), columns.size());
+
+  // A beam that is wide enough doesn't change the result (up to ties)
+  viterbi_search_t unbounded, wide;
+  wide.set_beam(1000, 1e9);
+  EXPECT_EQ(total_cost(columns, search_path(unbounded, columns)),
+            total_cost(columns, search_path(wide, columns)));
+
+  EXPECT_THROW(vs.set_beam(1, -1.0), std::invalid_argument);
+}
+
+TEST(ViterbiSearch, TestFixedLag) {
+  for (const size_t max_column_size : {1, 5, 20}) {
+    const auto& columns = generate_columns(
+        // transition costs
+        std::uniform_int_distribution<int>(0, 100),
+        // emission costs
+        std::uniform_int_distribution<int>(0, 100),
+        generate_column_counts(300,
+                               // column sizes
+                               std::uniform_int_distribution<size_t>(2, max_column_size + 1)));
+    test_fixed_lag<NaiveViterbiSearch<false>>(columns);
+    test_fixed_lag<ViterbiSearch>(columns);
+  }
+}
+
+TEST(ViterbiSearch, TestBeam) {
+  const auto& columns = generate_columns(
+      // transition costs
+      std::uniform_int_distribution<int>(0, 100),
+      // emission costs
+      std::uniform_int_distribution<int>(0, 100),
+      generate_column_counts(300,
+                             // column sizes
+                             std::uniform_int_distribution<size_t>(1, 20)));
+  test_beam<NaiveViterbiSearch<false>>(columns);
+  test_beam<ViterbiSearch>(columns);
+}
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
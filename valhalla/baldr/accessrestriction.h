@@ -5,6 +5,10 @@
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/baldr/json.h>
 
+namespace rapidjson {
+class writer_wrapper_t;
+}
+
 namespace valhalla {
 namespace baldr {
 
@@ -55,7 +59,7 @@ public:
    */
   void set_value(const uint64_t v);
 
-  const json::MapPtr json() const;
+  void json(rapidjson::writer_wrapper_t& writer) const;
 
   /**
    * operator < - for sorting. Sort by edge Id.
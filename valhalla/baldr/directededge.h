@@ -5,6 +5,10 @@
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/json.h>
+
+namespace rapidjson {
+class writer_wrapper_t;
+}
 #include <valhalla/baldr/turn.h>
 
 namespace valhalla {
@@ -1192,10 +1196,10 @@ public:
   }
 
   /**
-   * Create a json object representing this edge
-   * @return  Returns the json object
+   * Writes the json representation of this edge into the currently open object
+   * @param writer  the writer to write to
    */
-  json::MapPtr json() const;
+  void json(rapidjson::writer_wrapper_t& writer) const;
 
 protected:
   // 1st 8-byte word
@@ -10,6 +10,10 @@
 #include <valhalla/baldr/conditional_speed_limit.h>
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/json.h>
+
+namespace rapidjson {
+class writer_wrapper_t;
+}
 #include <valhalla/midgard/encoded.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
@@ -306,10 +310,10 @@ public:
   std::vector<std::string> level_ref() const;
 
   /**
-   * Returns json representing this object
-   * @return json object
+   * Writes the json representation of this object into the currently open object
+   * @param writer  the writer to write to
    */
-  json::MapPtr json() const;
+  void json(rapidjson::writer_wrapper_t& writer) const;
 
   // Operator EqualTo based on nodea and nodeb.
   bool operator==(const EdgeInfo& rhs) const;
@@ -8,6 +8,10 @@
 #include <valhalla/baldr/graphconstants.h>
 #include <valhalla/baldr/json.h>
 
+namespace rapidjson {
+class writer_wrapper_t;
+}
+
 namespace valhalla {
 namespace baldr {
 
@@ -168,10 +172,10 @@ public:
   }
 
   /**
-   * The json representation of the id
-   * @return  json
+   * Writes the json representation of the id into the currently open object
+   * @param writer  the writer to write to
    */
-  json::Value json() const;
+  void json(rapidjson::writer_wrapper_t& writer) const;
 
   /**
    * Post increments the id.
@@ -414,6 +414,90 @@ private:
   std::mutex& mutex_ref_;
 };
 
+/**
+ * Tile cache whose tiles live in a POSIX shared memory segment, so that the processes of a
+ * deployment which load tiles from a tile directory keep one copy of each tile between them rather
+ * than one each. A tile put into the cache by one process is read in place by the others.
+ *
+ * Each cache keeps its own FlatTileCache of the tile objects it has handed out, their memory is in
+ * the segment. The caches of a process share its mapping of the segment, the process takes one of
+ * 64 slots in the segment and marks the tiles it holds with it. Tiles are only evicted, least
+ * recently released first, to make room for new ones once no process holds them anymore. The slots of processes which die without giving theirs back are
+ * reclaimed along with their tiles. The segment records a fingerprint of the tileset it is filled
+ * from, a process of another tileset unlinks it and makes a new one in its place while the
+ * processes still using the old one keep it until they let go of it.
+ * A cache is NOT thread-safe, but several caches of a process may be used from different threads.
+ */
+class SharedTileCache : public TileCache {
+public:
+  /**
+   * Constructor. Opens the shared memory segment, unless another cache of this process already
+   * did, or makes it if this is the first process to use it. Throws std::runtime_error if the
+   * segment can't be opened or all of its process slots are taken.
+   * @param name          name of the shared memory segment, i.e. /valhalla_tiles
+   * @param segment_size  size of the segment in bytes, only used by the process that makes it
+   * @param max_size      maximum size of the tiles this process keeps a hold of
+   * @param fingerprint   identifies the tileset the tiles come from
+   */
+  SharedTileCache(const std::string& name,
+                  size_t segment_size,
+                  size_t max_size,
+                  uint64_t fingerprint = 0);
+
+  /**
+   * Reserves enough cache to hold (max_cache_size / tile_size) items.
+   * @param tile_size appeoximate size of one tile
+   */
+  void Reserve(size_t tile_size) override;
+
+  /**
+   * Checks if tile exists in the cache of this process or in the segment.
+   * @param graphid  the graphid of the tile
+   * @return true if tile exists in the cache
+   */
+  bool Contains(const GraphId& graphid) const override;
+
+  /**
+   * Copies a tile into the segment, unless another process already did, and puts the copy into
+   * the cache of this process. If there is no room in the segment the tile itself is cached.
+   * @param graphid  the graphid of the tile
+   * @param tile the graph tile
+   * @param size size of the tile in memory
+   */
+  graph_tile_ptr Put(const GraphId& graphid, graph_tile_ptr tile, size_t size) override;
+
+  /**
+   * Get a pointer to a graph tile object given a GraphId, from the cache of this process or else
+   * from the segment.
+   * @param graphid  the graphid of the tile
+   * @return GraphTile* a pointer to the graph tile
+   */
+  graph_tile_ptr Get(const GraphId& graphid) const override;
+
+  /**
+   * Lets you know if the cache of this process is too large.
+   * @return true if the cache is over committed with respect to the limit
+   */
+  bool OverCommitted() const override;
+
+  /**
+   * Clears the cache of this process, the segment is left to the other processes.
+   */
+  void Clear() override;
+
+  /**
+   *  Clears the cache of this process which frees its tiles in the segment for eviction.
+   */
+  void Trim() override;
+
+  // The mapping of the segment, shared with the tiles whose memory is in it
+  struct Segment;
+
+protected:
+  std::shared_ptr<Segment> segment_;
+  mutable FlatTileCache local_;
+};
+
 /**
  * Creates tile caches.
  */
@@ -448,6 +532,17 @@ public:
 
   virtual ~GraphReader() = default;
 
+  /**
+   * Makes a reader which shares the tiles of this one so that the two can be used from different
+   * threads. When tiles are reference counted thread-safely (ENABLE_THREAD_SAFE_TILE_REF_COUNT)
+   * the cache of this reader is made thread-safe (if it wasn't already) and both readers use it
+   * from then on. Otherwise a tile may not be handed between threads at all so the new reader
+   * gets a cache of its own, configured like this one's but never the global synchronized one.
+   * This reader must not be in use by another thread while this is called.
+   * @return a reader sharing the tile storage and tile getter (and maybe cache) of this one
+   */
+  std::unique_ptr<GraphReader> ShareTiles();
+
   virtual void SetInterrupt(const tile_getter_t::interrupt_t* interrupt) {
     if (tile_getter_) {
       tile_getter_->set_interrupt(interrupt);
@@ -971,6 +1066,12 @@ public:
   IncidentResult GetIncidents(const GraphId& edge_id, graph_tile_ptr& edge_tile);
 
 protected:
+  /**
+   * Constructor of a reader sharing the tiles of another one, see ShareTiles.
+   * @param other  the reader whose cache has already been made thread-safe, if it is to be shared
+   */
+  explicit GraphReader(const GraphReader& other);
+
   // (Tar) extract of tiles - the contents are empty if not being used
   struct tile_extract_t {
     tile_extract_t(const boost::property_tree::ptree& pt, bool traffic_readonly = true);
@@ -989,13 +1090,18 @@ protected:
   const std::string tile_dir_;
 
   // Stuff for getting at remote tiles
-  std::unique_ptr<tile_getter_t> tile_getter_;
+  std::shared_ptr<tile_getter_t> tile_getter_;
   const size_t max_concurrent_users_;
   const std::string tile_url_;
 
   std::mutex _404s_lock;
   std::unordered_set<GraphId> _404s;
 
+  // How the cache was configured, for the caches of the readers made by ShareTiles
+  const boost::property_tree::ptree cache_config_;
+  // The cache shared with the readers made by ShareTiles, cache_ then synchronizes access to it
+  std::shared_ptr<TileCache> shared_cache_;
+  std::shared_ptr<std::mutex> shared_cache_lock_;
   std::unique_ptr<TileCache> cache_;
 
   bool enable_incidents_;
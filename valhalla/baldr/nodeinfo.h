@@ -6,6 +6,10 @@
 #include <valhalla/baldr/graphid.h>
 #include <valhalla/baldr/graphtileptr.h>
 #include <valhalla/baldr/json.h>
+
+namespace rapidjson {
+class writer_wrapper_t;
+}
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
 
@@ -486,11 +490,11 @@ public:
   }
 
   /**
-   * Returns the json representation of the object
-   * @param tile the tile required to get admin information
-   * @return  json object
+   * Writes the json representation of the object into the currently open object
+   * @param tile    the tile required to get admin information
+   * @param writer  the writer to write to
    */
-  json::MapPtr json(const graph_tile_ptr& tile) const;
+  void json(const graph_tile_ptr& tile, rapidjson::writer_wrapper_t& writer) const;
 
 protected:
   // Organized into 8-byte words so structure will align to 8 byte boundaries.
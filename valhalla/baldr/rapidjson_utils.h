@@ -1,6 +1,7 @@
 #ifndef VALHALLA_BALDR_RAPIDJSON_UTILS_H_
 #define VALHALLA_BALDR_RAPIDJSON_UTILS_H_
 
+#include <cmath>
 #include <fstream>
 #include <istream>
 #include <locale>
@@ -282,9 +283,15 @@ class writer_wrapper_t {
 protected:
   rapidjson::StringBuffer buffer;
   rapidjson::Writer<decltype(buffer)> writer;
+  // 10 to the power of the decimals doubles are rounded to, 0 when they aren't rounded
+  double rounding;
+
+  inline double rounded(const double value) const {
+    return rounding ? std::round(value * rounding) / rounding : value;
+  }
 
 public:
-  writer_wrapper_t(size_t reservation = 0) : buffer(), writer(buffer) {
+  writer_wrapper_t(size_t reservation = 0) : buffer(), writer(buffer), rounding(0) {
     if (reservation != 0)
       buffer.Reserve(reservation);
   }
@@ -298,6 +305,11 @@ public:
     writer.StartObject();
   }
 
+  inline void start_object(const std::string& name) {
+    writer.String(name);
+    writer.StartObject();
+  }
+
   inline void start_array() {
     writer.StartArray();
   }
@@ -307,6 +319,11 @@ public:
     writer.StartArray();
   }
 
+  inline void start_array(const std::string& name) {
+    writer.String(name);
+    writer.StartArray();
+  }
+
   inline void end_object() {
     writer.EndObject();
   }
@@ -321,6 +338,18 @@ public:
 
   inline void set_precision(int precision) {
     writer.SetMaxDecimalPlaces(precision);
+    rounding = 0;
+  }
+
+  /**
+   * Like set_precision the doubles written after this have at most the given number of decimals,
+   * but rather than cutting off the remaining digits the values are rounded. This is how values of
+   * a fixed precision used to be written by baldr::json
+   * @param precision  the number of decimals to round to
+   */
+  inline void set_rounded_precision(int precision) {
+    writer.SetMaxDecimalPlaces(precision);
+    rounding = std::pow(10.0, precision);
   }
 
   inline void operator()(const char* key, const char* value) {
@@ -335,7 +364,7 @@ public:
 
   inline void operator()(const char* key, const double value) {
     writer.String(key);
-    writer.Double(value);
+    writer.Double(rounded(value));
   }
 
   inline void operator()(const char* key, const uint64_t value) {
@@ -370,7 +399,7 @@ public:
 
   inline void operator()(const std::string& key, const double value) {
     writer.String(key);
-    writer.Double(value);
+    writer.Double(rounded(value));
   }
 
   inline void operator()(const std::string& key, const uint64_t value) {
@@ -402,7 +431,7 @@ public:
   }
 
   inline void operator()(const double value) {
-    writer.Double(value);
+    writer.Double(rounded(value));
   }
 
   inline void operator()(const uint64_t value) {
@@ -4,6 +4,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <valhalla/baldr/directededge.h>
 #include <valhalla/baldr/edgeinfo.h>
@@ -31,11 +35,100 @@ public:
                                                  const sif::cost_ptr_t& costing = nullptr) const = 0;
 };
 
-class CandidateGridQuery final : public CandidateQuery {
+/**
+ * A process wide, thread safe cache of the candidate grids of tile bins. Grids are immutable once
+ * built so they are handed out as shared pointers which stay valid even after being evicted. The
+ * least recently used grids are evicted to keep the approximate memory of all of them within
+ * a configured bound.
+ */
+class CandidateGridCache {
 public:
   using grid_t = GridRangeQuery<baldr::GraphId, midgard::PointLL>;
 
-  CandidateGridQuery(baldr::GraphReader& reader, float cell_width, float cell_height);
+  // Identifies the grid of one bin of one tile from one tileset with one grid resolution
+  struct Key {
+    std::string tileset;
+    // bits of the tile header which change whenever the tile is rebuilt
+    uint64_t tile_fingerprint;
+    uint64_t tile_id;
+    int32_t bin_index;
+    float cell_width;
+    float cell_height;
+
+    bool operator==(const Key& other) const {
+      return tile_id == other.tile_id && bin_index == other.bin_index &&
+             cell_width == other.cell_width && cell_height == other.cell_height &&
+             tile_fingerprint == other.tile_fingerprint && tileset == other.tileset;
+    }
+  };
+
+  /**
+   * The cache shared by all matchers of the process
+   */
+  static CandidateGridCache& Global();
+
+  explicit CandidateGridCache(size_t max_bytes = 0);
+
+  /**
+   * Grow the memory bound of the cache to at least this many bytes
+   */
+  void Reserve(size_t max_bytes);
+
+  /**
+   * @return the cached grid or nullptr if it isn't cached, marks the grid as recently used
+   */
+  std::shared_ptr<const grid_t> Find(const Key& key);
+
+  /**
+   * Cache a grid unless another one for the same key beat us to it, evicting the least recently
+   * used grids if over the memory bound
+   * @return the grid which is now cached for this key
+   */
+  std::shared_ptr<const grid_t> Insert(const Key& key, std::shared_ptr<const grid_t> grid);
+
+  void Clear();
+
+  size_t size() const;
+
+  size_t bytes() const;
+
+  size_t max_bytes() const;
+
+private:
+  struct KeyHasher {
+    size_t operator()(const Key& key) const;
+  };
+
+  struct Entry {
+    std::shared_ptr<const grid_t> grid;
+    size_t bytes;
+    std::list<Key>::iterator lru;
+  };
+
+  void Evict();
+
+  mutable std::mutex mutex_;
+  size_t max_bytes_;
+  size_t bytes_;
+  // most recently used at the front
+  std::list<Key> lru_;
+  std::unordered_map<Key, Entry, KeyHasher> entries_;
+};
+
+class CandidateGridQuery final : public CandidateQuery {
+public:
+  using grid_t = CandidateGridCache::grid_t;
+
+  /**
+   * @param reader        graph reader used to fetch the tiles whose bins are indexed
+   * @param cell_width    width of the cells of the grids
+   * @param cell_height   height of the cells of the grids
+   * @param shared_cache  optional cache of grids to share them between queries (and threads)
+   */
+  CandidateGridQuery(baldr::GraphReader& reader,
+                     float cell_width,
+                     float cell_height,
+                     CandidateGridCache* shared_cache = nullptr);
 
   ~CandidateGridQuery() override;
 
@@ -61,7 +154,7 @@ public:
                                            edgeids.end(), costing);
   }
 
-  std::unordered_map<baldr::GraphId, grid_t>::size_type size() const {
+  std::unordered_map<int32_t, std::shared_ptr<const grid_t>>::size_type size() const {
     return grid_cache_.size();
   }
 
@@ -83,10 +176,13 @@ private:
   float cell_width_;
   float cell_height_;
 
-  // Grid cache - cached per "bin" within a graph tile
-  mutable std::unordered_map<int32_t, grid_t> grid_cache_;
+  // Grid cache - cached per "bin" within a graph tile. Clearing it only drops our references
+  // to the grids, those in the shared cache live on for other queries
+  mutable std::unordered_map<int32_t, std::shared_ptr<const grid_t>> grid_cache_;
 
   baldr::GraphReader& reader_;
+
+  CandidateGridCache* shared_cache_;
 };
 
 } // namespace meili
@@ -23,6 +23,8 @@ struct Config {
 
     size_t cache_size = 100240;
     size_t grid_size = 500;
+    // memory bound (bytes) of the grids shared by all matchers of the process, 0 disables sharing
+    size_t shared_cache_size = 268435456;
 
     void Read(const boost::property_tree::ptree& params);
   };
@@ -66,10 +68,24 @@ struct Config {
     void Read(const boost::property_tree::ptree& params);
   };
 
+  struct Viterbi {
+    // commit the matched path as soon as all hypotheses agree on it; bounds the memory of the
+    // search, not of the candidates, but disables alternative matches
+    bool fixed_lag = false;
+    // maximum number of candidates kept per measurement during the search (0 means unlimited)
+    size_t beam_width = 0;
+    // drop candidates whose cost exceeds the best one of their measurement by more than this
+    // margin (0 means unlimited)
+    float beam_cost_margin = 0.f;
+
+    void Read(const boost::property_tree::ptree& params);
+  };
+
   CandidateSearch candidate_search{};
   TransitionCost transition_cost{};
   EmissionCost emission_cost{};
   Routing routing{};
+  Viterbi viterbi{};
 };
 
 } // namespace meili
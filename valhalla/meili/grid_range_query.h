@@ -111,6 +111,24 @@ public:
     return items;
   }
 
+  // Approximate number of bytes held by the grid, used to bound caches of grids
+  size_t MemoryUsage() const {
+    size_t bytes = sizeof(*this);
+#ifdef GRID_USE_VECTOR
+    bytes += items_.capacity() * sizeof(std::vector<item_t>);
+    for (const auto& items : items_) {
+      bytes += items.capacity() * sizeof(item_t);
+    }
+#else
+    bytes += items_.bucket_count() * sizeof(void*);
+    for (const auto& items : items_) {
+      // the node holding the pair and its next pointer plus the vector's own storage
+      bytes += sizeof(items) + sizeof(void*) + items.second.capacity() * sizeof(item_t);
+    }
+#endif
+    return bytes;
+  }
+
 private:
   std::vector<item_t>& ItemsInSquare(int col, int row) {
     if (!(0 <= col && col < ncols_ && 0 <= row && row < nrows_)) {
@@ -157,26 +157,150 @@ struct Status {
   uint32_t permanent : 1;
 };
 
+/**
+ * Status of the nodes and destinations of one search. Nodes are kept in an open addressing table
+ * and destinations (which are small indices) in a dense array. Every entry is stamped with the
+ * generation of the search that wrote it so that the whole table is cleared for the next search
+ * by bumping the generation rather than by freeing and reallocating its memory. This lets one
+ * table be reused by all the transition searches of a matcher.
+ */
+class StatusTable {
+public:
+  StatusTable() : generation_(1), node_count_(0) {
+  }
+
+  /**
+   * Find the status of a node in the current search.
+   * @return  Returns nullptr if the node has no status yet
+   */
+  Status* find(const baldr::GraphId& nodeid) {
+    if (nodes_.empty()) {
+      return nullptr;
+    }
+    const size_t mask = nodes_.size() - 1;
+    for (size_t i = hash(nodeid) & mask;; i = (i + 1) & mask) {
+      auto& entry = nodes_[i];
+      if (entry.generation != generation_) {
+        return nullptr;
+      }
+      if (entry.nodeid == nodeid.value) {
+        return &entry.status;
+      }
+    }
+  }
+
+  /**
+   * Set the status of a node which has no status in the current search.
+   */
+  void emplace(const baldr::GraphId& nodeid, const uint32_t label_idx) {
+    // keep the load factor under a half so probe sequences stay short
+    if ((node_count_ + 1) * 2 > nodes_.size()) {
+      grow();
+    }
+    insert(nodeid.value, Status(label_idx));
+    ++node_count_;
+  }
+
+  /**
+   * Find the status of a destination in the current search.
+   * @return  Returns nullptr if the destination has no status yet
+   */
+  Status* find(const uint16_t dest) {
+    if (dest < dests_.size() && dests_[dest].generation == generation_) {
+      return &dests_[dest].status;
+    }
+    return nullptr;
+  }
+
+  /**
+   * Set the status of a destination which has no status in the current search.
+   */
+  void emplace(const uint16_t dest, const uint32_t label_idx) {
+    if (dest >= dests_.size()) {
+      dests_.resize(dest + 1);
+    }
+    dests_[dest] = {generation_, dest, Status(label_idx)};
+  }
+
+  /**
+   * Forget all statuses, this is O(1) unless the generation wraps around.
+   */
+  void clear() {
+    node_count_ = 0;
+    if (++generation_ == 0) {
+      nodes_.assign(nodes_.size(), Entry());
+      dests_.assign(dests_.size(), Entry());
+      generation_ = 1;
+    }
+  }
+
+private:
+  struct Entry {
+    uint32_t generation = 0;
+    uint64_t nodeid = 0;
+    Status status{0};
+  };
+
+  static size_t hash(const baldr::GraphId& nodeid) {
+    // graph ids of neighbouring nodes only differ in their low bits, mix them before masking
+    uint64_t h = nodeid.value * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+
+  void insert(const uint64_t nodeid, const Status& status) {
+    const size_t mask = nodes_.size() - 1;
+    size_t i = hash(baldr::GraphId(nodeid)) & mask;
+    while (nodes_[i].generation == generation_) {
+      i = (i + 1) & mask;
+    }
+    nodes_[i] = {generation_, nodeid, status};
+  }
+
+  void grow() {
+    std::vector<Entry> nodes(std::max<size_t>(nodes_.size() * 2, 1024));
+    nodes.swap(nodes_);
+    for (const auto& entry : nodes) {
+      if (entry.generation == generation_) {
+        insert(entry.nodeid, entry.status);
+      }
+    }
+  }
+
+  uint32_t generation_;
+  size_t node_count_;
+  std::vector<Entry> nodes_;
+  std::vector<Entry> dests_;
+};
+
+using status_table_ptr_t = std::shared_ptr<StatusTable>;
+
 /**
  * LabelSet used during shortest path construction and recovery. Includes a
- * priority queue (sorted by sortdist) and maps that contain status (is the
- * element "permanently" labeled) of nodes and edges.
+ * priority queue (sorted by sortdist) and a table that contains the status (is
+ * the element "permanently" labeled) of nodes and destinations.
  */
 class LabelSet {
 public:
-  LabelSet(const float max_cost, const float bucket_size = 1.0f);
+  /**
+   * @param max_cost     maximum cost of the labels in the queue
+   * @param bucket_size  bucket size of the queue
+   * @param status       status table to (re)use while searching, a new one is made if null
+   */
+  LabelSet(const float max_cost,
+           const float bucket_size = 1.0f,
+           status_table_ptr_t status = nullptr);
 
   /**
    * Add an origin label using a destination index.
    */
   void put(const uint16_t dest, const sif::TravelMode mode, const Label* edgelabel) {
     // Do not add a duplicate label for the same destination index
-    if (dest_status_.find(dest) == dest_status_.end()) {
+    if (!status_->find(dest)) {
       // If edgelabel is not null, append it to the label set otherwise append
       // a dummy. In both cases add the label to the priority queue, set its
       // predecessor to kInvalidLabel, and initialize costs to 0.
       const uint32_t idx = labels_.size();
-      dest_status_.emplace(dest, idx);
+      status_->emplace(dest, idx);
       labels_.emplace_back(edgelabel ? *edgelabel : Label());
       labels_.back().InitAsOrigin(mode, dest, {});
       queue_.add(idx);
@@ -188,12 +312,12 @@ public:
    */
   void put(const baldr::GraphId& nodeid, const sif::TravelMode mode, const Label* edgelabel) {
     // Do not add a duplicate origin label for the same node
-    if (node_status_.find(nodeid) == node_status_.end()) {
+    if (!status_->find(nodeid)) {
       // If edgelabel is not null, append it to the label set otherwise append
       // a dummy. In both cases add the label to the priority queue and set its
       // predecessor to kInvalidLabel
       const uint32_t idx = labels_.size();
-      node_status_.emplace(nodeid, idx);
+      status_->emplace(nodeid, idx);
       labels_.emplace_back(edgelabel ? *edgelabel : Label());
       labels_.back().InitAsOrigin(mode, kInvalidDestination, nodeid);
       queue_.add(idx);
@@ -254,18 +378,25 @@ public:
   }
 
   /**
-   * Clear the status maps.
+   * Clear the status table. The labels remain for path recovery but the table
+   * is handed back (cleared) so that the next search can reuse it.
    */
   void clear_status() {
-    node_status_.clear();
-    dest_status_.clear();
+    status_->clear();
+    status_ = std::make_shared<StatusTable>();
+  }
+
+  /**
+   * Number of labels in the set.
+   */
+  size_t size() const {
+    return labels_.size();
   }
 
 private:
-  baldr::DoubleBucketQueue<Label> queue_;                  // Priority queue
-  std::unordered_map<baldr::GraphId, Status> node_status_; // Node status
-  std::unordered_map<uint16_t, Status> dest_status_;       // Destination status
-  std::vector<Label> labels_;                              // Label list.
+  baldr::DoubleBucketQueue<Label> queue_; // Priority queue
+  status_table_ptr_t status_;             // Node and destination status
+  std::vector<Label> labels_;             // Label list.
 };
 
 using labelset_ptr_t = std::shared_ptr<LabelSet>;
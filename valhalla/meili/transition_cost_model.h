@@ -1,9 +1,14 @@
 #ifndef MMP_TRANSITION_COST_MODEL_H_
 #define MMP_TRANSITION_COST_MODEL_H_
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/meili/config.h>
 #include <valhalla/meili/measurement.h>
+#include <valhalla/meili/routing.h>
 #include <valhalla/meili/state.h>
 #include <valhalla/meili/topk_search.h>
 #include <valhalla/meili/viterbi_search.h>
@@ -49,9 +54,52 @@ public:
 
   float operator()(const StateId& lhs, const StateId& rhs) const;
 
+  /**
+   * Forget the routes kept for reuse and the like. To be called between traces.
+   */
+  void Clear();
+
 private:
   void UpdateRoute(const StateId& lhs, const StateId& rhs) const;
 
+  // A route from an origin to a column of destinations which may serve again. Tightly sampled or
+  // stationary traces have consecutive columns whose candidates are identical so the route searched
+  // from the previous column already holds the paths needed for the current one
+  struct ReusableRoute {
+    // the origin and incoming edge of the search, see OriginSignature
+    std::vector<uint64_t> origin;
+    size_t hash;
+    // the bounds of the search
+    float max_dist;
+    float max_time;
+    // the candidate edges of each destination by its index in the search, see LocationSignature
+    std::vector<std::vector<uint64_t>> destinations;
+    std::unordered_map<uint16_t, uint32_t> results;
+    labelset_ptr_t labelset;
+  };
+
+  // State shared by all copies of the model (the viterbi search copies it into a std::function)
+  struct Workspace {
+    // reused by every search so its memory is only allocated once
+    status_table_ptr_t status{std::make_shared<StatusTable>()};
+    // the routes searched from the current and the previous column
+    StateId::Time time{kInvalidTime};
+    std::vector<ReusableRoute> current_routes;
+    std::vector<ReusableRoute> previous_routes;
+  };
+
+  // Start keeping routes from this column, dropping those which can't be reused anymore
+  void AdvanceRoutes(const StateId::Time time) const;
+
+  // Finds a route from the same origin with the same bounds that looked for all of the given
+  // destinations, and fills in its results for them by their index in this search
+  const ReusableRoute* FindRoute(const std::vector<uint64_t>& origin,
+                                 size_t hash,
+                                 float max_dist,
+                                 float max_time,
+                                 const std::vector<std::vector<uint64_t>>& destinations,
+                                 std::unordered_map<uint16_t, uint32_t>& results) const;
+
   float ClockDistance(const StateId::Time& lhs, const StateId::Time& rhs) const {
     double clk_dist = -1.0;
 
@@ -91,6 +139,8 @@ private:
   float turn_cost_table_[181];
 
   bool match_on_restrictions_{false};
+
+  std::shared_ptr<Workspace> workspace_;
 };
 
 } // namespace meili
@@ -105,6 +105,30 @@ public:
   const ITransitionCostModel& transition_cost_model() const;
   void set_transition_cost_model(const ITransitionCostModel& cost_model);
 
+  /**
+   * Enable fixed-lag decoding. Whenever all the surviving hypotheses of the search share a common
+   * ancestor, the path up to that ancestor can no longer change, so it is committed and every
+   * other state and label at or before the ancestor's time is released. This bounds the memory of
+   * the search itself, the candidates of every column are still kept by whoever added them (i.e.
+   * the StateContainer of the MapMatcher). Since released states are gone for good, a committed
+   * search can't be redone to find alternative paths (i.e. don't combine with TopK).
+   *
+   * @param fixed_lag  whether to commit and release columns as soon as possible
+   */
+  void set_fixed_lag(bool fixed_lag);
+  bool fixed_lag() const;
+
+  /**
+   * Configure beam pruning of low probability states
+   *
+   * @param beam_width        maximum number of states kept per column, 0 means unlimited
+   * @param beam_cost_margin  states whose accumulated cost is worse than the best one of their
+   *                          column by more than this margin are dropped, 0 means unlimited
+   */
+  void set_beam(size_t beam_width, double beam_cost_margin);
+  size_t beam_width() const;
+  double beam_cost_margin() const;
+
 protected:
   // Calculate transition cost from left state to right state
   float TransitionCost(const StateId& lhs, const StateId& rhs) const;
@@ -116,14 +140,32 @@ protected:
   constexpr static double
   CostSofar(double prev_costsofar, float transition_cost, float emission_cost);
 
+  /* Walk back from the given states at the given time until they all meet in a single ancestor
+     (which is invalid if the path was broken there). Returns false if they don't meet before
+     the committed columns */
+  bool FindCommonAncestor(std::vector<StateId> frontier,
+                          StateId::Time time,
+                          StateId::Time& ancestor_time,
+                          StateId& ancestor) const;
+  /* Commit the path ending at the given state, releasing all other states at or before its time
+     and making the path states the winners of their columns */
+  void CommitPath(StateId::Time time, StateId stateid);
+  // Release all the search data of a committed column except the one of the state to keep
+  virtual void ReleaseColumn(StateId::Time time, const StateId& keep) = 0;
+
   std::vector<std::vector<StateId>> states_by_time;
   std::vector<StateId> winner_by_time;
+  // Columns before this time are committed and only keep their winner
+  StateId::Time committed_time_{0};
 
 private:
   std::unordered_set<StateId> added_states_;
   IEmissionCostModel emission_cost_model_;
   ITransitionCostModel transition_cost_model_;
   const stateid_iterator path_end_;
+  bool fixed_lag_{false};
+  size_t beam_width_{0};
+  double beam_cost_margin_{0.0};
 };
 
 template <bool Maximize> class NaiveViterbiSearch : public IViterbiSearch {
@@ -149,7 +191,10 @@ private:
   std::vector<StateLabel> InitLabels(const std::vector<StateId>& column,
                                      bool use_emission_cost) const;
   StateId FindWinner(const std::vector<StateLabel>& labels) const;
+  // Drop the labels that fall out of the beam, keeping the winner
+  void PruneLabels(std::vector<StateLabel>& labels) const;
   const StateLabel& GetLabel(const StateId& stateid) const;
+  void ReleaseColumn(StateId::Time time, const StateId& keep) override;
 
   std::vector<std::vector<StateLabel>> history_;
 };
@@ -174,10 +219,16 @@ private:
   void InitQueue(const std::vector<StateId>& column);
   void AddSuccessorsToQueue(const StateId& stateid);
   StateId::Time IterativeSearch(StateId::Time target, bool request_new_start);
+  // Whether the label falls out of the beam of its column
+  bool IsOutOfBeam(const StateLabel& label) const;
+  // Called once all states of a column are either scanned or pruned
+  void OnColumnExhausted(StateId::Time time);
+  void ReleaseColumn(StateId::Time time, const StateId& keep) override;
   constexpr static bool IsInvalidCost(double cost);
 
   std::vector<std::vector<StateId>> unreached_states_by_time;
   std::unordered_map<StateId, StateLabel> scanned_labels_;
+  std::vector<size_t> scanned_count_by_time_;
   SPQueue<StateLabel> queue_;
   StateId::Time earliest_time_{0};
 };
@@ -1,18 +1,21 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <iterator>
 #include <memory>
-#include <queue>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -256,10 +259,125 @@ protected:
   std::string file_name;
 };
 
+// a tournament (loser) tree over k sorted runs of memory. each step yields the run holding the
+// smallest remaining element in O(log k) comparisons which, unlike a priority queue, needs
+// neither copies of the elements nor any heap reshuffling when a run is exhausted
+template <class T, class Predicate> class loser_tree {
+public:
+  static constexpr size_t npos = -1;
+
+  loser_tree(std::vector<std::pair<const T*, const T*>> runs, const Predicate& predicate)
+      : runs_(std::move(runs)), tree_(std::max<size_t>(runs_.size(), 1), npos),
+        predicate_(predicate) {
+    if (!runs_.empty()) {
+      tree_[0] = init(1);
+    }
+  }
+
+  // the index of the run holding the smallest element or npos when all runs are exhausted
+  size_t winner() const {
+    return tree_[0] != npos && runs_[tree_[0]].first != runs_[tree_[0]].second ? tree_[0] : npos;
+  }
+
+  // the smallest element, only valid when winner() is not npos
+  const T& top() const {
+    return *runs_[tree_[0]].first;
+  }
+
+  // move past the smallest element and replay its path to the root
+  void pop() {
+    size_t w = tree_[0];
+    ++runs_[w].first;
+    for (size_t node = (w + runs_.size()) / 2; node > 0; node /= 2) {
+      if (less(tree_[node], w)) {
+        std::swap(tree_[node], w);
+      }
+    }
+    tree_[0] = w;
+  }
+
+protected:
+  // exhausted runs lose every match, ties go to the lower run so the merge is deterministic
+  bool less(size_t a, size_t b) const {
+    if (runs_[a].first == runs_[a].second) {
+      return false;
+    }
+    if (runs_[b].first == runs_[b].second) {
+      return true;
+    }
+    if (predicate_(*runs_[a].first, *runs_[b].first)) {
+      return true;
+    }
+    return !predicate_(*runs_[b].first, *runs_[a].first) && a < b;
+  }
+
+  // leaves live at [k, 2k) and internal nodes at [1, k), each internal node keeps the loser
+  size_t init(size_t node) {
+    if (node >= runs_.size()) {
+      return node - runs_.size();
+    }
+    size_t left = init(node * 2);
+    size_t right = init(node * 2 + 1);
+    if (less(right, left)) {
+      std::swap(left, right);
+    }
+    tree_[node] = right;
+    return left;
+  }
+
+  std::vector<std::pair<const T*, const T*>> runs_;
+  std::vector<size_t> tree_;
+  const Predicate& predicate_;
+};
+
+// runs func(thread, i) for every i in [0, count) spread over up to concurrency threads, the calling
+// thread being thread 0. the thread index lets func use per thread state such as its own graph
+// reader. the first failure stops the remaining work and is rethrown once all threads are done
+template <class Func> void parallel_for(size_t count, size_t concurrency, const Func& func) {
+  concurrency = std::min(count, std::max<size_t>(concurrency, 1));
+  if (concurrency <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      func(0, i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  std::exception_ptr error;
+  std::mutex error_lock;
+  auto work = [&](size_t thread) {
+    try {
+      for (size_t i = next++; i < count; i = next++) {
+        func(thread, i);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_lock);
+      if (!error) {
+        error = std::current_exception();
+      }
+      next = count;
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(concurrency - 1);
+  for (size_t i = 1; i < concurrency; ++i) {
+    threads.emplace_back(work, i);
+  }
+  work(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 template <class T> class sequence {
 public:
   // static_assert(std::is_pod<T>::value, "sequence requires POD types for now");
   static const size_t npos = -1;
+  // the number of elements sort keeps in memory at once unless told otherwise
+  static constexpr size_t default_sort_buffer = 1024 * 1024 * 512 / sizeof(T);
 
   using value_type = T;
 
@@ -307,9 +425,8 @@ public:
   // finds the first matching object by scanning O(n)
   // assumes nothing about the order of the file
   // the predicate should be something like an equality check
-  size_t find_first_of(const T& target,
-                       const std::function<bool(const T&, const T&)>& predicate,
-                       size_t start_index = 0) {
+  template <class Predicate>
+  size_t find_first_of(const T& target, const Predicate& predicate, size_t start_index = 0) {
     flush();
     // keep looking while we have stuff to look at
     while (start_index < memmap.size()) {
@@ -322,55 +439,57 @@ public:
     return npos;
   }
 
-  // sort the file based on the predicate, and outputs to output_seq
+  // sort the file based on the predicate
   //
-  // Strategy is to first sort sub-ranges of length buffer_size in place.
-  // These should all fit in memory. Then, merge the sub-ranges into the
-  // output sequence via priority queue.
-  void sort(const std::function<bool(const T&, const T&)>& predicate,
-            size_t buffer_size = 1024 * 1024 * 512 / sizeof(T)) {
+  // Strategy is to first sort sub-ranges (runs) of length buffer_size in place, several at a time
+  // on up to concurrency threads (callers pass mjolnir.concurrency). If there is only one run it is
+  // itself split across the threads and merged back in place. Otherwise the runs are merged in a
+  // single sequential pass through a loser tree into a temporary file which then replaces this one.
+  template <class Predicate>
+  void sort(const Predicate& predicate,
+            size_t buffer_size = default_sort_buffer,
+            size_t concurrency = 1) {
     flush();
     // if no elements we are done
     if (memmap.size() == 0) {
       return;
     }
 
-    // If there wont be any merging we may as well take the simple approach
-    if (buffer_size > memmap.size() + write_buffer.size()) {
-      std::sort(static_cast<T*>(memmap), static_cast<T*>(memmap) + memmap.size(), predicate);
+    concurrency = std::max<size_t>(concurrency, 1);
+    buffer_size = std::max<size_t>(buffer_size, 1);
+    T* data = static_cast<T*>(memmap);
+    const size_t count = memmap.size();
+
+    // If there wont be any merging to disk we sort it all in memory
+    if (buffer_size >= count) {
+      sort_in_memory(data, count, predicate, concurrency);
       return;
     }
 
+    // Sort the runs, each on its own thread
+    const size_t run_count = (count + buffer_size - 1) / buffer_size;
+    parallel_for(run_count, concurrency, [&](size_t, size_t run) {
+      std::sort(data + run * buffer_size, data + std::min(count, (run + 1) * buffer_size), predicate);
+    });
+
     auto tmp_path = filesystem::path(file_name).replace_filename(
         filesystem::path(file_name).filename().string() + ".tmp");
     {
-      // we need a temporary sequence to merge the sorted subsections into
-      sequence<T> output_seq(tmp_path.string(), true);
-
-      // Comparator needs to be inverted for pq to provide constant time *smallest* lookup
-      // Pq keeps track of element and its index.
-      auto cmp = [&predicate](const std::pair<T, size_t>& a, std::pair<T, size_t>& b) {
-        return predicate(b.first, a.first);
-      };
-      std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, decltype(cmp)> pq(
-          cmp);
-
-      // Sort the subsections
-      for (size_t i = 0; i < memmap.size(); i += buffer_size) {
-        std::sort(static_cast<T*>(memmap) + i,
-                  static_cast<T*>(memmap) + std::min(memmap.size(), i + buffer_size), predicate);
-        pq.emplace(*at(i), i);
+      // we need a temporary sequence to merge the sorted runs into, the merge reads each run and
+      // writes the output sequentially so we give it a large write buffer to keep the io streaming
+      sequence<T> output_seq(tmp_path.string(), true,
+                             std::max<size_t>(1024 * 1024 * 128 / sizeof(T), 1));
+      std::vector<std::pair<const T*, const T*>> runs;
+      runs.reserve(run_count);
+      for (size_t i = 0; i < count; i += buffer_size) {
+        runs.emplace_back(data + i, data + std::min(count, i + buffer_size));
       }
 
       // Perform the merge
-      while (!pq.empty()) {
-        auto tmp = pq.top();
-        pq.pop();
-        output_seq.push_back(tmp.first);
-        size_t new_idx = tmp.second + 1;
-        if (new_idx % buffer_size != 0 && new_idx < memmap.size()) {
-          pq.emplace(*at(new_idx), new_idx);
-        }
+      loser_tree<T, Predicate> tree(std::move(runs), predicate);
+      while (tree.winner() != loser_tree<T, Predicate>::npos) {
+        output_seq.push_back(tree.top());
+        tree.pop();
       }
       output_seq.flush();
     }
@@ -391,7 +510,7 @@ public:
   }
 
   // perform an volatile operation on all the items of this sequence
-  void transform(const std::function<void(T&)>& predicate) {
+  template <class Predicate> void transform(const Predicate& predicate) {
     flush();
     for (size_t i = 0; i < memmap.size(); ++i) {
       // grab the element
@@ -406,7 +525,7 @@ public:
   }
 
   // perform a non-volatile operation on all the items of this sequence
-  void enumerate(const std::function<void(const T&)>& predicate) {
+  template <class Predicate> void enumerate(const Predicate& predicate) {
     flush();
     // grab each element and do something with it
     for (size_t i = 0; i < memmap.size(); ++i) {
@@ -531,7 +650,7 @@ public:
   // search for an object using binary search O(logn)
   // assumes the file was written in sorted order
   // the predicate should be something like a less than or greater than check
-  iterator find(const T& target, const std::function<bool(const T&, const T&)>& predicate) {
+  template <class Predicate> iterator find(const T& target, const Predicate& predicate) {
     flush();
     // if no elements we are done
     if (memmap.size() == 0) {
@@ -584,6 +703,36 @@ public:
   }
 
 protected:
+  // sorts a range that fits in memory by sorting one slice per thread and then merging adjacent
+  // slices in place, pairs of slices being merged concurrently at each level
+  template <class Predicate>
+  static void sort_in_memory(T* data, size_t count, const Predicate& predicate, size_t concurrency) {
+    // not worth the threads for small ranges
+    const size_t min_slice = 1024 * 64;
+    size_t slices = std::min(concurrency, count / min_slice);
+    if (slices <= 1) {
+      std::sort(data, data + count, predicate);
+      return;
+    }
+
+    const size_t slice_size = (count + slices - 1) / slices;
+    slices = (count + slice_size - 1) / slice_size;
+    parallel_for(slices, concurrency, [&](size_t, size_t slice) {
+      std::sort(data + slice * slice_size, data + std::min(count, (slice + 1) * slice_size),
+                predicate);
+    });
+
+    for (size_t width = slice_size; width < count; width *= 2) {
+      const size_t merges = (count + width * 2 - 1) / (width * 2);
+      parallel_for(merges, concurrency, [&](size_t, size_t merge) {
+        T* begin = data + merge * width * 2;
+        T* middle = data + std::min(count, merge * width * 2 + width);
+        T* end = data + std::min(count, (merge + 1) * width * 2);
+        std::inplace_merge(begin, middle, end, predicate);
+      });
+    }
+  }
+
   std::shared_ptr<std::fstream> file;
   std::string file_name;
   std::vector<T> write_buffer;
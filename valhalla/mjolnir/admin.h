@@ -66,6 +66,12 @@ uint32_t GetMultiPolyId(const std::multimap<uint32_t, multi_polygon_type>& polys
 std::vector<std::pair<std::string, bool>>
 GetMultiPolyIndexes(const language_poly_index& language_ploys, const PointLL& ll);
 
+/**
+ * Parses a language tag into a vector of individual tokens.
+ * @param  lang_tag  languages separated by " - " or by semicolons
+ */
+std::vector<std::string> ParseLanguageTokens(const std::string& lang_tag);
+
 /**
  * Get the timezone polys from the db
  * @param  db_handle    sqlite3 db handle
@@ -8,7 +8,16 @@
 namespace valhalla {
 namespace mjolnir {
 
+/**
+ * Builds the admin database from OSM protocol buffer extracts.
+ * @param pt                     mjolnir config, admin is the path of the database.
+ * @param input_files            The extracts.
+ * @param release_osmpbf_memory  Free the protobuf library once parsing is done. Set to false
+ *                               when other threads are still parsing protobufs.
+ * @return Returns true if successful, false if an error occurs.
+ */
 bool BuildAdminFromPBF(const boost::property_tree::ptree& pt,
-                       const std::vector<std::string>& input_files);
+                       const std::vector<std::string>& input_files,
+                       const bool release_osmpbf_memory = true);
 }
 } // namespace valhalla
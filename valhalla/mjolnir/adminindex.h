@@ -0,0 +1,131 @@
+#ifndef VALHALLA_MJOLNIR_ADMININDEX_H_
+#define VALHALLA_MJOLNIR_ADMININDEX_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/sequence.h>
+#include <valhalla/mjolnir/admin.h>
+#include <valhalla/mjolnir/graphtilebuilder.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * A read only spatial index of the admin or timezone polygons in one of the spatialite dbs. It is
+ * built from the db once and memory mapped afterwards so that graph building can find the admins
+ * and timezones of a tile without running SQL or parsing WKT for every tile.
+ *
+ * The file is a packed R-tree (sort tile recursive) over the bounding boxes of the polygons,
+ * followed by the polygons as flat arrays of rings and points, the admin access rows and a table
+ * of strings. Polygons are kept in the order the SQL queries return them in so that tiles get
+ * the same admin indexes as they would from the db.
+ */
+class AdminIndex {
+public:
+  // The db the index was built from
+  enum class Kind : uint32_t { kAdmins = 0, kTimezones = 1 };
+
+  /**
+   * Memory maps an index file. Throws std::runtime_error if the file is not a valid index.
+   * @param file  the index file
+   */
+  explicit AdminIndex(const std::string& file);
+
+  /**
+   * Builds an index from a spatialite db. The file is written next to its final location and
+   * moved into place once complete.
+   * @param db_handle  sqlite3 db handle, must have spatialite loaded
+   * @param kind       whether the db holds admins or timezones
+   * @param file       the index file to write
+   * @return true if the index was written
+   */
+  static bool Build(sqlite3* db_handle, Kind kind, const std::string& file);
+
+  /**
+   * The index file that belongs with a db
+   * @param database  db file location
+   */
+  static std::string IndexPath(const std::string& database);
+
+  /**
+   * Opens the index of a db, building it first if it is missing or was built from another
+   * version of the db.
+   * @param database  db file location
+   * @param kind      whether the db holds admins or timezones
+   * @return the index or nullptr if there is no db or the index could not be built
+   */
+  static std::unique_ptr<AdminIndex> Open(const std::string& database, Kind kind);
+
+  /**
+   * Get the admin polys that intersect with the tile bounding box. Same as the sqlite version
+   * in admin.h, see there for the parameters.
+   */
+  std::multimap<uint32_t, multi_polygon_type>
+  GetAdminInfo(std::unordered_map<uint32_t, bool>& drive_on_right,
+               std::unordered_map<uint32_t, bool>& allow_intersection_names,
+               language_poly_index& language_polys,
+               const AABB2<PointLL>& aabb,
+               GraphTileBuilder& tilebuilder) const;
+
+  /**
+   * Get the timezone polys that intersect with the tile bounding box
+   * @param  aabb  bb of the tile
+   */
+  std::multimap<uint32_t, multi_polygon_type> GetTimeZones(const AABB2<PointLL>& aabb) const;
+
+  /**
+   * Get all the country access records, same as the sqlite version in admin.h
+   */
+  std::unordered_map<std::string, std::vector<int>> GetCountryAccess() const;
+
+  /**
+   * @return whether the index holds admins or timezones
+   */
+  Kind kind() const;
+
+  /**
+   * @return the number of polygons in the index
+   */
+  size_t size() const;
+
+  // Parts of the file layout, public only so the builder can write them
+  struct Header;
+  struct Node;
+  struct Entry;
+  struct Ring;
+  struct Access;
+
+protected:
+  // The entries whose polygons intersect the box along with those polygons, in the order the
+  // SQL queries returned them in
+  std::vector<std::pair<const Entry*, multi_polygon_type>> Query(const AABB2<PointLL>& aabb) const;
+
+  // Copies the polygons of an entry out of the file
+  multi_polygon_type Polygons(const Entry& entry) const;
+
+  // A string from the string table
+  std::string String(uint32_t offset) const;
+
+  midgard::mem_map<char> memmap_;
+  const Header* header_;
+  const Node* nodes_;
+  const Entry* entries_;
+  const Access* access_;
+  const Ring* rings_;
+  const double* points_;
+  const char* strings_;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_ADMININDEX_H_
@@ -2,6 +2,7 @@
 #define VALHALLA_MJOLNIR_ELEVATIONBUILDER_H
 
 #include <deque>
+#include <unordered_set>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -19,10 +20,15 @@ public:
    * @brief Add elevation information to the graph tiles.
    * param[in] config Config file to set ElevationBuilder properties
    * param[in] tile_ids Sequence of valhalla tile ids to build elevation tiles for.
+   * param[in] affected_tiles Tiles touched by the change since the previous build. When
+   *           mjolnir.previous_build.tile_dir is set, the other tiles copy the elevation
+   *           of the edges and nodes whose geometry did not change from the previous build
+   *           instead of sampling it again.
    * @attention It is considered that tiles are from the directory specified in config file.
    */
   static void Build(const boost::property_tree::ptree& config,
-                    std::deque<baldr::GraphId> tile_ids = {});
+                    std::deque<baldr::GraphId> tile_ids = {},
+                    const std::unordered_set<baldr::GraphId>& affected_tiles = {});
 };
 
 } // namespace mjolnir
@@ -63,6 +63,14 @@ public:
    */
   void StoreTileData();
 
+  /**
+   * Output the tile to file below a different tile directory than the one it
+   * was read from. Lets parallel builders stage their output while other
+   * threads may still be reading the original tile.
+   * @param  tile_dir  Base directory path to store the tile under.
+   */
+  void StoreTileData(const std::string& tile_dir);
+
   /**
    * Update a graph tile with new nodes and directed edges. Assumes no new
    * nodes or edges are added. Attributes within existing nodes and edges
@@ -22,11 +22,6 @@ public:
    */
   OSMAccessRestriction();
 
-  /**
-   * Destructor.
-   */
-  ~OSMAccessRestriction();
-
   /**
    * Set the restriction type
    */
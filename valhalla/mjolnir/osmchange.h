@@ -0,0 +1,60 @@
+#ifndef VALHALLA_MJOLNIR_OSMCHANGE_H
+#define VALHALLA_MJOLNIR_OSMCHANGE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * The OSM objects touched by an OSM change file (.osc or .osc.gz). Creations,
+ * modifications and deletions are not told apart, all that matters for a rebuild
+ * is which parts of the graph they touch.
+ */
+struct OSMChange {
+  // Ids of the nodes in the change
+  std::unordered_set<uint64_t> nodes;
+
+  // Ids of the ways in the change along with the ways that are members of a changed relation
+  std::unordered_set<uint64_t> ways;
+
+  // Ids of the relations in the change
+  std::unordered_set<uint64_t> relations;
+
+  // Locations of the nodes in the change that carry one
+  std::vector<midgard::PointLL> locations;
+
+  /**
+   * Reads an OSM change file with libosmium's xml parser, streaming it object by object.
+   * Files ending in .gz are inflated on the fly. Throws std::runtime_error if the file
+   * cannot be read.
+   * @param  filename  Path to the .osc or .osc.gz file.
+   * @return the objects touched by the change.
+   */
+  static OSMChange Read(const std::string& filename);
+
+  /**
+   * Finds the tiles, at every level of the hierarchy, that need rebuilding because of
+   * this change. A tile is affected when one of its edges belongs to a changed way, in
+   * either the current or the previous build, or when a changed node lies within it.
+   * The hierarchy parents of every affected tile are affected as well.
+   * @param  pt                 Config, mjolnir.tile_dir holds the current build.
+   * @param  previous_tile_dir  Tile directory of the previous build.
+   * @return the ids of the affected tiles.
+   */
+  std::unordered_set<baldr::GraphId> AffectedTiles(const boost::property_tree::ptree& pt,
+                                                   const std::string& previous_tile_dir) const;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_OSMCHANGE_H
@@ -12,6 +12,7 @@
 #include <valhalla/mjolnir/osmnodelinguistic.h>
 #include <valhalla/mjolnir/osmrestriction.h>
 #include <valhalla/mjolnir/osmway.h>
+#include <valhalla/mjolnir/sortedmultimap.h>
 #include <valhalla/mjolnir/uniquenames.h>
 
 namespace valhalla {
@@ -42,18 +43,18 @@ struct OSMLaneConnectivity {
   uint32_t from_lanes_index; // Index to string in UniqueNames
 };
 
-// Data types used within OSMData
-using RestrictionsMultiMap = std::unordered_multimap<uint64_t, OSMRestriction>;
-using ViaSet = std::unordered_set<uint64_t>;
-using AccessRestrictionsMultiMap = std::unordered_multimap<uint64_t, OSMAccessRestriction>;
-using BikeMultiMap = std::unordered_multimap<uint64_t, OSMBike>;
-using OSMLaneConnectivityMultiMap = std::unordered_multimap<uint64_t, OSMLaneConnectivity>;
-using LinguisticMultiMap = std::unordered_multimap<uint64_t, OSMLinguistic>;
-using ConditionalSpeedLimitsMultiMap =
-    std::unordered_multimap<uint64_t, baldr::ConditionalSpeedLimit>;
+// Data types used within OSMData. These are sorted arrays so that they can be written to and
+// used straight from the memory mapped temporary files between stages of the build
+using RestrictionsMultiMap = SortedMultiMap<uint64_t, OSMRestriction>;
+using ViaSet = SortedSet<uint64_t>;
+using AccessRestrictionsMultiMap = SortedMultiMap<uint64_t, OSMAccessRestriction>;
+using BikeMultiMap = SortedMultiMap<uint64_t, OSMBike>;
+using OSMLaneConnectivityMultiMap = SortedMultiMap<uint64_t, OSMLaneConnectivity>;
+using LinguisticMultiMap = SortedMultiMap<uint64_t, OSMLinguistic>;
+using ConditionalSpeedLimitsMultiMap = SortedMultiMap<uint64_t, baldr::ConditionalSpeedLimit>;
 
 // OSMString map uses the way Id as the key and the name index into UniqueNames as the value
-using OSMStringMap = std::unordered_map<uint64_t, uint32_t>;
+using OSMStringMap = SortedMultiMap<uint64_t, uint32_t>;
 
 /**
  * Simple container for OSM data.
@@ -78,6 +79,13 @@ struct OSMData {
    */
   bool read_from_unique_names_file(const std::string& tile_dir);
 
+  /**
+   * Sorts the restriction, relation and linguistic data so it can be looked up. Must be
+   * called once parsing has added to it. Refs added to the same way via add_to_name_map
+   * are joined here.
+   */
+  void sort();
+
   /**
    * add the direction information to the forward or reverse map for relations.
    */
@@ -105,7 +113,7 @@ struct OSMData {
   // Stores simple restrictions. Indexed by the from way Id
   RestrictionsMultiMap restrictions;
 
-  // unordered set used to find out if a wayid is included in any vias for complex restrictions
+  // set used to find out if a wayid is included in any vias for complex restrictions
   ViaSet via_set;
 
   // Stores access restrictions. Indexed by the from way Id.
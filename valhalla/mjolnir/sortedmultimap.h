@@ -0,0 +1,252 @@
+#ifndef VALHALLA_MJOLNIR_SORTEDMULTIMAP_H
+#define VALHALLA_MJOLNIR_SORTEDMULTIMAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <valhalla/midgard/logging.h>
+#include <valhalla/midgard/sequence.h>
+
+namespace valhalla {
+namespace mjolnir {
+
+/**
+ * Key and value pair stored within a SortedMultiMap. Unlike std::pair it is trivially
+ * copyable so that an array of them can be written to and mapped from a file as is.
+ */
+template <class Key, class Value> struct KeyValue {
+  Key first;
+  Value second;
+
+  KeyValue() : first{}, second{} {
+  }
+  KeyValue(const Key& k, const Value& v) : first(k), second(v) {
+  }
+  KeyValue(const std::pair<Key, Value>& p) : first(p.first), second(p.second) {
+  }
+};
+
+/**
+ * An array of records kept sorted by key. Records are appended while parsing and sorted
+ * once (stable, so records with equal keys keep their insertion order) before lookups,
+ * which are binary searches. The sorted array is the file format: writing dumps it as
+ * is and reading maps the file read only so lookups run directly on the mapped pages
+ * without parsing or allocating. Inserting into mapped records first copies them into
+ * memory, which only happens when a build is resumed from a stage that adds records.
+ */
+template <class Record, class Key, class KeyOf> class SortedRecords {
+public:
+  static_assert(std::is_trivially_copyable<Record>::value,
+                "Records are written to and mapped from files as is");
+
+  using key_type = Key;
+  using value_type = Record;
+  using const_iterator = const Record*;
+  using iterator = const_iterator;
+
+  SortedRecords() : sorted_(true) {
+  }
+
+  /**
+   * Appends a record. Lookups are not possible until sort() is called, unless records
+   * are appended in key order.
+   */
+  void insert(const Record& record) {
+    materialize();
+    if (!records_.empty() && KeyOf()(record) < KeyOf()(records_.back())) {
+      sorted_ = false;
+    }
+    records_.push_back(record);
+  }
+
+  template <class... Args> void emplace(Args&&... args) {
+    insert(Record(std::forward<Args>(args)...));
+  }
+
+  void reserve(size_t count) {
+    materialize();
+    records_.reserve(count);
+  }
+
+  void clear() {
+    map_.reset();
+    records_.clear();
+    sorted_ = true;
+  }
+
+  /**
+   * Sorts the records by key, records with equal keys keep their insertion order.
+   */
+  void sort() {
+    if (sorted_) {
+      return;
+    }
+    std::stable_sort(records_.begin(), records_.end(), [](const Record& a, const Record& b) {
+      return KeyOf()(a) < KeyOf()(b);
+    });
+    sorted_ = true;
+  }
+
+  /**
+   * Sorts the records and collapses every run of records with equal keys into its first
+   * record, calling combine(first, other) for each of the others in insertion order.
+   */
+  template <class Combine> void unique(const Combine& combine) {
+    sort();
+    // leave records (mapped ones especially) alone when there is nothing to collapse
+    auto equal = [](const Record& a, const Record& b) { return KeyOf()(a) == KeyOf()(b); };
+    if (std::adjacent_find(begin(), end(), equal) == end()) {
+      return;
+    }
+    materialize();
+    auto out = records_.begin();
+    for (auto in = std::next(out); in != records_.end(); ++in) {
+      if (KeyOf()(*in) == KeyOf()(*out)) {
+        combine(*out, *in);
+      } else {
+        *++out = *in;
+      }
+    }
+    records_.erase(std::next(out), records_.end());
+  }
+
+  const_iterator begin() const {
+    return map_ ? map_->get() : records_.data();
+  }
+  const_iterator end() const {
+    return begin() + size();
+  }
+  const_iterator cbegin() const {
+    return begin();
+  }
+  const_iterator cend() const {
+    return end();
+  }
+  size_t size() const {
+    return map_ ? map_->size() : records_.size();
+  }
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * Returns the range of records with the given key, or (end(), end()) if there are none.
+   */
+  std::pair<const_iterator, const_iterator> equal_range(const Key& key) const {
+    check_sorted();
+    auto lower = std::lower_bound(begin(), end(), key,
+                                  [](const Record& r, const Key& k) { return KeyOf()(r) < k; });
+    auto upper = std::upper_bound(lower, end(), key,
+                                  [](const Key& k, const Record& r) { return k < KeyOf()(r); });
+    if (lower == upper) {
+      return {end(), end()};
+    }
+    return {lower, upper};
+  }
+
+  const_iterator find(const Key& key) const {
+    return equal_range(key).first;
+  }
+
+  size_t count(const Key& key) const {
+    auto range = equal_range(key);
+    return range.second - range.first;
+  }
+
+  /**
+   * Writes the sorted records to a file.
+   * @return Returns true if successful, false if an error occurs.
+   */
+  bool write(const std::string& filename) {
+    sort();
+    // the file may be the one we have mapped so let go of it before truncating it
+    materialize();
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("Failed to open output file: " + filename);
+      return false;
+    }
+    file.write(reinterpret_cast<const char*>(records_.data()), records_.size() * sizeof(Record));
+    return !file.fail();
+  }
+
+  /**
+   * Maps the sorted records of a file written by write(). Any records held before are
+   * dropped.
+   * @return Returns true if successful, false if an error occurs.
+   */
+  bool read(const std::string& filename) {
+    clear();
+    struct stat s;
+    if (stat(filename.c_str(), &s) || s.st_size % sizeof(Record) != 0) {
+      LOG_ERROR("Failed to read input file: " + filename);
+      return false;
+    }
+    size_t count = s.st_size / sizeof(Record);
+    if (count > 0) {
+      map_ = std::make_shared<midgard::mem_map<Record>>();
+      map_->map_readonly(filename, count, POSIX_MADV_RANDOM);
+    }
+    return true;
+  }
+
+protected:
+  void check_sorted() const {
+    if (!sorted_) {
+      throw std::logic_error("Lookup into records which have not been sorted");
+    }
+  }
+
+  // Copies mapped records into memory so they can be modified
+  void materialize() {
+    if (map_) {
+      records_.assign(map_->get(), map_->get() + map_->size());
+      map_.reset();
+    }
+  }
+
+  // The records when held in memory
+  std::vector<Record> records_;
+
+  // The records when mapped from a file. Shared so that copies of the container stay cheap
+  std::shared_ptr<midgard::mem_map<Record>> map_;
+
+  bool sorted_;
+};
+
+template <class Key, class Value> struct KeyOfKeyValue {
+  const Key& operator()(const KeyValue<Key, Value>& r) const {
+    return r.first;
+  }
+};
+
+template <class Key> struct KeyOfKey {
+  const Key& operator()(const Key& k) const {
+    return k;
+  }
+};
+
+/**
+ * Multimap over a sorted array of KeyValue records, see SortedRecords.
+ */
+template <class Key, class Value>
+using SortedMultiMap = SortedRecords<KeyValue<Key, Value>, Key, KeyOfKeyValue<Key, Value>>;
+
+/**
+ * Set over a sorted array of keys, see SortedRecords. Duplicates are kept, which
+ * does not matter for membership tests.
+ */
+template <class Key> using SortedSet = SortedRecords<Key, Key, KeyOfKey<Key>>;
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_SORTEDMULTIMAP_H
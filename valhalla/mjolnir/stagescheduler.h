@@ -0,0 +1,64 @@
+#ifndef VALHALLA_MJOLNIR_STAGESCHEDULER_H_
+#define VALHALLA_MJOLNIR_STAGESCHEDULER_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace valhalla {
+namespace mjolnir {
+
+// How long a stage ran and the peak memory of the process while it did
+struct StageTiming {
+  std::string name;
+  double start;      // seconds since the scheduler started running
+  double duration;   // seconds the stage ran for
+  uint64_t peak_rss; // peak resident set size in bytes, 0 if it could not be measured
+};
+
+/**
+ * Runs a directed acyclic graph of build stages. A stage starts as soon as all of the
+ * stages it depends on have finished so that stages which do not depend on one another
+ * run concurrently. Dependencies on stages that were never added are considered met,
+ * which lets callers add only the part of the pipeline they want to run.
+ */
+class StageScheduler {
+public:
+  /**
+   * Adds a stage. Stages that are ready at the same time start in the order they were added.
+   * @param name          Unique name of the stage.
+   * @param work          The work of the stage.
+   * @param dependencies  Names of the stages that must finish before this one starts.
+   */
+  void add(const std::string& name,
+           const std::function<void()>& work,
+           const std::vector<std::string>& dependencies = {});
+
+  /**
+   * Runs all the stages, blocking until they are done. If a stage throws no more stages
+   * are started and, once the running ones finish, the first exception is rethrown.
+   * Throws std::logic_error if the dependencies form a cycle.
+   * @param concurrency  The maximum number of stages to run at once.
+   * @return the timings of the stages in the order they finished.
+   */
+  std::vector<StageTiming> run(unsigned int concurrency);
+
+  /**
+   * Peak resident set size of this process in bytes, 0 where it cannot be measured.
+   */
+  static uint64_t peak_rss();
+
+private:
+  struct Stage {
+    std::string name;
+    std::function<void()> work;
+    std::vector<std::string> dependencies;
+  };
+  std::vector<Stage> stages_;
+};
+
+} // namespace mjolnir
+} // namespace valhalla
+
+#endif // VALHALLA_MJOLNIR_STAGESCHEDULER_H_
@@ -1,10 +1,15 @@
 #ifndef VALHALLA_MJOLNIR_UTIL_H_
 #define VALHALLA_MJOLNIR_UTIL_H_
 
+#include <atomic>
 #include <boost/property_tree/ptree.hpp>
+#include <exception>
+#include <future>
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -206,16 +211,20 @@ struct TileManifest {
   std::map<baldr::GraphId, size_t> tileset;
 
   std::string ToString() const {
-    baldr::json::ArrayPtr array = baldr::json::array({});
+    rapidjson::writer_wrapper_t writer(64 + tileset.size() * 96);
+    writer.start_object();
+    writer.start_array("tiles");
     for (const auto& tile : tileset) {
-      const baldr::json::Value& graphid = tile.first.json();
-      const baldr::json::MapPtr& item = baldr::json::map(
-          {{"graphid", graphid}, {"node_index", static_cast<uint64_t>(tile.second)}});
-      array->emplace_back(item);
+      writer.start_object();
+      writer.start_object("graphid");
+      tile.first.json(writer);
+      writer.end_object();
+      writer("node_index", static_cast<uint64_t>(tile.second));
+      writer.end_object();
     }
-    std::stringstream manifest;
-    manifest << *baldr::json::map({{"tiles", array}});
-    return manifest.str();
+    writer.end_array();
+    writer.end_object();
+    return writer.get_buffer();
   }
 
   void LogToFile(const std::string& filename) const {
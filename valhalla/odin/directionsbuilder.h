@@ -1,6 +1,7 @@
 #ifndef VALHALLA_ODIN_DIRECTIONSBUILDER_H_
 #define VALHALLA_ODIN_DIRECTIONSBUILDER_H_
 
+#include <cstddef>
 #include <list>
 
 #include <valhalla/odin/enhancedtrippath.h>
@@ -26,10 +27,27 @@ public:
    *
    * @param api   the protobuf object containing the request, the path and a place
    *              to store the resulting directions
+   * @param markup_formatter  the markup formatter used by the narrative
+   * @param concurrency  the number of threads to build the legs of the routes on, the helper
+   *                     threads are shared by all callers. The directions are in the same
+   *                     order regardless
    */
-  static void Build(Api& api, const MarkupFormatter& markup_formatter);
+  static void Build(Api& api, const MarkupFormatter& markup_formatter, size_t concurrency = 1);
 
 protected:
+  /**
+   * Builds the maneuvers, narrative and directions of a single trip leg.
+   *
+   * @param options The directions options.
+   * @param trip_path The trip leg to build the directions of.
+   * @param markup_formatter The markup formatter used by the narrative.
+   * @param trip_directions The directions leg to populate.
+   */
+  static void BuildLeg(const Options& options,
+                       TripLeg& trip_path,
+                       const MarkupFormatter& markup_formatter,
+                       DirectionsLeg& trip_directions);
+
   /**
    * Update the heading of ~0 length edges.
    *
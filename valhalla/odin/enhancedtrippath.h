@@ -92,13 +92,17 @@ public:
     return trip_path_.summary();
   }
 
-  std::unique_ptr<EnhancedTripLeg_Node> GetEnhancedNode(const int node_index);
+  EnhancedTripLeg_Node* GetEnhancedNode(const int node_index);
 
-  std::unique_ptr<EnhancedTripLeg_Edge> GetPrevEdge(const int node_index, int delta = 1);
+  EnhancedTripLeg_Edge* GetPrevEdge(const int node_index, int delta = 1);
 
-  std::unique_ptr<EnhancedTripLeg_Edge> GetCurrEdge(const int node_index) const;
+  EnhancedTripLeg_Edge* GetCurrEdge(const int node_index);
 
-  std::unique_ptr<EnhancedTripLeg_Edge> GetNextEdge(const int node_index, int delta = 1) const;
+  const EnhancedTripLeg_Edge* GetCurrEdge(const int node_index) const;
+
+  EnhancedTripLeg_Edge* GetNextEdge(const int node_index, int delta = 1);
+
+  const EnhancedTripLeg_Edge* GetNextEdge(const int node_index, int delta = 1) const;
 
   bool IsValidNodeIndex(int node_index) const;
 
@@ -122,6 +126,11 @@ public:
 
 protected:
   TripLeg& trip_path_;
+
+  // The nodes and edges of the leg are wrapped once, in node index order, so that walking the
+  // path does not allocate a wrapper per access. The last node has no edge.
+  std::vector<EnhancedTripLeg_Node> nodes_;
+  std::vector<EnhancedTripLeg_Edge> edges_;
 };
 
 class EnhancedTripLeg_Edge {
@@ -674,7 +683,7 @@ public:
   bool HasNonBackwardTraversableSameNameRampIntersectingEdge(uint32_t from_heading,
                                                              const TravelMode travel_mode);
 
-  std::unique_ptr<EnhancedTripLeg_IntersectingEdge> GetIntersectingEdge(size_t index);
+  EnhancedTripLeg_IntersectingEdge* GetIntersectingEdge(size_t index);
 
   void CalculateRightLeftIntersectingEdgeCounts(uint32_t from_heading,
                                                 const TravelMode travel_mode,
@@ -767,6 +776,9 @@ public:
 
 protected:
   TripLeg_Node* mutable_node_;
+
+  // The intersecting edges wrapped once when the node is
+  std::vector<EnhancedTripLeg_IntersectingEdge> intersecting_edges_;
 };
 
 class EnhancedTripLeg_Admin {
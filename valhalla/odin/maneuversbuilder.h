@@ -232,7 +232,7 @@ protected:
    *
    * @param maneuver The maneuver at the intersection.
    */
-  uint16_t GetExpectedTurnLaneDirection(std::unique_ptr<EnhancedTripLeg_Edge>& turn_lane_edge,
+  uint16_t GetExpectedTurnLaneDirection(EnhancedTripLeg_Edge* turn_lane_edge,
                                         const Maneuver& maneuver) const;
 
   /**
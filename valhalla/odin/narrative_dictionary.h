@@ -1,9 +1,13 @@
 #ifndef VALHALLA_ODIN_NARRATIVE_DICTIONARY_H_
 #define VALHALLA_ODIN_NARRATIVE_DICTIONARY_H_
 
+#include <cstdint>
+#include <initializer_list>
 #include <locale>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <boost/property_tree/ptree.hpp>
@@ -174,8 +178,65 @@ constexpr auto kLevelTag = "<LEVEL>";
 namespace valhalla {
 namespace odin {
 
+/**
+ * A phrase split into the literal text between its tags and the tags themselves. The phrases are
+ * parsed once when the dictionary is loaded so that an instruction can be rendered in a single
+ * pass over the phrase rather than copying it and replacing each of its tags in turn.
+ */
+class PhraseTemplate {
+public:
+  // A tag and the value to render in its place
+  using TagValue = std::pair<std::string_view, std::string_view>;
+
+  PhraseTemplate() = default;
+
+  /**
+   * Parses a phrase. Tags are the upper case names in angle brackets, eg. <STREET_NAMES>.
+   * @param  phrase  the tagged phrase from the locale
+   */
+  explicit PhraseTemplate(const std::string& phrase);
+
+  /**
+   * Renders the phrase with its tags replaced by values. Tags without a value are rendered as
+   * they are, the same as the phrase text.
+   * @param  output  buffer to render into, it is cleared first so that its capacity is reused
+   * @param  values  the tags and their values
+   */
+  void Render(std::string& output, std::initializer_list<TagValue> values = {}) const;
+
+  /**
+   * @return the tagged phrase text
+   */
+  const std::string& text() const {
+    return text_;
+  }
+
+protected:
+  // A literal span of the phrase text or, if it is a tag, the span of the tag
+  struct Token {
+    uint32_t offset;
+    uint32_t length;
+    bool tag;
+  };
+
+  std::string text_;
+  std::vector<Token> tokens_;
+};
+
 struct PhraseSet {
   std::unordered_map<std::string, std::string> phrases;
+
+  // The phrases parsed into templates indexed by their numeric phrase id
+  std::vector<PhraseTemplate> templates;
+
+  /**
+   * Returns the template of the specified phrase id. Throws std::out_of_range if the phrase
+   * does not exist, the same as looking it up in phrases.
+   *
+   * @param  phrase_id  the phrase id
+   * @return the template of the phrase.
+   */
+  const PhraseTemplate& phrase(uint32_t phrase_id) const;
 };
 
 struct StartSubset : PhraseSet {
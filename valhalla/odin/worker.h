@@ -32,6 +32,8 @@ public:
 
 protected:
   MarkupFormatter markup_formatter_;
+  // how many threads the legs of a request are built on
+  size_t concurrency_;
 
 private:
   std::string service_name() const override {
@@ -52,6 +52,26 @@ public:
    */
   template <class coords_t> std::vector<double> get_all(const coords_t& coords);
 
+  /**
+   * @brief Loads and, if it is compressed, decompresses the data of a tile ahead of it being
+   *        sampled so that samples from it later do not have to wait. Safe to call while other
+   *        threads are sampling
+   * @param index  the index of the tile, see get_tile_index
+   * @return true if there is data for the tile
+   */
+  bool prefetch(uint16_t index);
+
+  /**
+   * @return How many decompressed tiles are kept in memory for reuse. Prefetching more tiles than
+   *         that ahead of sampling them gets the first ones evicted before they are sampled
+   */
+  static size_t unpacked_cache_size();
+
+  /**
+   * @return A tile index value from a coordinate
+   */
+  template <class coord_t> static uint16_t get_tile_index(const coord_t& coord);
+
 protected:
   /**
    * Get a single sample from the datasource
@@ -63,11 +83,6 @@ protected:
    */
   template <class coord_t> double get(const coord_t& coord, tile_data& tile);
 
-  /**
-   * @return A tile index value from a coordinate
-   */
-  template <class coord_t> static uint16_t get_tile_index(const coord_t& coord);
-
   /**
    * @brief Adds single tile in cache. Used only in tests
    * @param path path to the tile
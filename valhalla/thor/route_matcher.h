@@ -20,7 +20,9 @@ class RouteMatcher {
 public:
   /**
    * Form a path by matching shape with graph edges (edge walking). Also sets the path_edges
-   * on the appropriate locations in the shape so that trip leg builder will have that info
+   * on the appropriate locations in the shape so that trip leg builder will have that info.
+   * If the options carry the edge ids of the prior route the path is formed by looking them up
+   * rather than by walking the shape.
    *
    * @param mode_costing   Dynamic costing methods used to determine allowed edges and costs.
    * @param mode           Travel mode (indexes the costing methods).
@@ -2,7 +2,9 @@
 #define VALHALLA_TYR_ACTOR_H_
 
 #include <boost/property_tree/ptree.hpp>
+#include <future>
 #include <memory>
+#include <vector>
 
 #include <valhalla/baldr/graphreader.h>
 #include <valhalla/proto/api.pb.h>
@@ -142,6 +144,56 @@ public:
                                const std::function<void()>* interrupt = nullptr,
                                Api* api = nullptr);
 
+  /**
+   * Called with the index of a request in a batch and its json (or error json) response as soon as
+   * the request is done. Calls are serialized but happen in the order requests finish.
+   */
+  using result_callback_t = std::function<void(size_t, const std::string&)>;
+  using trace_result_callback_t = result_callback_t;
+
+  /**
+   * Perform the trace_attributes action on a batch of traces. The request is a json object with a
+   * "traces" array, each element of which holds the shape (or encoded_polyline) and any other
+   * options of a single trace_attributes request. Options at the top level of the request apply to
+   * all traces which don't override them. Traces are matched concurrently on the pool of workers
+   * used by submit. Only the exception thrown by the interrupt stops the batch, any other problem
+   * ends up in the response of its trace.
+   * @param request_str  json string with the shared options and the traces
+   * @param interrupt    allows the underlying computation to be aborted via the functor throwing
+   * @param on_result    optional callback to stream each trace's response as soon as it's ready
+   * @return json array of the responses (or errors) of all traces in the order of the request
+   */
+  std::string trace_attributes_batch(const std::string& request_str,
+                                     const std::function<void()>* interrupt = nullptr,
+                                     const trace_result_callback_t& on_result = nullptr);
+
+  /**
+   * Submit a json request of any action to a pool of workers and return without waiting for it.
+   * Each worker has its own loki/thor/odin workers and a graph reader sharing the tiles of the
+   * actor's reader (see GraphReader::ShareTiles). The pool is kept around between calls and is
+   * shared with batch and trace_attributes_batch, its size is configured via thor.batch_concurrency
+   * (defaults to the number of cores). Unlike the other actions this may be called from several
+   * threads at once
+   * @param action       the action to perform
+   * @param request_str  json string of the request
+   * @return the future response, getting it rethrows any error of the request
+   */
+  std::future<std::string> submit(Options::Action action, const std::string& request_str);
+
+  /**
+   * Perform a batch of json requests of the same action concurrently on the pool of workers used
+   * by submit. A problem with one of the requests only ends up in its (error json) response
+   * @param action     the action of all the requests
+   * @param requests   json strings of the requests
+   * @param interrupt  allows the underlying computation to be aborted via the functor throwing
+   * @param on_result  optional callback to stream each response as soon as it's ready
+   * @return the responses (or errors) of all the requests in the order of the requests
+   */
+  std::vector<std::string> batch(Options::Action action,
+                                 const std::vector<std::string>& requests,
+                                 const std::function<void()>* interrupt = nullptr,
+                                 const result_callback_t& on_result = nullptr);
+
   /**
    * Perform the height action and return json or protobuf depending on which was requested. The
    * request may either be in the form of a json string provided by the request_str parameter or
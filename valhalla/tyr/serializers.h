@@ -101,12 +101,8 @@ std::string serializeTraceAttributes(
  */
 std::string serializeStatus(Api& request);
 
-// Return a JSON array of OpenLR 1.5 line location references for each edge of a map matching
+// Writes a JSON array of OpenLR 1.5 line location references for each edge of a map matching
 // result. For the time being, result is only non-empty for auto costing requests.
-void route_references(baldr::json::MapPtr& route_json,
-                      const TripRoute& route,
-                      const Options& options);
-
 void openlr(const valhalla::Api& api, int route_index, rapidjson::writer_wrapper_t& writer);
 
 /**
@@ -122,15 +118,14 @@ std::string serializePbf(Api& request);
  * @return json string
  */
 void serializeWarnings(const valhalla::Api& api, rapidjson::writer_wrapper_t& writer);
-baldr::json::ArrayPtr serializeWarnings(const valhalla::Api& api);
 
 /**
- * Turns a line into a GeoJSON LineString geometry.
+ * Writes a line as the members of a GeoJSON LineString geometry into the currently open object.
  *
- * @param shape  The points making up the line.
- * @returns The GeoJSON geometry of the LineString
+ * @param shape   The points making up the line.
+ * @param writer  The writer to write the geometry to
  */
-baldr::json::MapPtr geojson_shape(const std::vector<midgard::PointLL> shape);
+void geojson_shape(const std::vector<midgard::PointLL>& shape, rapidjson::writer_wrapper_t& writer);
 
 // Elevation serialization support
 
@@ -253,19 +248,21 @@ namespace osrm {
  * Serialize a location into a osrm waypoint
  * http://project-osrm.org/docs/v5.5.1/api/#waypoint-object
  */
-valhalla::baldr::json::MapPtr
-waypoint(const valhalla::Location& location, bool is_tracepoint = false, bool is_optimized = false);
+void waypoint(const valhalla::Location& location,
+              rapidjson::writer_wrapper_t& writer,
+              bool is_tracepoint = false,
+              bool is_optimized = false);
 
 /*
- * Serialize locations into osrm waypoints
+ * Serialize locations into osrm waypoints, one array element per location
  */
-valhalla::baldr::json::ArrayPtr
-waypoints(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
-          bool tracepoints = false);
-valhalla::baldr::json::ArrayPtr waypoints(const valhalla::Trip& locations);
-valhalla::baldr::json::ArrayPtr intermediate_waypoints(const valhalla::TripLeg& leg);
+void waypoints(const google::protobuf::RepeatedPtrField<valhalla::Location>& locations,
+               rapidjson::writer_wrapper_t& writer,
+               bool tracepoints = false);
+void waypoints(const valhalla::Trip& locations, rapidjson::writer_wrapper_t& writer);
+void intermediate_waypoints(const valhalla::TripLeg& leg, rapidjson::writer_wrapper_t& writer);
 
-void serializeIncidentProperties(rapidjson::Writer<rapidjson::StringBuffer>& writer,
+void serializeIncidentProperties(rapidjson::writer_wrapper_t& writer,
                                  const valhalla::IncidentsTile::Metadata& incident_metadata,
                                  const int begin_shape_index,
                                  const int end_shape_index,
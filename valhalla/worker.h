@@ -1,6 +1,10 @@
 #ifndef __VALHALLA_SERVICE_H__
 #define __VALHALLA_SERVICE_H__
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <valhalla/baldr/json.h>
 #include <valhalla/baldr/rapidjson_utils.h>
@@ -62,6 +66,16 @@ struct valhalla_exception_t : public std::runtime_error {
  */
 void ParseApi(const std::string& json_request, Options::Action action, Api& api, const odin::json_locales_map_t customLocales = odin::json_locales_map_t());
 // void ParseApi(const std::string& json_request, Options::Action action, Api& api);
+
+/**
+ * Validate an already parsed json request and fill out the pbf request with it
+ *
+ * @param document      The parsed json request, it may be modified while being validated
+ * @param action        Which action to perform
+ * @param api           The pbf request which will be filled out with the json provided
+ * @param customLocales optional custom locales (to be added to built ones)
+ */
+void ParseApi(rapidjson::Document& document, Options::Action action, Api& api, const odin::json_locales_map_t customLocales = odin::json_locales_map_t());
 #ifdef ENABLE_SERVICES
 /**
  * Take the json OR pbf request and parse/validate it. If you pass a protobuf mime type in the request
@@ -99,6 +113,7 @@ const content_type JSON_MIME{"Content-type", "application/json;charset=utf-8"};
 const content_type JS_MIME{"Content-type", "application/javascript;charset=utf-8"};
 const content_type PBF_MIME{"Content-type", "application/x-protobuf"};
 const content_type GPX_MIME{"Content-type", "application/gpx+xml;charset=utf-8"};
+const content_type BINARY_MIME{"Content-type", "application/octet-stream"};
 } // namespace worker
 
 prime_server::worker_t::result_t to_response(const std::string& data,
@@ -106,6 +121,79 @@ prime_server::worker_t::result_t to_response(const std::string& data,
                                              const Api& options);
 #endif
 
+/**
+ * Bounds the work of each action that the workers of a process have in flight at once. The proxies
+ * hand requests to whichever worker is free in the order they came in, so without a bound a burst
+ * of expensive requests, like large matrices or isochrones, can occupy every worker and leave the
+ * cheap ones, like locate or height, waiting behind them. The work of a request is estimated from
+ * its size and a request that doesn't fit within the bound of its action is rejected right away
+ * rather than waiting for a worker. The bounds are per process: the requests are admitted by the
+ * loki workers and their work is in flight until the last stage of this process is done with it,
+ * which with httpd.service.in_process off is the loki stage itself
+ */
+class admission_t {
+public:
+  /**
+   * A claim on some of the work of an action, given back when destroyed
+   */
+  class ticket_t {
+  public:
+    ticket_t(admission_t& admission, Options::Action action, uint64_t work);
+    ~ticket_t();
+    ticket_t(const ticket_t&) = delete;
+    ticket_t& operator=(const ticket_t&) = delete;
+
+  private:
+    admission_t& admission;
+    Options::Action action;
+    uint64_t work;
+  };
+
+  /**
+   * Reads the bounds from httpd.service.admission, which has the most work that each action may
+   * have in flight. Actions without a bound, or a bound of 0, take on any request
+   * @param config  the config of the service
+   */
+  explicit admission_t(const boost::property_tree::ptree& config);
+
+  /**
+   * Estimates the work of a request in the units of its action. Those are the number of sources
+   * times the number of targets for matrices, the number of locations squared for optimized routes,
+   * the number of locations times the largest contour for isochrones, in minutes or kilometers, the
+   * number of shape points for traces and heights and the number of locations otherwise. Each
+   * recosting of the path adds the same work again
+   * @param options  the parsed options of the request
+   * @return the estimated work, at least 1
+   */
+  static uint64_t estimate(const Options& options);
+
+  /**
+   * Claims the work of a request from the bound on its action. Throws valhalla_exception_t 104 if
+   * the action has too much work in flight to take it on right now or 105 if it is more work than
+   * the action may ever have in flight
+   * @param options  the parsed options of the request
+   * @return the claim or nullptr if the action isn't bounded
+   */
+  std::unique_ptr<ticket_t> admit(const Options& options);
+
+  /**
+   * @return whether any of the actions are bounded
+   */
+  bool bounded() const;
+
+  /**
+   * @param action  the action to look at
+   * @return the work of the action which is currently in flight
+   */
+  uint64_t in_flight_work(Options::Action action);
+
+protected:
+  std::mutex mutex;
+  // indexed by action, a limit of 0 means the action is not bounded
+  std::vector<uint64_t> limits;
+  std::vector<uint64_t> in_flight;
+};
+
 struct statsd_client_t;
 class service_worker_t {
 public:
@@ -145,6 +233,46 @@ public:
   virtual void set_interrupt(const std::function<void()>* interrupt);
 
 protected:
+  /**
+   * Makes an empty request object on the protobuf arena of this worker. Every message and string
+   * of the request is then allocated out of the arena instead of one by one on the heap. The arena
+   * is reset by cleanup, once the request has been forwarded on, so that its first block is reused
+   * by the next request. Requests that are handed on in memory between the stages are made on the
+   * heap instead, so the arena is not used when the stages run in process
+   * @return the request object which is only valid until the next call to cleanup
+   */
+  Api& make_request();
+
+  /**
+   * Claims the work of the request from the bound on its action. The claim is handed on with the
+   * request and given back by cleanup in whichever stage finishes the request. The first stage of
+   * the pipeline admits the requests and only when all of the stages run in this process, as
+   * otherwise no one process sees all of the work in flight
+   * @param request  the parsed request
+   */
+  void admit(const Api& request);
+
+#ifdef ENABLE_SERVICES
+  /**
+   * Serializes the request to send it on to the next stage of the pipeline. When all of the stages
+   * run in this process the request object itself is handed on through a registry in this process
+   * and the message is only the id of it there, which saves serializing and parsing the request
+   * again at every stage
+   * @param request  the request to send on, it is left empty if it was handed on
+   * @return the message for the next stage
+   */
+  std::string forward_request(Api& request);
+
+  /**
+   * Parses the request sent on by the previous stage of the pipeline or takes it over if it was
+   * handed on in memory
+   * @param message  the message from the previous stage
+   * @param request  the request to parse into
+   * @return false if the message could not be parsed or has the id of no request handed on
+   */
+  bool receive_request(const zmq::message_t& message, Api& request);
+#endif
+
   /**
    * This converts each protobuf stat into a string and adds it to the queue of unsent stats
    * @param api  The request tracking object which has the tracked stats stored in it
@@ -172,6 +300,17 @@ protected:
 
   const std::function<void()>* interrupt;
   std::unique_ptr<statsd_client_t> statsd_client;
+  std::vector<char> arena_block;
+  google::protobuf::Arena arena;
+  // whether the stages of the pipeline run in this process and hand requests on in memory
+  bool in_process;
+  std::unique_ptr<Api> in_process_request;
+  // how long a request handed on waits for the next stage to take it before it's dropped
+  std::chrono::seconds handoff_expiry;
+  // bounds the work of each action in flight, shared by all of the workers of this process
+  std::shared_ptr<admission_t> admission;
+  // the claim of the request this worker is working on
+  std::unique_ptr<admission_t::ticket_t> admitted;
 };
 } // namespace valhalla
 